@@ -0,0 +1,414 @@
+// eta/hsm/ActorRuntime.hpp
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <queue>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "Hsm.hpp"
+
+namespace eta_hsm {
+
+/// What one worker of an ActorRuntime has done so far
+struct ActorWorkerStats {
+    uint64_t runs{0};    // times an actor was run (each drains one batch from its mailbox)
+    uint64_t events{0};  // events dispatched
+    uint64_t steals{0};  // actors taken from other workers' queues
+};
+
+/// Runs many machines ("actors") on a few worker threads, instead of a thread per machine.  Each machine owns a
+/// bounded mailbox (a utils::Mailbox, or anything else with its interface) that other threads and other actors post
+/// events to, and the runtime only ever runs machines that have events waiting or timers that have expired.
+///
+/// Every actor is run by at most one worker at a time, so its machine needs no locking of its own.  Each run fires
+/// the actor's expired timers and then drains at most `batch` events (see StateMachine::drain()), after which an
+/// actor that still has events goes to the back of its worker's queue, so that a busy actor cannot starve the others.
+/// Each worker has a queue of its own; a worker whose queue is empty steals half of another worker's.
+///
+/// What a machine needs is described by an Adapter:
+///
+///     struct Adapter {
+///         using Machine = ...;
+///         using Clock = ...;  // with a static now(), e.g. std::chrono::steady_clock
+///         static auto& mailbox(Machine&);
+///         static void fireTimers(Machine&, std::chrono::time_point<Clock> now);  // into the mailbox
+///         static std::optional<std::chrono::time_point<Clock>> nextTimer(const Machine&);  // see nextExpiration()
+///     };
+///
+/// Actors are added before start(), and the runtime does not own their machines, which must outlive it.
+template <typename Adapter>
+class ActorRuntime {
+public:
+    using Machine = typename Adapter::Machine;
+    using Event = typename Machine::Event;
+    using Clock = typename Adapter::Clock;
+    using TimePoint = std::chrono::time_point<Clock>;
+    using ActorId = uint32_t;
+
+    /// `workers` threads, each dispatching at most `batch` events to an actor before moving on to the next
+    explicit ActorRuntime(size_t workers = std::max<size_t>(std::thread::hardware_concurrency(), 1), size_t batch = 32)
+        : mQueues(std::max<size_t>(workers, 1)), mStats(mQueues.size()), mBatch{std::max<size_t>(batch, 1)}
+    {}
+
+    ~ActorRuntime() { stop(); }
+
+    ActorRuntime(const ActorRuntime&) = delete;
+    ActorRuntime& operator=(const ActorRuntime&) = delete;
+
+    /// Take on `machine`, returning the id to post to it with.  Only before start().
+    ActorId add(Machine& machine)
+    {
+        const auto id = static_cast<ActorId>(mActors.size());
+        Actor& actor = mActors.emplace_back(*this, machine, id);
+        Adapter::mailbox(machine).setNotify(&ActorRuntime::notify, &actor);
+        return id;
+    }
+
+    size_t size() const { return mActors.size(); }
+
+    Machine& machine(ActorId id) { return *mActors[id].machine; }
+
+    /// Start the workers.  Actors that were posted to (or whose timers expired) before this are run straight away.
+    void start()
+    {
+        for (Actor& actor : mActors)
+        {
+            if (!Adapter::mailbox(*actor.machine).empty())
+            {
+                schedule(actor);
+            }
+            if (const auto next = Adapter::nextTimer(*actor.machine))
+            {
+                armTimer(actor, *next);
+            }
+        }
+        for (size_t idx = 0; idx < mQueues.size(); ++idx)
+        {
+            mWorkers.emplace_back([this, idx]() { work(idx); });
+        }
+    }
+
+    /// Stop the workers once they have finished the actors they are running.  Events still in mailboxes stay there.  A
+    /// runtime cannot be started again.
+    void stop()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mSleepMutex);
+            mStopping = true;
+        }
+        mWake.notify_all();
+        for (auto& worker : mWorkers)
+        {
+            worker.join();
+        }
+        mWorkers.clear();
+    }
+
+    /// Post `event` to actor `id`, from any thread (including from an actor).  Returns false if its mailbox was full.
+    bool post(ActorId id, Event event) { return Adapter::mailbox(*mActors[id].machine).tryAddEvent(std::move(event)); }
+
+    /// Wait until no actor has events waiting or is being run (timers that have not expired yet do not count), or
+    /// until `timeout` has passed.  Returns false on timeout.
+    bool waitIdle(std::chrono::milliseconds timeout)
+    {
+        const auto deadline = std::chrono::steady_clock::now() + timeout;
+        while (mBusy.load(std::memory_order_acquire) != 0)
+        {
+            if (std::chrono::steady_clock::now() > deadline)
+            {
+                return false;
+            }
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+        }
+        return true;
+    }
+
+    /// What each worker has done so far (only exact once the workers have been stopped)
+    std::vector<ActorWorkerStats> stats() const
+    {
+        std::vector<ActorWorkerStats> stats;
+        for (const auto& worker : mStats)
+        {
+            stats.push_back({worker.runs.load(std::memory_order_relaxed), worker.events.load(std::memory_order_relaxed),
+                             worker.steals.load(std::memory_order_relaxed)});
+        }
+        return stats;
+    }
+
+protected:
+private:
+    /// Where an actor is in its life cycle.  Only the worker that moves an actor from eQueued to eRunning may run it,
+    /// and an actor is only ever queued once, which is what keeps any actor from running on two workers at once.
+    enum class ActorState : uint8_t {
+        eIdle,              // nothing to do
+        eQueued,            // in a worker's queue
+        eRunning,           // being run
+        eRunningNotified,   // being run, and something arrived that the run may have missed
+    };
+
+    struct Actor {
+        Actor(ActorRuntime& runtime_, Machine& machine_, ActorId id_) : runtime{&runtime_}, machine{&machine_}, id{id_}
+        {}
+
+        ActorRuntime* runtime;
+        Machine* machine;
+        ActorId id;
+        std::atomic<ActorState> state{ActorState::eIdle};
+        std::atomic<bool> timerQueued{false};
+        TimePoint armed{};  // the expiration last put in the timer queue (only touched by the running worker)
+    };
+
+    struct WorkQueue {
+        std::mutex mutex{};
+        std::deque<ActorId> actors{};
+    };
+
+    struct WorkerCounters {
+        std::atomic<uint64_t> runs{0};
+        std::atomic<uint64_t> events{0};
+        std::atomic<uint64_t> steals{0};
+    };
+
+    using TimerEntry = std::pair<TimePoint, ActorId>;
+
+    /// The worker (of which runtime) the current thread is, so that actors that post to other actors queue them on
+    /// their own worker
+    struct WorkerIdentity {
+        const ActorRuntime* runtime{nullptr};
+        size_t index{0};
+    };
+
+    static WorkerIdentity& currentWorker()
+    {
+        thread_local WorkerIdentity sWorker;
+        return sWorker;
+    }
+
+    /// Called by an actor's mailbox for every event added to it
+    static void notify(void* context)
+    {
+        Actor& actor = *static_cast<Actor*>(context);
+        actor.runtime->schedule(actor);
+    }
+
+    void schedule(Actor& actor)
+    {
+        ActorState state = actor.state.load(std::memory_order_acquire);
+        while (true)
+        {
+            switch (state)
+            {
+                case ActorState::eIdle:
+                    if (actor.state.compare_exchange_weak(state, ActorState::eQueued, std::memory_order_acq_rel))
+                    {
+                        mBusy.fetch_add(1, std::memory_order_acq_rel);
+                        enqueue(actor.id);
+                        return;
+                    }
+                    break;
+                case ActorState::eRunning:
+                    if (actor.state.compare_exchange_weak(state, ActorState::eRunningNotified,
+                                                          std::memory_order_acq_rel))
+                    {
+                        return;
+                    }
+                    break;
+                default:
+                    // Already queued, or the running worker already knows to look again
+                    return;
+            }
+        }
+    }
+
+    void enqueue(ActorId id)
+    {
+        const WorkerIdentity& worker = currentWorker();
+        const size_t index = worker.runtime == this
+                                 ? worker.index
+                                 : mNextQueue.fetch_add(1, std::memory_order_relaxed) % mQueues.size();
+        {
+            std::lock_guard<std::mutex> lock(mQueues[index].mutex);
+            mQueues[index].actors.push_back(id);
+        }
+        mQueued.fetch_add(1, std::memory_order_seq_cst);
+        if (mSleepers.load(std::memory_order_seq_cst) > 0)
+        {
+            std::lock_guard<std::mutex> lock(mSleepMutex);
+            mWake.notify_one();
+        }
+    }
+
+    std::optional<ActorId> popLocal(size_t index)
+    {
+        WorkQueue& queue = mQueues[index];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (queue.actors.empty())
+        {
+            return std::nullopt;
+        }
+        const ActorId id = queue.actors.front();
+        queue.actors.pop_front();
+        return id;
+    }
+
+    /// Take the back half of the first non-empty queue after our own, keeping all but one of them for later
+    std::optional<ActorId> steal(size_t index)
+    {
+        for (size_t offset = 1; offset < mQueues.size(); ++offset)
+        {
+            WorkQueue& victim = mQueues[(index + offset) % mQueues.size()];
+            std::unique_lock<std::mutex> lock(victim.mutex);
+            if (victim.actors.empty())
+            {
+                continue;
+            }
+            const size_t count = (victim.actors.size() + 1) / 2;
+            const auto first = victim.actors.end() - static_cast<std::ptrdiff_t>(count);
+            std::vector<ActorId> stolen(first, victim.actors.end());
+            victim.actors.erase(first, victim.actors.end());
+            lock.unlock();
+
+            mStats[index].steals.fetch_add(count, std::memory_order_relaxed);
+            if (count > 1)
+            {
+                std::lock_guard<std::mutex> ownLock(mQueues[index].mutex);
+                mQueues[index].actors.insert(mQueues[index].actors.end(), stolen.begin() + 1, stolen.end());
+            }
+            return stolen.front();
+        }
+        return std::nullopt;
+    }
+
+    void armTimer(Actor& actor, TimePoint expiration)
+    {
+        actor.armed = expiration;
+        actor.timerQueued.store(true, std::memory_order_relaxed);
+        std::lock_guard<std::mutex> lock(mTimerMutex);
+        mTimers.push({expiration, actor.id});
+    }
+
+    /// Schedule the actors whose timers have expired.  Only one worker at a time looks; the others have better things
+    /// to do than wait for it.
+    void fireDueTimers()
+    {
+        std::unique_lock<std::mutex> lock(mTimerMutex, std::try_to_lock);
+        if (!lock.owns_lock())
+        {
+            return;
+        }
+        const TimePoint now = Clock::now();
+        while (!mTimers.empty() && mTimers.top().first <= now)
+        {
+            Actor& actor = mActors[mTimers.top().second];
+            mTimers.pop();
+            actor.timerQueued.store(false, std::memory_order_relaxed);
+            schedule(actor);
+        }
+    }
+
+    /// How long an idle worker may sleep before it needs to look at the timers again
+    std::chrono::steady_clock::time_point wakeUpTime()
+    {
+        const auto latest = std::chrono::steady_clock::now() + std::chrono::milliseconds(10);
+        std::lock_guard<std::mutex> lock(mTimerMutex);
+        if (mTimers.empty())
+        {
+            return latest;
+        }
+        const auto untilDue = mTimers.top().first - Clock::now();
+        return std::min(latest, std::chrono::steady_clock::now() +
+                                    std::chrono::duration_cast<std::chrono::steady_clock::duration>(untilDue));
+    }
+
+    void run(size_t index, Actor& actor)
+    {
+        actor.state.store(ActorState::eRunning, std::memory_order_release);
+        Machine& machine = *actor.machine;
+        auto& mailbox = Adapter::mailbox(machine);
+
+        Adapter::fireTimers(machine, Clock::now());
+        DrainBudget<Clock> budget{};
+        budget.maxEvents = mBatch;
+        const auto drained = machine.drain(mailbox, budget);
+
+        const auto next = Adapter::nextTimer(machine);
+        if (next && (*next != actor.armed || !actor.timerQueued.load(std::memory_order_relaxed)))
+        {
+            armTimer(actor, *next);
+        }
+        mStats[index].runs.fetch_add(1, std::memory_order_relaxed);
+        mStats[index].events.fetch_add(drained.dispatched, std::memory_order_relaxed);
+
+        // Back of the queue if there is more to do, otherwise idle, unless more arrived while it was being run
+        ActorState state = ActorState::eRunning;
+        if (mailbox.empty() && actor.state.compare_exchange_strong(state, ActorState::eIdle, std::memory_order_acq_rel))
+        {
+            mBusy.fetch_sub(1, std::memory_order_acq_rel);
+            return;
+        }
+        actor.state.store(ActorState::eQueued, std::memory_order_release);
+        enqueue(actor.id);
+    }
+
+    void work(size_t index)
+    {
+        currentWorker() = {this, index};
+        while (!mStopping.load(std::memory_order_relaxed))
+        {
+            fireDueTimers();
+            std::optional<ActorId> id = popLocal(index);
+            if (!id)
+            {
+                id = steal(index);
+            }
+            if (id)
+            {
+                mQueued.fetch_sub(1, std::memory_order_relaxed);
+                run(index, mActors[*id]);
+                continue;
+            }
+
+            const auto wakeUp = wakeUpTime();
+            std::unique_lock<std::mutex> lock(mSleepMutex);
+            mSleepers.fetch_add(1, std::memory_order_seq_cst);
+            mWake.wait_until(lock, wakeUp,
+                             [this]() { return mStopping.load() || mQueued.load(std::memory_order_seq_cst) > 0; });
+            mSleepers.fetch_sub(1, std::memory_order_seq_cst);
+        }
+    }
+
+    std::deque<Actor> mActors{};
+    std::vector<WorkQueue> mQueues;
+    std::vector<WorkerCounters> mStats;
+    const size_t mBatch;
+    std::vector<std::thread> mWorkers{};
+
+    std::atomic<size_t> mNextQueue{0};
+    std::atomic<size_t> mQueued{0};  // actors in the queues
+    std::atomic<size_t> mBusy{0};    // actors queued or running
+
+    /// Idle workers sleep here until there is work, a timer is due, or the runtime stops
+    std::mutex mSleepMutex{};
+    std::condition_variable mWake{};
+    std::atomic<size_t> mSleepers{0};
+    std::atomic<bool> mStopping{false};
+
+    /// When each actor's next timer expires, soonest first (entries for timers since cleared or moved just cause a run
+    /// that finds nothing to do)
+    std::mutex mTimerMutex{};
+    std::priority_queue<TimerEntry, std::vector<TimerEntry>, std::greater<TimerEntry>> mTimers{};
+};
+
+}  // namespace eta_hsm
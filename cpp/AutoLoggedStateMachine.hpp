@@ -21,15 +21,6 @@ public:
 
     virtual ~AutoLoggedStateMachine() {}
 
-    /// Dispatch (step) state machine directly with a named event.
-    void dispatch(typename StateMachineTraits::Event evt)
-    {
-        // Save the event that we are dispatching so that it can be used for logging in next()
-        mEventDispatched = evt;
-        // Let the base class peform the actual dispatch normally
-        StateMachine<SM, StateMachineTraits>::dispatch(evt);
-    }
-
     /// Friend the LeafState so that it can access `next` below without exposing it to the world
     template <typename Traits, typename Parent>
     friend struct LeafState;
@@ -45,7 +36,8 @@ private:
         // only thing that this pointer can actually point to (composite states are abstract).
         // Therefore, in order to avoid a bunch of yuckiness elsehwere, we put in a little bit of a
         // hack here to catch this first initialization and avoid dereferencing the unitialized pointer.
-        if (mStateInitialized)
+        // (The pointer is also null again after stop(), until the machine is restarted.)
+        if (mStateInitialized && AutoLoggedStateMachine::mState)
         {
             typename StateMachineTraits::StateEnum originState = AutoLoggedStateMachine::mState->identify();
             typename StateMachineTraits::StateEnum destinationState = state.identify();
@@ -55,20 +47,27 @@ private:
                 static_assert(wise_enum::is_wise_enum_v<typename StateMachineTraits::StateEnum>, "Ignorant State Enum");
                 static_assert(wise_enum::is_wise_enum_v<typename StateMachineTraits::Event>, "Ignorant Event Enum");
 
-                // mpLogger->printf(mTransitionFormat, originState, destinationState, mEventDispatched);
+                // The event being handled, which may have been raised or recalled rather than dispatched
                 *mpLogger << mName << " HSM transitioning from " << wise_enum::to_string(originState) << " to "
-                          << wise_enum::to_string(destinationState) << " due to "
-                          << wise_enum::to_string(mEventDispatched) << std::endl;
+                          << wise_enum::to_string(destinationState);
+                if (const auto event = AutoLoggedStateMachine::handlingEvent())
+                {
+                    *mpLogger << " due to " << wise_enum::to_string(*event) << std::endl;
+                }
+                else
+                {
+                    *mpLogger << " outside of an event handler" << std::endl;
+                }
             }
         }
 
         // This is the line that actually changes the current state of the state machine
         AutoLoggedStateMachine::mState = &state;
+        ++AutoLoggedStateMachine::mTransitions;
         mStateInitialized = true;
     }
 
     bool mStateInitialized{false};
-    typename StateMachineTraits::Event mEventDispatched{StateMachineTraits::Event::eNone};
     // Format mTransitionFormat {};
     std::string mName{};
     Logger* mpLogger;
@@ -0,0 +1,401 @@
+// eta/hsm/Coroutine.hpp
+
+#pragma once
+
+#if !defined(__cpp_impl_coroutine)
+#error "Coroutine.hpp needs C++20 coroutines (e.g. -std=c++20); the rest of eta_hsm only needs C++17"
+#endif
+
+#include <array>
+#include <cassert>
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <utility>
+
+#include "Hsm.hpp"
+
+namespace eta_hsm {
+
+namespace detail {
+
+/// Fixed-size blocks on a free list; the storage itself is in CoroutineFramePool.  Each block starts with a pointer
+/// back to its pool, so that a frame can be given back knowing nothing but its address (which is all a coroutine's
+/// operator delete gets).
+class FramePoolBase {
+public:
+    static constexpr size_t kHeaderBytes = alignof(std::max_align_t);
+
+    /// A frame of `frameBytes`, or nullptr if it does not fit in a block or every block is in use
+    void* allocate(size_t frameBytes)
+    {
+        if (frameBytes > mBlockBytes - kHeaderBytes || !mFree)
+        {
+            ++mFailures;
+            return nullptr;
+        }
+        Block* block = mFree;
+        mFree = block->next;
+        block->pool = this;
+        ++mInUse;
+        return reinterpret_cast<std::byte*>(block) + kHeaderBytes;
+    }
+
+    static void deallocate(void* frame)
+    {
+        auto* block = reinterpret_cast<Block*>(static_cast<std::byte*>(frame) - kHeaderBytes);
+        FramePoolBase* pool = block->pool;
+        block->next = pool->mFree;
+        pool->mFree = block;
+        --pool->mInUse;
+    }
+
+    size_t inUse() const { return mInUse; }
+
+    /// How many frames could not be allocated (see Action::operator bool)
+    uint64_t failures() const { return mFailures; }
+
+protected:
+    FramePoolBase() = default;
+    FramePoolBase(const FramePoolBase&) = delete;
+    FramePoolBase& operator=(const FramePoolBase&) = delete;
+
+    void thread(std::byte* storage, size_t blocks, size_t blockBytes)
+    {
+        mBlockBytes = blockBytes;
+        mFree = nullptr;
+        for (size_t idx = blocks; idx > 0; --idx)
+        {
+            auto* block = reinterpret_cast<Block*>(storage + (idx - 1) * blockBytes);
+            block->next = mFree;
+            mFree = block;
+        }
+    }
+
+private:
+    union Block {
+        Block* next;          // while free
+        FramePoolBase* pool;  // while in use
+    };
+
+    Block* mFree{nullptr};
+    size_t mBlockBytes{0};
+    size_t mInUse{0};
+    uint64_t mFailures{0};
+};
+
+/// The first parameter of a coroutine action (the machine, or `*this` for a member function), as seen by the operator
+/// new of its promise:  where its frame comes from
+struct FrameSource {
+    template <typename Host>
+    FrameSource(Host& host) : pool{&host.coroutines().framePool()}
+    {}
+
+    FramePoolBase* pool;
+};
+
+/// Any other parameter of a coroutine action, which operator new has no use for
+struct AnyParameter {
+    template <typename Parameter>
+    AnyParameter(const Parameter&) noexcept
+    {}
+};
+
+}  // namespace detail
+
+/// kFrames coroutine frames of up to kFrameBytes each (including a small header), held inline, so that running a
+/// coroutine action never touches the heap.  How big a frame is depends on the coroutine and on the optimization
+/// level; one that does not fit fails to start (see Action::operator bool).
+template <size_t kFrames, size_t kFrameBytes>
+class CoroutineFramePool : public detail::FramePoolBase {
+public:
+    static_assert(kFrameBytes % alignof(std::max_align_t) == 0, "kFrameBytes must keep every block aligned");
+    static_assert(kFrameBytes > kHeaderBytes, "kFrameBytes leaves no room for a frame");
+
+    CoroutineFramePool() { thread(mStorage, kFrames, kFrameBytes); }
+
+    /// A copy starts out empty:  frames belong to the coroutines of the pool they came from
+    CoroutineFramePool(const CoroutineFramePool&) : CoroutineFramePool{} {}
+    CoroutineFramePool& operator=(const CoroutineFramePool&) { return *this; }
+
+private:
+    alignas(std::max_align_t) std::byte mStorage[kFrames * kFrameBytes];
+};
+
+/// The return type of a coroutine action.  An action is a member function of the machine (or any function whose first
+/// parameter is the machine), with up to four other parameters, so that its frame can come from the machine's
+/// CoroutineScope:
+///
+///     Action Valve::pressurize()
+///     {
+///         mOutputs.valveOpen = true;
+///         co_await coroutines().timer(mTimers, ValveEvent::eSettled, std::chrono::milliseconds(200));
+///         raise(mInputs.pressure > kMinPressure ? ValveEvent::ePressurized : ValveEvent::eLeak);
+///     }
+///
+/// It does nothing until it is handed to CoroutineScope::spawn().
+class Action {
+public:
+    struct promise_type {
+        // Non-template overloads, one per number of parameters after the machine, as gcc takes a templated operator
+        // new to be mismatched with the usual operator delete (-Wmismatched-new-delete)
+        using Source = detail::FrameSource;
+        using Param = detail::AnyParameter;
+        static void* operator new(size_t size, Source source) noexcept { return source.pool->allocate(size); }
+        static void* operator new(size_t size, Source source, Param) noexcept { return source.pool->allocate(size); }
+        static void* operator new(size_t size, Source source, Param, Param) noexcept
+        {
+            return source.pool->allocate(size);
+        }
+        static void* operator new(size_t size, Source source, Param, Param, Param) noexcept
+        {
+            return source.pool->allocate(size);
+        }
+        static void* operator new(size_t size, Source source, Param, Param, Param, Param) noexcept
+        {
+            return source.pool->allocate(size);
+        }
+        static void operator delete(void* frame, size_t) noexcept { detail::FramePoolBase::deallocate(frame); }
+        static Action get_return_object_on_allocation_failure() noexcept { return Action{}; }
+
+        Action get_return_object() noexcept { return Action{std::coroutine_handle<promise_type>::from_promise(*this)}; }
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        std::suspend_always final_suspend() noexcept { return {}; }
+        void return_void() noexcept {}
+        void unhandled_exception() noexcept { std::terminate(); }
+    };
+
+    Action() = default;
+    Action(Action&& other) noexcept : mHandle{std::exchange(other.mHandle, nullptr)} {}
+    Action& operator=(Action&& other) noexcept
+    {
+        std::swap(mHandle, other.mHandle);
+        return *this;
+    }
+    ~Action()
+    {
+        if (mHandle)
+        {
+            mHandle.destroy();
+        }
+    }
+
+    /// False if the frame could not be allocated (the pool was exhausted, or the frame is too big for it)
+    explicit operator bool() const { return static_cast<bool>(mHandle); }
+
+    /// Hand the coroutine over (to a CoroutineScope)
+    std::coroutine_handle<> release() { return std::exchange(mHandle, nullptr); }
+
+private:
+    explicit Action(std::coroutine_handle<promise_type> handle) : mHandle{handle} {}
+
+    std::coroutine_handle<promise_type> mHandle{};
+};
+
+/// The coroutine actions of one machine:  up to kMaxActions at once, with frames of up to kFrameBytes from a pool
+/// of their own.  An action is started by an entry or stateUpdate action (or any other) with spawn(), on behalf of
+/// the state it belongs to, and runs until it first suspends.  From then on it is resumed by the machine, when it is
+/// dispatched the event the action is waiting for (see event() and timer()), and it is destroyed, along with
+/// everything on its frame, when it returns or when the state it belongs to exits, whichever comes first.
+///
+/// To use it, declare kCoroutineActions in the StateMachineTraits and give the machine a CoroutineScope that it
+/// returns from coroutines():
+///
+///     struct ValveTraits {
+///         ...
+///         static constexpr bool kCoroutineActions = true;
+///     };
+///
+///     class Valve : public StateMachine<Valve, ValveTraits> {
+///         ...
+///         CoroutineScope<Valve, 4>& coroutines() { return mCoroutines; }
+///         CoroutineScope<Valve, 4> mCoroutines{};
+///     };
+///
+/// An event that any action is waiting for, whether dispatched, raised or recalled from deferral, goes to the actions
+/// instead of the current state, so events used to wake actions should be used for nothing else.  Actions act on the
+/// machine from the middle of an event handler, so they must not dispatch events to it; they raise() them instead.
+/// Copies of a machine start out without actions.
+template <typename SM, size_t kMaxActions, size_t kFrameBytes = 1024>
+class CoroutineScope {
+public:
+    using Event = typename SM::Event;
+    using StateEnum = typename SM::StateEnum;
+
+    CoroutineScope() = default;
+    CoroutineScope(const CoroutineScope&) : CoroutineScope{} {}
+    CoroutineScope& operator=(const CoroutineScope& other)
+    {
+        if (this != &other)
+        {
+            cancelAll();
+        }
+        return *this;
+    }
+    ~CoroutineScope() { cancelAll(); }
+
+    /// Start `action` on behalf of `owner` (usually the state whose entry or stateUpdate action this is), and run it
+    /// until it first suspends.  Returns false, dropping the action, if its frame could not be allocated.
+    bool spawn(StateEnum owner, Action action)
+    {
+        if (!action)
+        {
+            return false;
+        }
+        // There is a slot for every frame in the pool, so a frame always comes with a free slot
+        size_t idx = 0;
+        while (mSlots[idx].handle)
+        {
+            ++idx;
+        }
+        mSlots[idx] = Slot{action.release(), owner};
+        run(idx);
+        return true;
+    }
+
+    /// Resume every action waiting for `event`.  Returns false if none were.
+    bool resume(Event event)
+    {
+        bool resumed = false;
+        for (size_t idx = 0; idx < kMaxActions; ++idx)
+        {
+            Slot& slot = mSlots[idx];
+            if (slot.handle && slot.waiting && slot.awaited == event)
+            {
+                slot.waiting = false;
+                run(idx);
+                resumed = true;
+            }
+        }
+        return resumed;
+    }
+
+    /// Destroy every action that belongs to `owner`.  Called by the machine as `owner` exits.
+    void cancel(StateEnum owner)
+    {
+        for (size_t idx = 0; idx < kMaxActions; ++idx)
+        {
+            if (mSlots[idx].handle && mSlots[idx].owner == owner)
+            {
+                cancelAt(idx);
+            }
+        }
+    }
+
+    void cancelAll()
+    {
+        for (size_t idx = 0; idx < kMaxActions; ++idx)
+        {
+            if (mSlots[idx].handle)
+            {
+                cancelAt(idx);
+            }
+        }
+    }
+
+    /// Number of actions that have been started and have neither returned nor been cancelled
+    size_t active() const { return mPool.inUse(); }
+
+    /// Number of actions that could not be started because their frames could not be allocated
+    uint64_t allocationFailures() const { return mPool.failures(); }
+
+    /// For Action::promise_type::operator new
+    detail::FramePoolBase& framePool() { return mPool; }
+
+    /// Awaitable that suspends the running action until the machine is dispatched `event`
+    auto event(Event event) { return Awaiter{*this, event}; }
+
+    /// Awaitable that arms a timer for `event` in `timers` (a TimerBank or StaticTimerBank), grouped under the state
+    /// the running action belongs to, and suspends the action until the timer fires and the machine is dispatched the
+    /// event.  `when` is anything the bank's addTimer() takes:  a time_point, or a duration from the time the bank was
+    /// last checked.  The timer is only cleared along with the action when its state exits if the machine also
+    /// declares kClearTimersOnExit.
+    template <typename Timers, typename When>
+    auto timer(Timers& timers, Event event, When when)
+    {
+        return TimerAwaiter<Timers, When>{{*this, event}, timers, when};
+    }
+
+protected:
+private:
+    static constexpr size_t kNone = kMaxActions;
+
+    struct Slot {
+        std::coroutine_handle<> handle{};
+        StateEnum owner{};
+        bool waiting{false};
+        bool running{false};
+        bool cancelled{false};
+        Event awaited{};
+    };
+
+    struct Awaiter {
+        CoroutineScope& scope;
+        Event awaited;
+
+        bool await_ready() const noexcept { return false; }
+        void await_suspend(std::coroutine_handle<>) noexcept
+        {
+            Slot& slot = scope.running();
+            slot.waiting = true;
+            slot.awaited = awaited;
+        }
+        void await_resume() const noexcept {}
+    };
+
+    template <typename Timers, typename When>
+    struct TimerAwaiter : Awaiter {
+        Timers& timers;
+        When when;
+
+        void await_suspend(std::coroutine_handle<> handle) noexcept
+        {
+            timers.addTimer(this->awaited, this->scope.running().owner, when);
+            Awaiter::await_suspend(handle);
+        }
+    };
+
+    Slot& running()
+    {
+        assert(mRunning != kNone && "only actions started with spawn() can await through their CoroutineScope");
+        return mSlots[mRunning];
+    }
+
+    /// Resume the action in slot `idx` until it next suspends (actions may spawn others, hence the save and restore)
+    void run(size_t idx)
+    {
+        const size_t outer = std::exchange(mRunning, idx);
+        Slot& slot = mSlots[idx];
+        slot.running = true;
+        slot.handle.resume();
+        slot.running = false;
+        mRunning = outer;
+        if (slot.handle.done() || slot.cancelled)
+        {
+            destroyAt(idx);
+        }
+    }
+
+    void cancelAt(size_t idx)
+    {
+        if (mSlots[idx].running)
+        {
+            // Cancelled from within itself:  destroyed as soon as it suspends
+            mSlots[idx].cancelled = true;
+            return;
+        }
+        destroyAt(idx);
+    }
+
+    void destroyAt(size_t idx)
+    {
+        std::exchange(mSlots[idx], Slot{}).handle.destroy();
+    }
+
+    CoroutineFramePool<kMaxActions, kFrameBytes> mPool{};
+    std::array<Slot, kMaxActions> mSlots{};
+    size_t mRunning{kNone};
+};
+
+}  // namespace eta_hsm
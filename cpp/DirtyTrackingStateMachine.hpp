@@ -0,0 +1,88 @@
+// DirtyTrackingStateMachine.hpp
+
+#pragma once
+
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+
+#include "Hsm.hpp"
+#include "utils/FleetStore.hpp"
+
+namespace eta_hsm {
+
+namespace detail {
+template <typename SM, typename = void>
+struct HasEventScheduler : std::false_type {};
+template <typename SM>
+struct HasEventScheduler<SM, std::void_t<decltype(std::declval<SM&>().eventScheduler())>> : std::true_type {};
+}  // namespace detail
+
+/// A StateMachine that marks its bit in a DirtyBitmap (normally a FleetStore's) whenever it changes state, so that
+/// fleet checkpoints only need to capture the machines that actually changed since the last one.
+///
+/// If the machine has an eventScheduler() (the timer bank that kClearTimersOnExit clears), setting, clearing or firing
+/// any of its timers marks the machine as well.  Anything else that should be checkpointed (other timer banks, host
+/// fields, ...) is marked with markDirty().
+template <typename SM, typename StateMachineTraits>
+class DirtyTrackingStateMachine : public StateMachine<SM, StateMachineTraits> {
+public:
+    DirtyTrackingStateMachine() = default;
+
+    /// A copy (e.g. a Speculator's clone) is not tracked:  its transitions are not changes to the machine in the store
+    DirtyTrackingStateMachine(const DirtyTrackingStateMachine& other) : StateMachine<SM, StateMachineTraits>{other} {}
+
+    /// Assignment changes the state of this machine, so it keeps its own tracking (not `other`'s) and is marked dirty
+    DirtyTrackingStateMachine& operator=(const DirtyTrackingStateMachine& other)
+    {
+        StateMachine<SM, StateMachineTraits>::operator=(other);
+        markDirty();
+        return *this;
+    }
+
+    /// Start marking bit `id` of `bits` on every change (and mark it right away, so the first checkpoint captures us)
+    void trackDirty(utils::DirtyBitmap& bits, size_t id)
+    {
+        mDirtyBits = &bits;
+        mId = id;
+        if constexpr (detail::HasEventScheduler<SM>::value)
+        {
+            static_cast<SM*>(this)->eventScheduler().onChange(&timersChanged, this);
+        }
+        markDirty();
+    }
+
+    /// Stop marking any bit
+    void untrackDirty() { mDirtyBits = nullptr; }
+
+    bool tracksDirty() const { return mDirtyBits != nullptr; }
+
+    void markDirty()
+    {
+        if (mDirtyBits)
+        {
+            mDirtyBits->mark(mId);
+        }
+    }
+
+    /// Friend the LeafState so that it can access `next` below without exposing it to the world
+    template <typename Traits, typename Parent>
+    friend struct LeafState;
+
+private:
+    /// States use this function to set the next (current) state of the state machine
+    void next(const eta_hsm::TopState<
+              StateTraits<SM, typename StateMachineTraits::StateEnum, StateMachineTraits::StateEnum::eTop>>& state)
+        override
+    {
+        StateMachine<SM, StateMachineTraits>::next(state);
+        markDirty();
+    }
+
+    static void timersChanged(void* context) { static_cast<DirtyTrackingStateMachine*>(context)->markDirty(); }
+
+    utils::DirtyBitmap* mDirtyBits{nullptr};
+    size_t mId{0};
+};
+
+}  // namespace eta_hsm
@@ -2,10 +2,20 @@
 
 #pragma once
 
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
 #include <iostream>
+#include <limits>
+#include <optional>
 #include <type_traits>
+#include <utility>
 #include <variant>
 
+#include "utils/EventBucket.hpp"
+
 namespace eta_hsm {
 
 enum class Semantics {
@@ -13,6 +23,12 @@ enum class Semantics {
     eExternal,
 };
 
+/// Flavors of history pseudo-state (see History below)
+enum class HistoryKind {
+    eShallow,  // resume the most recently active direct child, then follow its default initial transitions
+    eDeep,     // resume the most recently active leaf directly
+};
+
 enum class DefaultActions {
     eNothing,
     eControlUpdate,  // entry, exit, and during
@@ -21,6 +37,101 @@ enum class DefaultActions {
 
 using EmptyType = std::monostate;
 
+/// How states receive events:  plain enums by value, and anything else (e.g. utils::PayloadEvent) by const reference,
+/// so that payloads are never copied on their way through the handler chain
+template <typename Event>
+using EventParam = std::conditional_t<std::is_enum_v<Event>, Event, const Event&>;
+
+namespace detail {
+
+/// The enum value that identifies an event, whether or not it carries a payload
+template <typename Event>
+constexpr auto eventId(const Event& evt)
+{
+    if constexpr (std::is_enum_v<Event>)
+    {
+        return evt;
+    }
+    else
+    {
+        return evt.id();
+    }
+}
+
+/// The kDeferredQueueCapacity of a machine (or of its traits), or 0 if it does not declare one
+template <typename Traits, typename = void>
+struct DeferredQueueCapacity : std::integral_constant<size_t, 0> {};
+template <typename Traits>
+struct DeferredQueueCapacity<Traits, std::void_t<decltype(Traits::kDeferredQueueCapacity)>>
+    : std::integral_constant<size_t, Traits::kDeferredQueueCapacity> {};
+
+}  // namespace detail
+
+template <typename State>
+struct ExitChain;
+template <typename State>
+struct HistoryChain;
+template <typename Comp, HistoryKind kKind>
+struct History;
+template <typename Current, typename Source, typename... Branches>
+struct Choice;
+template <typename Current, typename Source, typename... Terminals>
+struct Forward;
+
+/// The set of events that a state defers, as a bitmask indexed by event enum value (see Defer below)
+template <auto... kEvents>
+struct DeferEvents {
+    static_assert(((static_cast<uint64_t>(kEvents) < 64) && ...), "Only the first 64 event enum values can be deferred");
+    static constexpr uint64_t kMask = (uint64_t{0} | ... | (uint64_t{1} << static_cast<uint64_t>(kEvents)));
+};
+
+/// Declare the events a state defers by specializing Defer for that state, e.g.
+///
+///     template <>
+///     struct eta_hsm::Defer<Starting> : DeferEvents<Event::eRun, Event::eCalibrate> {};
+///
+/// A leaf state defers the events deferred by itself and by every one of its ancestors.  Deferred events are parked
+/// by StateMachine (see kDeferredQueueCapacity) and recalled as soon as the machine is in a state that no longer
+/// defers them.  By default, states defer nothing.
+template <typename State>
+struct Defer : DeferEvents<> {};
+
+/// The outgoing branches of a leaf state's completion transition (see Completion below)
+template <typename... Branches>
+struct CompletionBranches {
+    template <typename Leaf, typename Host>
+    static void run(Host& host)
+    {
+        if constexpr (sizeof...(Branches) > 0)
+        {
+            if (host.mCompletionDepth == Host::kMaxCompletionSteps)
+            {
+                ++host.mCompletionsOverLimit;
+                return;
+            }
+            ++host.mCompletionDepth;
+            Choice<Leaf, Leaf, Branches...> c(host);
+            --host.mCompletionDepth;
+        }
+    }
+};
+
+/// Declare a completion transition for a leaf state by specializing Completion for it, e.g.
+///
+///     template <>
+///     struct eta_hsm::Completion<Checking> : CompletionBranches<Branch<&Pump::primed, Running>, Else<Priming>> {};
+///
+/// As soon as the leaf has been entered (at the end of any Transition or Init that ends in it), the guards are
+/// evaluated in order and the first branch that holds is taken, exactly as if the leaf had handled an event.  If no
+/// guard holds (and there is no Else), the machine simply stays in the leaf.  By default, states have no completion
+/// transition.
+///
+/// A completion that leads to another leaf with a completion of its own is taken in the same step, so a chain of them
+/// nests.  After kMaxCompletionSteps completions in a row (which guards against leaves completing into each other
+/// forever), the machine stays in the leaf it has reached, and the cut-off is counted in droppedCompletions().
+template <typename State>
+struct Completion : CompletionBranches<> {};
+
 // There is always one and only one TopState at the top of the hierarchy
 // Host is the class that contains the state machine.
 template <typename Traits>
@@ -30,7 +141,7 @@ struct TopState {
 public:
     static constexpr typename Traits::StateEnum kState = Traits::kState;
 
-    virtual void eventHandler(typename Traits::Host&, typename Traits::Host::Event event) const = 0;
+    virtual void eventHandler(typename Traits::Host&, EventParam<typename Traits::Host::Event> event) const = 0;
     virtual void during(typename Traits::Host&) const = 0;
     virtual void during(typename Traits::Host&, const Input&) const = 0;
 
@@ -49,20 +160,43 @@ public:
         return false;
     }
 
+    /// Run the exit actions of this (leaf) state and all of its ancestors, including Top.  Used to tear down the
+    /// active configuration of a machine as a whole (see StateMachine::stop)
+    virtual void exitAll(typename Traits::Host&) const = 0;
+
+    /// Resume this (leaf) state as the remembered history of `ancestor`, which has just been entered (see History)
+    virtual void restoreDeepHistory(typename Traits::Host&, typename Traits::StateEnum ancestor) const = 0;
+    virtual void restoreShallowHistory(typename Traits::Host&, typename Traits::StateEnum ancestor) const = 0;
+
+    /// Does this (leaf) state, or any of its ancestors, defer `event`?
+    virtual bool defers(EventParam<typename Traits::Host::Event> event) const = 0;
+
     template <typename Current, typename Source, typename Target, Semantics>
     friend class Transition;
     template <typename Target>
     friend class Init;
+    template <typename State>
+    friend struct ExitChain;
+    template <typename State>
+    friend struct HistoryChain;
+    template <typename Current, typename Source, typename... Branches>
+    friend struct Choice;
+    template <typename Current, typename Source, typename... Terminals>
+    friend struct Forward;
 
 protected:
     // make these using declarations protected instead of private to avoid replicating below
     using Host = typename Traits::Host;
-    using Event = typename Traits::Host::Event;
+    using Event = EventParam<typename Traits::Host::Event>;
 
     template <typename Current>
-    void handleEvent(typename Traits::Host& host, const Current& current, typename Traits::Host::Event event) const
+    void handleEvent(typename Traits::Host& host, const Current& current,
+                     EventParam<typename Traits::Host::Event> event) const
     {}
 
+    /// Events deferred by this state and its ancestors
+    static constexpr uint64_t deferredMask() { return Defer<TopState>::kMask; }
+
 private:
     /// There is intentionally no default implementation for init.  This way the compiler will enforce the definition
     /// of init for any non-leaf state.
@@ -83,6 +217,12 @@ private:
     }
     static void exit(typename Traits::Host& host)
     {
+        // cancel the coroutine actions this state started (see Coroutine.hpp)
+        if constexpr (Traits::Host::kCoroutineActions)
+        {
+            host.coroutines().cancel(Traits::kState);
+        }
+
         if constexpr (Traits::Host::kDefaultActions == DefaultActions::eControlUpdate ||
                       Traits::Host::kDefaultActions == DefaultActions::eEntryExitOnly)
         {
@@ -105,6 +245,16 @@ public:
     friend class Transition;
     template <typename Target>
     friend class Init;
+    template <typename State>
+    friend struct ExitChain;
+    template <typename State>
+    friend struct HistoryChain;
+    template <typename Current, typename Source, typename... Branches>
+    friend struct Choice;
+    template <typename Current, typename Source, typename... Terminals>
+    friend struct Forward;
+    template <typename Comp, HistoryKind kKind>
+    friend struct History;
 
     static constexpr typename Traits::StateEnum kState = Traits::kState;
 
@@ -122,12 +272,16 @@ public:
 
 protected:
     template <typename Current>
-    void handleEvent(typename Traits::Host& host, const Current& current, typename Traits::Host::Event event) const
+    void handleEvent(typename Traits::Host& host, const Current& current,
+                     EventParam<typename Traits::Host::Event> event) const
     {
         // std::cout << "default CompState::handleEvent()" << std::endl;
         Parent_::handleEvent(host, current, event);
     }
 
+    /// Events deferred by this state and its ancestors
+    static constexpr uint64_t deferredMask() { return Defer<CompState>::kMask | Parent_::deferredMask(); }
+
 private:
     /// There is intentionally no default implementation for init.  This way the compiler will enforce the definition
     /// of init for any non-leaf state.
@@ -139,6 +293,12 @@ private:
     /// a child state.
     static void entry(typename Traits::Host& host)
     {
+        // open this state's residency span (see kTraceStates)
+        if constexpr (Traits::Host::kTraceStates)
+        {
+            host.stateTracer().enter(Traits::kState);
+        }
+
         if constexpr (Traits::Host::kDefaultActions == DefaultActions::eControlUpdate ||
                       Traits::Host::kDefaultActions == DefaultActions::eEntryExitOnly)
         {
@@ -148,18 +308,38 @@ private:
     }
     static void exit(typename Traits::Host& host)
     {
+        // remember where we were, in case we come back via a History pseudo-state
+        if constexpr (Traits::Host::kHistoryStates > 0)
+        {
+            static_assert(static_cast<size_t>(Traits::kState) < Traits::Host::kHistoryStates,
+                          "kHistoryStates must cover every StateEnum value");
+            host.rememberHistory(Traits::kState);
+        }
+
         // clear all timers associated with this state
         if constexpr (Traits::Host::kClearTimersOnExit)
         {
             host.template eventScheduler().clearAllTimersInGroup(Traits::kState);
         }
 
+        // cancel the coroutine actions this state started (see Coroutine.hpp)
+        if constexpr (Traits::Host::kCoroutineActions)
+        {
+            host.coroutines().cancel(Traits::kState);
+        }
+
         if constexpr (Traits::Host::kDefaultActions == DefaultActions::eControlUpdate ||
                       Traits::Host::kDefaultActions == DefaultActions::eEntryExitOnly)
         {
             host.template exit<Traits::kState>();
         }
         // else, do nothing
+
+        // close this state's residency span (see kTraceStates)
+        if constexpr (Traits::Host::kTraceStates)
+        {
+            host.stateTracer().exit(Traits::kState);
+        }
     }
 
     // This is so that the parent type is still accessible after the template has been specialized
@@ -179,11 +359,19 @@ public:
 
     template <typename Target>
     friend class Init;
+    template <typename State>
+    friend struct ExitChain;
+    template <typename State>
+    friend struct HistoryChain;
+    template <typename Current, typename Source, typename... Branches>
+    friend struct Choice;
+    template <typename Current, typename Source, typename... Terminals>
+    friend struct Forward;
 
     static constexpr typename Traits::StateEnum kState = Traits::kState;
 
     /// eventHandler is public entry point into the state, only defined for leaf states.
-    void eventHandler(typename Traits::Host& host, typename Traits::Host::Event event) const final
+    void eventHandler(typename Traits::Host& host, EventParam<typename Traits::Host::Event> event) const final
     {
         handleEvent(host, *this, event);
     }
@@ -212,10 +400,35 @@ public:
         // else, do nothing
     };
 
+    void exitAll(typename Traits::Host& host) const final { ExitChain<LeafState>::run(host); }
+
+    void restoreDeepHistory(typename Traits::Host& host, typename Traits::StateEnum ancestor) const final
+    {
+        HistoryChain<LeafState>::enterBelow(host, ancestor);
+        init(host);
+    }
+    void restoreShallowHistory(typename Traits::Host& host, typename Traits::StateEnum ancestor) const final
+    {
+        HistoryChain<LeafState>::enterChildOf(host, ancestor);
+    }
+
+    /// A single test against a mask that is folded together at compile time
+    bool defers(EventParam<typename Traits::Host::Event> event) const final
+    {
+        constexpr uint64_t kMask = deferredMask();
+        static_assert(kMask == 0 || detail::DeferredQueueCapacity<typename Traits::Host>::value > 0,
+                      "a state defers events (see Defer), but the machine has no kDeferredQueueCapacity to park them");
+        const auto idx = static_cast<uint64_t>(detail::eventId(event));
+        return idx < 64 && ((kMask >> idx) & 1) != 0;
+    }
+
     /// Expose direct access to state instance for testing and simmulation only.
     /// WARNING: This exposes access to all sorts of stuff that you shouldn't be touching!
     static const LeafState& instanceForTestingOnly() { return mObj; }
 
+    /// The one and only instance of this leaf, usable in constant expressions (e.g. to build tables of leaves)
+    static constexpr const LeafState* instance() { return &mObj; }
+
     /// Identify yourself with a run-time usable enum
     /// Not intended for use in non-test code
     typename Traits::StateEnum identify() const final { return Traits::kState; }
@@ -234,15 +447,23 @@ public:
 
 protected:
     template <typename Current>
-    void handleEvent(typename Traits::Host& host, const Current& current, typename Traits::Host::Event event) const
+    void handleEvent(typename Traits::Host& host, const Current& current,
+                     EventParam<typename Traits::Host::Event> event) const
     {
         // std::cout << "default LeafState::handleEvent()" << std::endl;
         Parent_::handleEvent(host, current, event);
     }
 
+    /// Events deferred by this state and its ancestors
+    static constexpr uint64_t deferredMask() { return Defer<LeafState>::kMask | Parent_::deferredMask(); }
+
 private:
     // Specific leaf states should not specialize this init behavior.
-    static void init(typename Traits::Host& host) { host.next(mObj); }
+    static void init(typename Traits::Host& host)
+    {
+        host.next(mObj);
+        Completion<LeafState>::template run<LeafState>(host);
+    }
 
     /// Default implementation of entry/exit can now be suggested via optional kDefaultAction argument to StateMachine,
     /// but can still be arbitrarily specialized by state.  Unfortunately, I think that these need to be repeated for
@@ -250,6 +471,12 @@ private:
     /// a child state.
     static void entry(typename Traits::Host& host)
     {
+        // open this state's residency span (see kTraceStates)
+        if constexpr (Traits::Host::kTraceStates)
+        {
+            host.stateTracer().enter(Traits::kState);
+        }
+
         if constexpr (Traits::Host::kDefaultActions == DefaultActions::eControlUpdate ||
                       Traits::Host::kDefaultActions == DefaultActions::eEntryExitOnly)
         {
@@ -265,12 +492,24 @@ private:
             host.template eventScheduler().clearAllTimersInGroup(Traits::kState);
         }
 
+        // cancel the coroutine actions this state started (see Coroutine.hpp)
+        if constexpr (Traits::Host::kCoroutineActions)
+        {
+            host.coroutines().cancel(Traits::kState);
+        }
+
         if constexpr (Traits::Host::kDefaultActions == DefaultActions::eControlUpdate ||
                       Traits::Host::kDefaultActions == DefaultActions::eEntryExitOnly)
         {
             host.template exit<Traits::kState>();
         }
         // else, do nothing
+
+        // close this state's residency span (see kTraceStates)
+        if constexpr (Traits::Host::kTraceStates)
+        {
+            host.stateTracer().exit(Traits::kState);
+        }
     }
 
     using ParentState = Parent_;
@@ -356,6 +595,63 @@ struct Transition {
     Host& mHost;
 };
 
+/// One outgoing branch of a Choice (or of a completion transition), taken when kGuard holds for the host.  The guard
+/// is either a const member function of the host (`&Pump::primed`) or a function taking `const Host&`.
+template <auto kGuard, typename Target_>
+struct Branch {
+    using Target = Target_;
+
+    template <typename Host>
+    static bool guard(const Host& host)
+    {
+        return std::invoke(kGuard, host);
+    }
+};
+
+/// The branch that is taken when no other one is (list it last)
+template <typename Target_>
+struct Else {
+    using Target = Target_;
+
+    template <typename Host>
+    static constexpr bool guard(const Host&)
+    {
+        return true;
+    }
+};
+
+/// A choice pseudo-state:  from within Current::handleEvent, `Choice<Current, ThisState, Branch<...>..., Else<...>>
+/// c(stateMachine);` takes the Transition of the first branch whose guard holds.  Every branch is resolved at compile
+/// time into its own Transition instantiation, so evaluating the choice is a straight-line chain of guard tests
+/// rather than a dispatch of some synthetic event.
+///
+/// Guards are evaluated before any exit action runs (i.e., with junction semantics), so they see the machine as it
+/// was when the event arrived.  taken() tells whether any branch was taken.
+template <typename Current, typename Source, typename... Branches>
+struct Choice {
+    using Host = typename Current::Host;
+
+    static_assert(sizeof...(Branches) > 0, "A Choice needs at least one branch");
+
+    Choice(Host& host) : mTaken{(take<Branches>(host) || ...)} {}
+
+    bool taken() const { return mTaken; }
+
+private:
+    template <typename B>
+    static bool take(Host& host)
+    {
+        if (B::guard(static_cast<const Host&>(host)))
+        {
+            Transition<Current, Source, typename B::Target> t(host);
+            return true;
+        }
+        return false;
+    }
+
+    bool mTaken;
+};
+
 template <typename Target>
 struct Init {
     using Host = typename Target::Host;
@@ -371,6 +667,152 @@ struct Init {
     Host& mHost;
 };
 
+/// Runs exit actions from State up through Top.  Unlike Transition, this does not stop at a least common ancestor.
+template <typename State>
+struct ExitChain {
+    static void run(typename State::Host& host)
+    {
+        State::exit(host);
+        if constexpr (!std::is_same_v<typename State::ParentState, State>)
+        {
+            ExitChain<typename State::ParentState>::run(host);
+        }
+    }
+};
+
+/// Walks the ancestry of a leaf to resume it (or the branch that contains it) as the history of one of its ancestors
+template <typename State>
+struct HistoryChain {
+    using Host = typename State::Host;
+    using StateEnum = std::remove_const_t<decltype(State::kState)>;
+    static constexpr bool kIsTop = std::is_same_v<typename State::ParentState, State>;
+
+    /// Run the entry actions of every state strictly below `ancestor` down to (and including) State, outermost first
+    static bool enterBelow(Host& host, StateEnum ancestor)
+    {
+        if constexpr (kIsTop)
+        {
+            return false;  // `ancestor` is not an ancestor after all
+        }
+        else
+        {
+            using Parent = typename State::ParentState;
+            if (Parent::kState != ancestor && !HistoryChain<Parent>::enterBelow(host, ancestor))
+            {
+                return false;
+            }
+            State::entry(host);
+            return true;
+        }
+    }
+
+    /// Enter the child of `ancestor` that contains State and follow that child's default initial transitions
+    static bool enterChildOf(Host& host, StateEnum ancestor)
+    {
+        if constexpr (kIsTop)
+        {
+            return false;
+        }
+        else
+        {
+            using Parent = typename State::ParentState;
+            if (Parent::kState == ancestor)
+            {
+                State::entry(host);
+                State::init(host);
+                return true;
+            }
+            return HistoryChain<Parent>::enterChildOf(host, ancestor);
+        }
+    }
+};
+
+/// History pseudo-states.  Use ShallowHistory<Comp> or DeepHistory<Comp> as the target of a Transition (or an Init)
+/// to re-enter Comp where it left off rather than via its default init():
+///   - DeepHistory resumes the leaf that was active when Comp was last exited, running the entry actions of the states
+///     in between but skipping the init() chain entirely.
+///   - ShallowHistory resumes the child of Comp that was active when Comp was last exited, and then follows that
+///     child's default init() chain.
+/// If Comp has never been exited (or the history has been cleared), both fall back to Comp's default init().
+///
+/// History is only recorded for machines whose traits declare `kHistoryStates` (the number of StateEnum values).  It
+/// is stored as one leaf pointer per state in an array indexed by StateEnum, so both recording (on exit) and
+/// restoring are O(1) in the number of states.
+template <typename Comp, HistoryKind kKind>
+struct History : Comp {
+    template <typename Current, typename Source, typename Target, Semantics>
+    friend class Transition;
+    template <typename Target>
+    friend class Init;
+
+private:
+    static void init(typename Comp::Host& host)
+    {
+        static_assert(Comp::Host::kHistoryStates > 0, "History requires kHistoryStates in the StateMachineTraits");
+        const auto* leaf = host.historyLeaf(Comp::kState);
+        if (leaf == nullptr)
+        {
+            Comp::init(host);
+        }
+        else if constexpr (kKind == HistoryKind::eDeep)
+        {
+            leaf->restoreDeepHistory(host, Comp::kState);
+        }
+        else
+        {
+            leaf->restoreShallowHistory(host, Comp::kState);
+        }
+    }
+};
+
+template <typename Comp>
+using ShallowHistory = History<Comp, HistoryKind::eShallow>;
+template <typename Comp>
+using DeepHistory = History<Comp, HistoryKind::eDeep>;
+
+namespace detail {
+
+/// Optional traits default to "off" so that existing StateMachineTraits keep compiling unchanged
+template <typename Traits, typename = void>
+struct HistoryStates : std::integral_constant<size_t, 0> {};
+template <typename Traits>
+struct HistoryStates<Traits, std::void_t<decltype(Traits::kHistoryStates)>>
+    : std::integral_constant<size_t, Traits::kHistoryStates> {};
+
+template <typename Traits, typename = void>
+struct InternalQueueCapacity : std::integral_constant<size_t, 0> {};
+template <typename Traits>
+struct InternalQueueCapacity<Traits, std::void_t<decltype(Traits::kInternalQueueCapacity)>>
+    : std::integral_constant<size_t, Traits::kInternalQueueCapacity> {};
+
+template <typename Traits, typename = void>
+struct CoroutineActions : std::false_type {};
+template <typename Traits>
+struct CoroutineActions<Traits, std::void_t<decltype(Traits::kCoroutineActions)>>
+    : std::bool_constant<Traits::kCoroutineActions> {};
+
+template <typename Traits, typename = void>
+struct MaxInternalSteps : std::integral_constant<size_t, 4 * InternalQueueCapacity<Traits>::value> {};
+template <typename Traits>
+struct MaxInternalSteps<Traits, std::void_t<decltype(Traits::kMaxInternalSteps)>>
+    : std::integral_constant<size_t, Traits::kMaxInternalSteps> {};
+
+template <typename Traits, typename = void>
+struct TraceStates : std::false_type {};
+template <typename Traits>
+struct TraceStates<Traits, std::void_t<decltype(Traits::kTraceStates)>> : std::bool_constant<Traits::kTraceStates> {};
+
+template <typename Traits, typename = void>
+struct MaxCompletionSteps : std::integral_constant<size_t, 16> {};
+template <typename Traits>
+struct MaxCompletionSteps<Traits, std::void_t<decltype(Traits::kMaxCompletionSteps)>>
+    : std::integral_constant<size_t, Traits::kMaxCompletionSteps> {};
+
+/// Stand-in for the internal event queue of machines that do not have one
+struct NoEventQueue {};
+
+}  // namespace detail
+
 template <typename Host_, typename StateEnum_, StateEnum_ kState_>
 struct StateTraits {
     using Host = Host_;
@@ -393,43 +835,295 @@ struct StateMachineTraits {
     static constexpr bool kClearTimersOnExit = false;  // could make default once all state machines support it
 };
 
+/// Limits on how much work a single StateMachine::drain() may do.  The defaults are unlimited, so that only the
+/// limit(s) that are set matter.
+template <typename Clock>
+struct DrainBudget {
+    size_t maxEvents{std::numeric_limits<size_t>::max()};
+    typename Clock::duration maxTime{Clock::duration::max()};
+};
+
+/// What a StateMachine::drain() got done
+template <typename Clock>
+struct DrainStats {
+    size_t dispatched{0};                // events taken from the bucket and dispatched
+    size_t remaining{0};                 // events still in the bucket when drain() returned
+    typename Clock::duration elapsed{};  // time spent, as measured by the Clock
+
+    /// Did the bucket empty before the budget ran out?
+    bool drained() const { return remaining == 0; }
+};
+
 template <typename SM, typename StateMachineTraits>
 class StateMachine {
 public:
     StateMachine() {}
     virtual ~StateMachine(){};
 
+    /// Machines can be copied, e.g. to run "what if" sequences of events on clones (see Speculator).  The current
+    /// state and history only point at the static leaf instances, which are shared by every machine, so a copy is in
+    /// the same state as the original without running any entry actions, and copying the machine itself never
+    /// allocates.  Members of the host are copied by the host's own copy constructor.
+    StateMachine(const StateMachine&) = default;
+    StateMachine& operator=(const StateMachine&) = default;
+
     /// Expose type of Event so that derived classes can see it
     using Event = typename StateMachineTraits::Event;
     using StateEnum = typename StateMachineTraits::StateEnum;
     // using StateTransition = typename StateMachineTraits::StateTransition;
     static constexpr DefaultActions kDefaultActions = StateMachineTraits::kDefaultActions;
     static constexpr bool kClearTimersOnExit = StateMachineTraits::kClearTimersOnExit;
+    static constexpr size_t kHistoryStates = detail::HistoryStates<StateMachineTraits>::value;
+    static constexpr size_t kInternalQueueCapacity = detail::InternalQueueCapacity<StateMachineTraits>::value;
+    static constexpr size_t kMaxInternalSteps = detail::MaxInternalSteps<StateMachineTraits>::value;
+    static constexpr size_t kMaxCompletionSteps = detail::MaxCompletionSteps<StateMachineTraits>::value;
+    static constexpr size_t kDeferredQueueCapacity = detail::DeferredQueueCapacity<StateMachineTraits>::value;
+    static constexpr bool kCoroutineActions = detail::CoroutineActions<StateMachineTraits>::value;
+    static constexpr bool kTraceStates = detail::TraceStates<StateMachineTraits>::value;  // see utils::StateTracer
 
     /// Dispatch (step) state machine directly with a named utils.
-    virtual void dispatch(Event evt) { mState->eventHandler(*static_cast<SM*>(this), evt); }
+    /// Any events raised (see raise) while handling it are processed before this returns, and so are any deferred
+    /// events (see Defer) that the state reached no longer defers.
+    /// With kCoroutineActions, an event that suspended coroutine actions are waiting for resumes them instead (see
+    /// Coroutine.hpp).
+    virtual void dispatch(Event evt)
+    {
+        const StatePtr previous = mState;
+        step(std::move(evt));
+        runToCompletion();
+        recallDeferred(previous);
+    }
 
     /// Kick off during action for current state
-    void during() { mState->during(*static_cast<SM*>(this)); }
+    void during()
+    {
+        const StatePtr previous = mState;
+        mState->during(*static_cast<SM*>(this));
+        runToCompletion();
+        recallDeferred(previous);
+    }
 
     // has to be templatized as SM is not resolved yet so cannot lift Input type
     template <typename Input>
     void during(const Input& input)
     {
+        const StatePtr previous = mState;
         mState->during(*static_cast<SM*>(this), input);
+        runToCompletion();
+        recallDeferred(previous);
     }
 
+    /// Dispatch events from `bucket` until it is empty, `budget.maxEvents` have been dispatched, or `budget.maxTime`
+    /// has elapsed on `clock` (checked before each event, so a single slow event can overrun the deadline, but no new
+    /// event is started after it).  This replaces the "one event per update" pattern, which lets a backlog build up
+    /// under bursts, while still bounding the latency of an update.
+    ///
+    /// Works with any of the utils event buckets (anything with empty(), size(), and getEvent()).  The clock defaults
+    /// to the Clock of the StateMachineTraits; pass one explicitly for clocks with a non-static now() such as FakeClock.
+    template <typename Bucket, typename Clock = typename StateMachineTraits::Clock>
+    DrainStats<Clock> drain(Bucket& bucket, const DrainBudget<Clock>& budget, const Clock& clock = Clock{})
+    {
+        DrainStats<Clock> stats{};
+        const auto start = clock.now();
+        while (!bucket.empty() && stats.dispatched < budget.maxEvents)
+        {
+            stats.elapsed = clock.now() - start;
+            if (stats.elapsed >= budget.maxTime)
+            {
+                break;
+            }
+            dispatch(bucket.getEvent());
+            ++stats.dispatched;
+        }
+        stats.elapsed = clock.now() - start;
+        stats.remaining = bucket.size();
+        return stats;
+    }
+
+    /// Raise an internal event from within an action (handleEvent, entry, exit, or during).  Internal events are
+    /// dispatched as soon as the current dispatch (or during) has finished, in the order they were raised and ahead of
+    /// anything still waiting in an external event bucket, so that a machine reacts to its own events within the
+    /// same step instead of one update later.
+    ///
+    /// Requires kInternalQueueCapacity in the StateMachineTraits.  The queue is a fixed-size ring, so raising is
+    /// allocation-free; events raised while it is full are dropped, as are events still queued after kMaxInternalSteps
+    /// internal events in a row (which guards against two states raising events at each other forever).  Either way,
+    /// they are counted in droppedInternalEvents().
+    void raise(Event evt)
+    {
+        static_assert(kInternalQueueCapacity > 0, "raise() requires kInternalQueueCapacity in the StateMachineTraits");
+        mInternalEvents.addEvent(std::move(evt));
+    }
+
+    /// Number of internal events that were dropped because the queue was full or the step limit was reached
+    uint64_t droppedInternalEvents() const
+    {
+        if constexpr (kInternalQueueCapacity > 0)
+        {
+            return mInternalEvents.overflows() + mInternalEventsOverLimit;
+        }
+        else
+        {
+            return 0;
+        }
+    }
+
+    /// Number of completion transitions that were not taken because kMaxCompletionSteps had been reached
+    uint64_t droppedCompletions() const { return mCompletionsOverLimit; }
+
+    /// Number of deferred events currently parked, waiting for a state that does not defer them
+    size_t deferredEvents() const
+    {
+        if constexpr (kDeferredQueueCapacity > 0)
+        {
+            return mDeferredEvents.size();
+        }
+        else
+        {
+            return 0;
+        }
+    }
+
+    /// Number of deferred events that were dropped because the deferred queue was full
+    uint64_t droppedDeferredEvents() const
+    {
+        if constexpr (kDeferredQueueCapacity > 0)
+        {
+            return mDeferredEvents.overflows();
+        }
+        else
+        {
+            return 0;
+        }
+    }
+
+    /// Forget all parked deferred events
+    void clearDeferredEvents()
+    {
+        if constexpr (kDeferredQueueCapacity > 0)
+        {
+            mDeferredEvents.clear();
+        }
+    }
+
+    /// Enter Top and follow the init chain down to the initial leaf, like the "Transition<Top, Top, Top>" that most
+    /// machines run in their constructors (but without also running Top's exit action first).  Only needed when a
+    /// machine is started (or restarted after stop) by something else, e.g. by the state that holds it as a Submachine.
+    void start()
+    {
+        using Top = TopState<StateTraits<SM, StateEnum, StateEnum::eTop>>;
+        Init<Top> i(*static_cast<SM*>(this));
+    }
+
+    /// Run the exit actions of the current leaf and every one of its ancestors, leaving the machine without a current
+    /// state.  The machine must not be dispatched again until start() has been called.
+    void stop()
+    {
+        if (mState)
+        {
+            mState->exitAll(*static_cast<SM*>(this));
+            mState = nullptr;
+        }
+    }
+
+    /// Has the machine been started (and not stopped since)?
+    bool started() const { return mState != nullptr; }
+
     /// Identify current state with a run-time usable enum
     /// Not intended for use in non-test code
     StateEnum identify() const { return mState->identify(); }
 
+    /// Is the machine currently in `Leaf`?  A single pointer comparison (no virtual call), for use on hot paths.
+    template <typename Leaf>
+    bool isIn() const
+    {
+        return mState == &Leaf::instanceForTestingOnly();
+    }
+
     /// Test for current state membership of some parent super-state (including itself)
     /// Definitely not intended for use in non-test code
     bool isInSubstateOf(StateEnum queryState) const { return mState->isSubstateOf(queryState); }
 
+    /// Number of transitions (including initial ones) that have settled in a leaf since the machine was created
+    uint64_t transitions() const { return mTransitions; }
+
+    /// The leaf that was active when `composite` was last exited (Top if there is no history)
+    StateEnum history(StateEnum composite) const
+    {
+        const auto* leaf = historyLeaf(composite);
+        return leaf ? leaf->identify() : StateEnum::eTop;
+    }
+
+    /// Forget all history, so that History pseudo-states fall back to default init() until states are exited again
+    void clearHistory() { mHistory.fill(nullptr); }
+
+    /// The run-time state of the machine itself as plain data:  the current leaf, the history of each composite state
+    /// (eTop where there is none), and any parked deferred events.  Timers, buckets and the like belong to the host,
+    /// which snapshots them alongside (see TimerBank::snapshot, StaticEventBucket::snapshot, TimeTracker::snapshot).
+    struct Snapshot {
+        StateEnum state{StateEnum::eTop};
+        std::array<StateEnum, kHistoryStates> history{};
+        utils::EventBucketSnapshot<Event, kDeferredQueueCapacity> deferred{};
+    };
+
+    /// Capture the machine's run-time state, e.g. to checkpoint it for a hot standby
+    Snapshot snapshot() const
+    {
+        Snapshot snap{};
+        snap.state = identify();
+        for (size_t i = 0; i < kHistoryStates; ++i)
+        {
+            snap.history[i] = mHistory[i] ? mHistory[i]->identify() : StateEnum::eTop;
+        }
+        if constexpr (kDeferredQueueCapacity > 0)
+        {
+            snap.deferred = mDeferredEvents.snapshot();
+        }
+        return snap;
+    }
+
+    /// Put the machine back into the run-time state captured by snapshot(), WITHOUT running any entry or exit actions
+    /// (the host's own state, e.g. its timers, is expected to be restored alongside).  Table maps StateEnum values to
+    /// leaf states; see StateTable.  Returns false, leaving the machine as it was, if `snap` names anything other than
+    /// leaves of this machine.
+    template <typename Table>
+    bool restore(const Snapshot& snap)
+    {
+        const StatePtr leaf = Table::leaf(snap.state);
+        if (!leaf)
+        {
+            return false;
+        }
+        std::array<StatePtr, kHistoryStates> history{};
+        for (size_t i = 0; i < kHistoryStates; ++i)
+        {
+            if (snap.history[i] != StateEnum::eTop && !(history[i] = Table::leaf(snap.history[i])))
+            {
+                return false;
+            }
+        }
+        mState = leaf;
+        mHistory = history;
+        if constexpr (kInternalQueueCapacity > 0)
+        {
+            mInternalEvents.clear();
+        }
+        if constexpr (kDeferredQueueCapacity > 0)
+        {
+            mDeferredEvents.restore(snap.deferred);
+        }
+        return true;
+    }
+
     /// Friend the LeafState so that it can access `next` below without exposing it to the world
     template <typename Traits, typename Parent>
     friend struct LeafState;
+    template <typename Traits, typename Parent>
+    friend struct CompState;
+    template <typename Comp, HistoryKind kKind>
+    friend struct History;
+    template <typename... Branches>
+    friend struct CompletionBranches;
 
     /// Expose direct setting of state for testing and simmulation only.
     /// WARNING: This BYPASSES entry and exit methods
@@ -439,10 +1133,140 @@ public:
         mState = &State::instanceForTestingOnly();
     }
 
+    /// Run-time counterpart of the above, for a leaf looked up in a table (see StateTable)
+    /// WARNING: This BYPASSES entry and exit methods
+    void directlySetStateForTestingOnly(const eta_hsm::TopState<StateTraits<SM, StateEnum, StateEnum::eTop>>& leaf)
+    {
+        mState = &leaf;
+    }
+
 protected:
     /// States use this function to set the next (current) state of the state machine
-    virtual void next(const eta_hsm::TopState<StateTraits<SM, StateEnum, StateEnum::eTop>>& state) { mState = &state; }
+    virtual void next(const eta_hsm::TopState<StateTraits<SM, StateEnum, StateEnum::eTop>>& state)
+    {
+        mState = &state;
+        ++mTransitions;
+    }
     const eta_hsm::TopState<StateTraits<SM, StateEnum, StateEnum::eTop>>* mState{};
+    uint64_t mTransitions{0};
+
+    /// The (id of the) event the current state is handling, whether it was dispatched, raised or recalled from
+    /// deferral, or nothing outside of an event handler (e.g. for transitions taken by during() or on start)
+    using EventId = std::decay_t<decltype(detail::eventId(std::declval<const Event&>()))>;
+    std::optional<EventId> handlingEvent() const { return mHandlingEvent; }
+
+private:
+    using StatePtr = const eta_hsm::TopState<StateTraits<SM, StateEnum, StateEnum::eTop>>*;
+
+    /// Hand an event to the coroutine actions waiting for it, if there are any, and otherwise to the current state,
+    /// unless it defers the event, in which case it is parked for later.  Dispatched, raised and recalled events all
+    /// come through here.
+    void step(Event&& evt)
+    {
+        if (resumeCoroutines(evt))
+        {
+            return;
+        }
+        if constexpr (kDeferredQueueCapacity > 0)
+        {
+            if (mState->defers(evt))
+            {
+                mDeferredEvents.addEvent(std::move(evt));
+                return;
+            }
+        }
+        const std::optional<EventId> outer = std::exchange(mHandlingEvent, detail::eventId(evt));
+        mState->eventHandler(*static_cast<SM*>(this), evt);
+        mHandlingEvent = outer;
+    }
+
+    /// Hand `evt` to the coroutine actions waiting for it, if there are any
+    bool resumeCoroutines(const Event& evt)
+    {
+        if constexpr (kCoroutineActions)
+        {
+            return static_cast<SM*>(this)->coroutines().resume(evt);
+        }
+        else
+        {
+            return false;
+        }
+    }
+
+    /// Dispatch internal events until there are none left (or the step limit is hit)
+    void runToCompletion()
+    {
+        if constexpr (kInternalQueueCapacity > 0)
+        {
+            size_t steps = 0;
+            while (!mInternalEvents.empty())
+            {
+                if (steps++ == kMaxInternalSteps)
+                {
+                    mInternalEventsOverLimit += mInternalEvents.size();
+                    mInternalEvents.clear();
+                    return;
+                }
+                step(mInternalEvents.getEvent());
+            }
+        }
+    }
+
+    /// Which events are deferred depends only on the current leaf, so parked events only need another look when the
+    /// state has changed.  Each pass goes once through the events that were parked at its start, in order, so
+    /// deferred events keep their relative order.  Passes repeat while recalled events keep changing the state, up to
+    /// a limit that guards against states that re-raise the events they are handed.
+    void recallDeferred(StatePtr previous)
+    {
+        if constexpr (kDeferredQueueCapacity > 0)
+        {
+            for (size_t pass = 0; pass <= kDeferredQueueCapacity && mState != previous && !mDeferredEvents.empty();
+                 ++pass)
+            {
+                previous = mState;
+                for (size_t pending = mDeferredEvents.size(); pending > 0; --pending)
+                {
+                    step(mDeferredEvents.getEvent());
+                    runToCompletion();
+                }
+            }
+        }
+    }
+
+    /// Composite states record the active leaf here as they are exited
+    void rememberHistory(StateEnum composite) { mHistory[static_cast<size_t>(composite)] = mState; }
+
+    StatePtr historyLeaf(StateEnum composite) const
+    {
+        if constexpr (kHistoryStates > 0)
+        {
+            return mHistory[static_cast<size_t>(composite)];
+        }
+        else
+        {
+            return nullptr;
+        }
+    }
+
+    /// Last active leaf of each composite state, indexed by StateEnum (empty unless kHistoryStates is declared)
+    std::array<StatePtr, kHistoryStates> mHistory{};
+
+    /// Events raised by actions, waiting to be processed within the current step
+    std::conditional_t<(kInternalQueueCapacity > 0), utils::StaticEventBucket<Event, kInternalQueueCapacity>,
+                       detail::NoEventQueue>
+        mInternalEvents{};
+    uint64_t mInternalEventsOverLimit{0};
+
+    /// Completion transitions currently nested within each other, and those cut off by kMaxCompletionSteps
+    size_t mCompletionDepth{0};
+    uint64_t mCompletionsOverLimit{0};
+
+    std::optional<EventId> mHandlingEvent{};
+
+    /// Events deferred by the states they arrived in, oldest first
+    std::conditional_t<(kDeferredQueueCapacity > 0), utils::StaticEventBucket<Event, kDeferredQueueCapacity>,
+                       detail::NoEventQueue>
+        mDeferredEvents{};
 };
 
 }  // namespace eta_hsm
@@ -0,0 +1,319 @@
+// eta/hsm/HsmTestRunner.hpp
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <istream>
+#include <map>
+#include <ostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "Hsm.hpp"
+#include "StateTable.hpp"
+#include "utils/ForkJoinPool.hpp"
+#include "utils/TestLog.hpp"
+#include "wise_enum/wise_enum.h"
+
+namespace eta_hsm {
+namespace testing {
+
+/// What one event does to a machine that is sitting in one leaf
+template <typename SM>
+struct ConformanceCell {
+    typename SM::StateEnum from;
+    typename SM::Event event;
+    typename SM::StateEnum to;  // the leaf the machine ends up in
+    uint64_t transitions;       // transitions taken on the way (see StateMachine::transitions)
+    std::string trace;          // everything the machine logged to TestLog while handling the event
+
+    bool operator==(const ConformanceCell& other) const
+    {
+        return from == other.from && event == other.event && to == other.to && transitions == other.transitions &&
+               trace == other.trace;
+    }
+    bool operator!=(const ConformanceCell& other) const { return !(*this == other); }
+};
+
+namespace detail {
+
+/// Enums are written by name if they are wise_enums, and by value otherwise (e.g. state enums with more values than
+/// wise_enum supports)
+template <typename Enum>
+std::string enumToString(Enum value)
+{
+    if constexpr (wise_enum::is_wise_enum_v<Enum>)
+    {
+        return std::string{wise_enum::to_string(value)};
+    }
+    else
+    {
+        return std::to_string(static_cast<long long>(value));
+    }
+}
+
+template <typename Enum>
+Enum enumFromString(const std::string& text)
+{
+    if constexpr (wise_enum::is_wise_enum_v<Enum>)
+    {
+        if (const auto value = wise_enum::from_string<Enum>(text))
+        {
+            return *value;
+        }
+        throw std::runtime_error("unknown enumerator '" + text + "'");
+    }
+    else
+    {
+        return static_cast<Enum>(std::stoll(text));
+    }
+}
+
+/// Traces may hold anything, so tabs, newlines and backslashes are escaped to keep one cell per line
+inline std::string escapeTrace(std::string_view trace)
+{
+    std::string escaped;
+    escaped.reserve(trace.size());
+    for (const char c : trace)
+    {
+        switch (c)
+        {
+            case '\\':
+                escaped += "\\\\";
+                break;
+            case '\t':
+                escaped += "\\t";
+                break;
+            case '\n':
+                escaped += "\\n";
+                break;
+            default:
+                escaped += c;
+        }
+    }
+    return escaped;
+}
+
+inline std::string unescapeTrace(std::string_view escaped)
+{
+    std::string trace;
+    trace.reserve(escaped.size());
+    for (size_t idx = 0; idx < escaped.size(); ++idx)
+    {
+        if (escaped[idx] != '\\' || idx + 1 == escaped.size())
+        {
+            trace += escaped[idx];
+            continue;
+        }
+        const char next = escaped[++idx];
+        trace += next == 't' ? '\t' : next == 'n' ? '\n' : next;
+    }
+    return trace;
+}
+
+}  // namespace detail
+
+/// Runs every event in every leaf of a machine and records what happens (see ConformanceCell), for comparison with a
+/// golden table.  This replaces hand-written (state, event) scenarios:  nothing a machine does in any leaf can change
+/// without the table noticing.
+///
+/// Leaves come from the machine's StateTable (`Table`, see ETA_HSM_REGISTER_STATE) and, by default, events from
+/// wise_enum.  Each cell starts from a copy of `prototype` that is put directly into the leaf, so no entry actions
+/// are run to get there (and, as with directlySetStateForTestingOnly, composite states' init() is not either).  The
+/// cells are spread over a ForkJoinPool; each capture goes into the TestLog shard of the thread that runs the cell.
+template <typename SM, typename Table>
+class ConformanceRunner {
+public:
+    using Event = typename SM::Event;
+    using StateEnum = typename SM::StateEnum;
+    using Cell = ConformanceCell<SM>;
+
+    ConformanceRunner(utils::ForkJoinPool& pool, const SM& prototype) : mPool{pool}, mPrototype{prototype} {}
+
+    /// Every registered leaf, in StateEnum order
+    static std::vector<StateEnum> leaves()
+    {
+        std::vector<StateEnum> leaves;
+        for (size_t idx = 0; idx < Table::size(); ++idx)
+        {
+            if (Table::isLeaf(static_cast<StateEnum>(idx)))
+            {
+                leaves.push_back(static_cast<StateEnum>(idx));
+            }
+        }
+        return leaves;
+    }
+
+    /// Every leaf x every Event (which has to be a wise_enum), ordered by leaf and then by event
+    std::vector<Cell> run()
+    {
+        static_assert(wise_enum::is_wise_enum_v<Event>, "Pass the events to run() explicitly");
+        std::vector<Event> events;
+        for (const auto& event : wise_enum::range<Event>)
+        {
+            events.push_back(event.value);
+        }
+        return run(events);
+    }
+
+    /// Every leaf x every event in `events`, ordered by leaf and then by event
+    std::vector<Cell> run(const std::vector<Event>& events)
+    {
+        const std::vector<StateEnum> from = leaves();
+        std::vector<Cell> cells(from.size() * events.size());
+        mPool.run(cells.size(), [&](size_t idx) {
+            Cell& cell = cells[idx];
+            cell.from = from[idx / events.size()];
+            cell.event = events[idx % events.size()];
+
+            SM clone(mPrototype);
+            Table::setState(clone, cell.from);
+            const uint64_t before = clone.transitions();
+            utils::TestLog::instance().startCapture();
+            clone.dispatch(cell.event);
+            utils::TestLog::instance().stopCapture();
+            cell.to = clone.identify();
+            cell.transitions = clone.transitions() - before;
+            cell.trace = utils::TestLog::instance().getCaptured();
+        });
+        return cells;
+    }
+
+protected:
+private:
+    utils::ForkJoinPool& mPool;
+    const SM& mPrototype;
+};
+
+/// Write `cells` as a golden table:  one tab separated line per cell of from, event, to, transitions and trace
+template <typename SM>
+void writeConformance(std::ostream& os, const std::vector<ConformanceCell<SM>>& cells)
+{
+    os << "# from\tevent\tto\ttransitions\ttrace\n";
+    for (const auto& cell : cells)
+    {
+        os << detail::enumToString(cell.from) << '\t' << detail::enumToString(cell.event) << '\t'
+           << detail::enumToString(cell.to) << '\t' << cell.transitions << '\t' << detail::escapeTrace(cell.trace)
+           << '\n';
+    }
+}
+
+/// Read a golden table written by writeConformance().  Blank lines and lines starting with '#' are skipped; anything
+/// else that does not parse throws std::runtime_error.
+template <typename SM>
+std::vector<ConformanceCell<SM>> readConformance(std::istream& is)
+{
+    std::vector<ConformanceCell<SM>> cells;
+    std::string line;
+    size_t lineNumber = 0;
+    while (std::getline(is, line))
+    {
+        ++lineNumber;
+        if (line.empty() || line[0] == '#')
+        {
+            continue;
+        }
+        std::vector<std::string> fields;
+        std::istringstream fieldStream{line};
+        std::string field;
+        while (fields.size() < 4 && std::getline(fieldStream, field, '\t'))
+        {
+            fields.push_back(field);
+        }
+        std::getline(fieldStream, field);
+        if (fields.size() != 4)
+        {
+            throw std::runtime_error("golden table line " + std::to_string(lineNumber) + " has too few fields");
+        }
+        try
+        {
+            cells.push_back({detail::enumFromString<typename SM::StateEnum>(fields[0]),
+                             detail::enumFromString<typename SM::Event>(fields[1]),
+                             detail::enumFromString<typename SM::StateEnum>(fields[2]), std::stoull(fields[3]),
+                             detail::unescapeTrace(fieldStream ? field : std::string{})});
+        }
+        catch (const std::exception& error)
+        {
+            throw std::runtime_error("golden table line " + std::to_string(lineNumber) + ": " + error.what());
+        }
+    }
+    return cells;
+}
+
+/// Every difference between `golden` and `actual`, described one per string (so none means they agree).  Cells are
+/// matched up by (from, event), so neither needs to be in any particular order.
+template <typename SM>
+std::vector<std::string> compareConformance(const std::vector<ConformanceCell<SM>>& golden,
+                                            const std::vector<ConformanceCell<SM>>& actual)
+{
+    using Cell = ConformanceCell<SM>;
+    const auto key = [](const Cell& cell) {
+        return std::make_pair(static_cast<long long>(cell.from), static_cast<long long>(cell.event));
+    };
+    const auto describe = [](const Cell& cell) {
+        return detail::enumToString(cell.to) + " after " + std::to_string(cell.transitions) + " transition(s), \"" +
+               detail::escapeTrace(cell.trace) + "\"";
+    };
+    const auto where = [](const Cell& cell) {
+        return detail::enumToString(cell.from) + " + " + detail::enumToString(cell.event) + ": ";
+    };
+
+    std::map<std::pair<long long, long long>, const Cell*> expected;
+    for (const Cell& cell : golden)
+    {
+        expected[key(cell)] = &cell;
+    }
+    std::vector<std::string> differences;
+    for (const Cell& cell : actual)
+    {
+        const auto found = expected.find(key(cell));
+        if (found == expected.end())
+        {
+            differences.push_back(where(cell) + "not in the golden table, got " + describe(cell));
+            continue;
+        }
+        if (*found->second != cell)
+        {
+            differences.push_back(where(cell) + "expected " + describe(*found->second) + ", got " + describe(cell));
+        }
+        expected.erase(found);
+    }
+    for (const auto& [_, cell] : expected)
+    {
+        differences.push_back(where(*cell) + "in the golden table, but was not run");
+    }
+    return differences;
+}
+
+/// Compare `actual` with the golden table in the file at `path`.  If the environment variable ETA_HSM_UPDATE_GOLDEN
+/// is set, the file is (re)written from `actual` instead, so that intended changes are a rerun and a diff away.
+template <typename SM>
+std::vector<std::string> checkGolden(const std::string& path, const std::vector<ConformanceCell<SM>>& actual)
+{
+    if (std::getenv("ETA_HSM_UPDATE_GOLDEN"))
+    {
+        std::ofstream output{path};
+        writeConformance(output, actual);
+        if (!output)
+        {
+            throw std::runtime_error("could not write golden table " + path);
+        }
+        return {};
+    }
+    std::ifstream input{path};
+    if (!input)
+    {
+        throw std::runtime_error("could not read golden table " + path + " (set ETA_HSM_UPDATE_GOLDEN to create it)");
+    }
+    return compareConformance(readConformance<SM>(input), actual);
+}
+
+}  // namespace testing
+}  // namespace eta_hsm
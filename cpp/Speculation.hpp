@@ -0,0 +1,75 @@
+// eta/hsm/Speculation.hpp
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "Hsm.hpp"
+#include "utils/ForkJoinPool.hpp"
+
+namespace eta_hsm {
+
+/// Where a clone of a machine ended up after a speculative run (see Speculator)
+template <typename StateEnum>
+struct SpeculativeOutcome {
+    StateEnum state;        // the leaf the clone settled in
+    uint64_t transitions;   // transitions the clone took on the way
+    size_t dispatched;      // events dispatched to the clone
+};
+
+/// Answers "if these events arrived, where would the machine end up?" for a batch of event sequences at once, without
+/// touching the live machine:  every sequence is dispatched to its own copy of the live machine, and the copies are
+/// run in parallel on a ForkJoinPool.
+///
+/// Copying a machine is cheap (see StateMachine's copy constructor), but entry and exit actions run on the clones as
+/// usual, so the host's copy constructor must leave a clone with nothing that reaches outside of it (e.g. loggers,
+/// shared event buckets or outputs).  Clones live on the stack of the thread that runs them; the host's members are
+/// the only thing that may allocate.
+template <typename SM>
+class Speculator {
+public:
+    using Event = typename SM::Event;
+    using StateEnum = typename SM::StateEnum;
+    using Outcome = SpeculativeOutcome<StateEnum>;
+
+    explicit Speculator(utils::ForkJoinPool& pool) : mPool{pool} {}
+
+    /// Run every sequence in `sequences` (each an iterable of events) on a clone of `live`, writing the outcome of
+    /// sequences[idx] to outcomes[idx].  `outcomes` is resized only if it is too small, so it can be reused.
+    template <typename Sequences>
+    void run(const SM& live, const Sequences& sequences, std::vector<Outcome>& outcomes)
+    {
+        if (outcomes.size() < sequences.size())
+        {
+            outcomes.resize(sequences.size(), Outcome{StateEnum::eTop, 0, 0});
+        }
+        const uint64_t before = live.transitions();
+        mPool.run(sequences.size(), [&](size_t idx) {
+            SM clone(live);
+            size_t dispatched = 0;
+            for (const auto& evt : sequences[idx])
+            {
+                clone.dispatch(evt);
+                ++dispatched;
+            }
+            outcomes[idx] = {clone.identify(), clone.transitions() - before, dispatched};
+        });
+    }
+
+    /// Convenience version of the above that returns a new vector of outcomes
+    template <typename Sequences>
+    std::vector<Outcome> run(const SM& live, const Sequences& sequences)
+    {
+        std::vector<Outcome> outcomes;
+        run(live, sequences, outcomes);
+        return outcomes;
+    }
+
+protected:
+private:
+    utils::ForkJoinPool& mPool;
+};
+
+}  // namespace eta_hsm
@@ -0,0 +1,128 @@
+// eta/hsm/StateTable.hpp
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+
+#include "Hsm.hpp"
+
+namespace eta_hsm {
+
+/// Associate a StateEnum value with the type of the state that it names, so that StateTable can find it.  This only
+/// declares a function (it is never called or defined), which lets it be used in whatever namespace the state types
+/// are declared in; the state declaration macros (see macros/HsmMacros.hpp) do it for every state they declare.
+#define ETA_HSM_REGISTER_STATE(controller, name, state_enum) \
+    name* stateTypeTag(controller*, std::integral_constant<state_enum, state_enum::e##name>)
+
+/// Fallback for StateEnum values that were never registered
+void stateTypeTag(...);
+
+namespace detail {
+
+template <typename T>
+struct IsLeafState : std::false_type {};
+template <typename Traits, typename Parent>
+struct IsLeafState<LeafState<Traits, Parent>> : std::true_type {};
+
+}  // namespace detail
+
+/// A table, indexed by StateEnum value, of the leaf state instances of Host and of which states are leaves.  It is
+/// generated at compile time from the registered states (see ETA_HSM_REGISTER_STATE), so looking up a state is a
+/// single array access:  no map, no std::function, no allocation, and nothing that depends on the order in which
+/// static objects are initialized.  kStateCount must be larger than every registered StateEnum value.
+///
+/// This is meant for simulation resets and failover restore, where a machine needs to be put back into a leaf that
+/// is only known at run time.  Like directlySetStateForTestingOnly, setState BYPASSES entry and exit actions.
+template <typename Host, size_t kStateCount>
+class StateTable {
+public:
+    using StateEnum = typename Host::StateEnum;
+    using StatePtr = const TopState<StateTraits<Host, StateEnum, StateEnum::eTop>>*;
+
+    /// One more than the largest StateEnum value the table can hold
+    static constexpr size_t size() { return kStateCount; }
+
+    /// Has `state` been registered?
+    static constexpr bool isDeclared(StateEnum state) { return flag(state, kDeclared); }
+
+    /// Is `state` a (registered) leaf state?
+    static constexpr bool isLeaf(StateEnum state) { return flag(state, kLeafFlags); }
+
+    /// The instance of leaf `state`, or nullptr if `state` is not a leaf
+    static StatePtr leaf(StateEnum state)
+    {
+        const auto idx = static_cast<size_t>(state);
+        return idx < kStateCount ? leaves()[idx] : nullptr;
+    }
+
+    /// Put `host` directly into leaf `state` (without running any entry or exit actions).  Returns false, leaving
+    /// `host` as it was, if `state` is not a leaf.
+    static bool setState(Host& host, StateEnum state)
+    {
+        if (StatePtr target = leaf(state))
+        {
+            host.directlySetStateForTestingOnly(*target);
+            return true;
+        }
+        return false;
+    }
+
+protected:
+private:
+    template <size_t kIdx>
+    using StateAt = std::remove_pointer_t<decltype(stateTypeTag(
+        static_cast<Host*>(nullptr), std::integral_constant<StateEnum, static_cast<StateEnum>(kIdx)>{}))>;
+
+    template <size_t... kIdx>
+    static constexpr std::array<bool, kStateCount> declaredFlags(std::index_sequence<kIdx...>)
+    {
+        return {!std::is_void_v<StateAt<kIdx>>...};
+    }
+
+    template <size_t... kIdx>
+    static constexpr std::array<bool, kStateCount> leafFlags(std::index_sequence<kIdx...>)
+    {
+        return {detail::IsLeafState<StateAt<kIdx>>::value...};
+    }
+
+    template <size_t kIdx>
+    static constexpr StatePtr leafAt()
+    {
+        if constexpr (detail::IsLeafState<StateAt<kIdx>>::value)
+        {
+            return StateAt<kIdx>::instance();
+        }
+        else
+        {
+            return nullptr;
+        }
+    }
+
+    /// Built on first use rather than when StateTable is instantiated, so that every state has been declared by then
+    static const std::array<StatePtr, kStateCount>& leaves()
+    {
+        static constexpr std::array<StatePtr, kStateCount> kLeaves =
+            makeLeaves(std::make_index_sequence<kStateCount>{});
+        return kLeaves;
+    }
+
+    template <size_t... kIdx>
+    static constexpr std::array<StatePtr, kStateCount> makeLeaves(std::index_sequence<kIdx...>)
+    {
+        return {leafAt<kIdx>()...};
+    }
+
+    static constexpr bool flag(StateEnum state, const std::array<bool, kStateCount>& flags)
+    {
+        const auto idx = static_cast<size_t>(state);
+        return idx < kStateCount && flags[idx];
+    }
+
+    static constexpr std::array<bool, kStateCount> kDeclared = declaredFlags(std::make_index_sequence<kStateCount>{});
+    static constexpr std::array<bool, kStateCount> kLeafFlags = leafFlags(std::make_index_sequence<kStateCount>{});
+};
+
+}  // namespace eta_hsm
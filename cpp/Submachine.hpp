@@ -0,0 +1,132 @@
+// eta/hsm/Submachine.hpp
+
+#pragma once
+
+#include <utility>
+
+#include "Hsm.hpp"
+
+namespace eta_hsm {
+
+/// Reaching ChildLeaf in a submachine takes the parent machine to ParentTarget (see Forward)
+template <typename ChildLeaf, typename ParentTarget>
+struct OnTerminal {
+    using Leaf = ChildLeaf;
+    using Target = ParentTarget;
+};
+
+/// A whole StateMachine reused as (the inside of) a state of a larger machine.
+///
+/// The child machine is held by value, so its current state, its timers, and its event buckets all live inline in
+/// the parent's memory.  The parent holds the Submachine as a member and ties it into the leaf state that contains it:
+///
+///     template <>
+///     inline void Lift::entry<LiftState::eBoarding>() { mDoor.enter(); }
+///     template <>
+///     inline void Lift::exit<LiftState::eBoarding>() { mDoor.exit(); }
+///     ... and in Boarding::handleEvent():
+///     Forward<Current, ThisState, OnTerminal<door::Shut, Moving>, OnTerminal<door::Jammed, Fault>> f(
+///         stateMachine, stateMachine.mDoor, DoorEvent::eClosed);
+///
+/// so that the child starts from its initial state every time that state is entered, is stopped (running the exit
+/// actions of its active configuration) when it is exited, and its terminal states turn into parent transitions.
+///
+/// Forward only notices terminals that the forwarded event leads to.  A child can also get to one on its own:  from
+/// its during action, from a timer dispatched straight into it, or already on start (when the parent is in the middle
+/// of entering the containing state and cannot transition yet).  Those are picked up by a Forward without an event,
+/// typically from the containing state's during action, right after the child's:
+///
+///     template <>
+///     inline void Boarding::during(Lift& stateMachine, const Input&) const
+///     {
+///         stateMachine.mDoor.during();
+///         Forward<ThisState, ThisState, OnTerminal<door::Shut, Moving>, OnTerminal<door::Jammed, Fault>> f(
+///             stateMachine, stateMachine.mDoor);
+///     }
+///
+/// Child machines that are meant to be embedded should not start themselves in their constructors (the usual
+/// "Transition<Top, Top, Top>"):  the Submachine starts them when the parent enters the containing state.
+template <typename Child>
+class Submachine {
+public:
+    using Machine = Child;
+    using Event = typename Child::Event;
+
+    template <typename... Args>
+    explicit Submachine(Args&&... args) : mChild(std::forward<Args>(args)...)
+    {}
+
+    /// Start the child (from its initial state) unless it is already running
+    void enter()
+    {
+        if (!mChild.started())
+        {
+            mChild.start();
+        }
+    }
+
+    /// Stop the child, running the exit actions of its whole active configuration
+    void exit() { mChild.stop(); }
+
+    /// Dispatch an event to the child.  The call is resolved statically, so there is no extra virtual hop on the way
+    /// into the child beyond its own leaf dispatch.
+    void dispatch(Event evt) { mChild.Child::dispatch(std::move(evt)); }
+
+    /// Kick off the during action of the child's current state
+    template <typename... Input>
+    void during(const Input&... input)
+    {
+        mChild.during(input...);
+    }
+
+    bool running() const { return mChild.started(); }
+
+    Child& machine() { return mChild; }
+    const Child& machine() const { return mChild; }
+
+protected:
+private:
+    Child mChild;
+};
+
+/// Forward an event from within Current::handleEvent to a submachine, then take the parent Transition that belongs
+/// to the terminal state (if any) that the child ended up in.  Terminals are checked in order with a pointer
+/// comparison each, and every mapping is its own Transition instantiation, so there is no table or virtual call
+/// between the child reaching a terminal state and the parent reacting to it.
+template <typename Current, typename Source, typename... Terminals>
+struct Forward {
+    using Host = typename Current::Host;
+
+    template <typename Child, typename Event>
+    Forward(Host& host, Submachine<Child>& submachine, Event&& evt)
+    {
+        submachine.dispatch(std::forward<Event>(evt));
+        mTerminated = (leave<Terminals>(host, submachine.machine()) || ...);
+    }
+
+    /// Forward nothing, and only take the parent Transition for a terminal state that the child reached by itself
+    /// (see Submachine)
+    template <typename Child>
+    Forward(Host& host, const Submachine<Child>& submachine)
+        : mTerminated{(leave<Terminals>(host, submachine.machine()) || ...)}
+    {}
+
+    /// Did the child reach one of the terminal states (and so the parent transition)?
+    bool terminated() const { return mTerminated; }
+
+private:
+    template <typename Terminal, typename Child>
+    static bool leave(Host& host, const Child& child)
+    {
+        if (child.template isIn<typename Terminal::Leaf>())
+        {
+            Transition<Current, Source, typename Terminal::Target> t(host);
+            return true;
+        }
+        return false;
+    }
+
+    bool mTerminated{false};
+};
+
+}  // namespace eta_hsm
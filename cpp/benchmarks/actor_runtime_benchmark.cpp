@@ -0,0 +1,123 @@
+// actor_runtime_benchmark.cpp
+
+#include <benchmark/benchmark.h>
+
+#include <chrono>
+#include <memory>
+#include <optional>
+#include <vector>
+
+#include "../ActorRuntime.hpp"
+#include "../Hsm.hpp"
+#include "../utils/Mailbox.hpp"
+
+namespace eta_hsm {
+namespace benchmarks {
+
+enum class ToggleEvent { eFlip, eNone };
+
+enum class ToggleState { eTop, eOff, eOn };
+
+struct ToggleTraits {
+    using Clock = std::chrono::steady_clock;
+    using Event = ToggleEvent;
+    using StateEnum = ToggleState;
+    static constexpr DefaultActions kDefaultActions = DefaultActions::eNothing;
+    static constexpr bool kClearTimersOnExit = false;
+};
+
+/// Off <-(eFlip)-> On, with a mailbox of its own so that it can run as an actor
+class Toggle : public StateMachine<Toggle, ToggleTraits> {
+public:
+    using Input = EmptyType;
+
+    Toggle();
+
+    utils::Mailbox<ToggleEvent, 16> mMailbox{};
+};
+
+template <ToggleState kState>
+using ToggleStateTraits = StateTraits<Toggle, ToggleState, kState>;
+
+using ToggleTop = TopState<ToggleStateTraits<ToggleState::eTop>>;
+using ToggleOff = LeafState<ToggleStateTraits<ToggleState::eOff>, ToggleTop>;
+using ToggleOn = LeafState<ToggleStateTraits<ToggleState::eOn>, ToggleTop>;
+
+}  // namespace benchmarks
+
+template <>
+template <typename Current>
+inline void benchmarks::ToggleOff::handleEvent(benchmarks::Toggle& stateMachine, const Current& currentState,
+                                               Event event) const
+{
+    if (event == benchmarks::ToggleEvent::eFlip)
+    {
+        Transition<Current, ThisState, benchmarks::ToggleOn> t(stateMachine);
+        return;
+    }
+    return ParentState::handleEvent(stateMachine, currentState, event);
+}
+
+template <>
+template <typename Current>
+inline void benchmarks::ToggleOn::handleEvent(benchmarks::Toggle& stateMachine, const Current& currentState,
+                                              Event event) const
+{
+    if (event == benchmarks::ToggleEvent::eFlip)
+    {
+        Transition<Current, ThisState, benchmarks::ToggleOff> t(stateMachine);
+        return;
+    }
+    return ParentState::handleEvent(stateMachine, currentState, event);
+}
+
+template <>
+inline void benchmarks::ToggleTop::init(benchmarks::Toggle& stateMachine)
+{
+    Init<benchmarks::ToggleOff> i(stateMachine);
+}
+
+namespace benchmarks {
+
+Toggle::Toggle()
+{
+    Transition<ToggleTop, ToggleTop, ToggleTop> t(*this);
+}
+
+struct ToggleAdapter {
+    using Machine = Toggle;
+    using Clock = std::chrono::steady_clock;
+
+    static auto& mailbox(Machine& machine) { return machine.mMailbox; }
+    static void fireTimers(Machine&, std::chrono::time_point<Clock>) {}
+    static std::optional<std::chrono::time_point<Clock>> nextTimer(const Machine&) { return std::nullopt; }
+};
+
+/// One eFlip to each of 100k actors, posted from one thread and run on state.range(0) workers:  the cost of getting
+/// an event to an actor and dispatching it, which should fall as workers are added (on as many cores)
+void BM_ActorRuntimeFanOut(benchmark::State& state)
+{
+    constexpr uint32_t kActors = 100000;
+    std::vector<std::unique_ptr<Toggle>> toggles;
+    ActorRuntime<ToggleAdapter> runtime(static_cast<size_t>(state.range(0)));
+    for (uint32_t idx = 0; idx < kActors; ++idx)
+    {
+        toggles.push_back(std::make_unique<Toggle>());
+        runtime.add(*toggles.back());
+    }
+    runtime.start();
+    for (auto _ : state)
+    {
+        for (uint32_t id = 0; id < kActors; ++id)
+        {
+            runtime.post(id, ToggleEvent::eFlip);
+        }
+        runtime.waitIdle(std::chrono::seconds(60));
+    }
+    runtime.stop();
+    state.SetItemsProcessed(state.iterations() * kActors);
+}
+BENCHMARK(BM_ActorRuntimeFanOut)->Arg(1)->Arg(2)->Arg(4)->UseRealTime()->Unit(benchmark::kMillisecond);
+
+}  // namespace benchmarks
+}  // namespace eta_hsm
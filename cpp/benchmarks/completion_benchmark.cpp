@@ -0,0 +1,202 @@
+// completion_benchmark.cpp
+
+#include <benchmark/benchmark.h>
+
+#include <chrono>
+
+#include "../Hsm.hpp"
+#include "../utils/EventBucket.hpp"
+
+namespace eta_hsm {
+namespace benchmarks {
+
+enum class GateEvent { eOpen, eClose, eChecked, eNone };
+
+enum class GateState { eTop, eClosed, eChecking, eOpened, eBlocked };
+
+/// Closed -(eOpen)-> Checking, which immediately moves on to Opened (or Blocked) depending on a guard
+template <bool kCompletion>
+struct GateTraits {
+    using Clock = std::chrono::steady_clock;
+    using Event = GateEvent;
+    using StateEnum = GateState;
+    static constexpr DefaultActions kDefaultActions =
+        kCompletion ? DefaultActions::eNothing : DefaultActions::eEntryExitOnly;
+    static constexpr bool kClearTimersOnExit = false;
+};
+
+/// Checking decides where to go with a completion transition
+class CompletionGate : public StateMachine<CompletionGate, GateTraits<true>> {
+public:
+    using Input = EmptyType;
+    CompletionGate();
+
+    bool clear() const { return mClear; }
+    bool mClear{true};
+};
+
+/// Checking decides where to go by queueing a synthetic eChecked from its entry action, to be dispatched next tick
+class QueuedGate : public StateMachine<QueuedGate, GateTraits<false>> {
+public:
+    using Input = EmptyType;
+    QueuedGate();
+
+    template <GateState kState>
+    void entry()
+    {
+        if constexpr (kState == GateState::eChecking)
+        {
+            mEventBucket.addEvent(GateEvent::eChecked);
+        }
+    }
+
+    template <GateState kState>
+    void exit()
+    {}
+
+    bool clear() const { return mClear; }
+    bool mClear{true};
+    utils::StaticEventBucket<GateEvent, 4> mEventBucket{};
+};
+
+template <typename Gate, GateState kState>
+using GateStateTraits = StateTraits<Gate, GateState, kState>;
+
+template <typename Gate>
+struct GateStates {
+    using Top = TopState<GateStateTraits<Gate, GateState::eTop>>;
+    using Closed = LeafState<GateStateTraits<Gate, GateState::eClosed>, Top>;
+    using Checking = LeafState<GateStateTraits<Gate, GateState::eChecking>, Top>;
+    using Opened = LeafState<GateStateTraits<Gate, GateState::eOpened>, Top>;
+    using Blocked = LeafState<GateStateTraits<Gate, GateState::eBlocked>, Top>;
+};
+
+using CG = GateStates<CompletionGate>;
+using QG = GateStates<QueuedGate>;
+
+}  // namespace benchmarks
+
+template <>
+struct Completion<benchmarks::CG::Checking>
+    : CompletionBranches<Branch<&benchmarks::CompletionGate::clear, benchmarks::CG::Opened>,
+                         Else<benchmarks::CG::Blocked>> {};
+
+template <>
+template <typename Current>
+inline void benchmarks::CG::Closed::handleEvent(benchmarks::CompletionGate& stateMachine,
+                                                const Current& currentState, Event event) const
+{
+    if (event == benchmarks::GateEvent::eOpen)
+    {
+        Transition<Current, ThisState, benchmarks::CG::Checking> t(stateMachine);
+        return;
+    }
+    return ParentState::handleEvent(stateMachine, currentState, event);
+}
+
+template <>
+template <typename Current>
+inline void benchmarks::CG::Opened::handleEvent(benchmarks::CompletionGate& stateMachine,
+                                                const Current& currentState, Event event) const
+{
+    if (event == benchmarks::GateEvent::eClose)
+    {
+        Transition<Current, ThisState, benchmarks::CG::Closed> t(stateMachine);
+        return;
+    }
+    return ParentState::handleEvent(stateMachine, currentState, event);
+}
+
+template <>
+inline void benchmarks::CG::Top::init(benchmarks::CompletionGate& stateMachine)
+{
+    Init<benchmarks::CG::Closed> i(stateMachine);
+}
+
+template <>
+template <typename Current>
+inline void benchmarks::QG::Closed::handleEvent(benchmarks::QueuedGate& stateMachine, const Current& currentState,
+                                                Event event) const
+{
+    if (event == benchmarks::GateEvent::eOpen)
+    {
+        Transition<Current, ThisState, benchmarks::QG::Checking> t(stateMachine);
+        return;
+    }
+    return ParentState::handleEvent(stateMachine, currentState, event);
+}
+
+template <>
+template <typename Current>
+inline void benchmarks::QG::Checking::handleEvent(benchmarks::QueuedGate& stateMachine, const Current& currentState,
+                                                  Event event) const
+{
+    if (event == benchmarks::GateEvent::eChecked)
+    {
+        if (stateMachine.clear())
+        {
+            Transition<Current, ThisState, benchmarks::QG::Opened> t(stateMachine);
+        }
+        else
+        {
+            Transition<Current, ThisState, benchmarks::QG::Blocked> t(stateMachine);
+        }
+        return;
+    }
+    return ParentState::handleEvent(stateMachine, currentState, event);
+}
+
+template <>
+template <typename Current>
+inline void benchmarks::QG::Opened::handleEvent(benchmarks::QueuedGate& stateMachine, const Current& currentState,
+                                                Event event) const
+{
+    if (event == benchmarks::GateEvent::eClose)
+    {
+        Transition<Current, ThisState, benchmarks::QG::Closed> t(stateMachine);
+        return;
+    }
+    return ParentState::handleEvent(stateMachine, currentState, event);
+}
+
+template <>
+inline void benchmarks::QG::Top::init(benchmarks::QueuedGate& stateMachine)
+{
+    Init<benchmarks::QG::Closed> i(stateMachine);
+}
+
+namespace benchmarks {
+
+CompletionGate::CompletionGate() { Transition<CG::Top, CG::Top, CG::Top> t(*this); }
+QueuedGate::QueuedGate() { Transition<QG::Top, QG::Top, QG::Top> t(*this); }
+
+/// Closed -> Checking -> Opened -> Closed, with Checking resolved by a completion transition inside one dispatch
+void BM_CompletionTransition(benchmark::State& state)
+{
+    CompletionGate gate;
+    for (auto _ : state)
+    {
+        gate.dispatch(GateEvent::eOpen);
+        gate.dispatch(GateEvent::eClose);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_CompletionTransition);
+
+/// The same round trip with the queued-event workaround:  an extra trip through the bucket and an extra dispatch
+/// (in a real controller, also an extra tick before the gate is actually open)
+void BM_QueuedCompletionEvent(benchmark::State& state)
+{
+    QueuedGate gate;
+    for (auto _ : state)
+    {
+        gate.dispatch(GateEvent::eOpen);
+        gate.dispatch(gate.mEventBucket.getEvent());
+        gate.dispatch(GateEvent::eClose);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_QueuedCompletionEvent);
+
+}  // namespace benchmarks
+}  // namespace eta_hsm
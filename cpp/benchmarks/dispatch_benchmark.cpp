@@ -0,0 +1,110 @@
+// dispatch_benchmark.cpp
+
+#include <benchmark/benchmark.h>
+
+#include "../examples/canonical/Canonical.hpp"
+#include "../examples/cd_player/CDPlayer.hpp"
+#include "../examples/controller/ExampleControl.hpp"
+#include "../utils/TestLog.hpp"
+
+namespace eta_hsm {
+namespace benchmarks {
+
+/// The examples log liberally through TestLog, which we do not want to measure (or see)
+void quietTestLog()
+{
+    static bool sQuieted = [] {
+        utils::TestLog::instance().disable();
+        return true;
+    }();
+    (void)sQuieted;
+}
+
+/// Round trip between two leaf states that are siblings under Top (the timing loop main.cpp used to run)
+void BM_CdPlayerPlayStop(benchmark::State& state)
+{
+    quietTestLog();
+    examples::cd_player::Player player;
+    for (auto _ : state)
+    {
+        player.dispatch(examples::cd_player::CdEvent::ePlay);
+        player.dispatch(examples::cd_player::CdEvent::eStop);
+    }
+    state.SetItemsProcessed(state.iterations() * 2);
+}
+BENCHMARK(BM_CdPlayerPlayStop);
+
+/// An event that is handled by the leaf state without causing a transition
+void BM_CdPlayerHandledWithoutTransition(benchmark::State& state)
+{
+    quietTestLog();
+    examples::cd_player::Player player;
+    for (auto _ : state)
+    {
+        player.dispatch(examples::cd_player::CdEvent::eStop);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_CdPlayerHandledWithoutTransition);
+
+/// An event that nobody handles, so it bubbles from S11 all the way up to Top
+void BM_CanonicalUnhandled(benchmark::State& state)
+{
+    quietTestLog();
+    examples::canonical::Canonical canonical;
+    for (auto _ : state)
+    {
+        canonical.dispatch(examples::canonical::CanonicalEvent::H);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_CanonicalUnhandled);
+
+/// Round trip S11 -> S211 -> S11 through the S0 superstate
+void BM_CanonicalRoundTrip(benchmark::State& state)
+{
+    quietTestLog();
+    examples::canonical::Canonical canonical;
+    for (auto _ : state)
+    {
+        canonical.dispatch(examples::canonical::CanonicalEvent::E);
+        canonical.dispatch(examples::canonical::CanonicalEvent::G);
+    }
+    state.SetItemsProcessed(state.iterations() * 2);
+}
+BENCHMARK(BM_CanonicalRoundTrip);
+
+/// AutoLoggedStateMachine::dispatch of an event handled in a leaf state (Drunk) without a transition
+void BM_ExampleControlDispatch(benchmark::State& state)
+{
+    quietTestLog();
+    examples::controller::ExampleControl control;
+    control.dispatch(examples::controller::ExampleEvent::eDrinkWiskey);
+    control.dispatch(examples::controller::ExampleEvent::eDrinkWiskey);
+    for (auto _ : state)
+    {
+        control.dispatch(examples::controller::ExampleEvent::eLookAtWatch);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_ExampleControlDispatch);
+
+/// A complete controller tick:  queue an event, then update() pulls it from the bucket, dispatches, and runs during()
+void BM_ExampleControlUpdate(benchmark::State& state)
+{
+    quietTestLog();
+    examples::controller::ExampleControl control;
+    control.dispatch(examples::controller::ExampleEvent::eDrinkWiskey);
+    control.dispatch(examples::controller::ExampleEvent::eDrinkWiskey);
+    const examples::controller::Input input{};
+    for (auto _ : state)
+    {
+        control.addEvent(examples::controller::ExampleEvent::eLookAtWatch);
+        control.update(input);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_ExampleControlUpdate);
+
+}  // namespace benchmarks
+}  // namespace eta_hsm
@@ -0,0 +1,91 @@
+// event_bucket_benchmark.cpp
+
+#include <benchmark/benchmark.h>
+
+#include <memory>
+#include <vector>
+
+#include "../utils/EventBucket.hpp"
+#include "../utils/EventBus.hpp"
+
+namespace eta_hsm {
+namespace benchmarks {
+
+enum class BucketEvent { eUrgent, eHigh, eMedium, eLow, eNone };
+
+constexpr BucketEvent kMix[] = {BucketEvent::eLow, BucketEvent::eUrgent, BucketEvent::eMedium, BucketEvent::eHigh};
+
+/// Fill the bucket with `state.range(0)` events (through the EventBucket interface, as producers would) and drain it
+template <typename Bucket>
+void fillAndDrain(benchmark::State& state)
+{
+    Bucket concrete;
+    utils::EventBucket<BucketEvent>& bucket = concrete;
+    for (auto _ : state)
+    {
+        for (int64_t idx = 0; idx < state.range(0); ++idx)
+        {
+            bucket.addEvent(kMix[idx % 4]);
+        }
+        while (!concrete.empty())
+        {
+            benchmark::DoNotOptimize(concrete.getEvent());
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+void BM_OrderedEventBucket(benchmark::State& state) { fillAndDrain<utils::OrderedEventBucket<BucketEvent>>(state); }
+BENCHMARK(BM_OrderedEventBucket)->Arg(1)->Arg(8)->Arg(64)->Arg(512);
+
+void BM_PrioritizedEventBucket(benchmark::State& state)
+{
+    fillAndDrain<utils::PrioritizedEventBucket<BucketEvent>>(state);
+}
+BENCHMARK(BM_PrioritizedEventBucket)->Arg(1)->Arg(8)->Arg(64)->Arg(512);
+
+/// A supervisor tells `state.range(0)` children about one event by adding it to each child's bucket, and each child
+/// takes it
+void BM_BroadcastByBucket(benchmark::State& state)
+{
+    std::vector<utils::StaticEventBucket<BucketEvent, 4>> children(static_cast<size_t>(state.range(0)));
+    for (auto _ : state)
+    {
+        for (auto& child : children)
+        {
+            child.addEvent(BucketEvent::eHigh);
+        }
+        for (auto& child : children)
+        {
+            benchmark::DoNotOptimize(child.getEvent());
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_BroadcastByBucket)->Arg(16)->Arg(256)->Arg(1024);
+
+/// As BM_BroadcastByBucket, but published once on an EventBus that every child subscribes to
+void BM_BroadcastByBus(benchmark::State& state)
+{
+    using Bus = utils::EventBus<BucketEvent, 64>;
+    Bus bus;
+    std::vector<std::unique_ptr<Bus::Subscriber>> children;
+    for (int64_t idx = 0; idx < state.range(0); ++idx)
+    {
+        children.push_back(std::make_unique<Bus::Subscriber>(bus));
+        children.back()->subscribe(BucketEvent::eHigh);
+    }
+    for (auto _ : state)
+    {
+        bus.publish(BucketEvent::eHigh);
+        for (auto& child : children)
+        {
+            benchmark::DoNotOptimize(child->getEvent());
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_BroadcastByBus)->Arg(16)->Arg(256)->Arg(1024);
+
+}  // namespace benchmarks
+}  // namespace eta_hsm
@@ -0,0 +1,128 @@
+// event_log_benchmark.cpp
+
+#include <benchmark/benchmark.h>
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "../Hsm.hpp"
+#include "../utils/EventLog.hpp"
+#include "../utils/FakeClock.hpp"
+
+namespace eta_hsm {
+namespace benchmarks {
+
+enum class LampEvent { eToggle, eNone };
+
+enum class LampState { eTop, eDark, eLit };
+
+struct LampTraits {
+    using Clock = utils::FakeClock;
+    using Event = LampEvent;
+    using StateEnum = LampState;
+    static constexpr DefaultActions kDefaultActions = DefaultActions::eNothing;
+    static constexpr bool kClearTimersOnExit = false;
+};
+
+class Lamp : public StateMachine<Lamp, LampTraits> {
+public:
+    using Input = EmptyType;
+    Lamp();
+};
+
+template <LampState kState>
+using LampStateTraits = StateTraits<Lamp, LampState, kState>;
+
+using LampTop = TopState<LampStateTraits<LampState::eTop>>;
+using LampDark = LeafState<LampStateTraits<LampState::eDark>, LampTop>;
+using LampLit = LeafState<LampStateTraits<LampState::eLit>, LampTop>;
+
+}  // namespace benchmarks
+
+template <>
+template <typename Current>
+inline void benchmarks::LampDark::handleEvent(benchmarks::Lamp& stateMachine, const Current& currentState,
+                                              Event event) const
+{
+    if (event == benchmarks::LampEvent::eToggle)
+    {
+        Transition<Current, ThisState, benchmarks::LampLit> t(stateMachine);
+        return;
+    }
+    return ParentState::handleEvent(stateMachine, currentState, event);
+}
+
+template <>
+template <typename Current>
+inline void benchmarks::LampLit::handleEvent(benchmarks::Lamp& stateMachine, const Current& currentState,
+                                             Event event) const
+{
+    if (event == benchmarks::LampEvent::eToggle)
+    {
+        Transition<Current, ThisState, benchmarks::LampDark> t(stateMachine);
+        return;
+    }
+    return ParentState::handleEvent(stateMachine, currentState, event);
+}
+
+template <>
+inline void benchmarks::LampTop::init(benchmarks::Lamp& stateMachine)
+{
+    Init<benchmarks::LampDark> i(stateMachine);
+}
+
+namespace benchmarks {
+
+Lamp::Lamp() { Transition<LampTop, LampTop, LampTop> t(*this); }
+
+constexpr uint32_t kLamps = 1000;
+constexpr uint64_t kLoggedEvents = 1 << 20;
+
+std::string eventLogPath() { return "/tmp/eta_hsm_event_log_benchmark.log"; }
+
+/// Cost on the control thread of logging a dispatched event (the write and sync happen on the log's writer)
+void BM_EventLogAppend(benchmark::State& state)
+{
+    std::remove(eventLogPath().c_str());
+    utils::EventLog log(eventLogPath());
+    uint64_t idx = 0;
+    for (auto _ : state)
+    {
+        log.append(static_cast<uint32_t>(idx % kLamps), idx, 0);
+        ++idx;
+    }
+    state.SetItemsProcessed(state.iterations());
+    state.counters["stalls"] = static_cast<double>(log.stalls());
+}
+BENCHMARK(BM_EventLogAppend);
+
+/// Recovery:  read the log back and replay every event through dispatch, driving a FakeClock along the way
+void BM_EventLogReplay(benchmark::State& state)
+{
+    std::remove(eventLogPath().c_str());
+    {
+        utils::EventLog log(eventLogPath());
+        for (uint64_t idx = 0; idx < kLoggedEvents; ++idx)
+        {
+            log.append(static_cast<uint32_t>(idx % kLamps), idx * 1000, static_cast<uint32_t>(LampEvent::eToggle));
+        }
+    }
+    utils::EventLogReader reader(eventLogPath());
+    std::vector<Lamp> lamps(kLamps);
+    utils::FakeClock clock;
+    for (auto _ : state)
+    {
+        clock.reset_to_epoch();
+        reader.replay(0, [&](uint64_t, const utils::EventLogRecord& record) {
+            clock.advance(utils::FakeClock::time_point(std::chrono::nanoseconds(record.timestampNs)) - clock.now());
+            lamps[record.machineId].dispatch(static_cast<LampEvent>(record.event));
+        });
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(kLoggedEvents));
+}
+BENCHMARK(BM_EventLogReplay)->Unit(benchmark::kMillisecond);
+
+}  // namespace benchmarks
+}  // namespace eta_hsm
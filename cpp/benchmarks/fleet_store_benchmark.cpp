@@ -0,0 +1,159 @@
+// fleet_store_benchmark.cpp
+
+#include <benchmark/benchmark.h>
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "../DirtyTrackingStateMachine.hpp"
+#include "../StateTable.hpp"
+#include "../utils/FleetStore.hpp"
+
+namespace eta_hsm {
+namespace benchmarks {
+
+enum class ValveEvent { eToggle, eNone };
+
+enum class ValveState { eTop, eShut, eOpen };
+
+struct ValveTraits {
+    using Clock = std::chrono::steady_clock;
+    using Event = ValveEvent;
+    using StateEnum = ValveState;
+    static constexpr DefaultActions kDefaultActions = DefaultActions::eNothing;
+    static constexpr bool kClearTimersOnExit = false;
+};
+
+struct ValveRecord;
+
+class Valve : public DirtyTrackingStateMachine<Valve, ValveTraits> {
+public:
+    using Input = EmptyType;
+    Valve();
+
+    double mFlow{0.0};
+};
+
+/// Sized like a machine with a handful of timers and host fields
+struct ValveRecord {
+    Valve::Snapshot machine;
+    double flow;
+    std::array<uint64_t, 12> padding;
+};
+
+template <ValveState kState>
+using ValveStateTraits = StateTraits<Valve, ValveState, kState>;
+
+using Top = TopState<ValveStateTraits<ValveState::eTop>>;
+using Shut = LeafState<ValveStateTraits<ValveState::eShut>, Top>;
+using Open = LeafState<ValveStateTraits<ValveState::eOpen>, Top>;
+
+ETA_HSM_REGISTER_STATE(Valve, Shut, ValveState);
+ETA_HSM_REGISTER_STATE(Valve, Open, ValveState);
+
+}  // namespace benchmarks
+
+template <>
+template <typename Current>
+inline void benchmarks::Shut::handleEvent(benchmarks::Valve& stateMachine, const Current& currentState,
+                                               Event event) const
+{
+    if (event == benchmarks::ValveEvent::eToggle)
+    {
+        Transition<Current, ThisState, benchmarks::Open> t(stateMachine);
+        return;
+    }
+    return ParentState::handleEvent(stateMachine, currentState, event);
+}
+
+template <>
+template <typename Current>
+inline void benchmarks::Open::handleEvent(benchmarks::Valve& stateMachine, const Current& currentState,
+                                               Event event) const
+{
+    if (event == benchmarks::ValveEvent::eToggle)
+    {
+        Transition<Current, ThisState, benchmarks::Shut> t(stateMachine);
+        return;
+    }
+    return ParentState::handleEvent(stateMachine, currentState, event);
+}
+
+template <>
+inline void benchmarks::Top::init(benchmarks::Valve& stateMachine)
+{
+    Init<benchmarks::Shut> i(stateMachine);
+}
+
+namespace benchmarks {
+
+Valve::Valve() { Transition<Top, Top, Top> t(*this); }
+
+constexpr size_t kFleetSize = 100000;
+
+std::string fleetStorePath()
+{
+    return "/tmp/eta_hsm_fleet_store_benchmark.store";
+}
+
+/// A periodic checkpoint of 100k machines, of which the given per mille changed since the last one
+void BM_FleetCheckpoint(benchmark::State& state)
+{
+    std::remove(fleetStorePath().c_str());
+    utils::FleetStore<ValveRecord> store(fleetStorePath(), kFleetSize);
+    std::vector<Valve> fleet(kFleetSize);
+    for (size_t id = 0; id < kFleetSize; ++id)
+    {
+        fleet[id].trackDirty(store.dirtyBits(), id);
+    }
+    const size_t stride = 1000 / static_cast<size_t>(state.range(0));
+    size_t written = 0;
+    for (auto _ : state)
+    {
+        store.checkpoint([&](size_t id, ValveRecord& record) { record = {fleet[id].snapshot(), fleet[id].mFlow, {}}; });
+        state.PauseTiming();
+        for (size_t id = 0; id < kFleetSize; id += stride)
+        {
+            fleet[id].dispatch(ValveEvent::eToggle);
+        }
+        written += kFleetSize / stride;
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(written));
+}
+BENCHMARK(BM_FleetCheckpoint)->Arg(1)->Arg(10)->Arg(100)->Unit(benchmark::kMillisecond);
+
+/// Restart:  map the store and restore 100k machines straight from it
+void BM_FleetRestart(benchmark::State& state)
+{
+    std::remove(fleetStorePath().c_str());
+    {
+        utils::FleetStore<ValveRecord> store(fleetStorePath(), kFleetSize);
+        std::vector<Valve> fleet(kFleetSize);
+        for (size_t id = 0; id < kFleetSize; ++id)
+        {
+            fleet[id].trackDirty(store.dirtyBits(), id);
+        }
+        store.checkpoint([&](size_t id, ValveRecord& record) { record = {fleet[id].snapshot(), fleet[id].mFlow, {}}; });
+    }
+    std::vector<Valve> fleet(kFleetSize);
+    for (auto _ : state)
+    {
+        utils::FleetStore<ValveRecord> store(fleetStorePath(), kFleetSize);
+        for (size_t id = 0; id < kFleetSize; ++id)
+        {
+            fleet[id].restore<StateTable<Valve, 3>>(store[id].machine);
+            fleet[id].mFlow = store[id].flow;
+        }
+        benchmark::DoNotOptimize(fleet.data());
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(kFleetSize));
+}
+BENCHMARK(BM_FleetRestart)->Unit(benchmark::kMillisecond);
+
+}  // namespace benchmarks
+}  // namespace eta_hsm
@@ -0,0 +1,126 @@
+// internal_event_benchmark.cpp
+
+#include <benchmark/benchmark.h>
+
+#include <chrono>
+
+#include "../Hsm.hpp"
+#include "../utils/EventBucket.hpp"
+
+namespace eta_hsm {
+namespace benchmarks {
+
+enum class RelayEvent { eGo, eBack, eNone };
+
+enum class RelayState { eTop, eIdle, eBusy };
+
+struct RelayTraits {
+    using Clock = std::chrono::steady_clock;
+    using Event = RelayEvent;
+    using StateEnum = RelayState;
+    static constexpr DefaultActions kDefaultActions = DefaultActions::eNothing;
+    static constexpr bool kClearTimersOnExit = false;
+    static constexpr size_t kInternalQueueCapacity = 4;
+};
+
+/// Idle -(eGo)-> Busy, whose reaction is to send eBack to itself, either raised on the internal queue or added to an
+/// ordinary event bucket (the way the examples did it before StateMachine::raise existed)
+class Relay : public StateMachine<Relay, RelayTraits> {
+public:
+    using Input = EmptyType;
+
+    explicit Relay(bool useInternalQueue);
+
+    void react(RelayEvent evt)
+    {
+        if (mUseInternalQueue)
+        {
+            raise(evt);
+        }
+        else
+        {
+            mEventBucket.addEvent(evt);
+        }
+    }
+
+    utils::StaticEventBucket<RelayEvent, 4> mEventBucket{};
+    const bool mUseInternalQueue;
+};
+
+template <RelayState kState>
+using RelayStateTraits = StateTraits<Relay, RelayState, kState>;
+
+using RelayTop = TopState<RelayStateTraits<RelayState::eTop>>;
+using RelayIdle = LeafState<RelayStateTraits<RelayState::eIdle>, RelayTop>;
+using RelayBusy = LeafState<RelayStateTraits<RelayState::eBusy>, RelayTop>;
+
+}  // namespace benchmarks
+
+template <>
+template <typename Current>
+inline void benchmarks::RelayIdle::handleEvent(benchmarks::Relay& stateMachine, const Current& currentState,
+                                               Event event) const
+{
+    if (event == benchmarks::RelayEvent::eGo)
+    {
+        stateMachine.react(benchmarks::RelayEvent::eBack);
+        Transition<Current, ThisState, benchmarks::RelayBusy> t(stateMachine);
+        return;
+    }
+    return ParentState::handleEvent(stateMachine, currentState, event);
+}
+
+template <>
+template <typename Current>
+inline void benchmarks::RelayBusy::handleEvent(benchmarks::Relay& stateMachine, const Current& currentState,
+                                               Event event) const
+{
+    if (event == benchmarks::RelayEvent::eBack)
+    {
+        Transition<Current, ThisState, benchmarks::RelayIdle> t(stateMachine);
+        return;
+    }
+    return ParentState::handleEvent(stateMachine, currentState, event);
+}
+
+template <>
+inline void benchmarks::RelayTop::init(benchmarks::Relay& stateMachine)
+{
+    Init<benchmarks::RelayIdle> i(stateMachine);
+}
+
+namespace benchmarks {
+
+Relay::Relay(bool useInternalQueue) : mUseInternalQueue{useInternalQueue}
+{
+    Transition<RelayTop, RelayTop, RelayTop> t(*this);
+}
+
+/// The reaction to eGo is complete when dispatch() returns
+void BM_ReactionInternalQueue(benchmark::State& state)
+{
+    Relay relay{true};
+    for (auto _ : state)
+    {
+        relay.dispatch(RelayEvent::eGo);
+    }
+    state.SetItemsProcessed(state.iterations() * 2);
+}
+BENCHMARK(BM_ReactionInternalQueue);
+
+/// The reaction to eGo waits in the event bucket for the next tick; this measures only the CPU time of the two
+/// dispatches, the real cost is the tick period spent in between
+void BM_ReactionExternalBucket(benchmark::State& state)
+{
+    Relay relay{false};
+    for (auto _ : state)
+    {
+        relay.dispatch(RelayEvent::eGo);
+        relay.dispatch(relay.mEventBucket.getEvent());
+    }
+    state.SetItemsProcessed(state.iterations() * 2);
+}
+BENCHMARK(BM_ReactionExternalBucket);
+
+}  // namespace benchmarks
+}  // namespace eta_hsm
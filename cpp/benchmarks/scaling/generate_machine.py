@@ -0,0 +1,327 @@
+"""Generate synthetic eta-hsm state machines for scaling benchmarks.
+
+The examples in this repository top out at a handful of states, which makes it
+hard to predict how compile time, object size, and dispatch cost behave for
+machines with hundreds of states.  This script emits a header/source pair that
+declares a machine with a configurable number of states, hierarchy depth,
+fanout, number of events, and transition density, written in exactly the same
+style as the hand-written examples (Transition<> instantiations inside
+specialized handleEvent() functions).
+
+Usage:
+    generate_machine.py --name Synthetic64 --states 64 --depth 4 --fanout 4 \
+        --events 16 --density 0.2 --output-dir <dir>
+"""
+
+import argparse
+import os
+import random
+
+
+class GeneratedState:
+    """A node in the generated state hierarchy."""
+
+    def __init__(self, index, parent=None):
+        """Create a state, registering it with its parent (if any)."""
+        self.index = index
+        self.parent = parent
+        self.children = []
+        self.transitions = []  # list of (event index, target state)
+        self.depth = 0 if parent is None else parent.depth + 1
+        if parent:
+            parent.children.append(self)
+
+    @property
+    def name(self):
+        """C++ type alias for this state."""
+        return "Top" if self.parent is None else "S{}".format(self.index)
+
+    @property
+    def enum(self):
+        """C++ enumerator for this state."""
+        return "e" + self.name
+
+    @property
+    def is_leaf(self):
+        """Leaf states are the ones without children."""
+        return self.parent is not None and not self.children
+
+    def ancestors(self):
+        """All states above this one, nearest first."""
+        state = self.parent
+        while state is not None:
+            yield state
+            state = state.parent
+
+
+def build_hierarchy(state_count, depth, fanout):
+    """Build a breadth-first tree with at most `depth` levels below Top and `fanout` children per composite."""
+    top = GeneratedState(0)
+    states = [top]
+    frontier = [top]
+    while len(states) < state_count and frontier:
+        next_frontier = []
+        for parent in frontier:
+            for _ in range(fanout):
+                if len(states) >= state_count:
+                    break
+                child = GeneratedState(len(states), parent)
+                states.append(child)
+                if child.depth < depth:
+                    next_frontier.append(child)
+        frontier = next_frontier
+    return states
+
+
+def add_transitions(states, event_count, density, rng):
+    """Give each non-Top state a transition for roughly `density` of the events, to a random target."""
+    targets = states[1:]
+    for state in targets:
+        for event in range(event_count):
+            if rng.random() < density:
+                state.transitions.append((event, rng.choice(targets)))
+
+
+def transition_samples(states, limit=64):
+    """Pick (leaf, event) pairs that are known to cause a transition, handled as close to the leaf as possible."""
+    samples = []
+    leaves = [s for s in states if s.is_leaf]
+    for leaf_index, leaf in enumerate(leaves):
+        for state in [leaf] + list(leaf.ancestors()):
+            if state.transitions:
+                samples.append((leaf_index, state.transitions[0][0]))
+                break
+        if len(samples) >= limit:
+            break
+    return samples
+
+
+def emit_header(name, states, event_count):
+    """Emit the header declaring the machine and its (inline) state definitions."""
+    namespace = name.lower()
+    leaves = [s for s in states if s.is_leaf]
+    composites = [s for s in states if not s.is_leaf]
+    lines = []
+    out = lines.append
+
+    out("// {}.hpp".format(name))
+    out("// Generated by benchmarks/scaling/generate_machine.py -- do not edit")
+    out("")
+    out("#pragma once")
+    out("")
+    out("#include <chrono>")
+    out("#include <cstddef>")
+    out("")
+    out('#include "Hsm.hpp"')
+    out('#include "StateTable.hpp"')
+    out("")
+    out("namespace eta_hsm {")
+    out("namespace benchmarks {")
+    out("namespace {} {{".format(namespace))
+    out("")
+    out("enum class Event {")
+    for event in range(event_count):
+        out("    eE{},".format(event))
+    out("    eNone,")
+    out("};")
+    out("")
+    out("enum class State {")
+    for state in states:
+        out("    {},".format(state.enum))
+    out("};")
+    out("")
+    out("constexpr size_t kEventCount = {};".format(event_count))
+    out("constexpr size_t kStateCount = {};".format(len(states)))
+    out("constexpr size_t kLeafCount = {};".format(len(leaves)))
+    out("constexpr size_t kMaxDepth = {};".format(max(s.depth for s in states)))
+    out("")
+    out("/// Index of (one of) the most deeply nested leaves")
+    out("constexpr size_t kDeepestLeaf = {};".format(leaves.index(max(leaves, key=lambda s: s.depth))))
+    out("")
+    out("/// Starting leaves and events that are known to cause a transition")
+    out("struct TransitionSample {")
+    out("    size_t leaf;")
+    out("    Event event;")
+    out("};")
+    out("constexpr size_t kTransitionSampleCount = {};".format(len(transition_samples(states))))
+    out("extern const TransitionSample kTransitionSamples[kTransitionSampleCount];")
+    out("")
+    out("using Traits = eta_hsm::StateMachineTraits<Event, State, std::chrono::steady_clock>;")
+    out("")
+    out("class Machine : public eta_hsm::StateMachine<Machine, Traits> {")
+    out("public:")
+    out("    using Input = EmptyType;")
+    out("    Machine();")
+    out("")
+    out("    /// Jump directly into the leaf with the given index (0 <= idx < kLeafCount), bypassing entry/exit")
+    out("    void setLeaf(size_t idx);")
+    out("")
+    out("    /// The leaf with the given index as a run-time usable enum")
+    out("    static State leaf(size_t idx);")
+    out("};")
+    out("")
+    out("template <State kState>")
+    out("using MachineTraits = StateTraits<Machine, State, kState>;")
+    out("")
+    for state in states:
+        if state.parent is None:
+            out("using Top = eta_hsm::TopState<MachineTraits<State::eTop>>;")
+        elif state.is_leaf:
+            out("using {} = eta_hsm::LeafState<MachineTraits<State::{}>, {}>;".format(
+                state.name, state.enum, state.parent.name))
+        else:
+            out("using {} = eta_hsm::CompState<MachineTraits<State::{}>, {}>;".format(
+                state.name, state.enum, state.parent.name))
+    out("")
+    for state in states:
+        out("ETA_HSM_REGISTER_STATE(Machine, {}, State);".format(state.name))
+    out("")
+    out("using MachineStateTable = eta_hsm::StateTable<Machine, kStateCount>;")
+    out("")
+    out("}}  // namespace {}".format(namespace))
+    out("}  // namespace benchmarks")
+    out("")
+
+    qualified = "benchmarks::{}::".format(namespace)
+    for state in states:
+        out("template <>")
+        out("template <typename Current>")
+        out("inline void {0}{1}::handleEvent({0}Machine& stateMachine, const Current& currentState,".format(
+            qualified, state.name))
+        out("    Event event) const")
+        out("{")
+        if state.parent is None:
+            out("    (void)stateMachine;")
+            out("    (void)currentState;")
+            out("    (void)event;")
+            out("    return;  // Top has no parent")
+            out("}")
+            out("")
+            continue
+        out("    switch (event)")
+        out("    {")
+        for event, target in state.transitions:
+            out("        case {}Event::eE{}:".format(qualified, event))
+            out("        {")
+            out("            Transition<Current, ThisState, {}{}> t(stateMachine);".format(qualified, target.name))
+            out("            return;")
+            out("        }")
+        out("        default:")
+        out("            break;")
+        out("    }")
+        out("    return ParentState::handleEvent(stateMachine, currentState, event);")
+        out("}")
+        out("")
+
+    # init() must be declared bottom-up, so emit the deepest composites first
+    for state in sorted(composites, key=lambda s: -s.depth):
+        out("template <>")
+        out("inline void {0}{1}::init({0}Machine& stateMachine)".format(qualified, state.name))
+        out("{")
+        out("    Init<{}{}> i(stateMachine);".format(qualified, state.children[0].name))
+        out("}")
+        out("")
+
+    out("}  // namespace eta_hsm")
+    out("")
+    return "\n".join(lines)
+
+
+def emit_source(name, states):
+    """Emit the source file that instantiates every state of the machine."""
+    namespace = name.lower()
+    leaves = [s for s in states if s.is_leaf]
+    lines = []
+    out = lines.append
+
+    out("// {}.cpp".format(name))
+    out("// Generated by benchmarks/scaling/generate_machine.py -- do not edit")
+    out("")
+    out('#include "{}.hpp"'.format(name))
+    out("")
+    out("namespace eta_hsm {")
+    out("namespace benchmarks {")
+    out("namespace {} {{".format(namespace))
+    out("")
+    out("Machine::Machine() { eta_hsm::Transition<Top, Top, Top> t(*this); }")
+    out("")
+    out("void Machine::setLeaf(size_t idx)")
+    out("{")
+    out("    switch (idx)")
+    out("    {")
+    for idx, leaf in enumerate(leaves):
+        out("        case {}:".format(idx))
+        out("            directlySetStateForTestingOnly<{}>();".format(leaf.name))
+        out("            break;")
+    out("        default:")
+    out("            break;")
+    out("    }")
+    out("}")
+    out("")
+    out("const TransitionSample kTransitionSamples[kTransitionSampleCount] = {")
+    for leaf_index, event in transition_samples(states):
+        out("    {{{}, Event::eE{}}},".format(leaf_index, event))
+    out("};")
+    out("")
+    out("State Machine::leaf(size_t idx)")
+    out("{")
+    out("    static constexpr State kLeaves[] = {")
+    for leaf in leaves:
+        out("        State::{},".format(leaf.enum))
+    out("    };")
+    out("    return kLeaves[idx % kLeafCount];")
+    out("}")
+    out("")
+    out("}}  // namespace {}".format(namespace))
+    out("}  // namespace benchmarks")
+    out("}  // namespace eta_hsm")
+    out("")
+    return "\n".join(lines)
+
+
+def write_if_changed(path, contents):
+    """Avoid touching outputs that have not changed so that the build does not recompile needlessly."""
+    if os.path.exists(path):
+        with open(path) as existing:
+            if existing.read() == contents:
+                return
+    with open(path, "w") as output:
+        output.write(contents)
+
+
+def generate(name, states, depth, fanout, events, density, seed, output_dir):
+    """Generate {name}.hpp and {name}.cpp in output_dir and return the state hierarchy."""
+    rng = random.Random(seed)
+    hierarchy = build_hierarchy(states, depth, fanout)
+    if len(hierarchy) < states:
+        raise ValueError("depth {} and fanout {} only allow {} states".format(depth, fanout, len(hierarchy)))
+    add_transitions(hierarchy, events, density, rng)
+    os.makedirs(output_dir, exist_ok=True)
+    write_if_changed(os.path.join(output_dir, name + ".hpp"), emit_header(name, hierarchy, events))
+    write_if_changed(os.path.join(output_dir, name + ".cpp"), emit_source(name, hierarchy))
+    return hierarchy
+
+
+def main():
+    """Parse the command line and generate a machine."""
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--name", required=True, help="name of the generated files and (lowercased) namespace")
+    parser.add_argument("--states", type=int, default=64, help="total number of states, including Top")
+    parser.add_argument("--depth", type=int, default=4, help="maximum number of levels below Top")
+    parser.add_argument("--fanout", type=int, default=4, help="maximum number of children per composite state")
+    parser.add_argument("--events", type=int, default=16, help="number of distinct events")
+    parser.add_argument("--density", type=float, default=0.2,
+                        help="probability that a given state handles a given event with a transition")
+    parser.add_argument("--seed", type=int, default=0, help="random seed, so that output is reproducible")
+    parser.add_argument("--output-dir", default=".", help="where to write the generated files")
+    args = parser.parse_args()
+
+    try:
+        generate(args.name, args.states, args.depth, args.fanout, args.events, args.density, args.seed,
+                 args.output_dir)
+    except ValueError as error:
+        parser.error(str(error))
+
+
+if __name__ == "__main__":
+    main()
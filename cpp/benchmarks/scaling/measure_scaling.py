@@ -0,0 +1,102 @@
+"""Measure how compile time and object size scale with the number of states in a machine.
+
+Generates a series of synthetic machines with generate_machine.py, compiles each one on its own, and reports the
+wall-clock compile time and object size (total, and per state) as a table and optionally as JSON.
+
+Usage:
+    measure_scaling.py --compiler c++ --include-dir <eta_hsm cpp dir> [--sizes 8 64 512] [--json out.json]
+"""
+
+import argparse
+import json
+import os
+import shlex
+import subprocess
+import tempfile
+import time
+
+import generate_machine
+
+
+def depth_and_fanout(states):
+    """Pick a roughly balanced hierarchy for the requested number of states."""
+    for depth in range(2, 8):
+        fanout = 2
+        while 1 + sum(fanout ** level for level in range(1, depth + 1)) < states:
+            fanout += 1
+        if fanout <= 8:
+            return depth, fanout
+    return 8, 8
+
+
+def text_size(compiler, object_path):
+    """Size of the code in the object, if binutils `size` is available (otherwise None)."""
+    size_tool = os.path.join(os.path.dirname(compiler), "size")
+    for tool in (size_tool, "size"):
+        try:
+            output = subprocess.run([tool, object_path], check=True, capture_output=True, text=True).stdout
+            return int(output.splitlines()[1].split()[0])
+        except (OSError, subprocess.CalledProcessError, IndexError, ValueError):
+            continue
+    return None
+
+
+def measure(compiler, flags, include_dirs, states, events, density, work_dir):
+    """Generate and compile one machine, returning its measurements."""
+    name = "Synthetic{}".format(states)
+    depth, fanout = depth_and_fanout(states)
+    generate_machine.generate(name, states, depth, fanout, events, density, 0, work_dir)
+    source = os.path.join(work_dir, name + ".cpp")
+    obj = os.path.join(work_dir, name + ".o")
+    command = [compiler] + flags + ["-I" + work_dir] + ["-I" + d for d in include_dirs] + ["-c", source, "-o", obj]
+
+    start = time.monotonic()
+    subprocess.run(command, check=True)
+    seconds = time.monotonic() - start
+
+    object_bytes = os.path.getsize(obj)
+    return {
+        "states": states,
+        "depth": depth,
+        "fanout": fanout,
+        "events": events,
+        "compile_seconds": seconds,
+        "object_bytes": object_bytes,
+        "text_bytes": text_size(compiler, obj),
+        "compile_ms_per_state": 1000.0 * seconds / states,
+        "object_bytes_per_state": object_bytes / states,
+    }
+
+
+def main():
+    """Parse the command line, measure every size, and report."""
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--compiler", default="c++", help="C++ compiler to measure")
+    parser.add_argument("--flags", default="-std=c++17 -O2", help="compiler flags (one string)")
+    parser.add_argument("--include-dir", action="append", default=[], help="include path for Hsm.hpp (repeatable)")
+    parser.add_argument("--sizes", type=int, nargs="+", default=[8, 32, 64, 128, 256, 512])
+    parser.add_argument("--events", type=int, default=16, help="number of distinct events in every machine")
+    parser.add_argument("--density", type=float, default=0.1, help="transition density, see generate_machine.py")
+    parser.add_argument("--json", help="also write the results here")
+    args = parser.parse_args()
+
+    results = []
+    with tempfile.TemporaryDirectory(prefix="eta_hsm_scaling_") as work_dir:
+        for states in args.sizes:
+            results.append(measure(args.compiler, shlex.split(args.flags), args.include_dir, states, args.events,
+                                   args.density, work_dir))
+
+    print("{:>7} {:>6} {:>7} {:>11} {:>12} {:>11} {:>13} {:>12}".format(
+        "states", "depth", "fanout", "compile(s)", "ms/state", "object(B)", "B/state", "text(B)"))
+    for r in results:
+        print("{:>7} {:>6} {:>7} {:>11.2f} {:>12.2f} {:>11} {:>13.0f} {:>12}".format(
+            r["states"], r["depth"], r["fanout"], r["compile_seconds"], r["compile_ms_per_state"],
+            r["object_bytes"], r["object_bytes_per_state"], r["text_bytes"] if r["text_bytes"] is not None else "-"))
+
+    if args.json:
+        with open(args.json, "w") as output:
+            json.dump({"compiler": args.compiler, "flags": args.flags, "results": results}, output, indent=2)
+
+
+if __name__ == "__main__":
+    main()
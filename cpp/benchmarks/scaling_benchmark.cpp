@@ -0,0 +1,150 @@
+// scaling_benchmark.cpp
+//
+// Dispatch, transition, and hierarchy query cost for machines produced by scaling/generate_machine.py, so that the
+// cost of growing a machine from a handful of states to hundreds can be read off directly.
+
+#include <benchmark/benchmark.h>
+
+#include <random>
+#include <vector>
+
+#include "HsmTestRunner.hpp"
+#include "Synthetic512.hpp"
+#include "Synthetic64.hpp"
+#include "Synthetic8.hpp"
+
+namespace eta_hsm {
+namespace benchmarks {
+
+/// Random (but reproducible) events, so that every size sees the same mix of handled and unhandled events
+template <typename Synthetic>
+std::vector<typename Synthetic::Event> randomEvents(size_t count)
+{
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<size_t> distribution(0, Synthetic::kEventCount - 1);
+    std::vector<typename Synthetic::Event> events(count);
+    for (auto& event : events)
+    {
+        event = static_cast<typename Synthetic::Event>(distribution(rng));
+    }
+    return events;
+}
+
+/// Adapts one generated namespace to the (template) benchmarks below
+#define ETA_HSM_SYNTHETIC(NAME, NS)                                                                 \
+    struct NAME {                                                                                  \
+        using Machine = NS::Machine;                                                               \
+        using Event = NS::Event;                                                                   \
+        using State = NS::State;                                                                   \
+        using StateTable = NS::MachineStateTable;                                                  \
+        static constexpr size_t kEventCount = NS::kEventCount;                                     \
+        static constexpr size_t kStateCount = NS::kStateCount;                                     \
+        static constexpr size_t kMaxDepth = NS::kMaxDepth;                                         \
+        static constexpr size_t kDeepestLeaf = NS::kDeepestLeaf;                                   \
+        static constexpr size_t kTransitionSampleCount = NS::kTransitionSampleCount;               \
+        static const NS::TransitionSample& transitionSample(size_t idx)                            \
+        {                                                                                          \
+            return NS::kTransitionSamples[idx % NS::kTransitionSampleCount];                       \
+        }                                                                                          \
+    };
+
+ETA_HSM_SYNTHETIC(Synthetic8, synthetic8)
+ETA_HSM_SYNTHETIC(Synthetic64, synthetic64)
+ETA_HSM_SYNTHETIC(Synthetic512, synthetic512)
+
+#undef ETA_HSM_SYNTHETIC
+
+template <typename Synthetic>
+void labelWithSize(benchmark::State& state)
+{
+    state.counters["states"] = Synthetic::kStateCount;
+    state.counters["depth"] = Synthetic::kMaxDepth;
+    state.SetItemsProcessed(state.iterations());
+}
+
+/// A random event stream, starting wherever the previous event left the machine
+template <typename Synthetic>
+void BM_SyntheticDispatch(benchmark::State& state)
+{
+    const auto events = randomEvents<Synthetic>(1024);
+    typename Synthetic::Machine machine;
+    size_t idx = 0;
+    for (auto _ : state)
+    {
+        machine.dispatch(events[idx++ & 1023]);
+    }
+    labelWithSize<Synthetic>(state);
+}
+BENCHMARK_TEMPLATE(BM_SyntheticDispatch, Synthetic8);
+BENCHMARK_TEMPLATE(BM_SyntheticDispatch, Synthetic64);
+BENCHMARK_TEMPLATE(BM_SyntheticDispatch, Synthetic512);
+
+/// Events that are known to cause a transition from the given leaf.  Resetting the leaf bypasses entry/exit actions.
+template <typename Synthetic>
+void BM_SyntheticTransition(benchmark::State& state)
+{
+    typename Synthetic::Machine machine;
+    size_t idx = 0;
+    for (auto _ : state)
+    {
+        const auto& sample = Synthetic::transitionSample(idx++);
+        machine.setLeaf(sample.leaf);
+        machine.dispatch(sample.event);
+    }
+    labelWithSize<Synthetic>(state);
+}
+BENCHMARK_TEMPLATE(BM_SyntheticTransition, Synthetic8);
+BENCHMARK_TEMPLATE(BM_SyntheticTransition, Synthetic64);
+BENCHMARK_TEMPLATE(BM_SyntheticTransition, Synthetic512);
+
+/// Worst case for isInSubstateOf:  asking the deepest leaf about a state that is not one of its ancestors walks all
+/// the way up to Top
+template <typename Synthetic>
+void BM_SyntheticIsInSubstateOf(benchmark::State& state)
+{
+    typename Synthetic::Machine machine;
+    machine.setLeaf(Synthetic::kDeepestLeaf);
+    const auto current = machine.identify();
+    // Every non-Top state is a valid query, and at most kMaxDepth of them are ancestors of the deepest leaf
+    size_t idx = 0;
+    for (auto _ : state)
+    {
+        auto query = static_cast<typename Synthetic::State>(1 + (idx++ % (Synthetic::kStateCount - 1)));
+        if (query == current)
+        {
+            continue;
+        }
+        benchmark::DoNotOptimize(machine.isInSubstateOf(query));
+    }
+    labelWithSize<Synthetic>(state);
+}
+BENCHMARK_TEMPLATE(BM_SyntheticIsInSubstateOf, Synthetic8);
+BENCHMARK_TEMPLATE(BM_SyntheticIsInSubstateOf, Synthetic64);
+BENCHMARK_TEMPLATE(BM_SyntheticIsInSubstateOf, Synthetic512);
+
+/// The full (leaf x event) conformance matrix (see testing::ConformanceRunner), run on every core
+template <typename Synthetic>
+void BM_SyntheticConformance(benchmark::State& state)
+{
+    utils::ForkJoinPool pool;
+    const typename Synthetic::Machine prototype;
+    testing::ConformanceRunner<typename Synthetic::Machine, typename Synthetic::StateTable> runner(pool, prototype);
+    std::vector<typename Synthetic::Event> events;
+    for (size_t idx = 0; idx < Synthetic::kEventCount; ++idx)
+    {
+        events.push_back(static_cast<typename Synthetic::Event>(idx));
+    }
+    size_t cells = 0;
+    for (auto _ : state)
+    {
+        cells = runner.run(events).size();
+    }
+    labelWithSize<Synthetic>(state);
+    state.counters["cells"] = static_cast<double>(cells);
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(cells));
+}
+BENCHMARK_TEMPLATE(BM_SyntheticConformance, Synthetic64)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_SyntheticConformance, Synthetic512)->Unit(benchmark::kMillisecond);
+
+}  // namespace benchmarks
+}  // namespace eta_hsm
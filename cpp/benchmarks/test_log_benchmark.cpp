@@ -0,0 +1,46 @@
+// test_log_benchmark.cpp
+
+#include <benchmark/benchmark.h>
+
+#include "../examples/canonical/Canonical.hpp"
+#include "../utils/TestLog.hpp"
+
+namespace eta_hsm {
+namespace benchmarks {
+
+void quietTestLog();
+
+/// The canonical E/E round trip from S11, capturing every action it logs, with each benchmark thread running its own
+/// machine into its own TestLog shard.  Time per item should stay flat as threads are added.
+void BM_CanonicalCapturedTransition(benchmark::State& state)
+{
+    quietTestLog();
+    examples::canonical::Canonical canonical;
+    for (auto _ : state)
+    {
+        utils::TestLog::instance().startCapture();
+        canonical.directlySetStateForTestingOnly<examples::canonical::S11>();
+        canonical.dispatch(examples::canonical::CanonicalEvent::E);
+        utils::TestLog::instance().stopCapture();
+        benchmark::DoNotOptimize(utils::TestLog::instance().captured().size());
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_CanonicalCapturedTransition)->ThreadRange(1, 8)->UseRealTime();
+
+/// The same transition without capturing, so the difference between the two is the cost of the capture itself
+void BM_CanonicalUncapturedTransition(benchmark::State& state)
+{
+    quietTestLog();
+    examples::canonical::Canonical canonical;
+    for (auto _ : state)
+    {
+        canonical.directlySetStateForTestingOnly<examples::canonical::S11>();
+        canonical.dispatch(examples::canonical::CanonicalEvent::E);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_CanonicalUncapturedTransition)->ThreadRange(1, 8)->UseRealTime();
+
+}  // namespace benchmarks
+}  // namespace eta_hsm
@@ -0,0 +1,59 @@
+// time_tracker_benchmark.cpp
+
+#include <benchmark/benchmark.h>
+
+#include <chrono>
+
+#include "../utils/FakeClock.hpp"
+#include "../utils/TimeTracker.hpp"
+
+namespace eta_hsm {
+namespace benchmarks {
+
+WISE_ENUM_CLASS((TrackedState, int32_t), eTop, eOn, eWarming, eReady, eOff)
+
+void BM_TimeTrackerEnterExit(benchmark::State& state)
+{
+    utils::FakeClock clock;
+    utils::TimeTracker<TrackedState, utils::FakeClock> tracker(clock);
+    for (auto _ : state)
+    {
+        tracker.enter(TrackedState::eWarming);
+        tracker.exit(TrackedState::eWarming);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_TimeTrackerEnterExit);
+
+void BM_TimeTrackerQuery(benchmark::State& state)
+{
+    utils::FakeClock clock;
+    utils::TimeTracker<TrackedState, utils::FakeClock> tracker(clock);
+    tracker.enter(TrackedState::eTop);
+    tracker.enter(TrackedState::eOn);
+    clock.advance(std::chrono::seconds(1));
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(tracker.timeInState(TrackedState::eOn));
+        benchmark::DoNotOptimize(tracker.timeInState(TrackedState::eOff));  // not in state, returns 0
+    }
+    state.SetItemsProcessed(state.iterations() * 2);
+}
+BENCHMARK(BM_TimeTrackerQuery);
+
+/// The same query against the real steady_clock, which is what production controllers pay
+void BM_TimeTrackerQuerySteadyClock(benchmark::State& state)
+{
+    std::chrono::steady_clock clock;
+    utils::TimeTracker<TrackedState, std::chrono::steady_clock> tracker(clock);
+    tracker.enter(TrackedState::eOn);
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(tracker.timeInState(TrackedState::eOn));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_TimeTrackerQuerySteadyClock);
+
+}  // namespace benchmarks
+}  // namespace eta_hsm
@@ -0,0 +1,117 @@
+// timer_benchmark.cpp
+
+#include <benchmark/benchmark.h>
+
+#include <chrono>
+
+#include "../utils/EventBucket.hpp"
+#include "../utils/FakeClock.hpp"
+#include "../utils/Timer.hpp"
+
+namespace eta_hsm {
+namespace benchmarks {
+
+WISE_ENUM_CLASS((TimerEvent, int32_t), eNone, eOne, eTwo, eThree, eFour)
+
+WISE_ENUM_CLASS((TimerGroup, int32_t), eNone, eA, eB, eC, eD, eE, eF, eG, eH, eI, eJ, eK, eL, eM, eN, eO, eP)
+
+using TimerClock = utils::FakeClock;
+using Traits = utils::TimerTraits<TimerClock, TimerEvent, TimerGroup>;
+const auto kEpoch = TimerClock::time_point();
+
+TimerGroup groupFor(int64_t idx) { return static_cast<TimerGroup>(1 + idx % (wise_enum::size<TimerGroup> - 1)); }
+
+/// Arm and then cancel a timer while `state.range(0)` other timers are already armed
+template <typename Bank>
+void armAndCancel(benchmark::State& state, Bank& bank)
+{
+    for (int64_t idx = 0; idx < state.range(0); ++idx)
+    {
+        bank.addTimer(TimerEvent::eOne, groupFor(idx + 1), kEpoch + std::chrono::seconds(100 + idx));
+    }
+    for (auto _ : state)
+    {
+        bank.addTimer(TimerEvent::eTwo, TimerGroup::eA, kEpoch + std::chrono::seconds(50));
+        bank.clearAllTimersInGroup(TimerGroup::eA);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+void BM_TimerBankAddCancel(benchmark::State& state)
+{
+    utils::TimerBank<Traits> bank;
+    armAndCancel(state, bank);
+}
+BENCHMARK(BM_TimerBankAddCancel)->Arg(0)->Arg(4)->Arg(15);
+
+void BM_StaticTimerBankAddCancel(benchmark::State& state)
+{
+    utils::StaticTimerBank<Traits> bank;
+    armAndCancel(state, bank);
+}
+BENCHMARK(BM_StaticTimerBankAddCancel)->Arg(0)->Arg(4)->Arg(15);
+
+/// Arm `state.range(0)` timers and then let all of them expire into an event bucket
+template <typename Bank>
+void armAndExpire(benchmark::State& state, Bank& bank)
+{
+    utils::OrderedEventBucket<TimerEvent> bucket;
+    for (auto _ : state)
+    {
+        for (int64_t idx = 0; idx < state.range(0); ++idx)
+        {
+            bank.addTimer(TimerEvent::eThree, groupFor(idx), kEpoch + std::chrono::seconds(10 + idx));
+        }
+        bank.checkTimers(kEpoch + std::chrono::seconds(5), bucket);  // nothing expired yet
+        bank.checkTimers(kEpoch + std::chrono::hours(1), bucket);
+        bucket.clear();
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+void BM_TimerBankExpire(benchmark::State& state)
+{
+    utils::TimerBank<Traits> bank;
+    armAndExpire(state, bank);
+}
+BENCHMARK(BM_TimerBankExpire)->Arg(1)->Arg(4)->Arg(16);
+
+void BM_StaticTimerBankExpire(benchmark::State& state)
+{
+    utils::StaticTimerBank<Traits> bank;
+    armAndExpire(state, bank);
+}
+BENCHMARK(BM_StaticTimerBankExpire)->Arg(1)->Arg(4)->Arg(16);
+
+/// The common case on every controller tick:  check timers when none of them have expired
+template <typename Bank>
+void checkNothingExpired(benchmark::State& state, Bank& bank)
+{
+    utils::OrderedEventBucket<TimerEvent> bucket;
+    for (int64_t idx = 0; idx < state.range(0); ++idx)
+    {
+        bank.addTimer(TimerEvent::eFour, groupFor(idx), kEpoch + std::chrono::hours(1));
+    }
+    for (auto _ : state)
+    {
+        bank.checkTimers(kEpoch, bucket);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+void BM_TimerBankCheckIdle(benchmark::State& state)
+{
+    utils::TimerBank<Traits> bank;
+    checkNothingExpired(state, bank);
+}
+BENCHMARK(BM_TimerBankCheckIdle)->Arg(0)->Arg(16);
+
+void BM_StaticTimerBankCheckIdle(benchmark::State& state)
+{
+    utils::StaticTimerBank<Traits> bank;
+    checkNothingExpired(state, bank);
+}
+BENCHMARK(BM_StaticTimerBankCheckIdle)->Arg(0)->Arg(16);
+
+}  // namespace benchmarks
+}  // namespace eta_hsm
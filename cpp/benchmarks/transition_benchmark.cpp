@@ -0,0 +1,68 @@
+// transition_benchmark.cpp
+
+#include <benchmark/benchmark.h>
+
+#include "../examples/canonical/Canonical.hpp"
+#include "../utils/TestLog.hpp"
+
+namespace eta_hsm {
+namespace benchmarks {
+
+void quietTestLog();
+
+/// Transitions out of S11 in the canonical example, ordered by how far away the least common ancestor (LCA) is.
+/// Each case is an event along with a description of the transition that it causes.
+struct TransitionCase {
+    examples::canonical::CanonicalEvent event;
+    const char* label;
+};
+
+const TransitionCase kTransitionCases[] = {
+    {examples::canonical::CanonicalEvent::Z, "S11->S12 sibling, LCA S1 (1 exit, 1 entry)"},
+    {examples::canonical::CanonicalEvent::B_LOCAL, "S1->S11 local, LCA S1 (1 exit, 1 entry)"},
+    {examples::canonical::CanonicalEvent::A, "S1->S1 self, LCA S0 (2 exits, 2 entries)"},
+    {examples::canonical::CanonicalEvent::C, "S1->S2 cousin, LCA S0 (2 exits, 3 entries)"},
+    {examples::canonical::CanonicalEvent::G, "S11->S211, LCA S0 (2 exits, 3 entries)"},
+    {examples::canonical::CanonicalEvent::D, "S1->S0, LCA Top (3 exits, 3 entries)"},
+    {examples::canonical::CanonicalEvent::E, "S0->S211, LCA Top (3 exits, 4 entries)"},
+};
+
+/// Start every iteration from S11.  Resetting the state directly bypasses entry/exit actions, so the reset itself
+/// costs no more than a pointer assignment.
+void BM_CanonicalTransitionFromS11(benchmark::State& state)
+{
+    quietTestLog();
+    const auto& transitionCase = kTransitionCases[state.range(0)];
+    examples::canonical::Canonical canonical;
+    for (auto _ : state)
+    {
+        canonical.directlySetStateForTestingOnly<examples::canonical::S11>();
+        canonical.dispatch(transitionCase.event);
+    }
+    state.SetLabel(transitionCase.label);
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_CanonicalTransitionFromS11)->DenseRange(0, std::size(kTransitionCases) - 1);
+
+/// Depth of the handler chain:  events handled (by transitioning) at successively higher levels above S211
+void BM_CanonicalHandlerDepthFromS211(benchmark::State& state)
+{
+    quietTestLog();
+    // S211 handles D, S21 handles H, S2 handles C, S0 handles E
+    static const examples::canonical::CanonicalEvent kEvents[] = {
+        examples::canonical::CanonicalEvent::D, examples::canonical::CanonicalEvent::H,
+        examples::canonical::CanonicalEvent::C, examples::canonical::CanonicalEvent::E};
+    const auto event = kEvents[state.range(0)];
+    examples::canonical::Canonical canonical;
+    for (auto _ : state)
+    {
+        canonical.directlySetStateForTestingOnly<examples::canonical::S211>();
+        canonical.dispatch(event);
+    }
+    state.SetLabel("handled " + std::to_string(state.range(0)) + " level(s) above the leaf");
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_CanonicalHandlerDepthFromS211)->DenseRange(0, 3);
+
+}  // namespace benchmarks
+}  // namespace eta_hsm
@@ -2,48 +2,23 @@
 
 // CDPlayer.cpp
 #include <chrono>
+#include <cstdint>
 
 #include "../../Hsm.hpp"
+#include "../../StateTable.hpp"
 #include "../../utils/TestLog.hpp"
+#include "wise_enum/wise_enum.h"
 
 namespace eta_hsm {
 namespace examples {
 namespace canonical {
 
-enum class CanonicalEvent {
-    // events with (default) external transition semantics
-    A,
-    B,
-    C,
-    D,
-    E,
-    F,
-    G,
-    H,
+// Events with (default) external transition semantics, the same events with local transition semantics, and Z, which
+// is not part of the typical example
+WISE_ENUM_CLASS((CanonicalEvent, int32_t), A, B, C, D, E, F, G, H, A_LOCAL, B_LOCAL, C_LOCAL, D_LOCAL, E_LOCAL, F_LOCAL,
+                G_LOCAL, H_LOCAL, Z)
 
-    // same events with local transition semantics
-    A_LOCAL,
-    B_LOCAL,
-    C_LOCAL,
-    D_LOCAL,
-    E_LOCAL,
-    F_LOCAL,
-    G_LOCAL,
-    H_LOCAL,
-
-    Z,  // not part of typical example
-};
-
-enum class CanonicalState {
-    eTop,
-    eS0,
-    eS1,
-    eS11,
-    eS12,
-    eS2,
-    eS21,
-    eS211,
-};
+WISE_ENUM_CLASS((CanonicalState, int32_t), eTop, eS0, eS1, eS11, eS12, eS2, eS21, eS211)
 
 using Clock = std::chrono::steady_clock;
 
@@ -67,6 +42,19 @@ using S2 = eta_hsm::CompState<CanonicalTraits<CanonicalState::eS2>, S0>;
 using S21 = eta_hsm::CompState<CanonicalTraits<CanonicalState::eS21>, S2>;
 using S211 = eta_hsm::LeafState<CanonicalTraits<CanonicalState::eS211>, S21>;
 
+ETA_HSM_REGISTER_STATE(Canonical, Top, CanonicalState);
+ETA_HSM_REGISTER_STATE(Canonical, S0, CanonicalState);
+ETA_HSM_REGISTER_STATE(Canonical, S1, CanonicalState);
+ETA_HSM_REGISTER_STATE(Canonical, S11, CanonicalState);
+ETA_HSM_REGISTER_STATE(Canonical, S12, CanonicalState);
+ETA_HSM_REGISTER_STATE(Canonical, S2, CanonicalState);
+ETA_HSM_REGISTER_STATE(Canonical, S21, CanonicalState);
+ETA_HSM_REGISTER_STATE(Canonical, S211, CanonicalState);
+
+using CanonicalStateTable = StateTable<Canonical, wise_enum::size<CanonicalState>>;
+
 }  // namespace canonical
 }  // namespace examples
 }  // namespace eta_hsm
+
+#include "Canonical-hsm.hpp"
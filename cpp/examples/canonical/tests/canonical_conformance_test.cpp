@@ -0,0 +1,87 @@
+#include "../../../HsmTestRunner.hpp"
+#include "../Canonical.hpp"
+
+#include <gtest/gtest.h>
+
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace eta_hsm {
+namespace examples {
+namespace canonical {
+namespace tests {
+
+using Runner = testing::ConformanceRunner<Canonical, CanonicalStateTable>;
+using Cell = Runner::Cell;
+
+class CanonicalConformanceTest : public ::testing::Test {
+protected:
+    void SetUp() override
+    {
+        if (!utils::TestLog::kCompiledIn)
+        {
+            GTEST_SKIP() << "TestLog statements are compiled out, so there are no traces to compare";
+        }
+        utils::TestLog::instance().disable();
+    }
+    void TearDown() override { utils::TestLog::instance().enable(); }
+
+    utils::ForkJoinPool pool_{3};
+    Canonical prototype_;
+};
+
+TEST_F(CanonicalConformanceTest, LeavesComeFromTheStateTable)
+{
+    EXPECT_EQ(Runner::leaves(),
+              (std::vector<CanonicalState>{CanonicalState::eS11, CanonicalState::eS12, CanonicalState::eS211}));
+}
+
+TEST_F(CanonicalConformanceTest, EveryLeafAndEventMatchesTheGoldenTable)
+{
+    const std::vector<Cell> cells = Runner(pool_, prototype_).run();
+    ASSERT_EQ(cells.size(), 3 * wise_enum::size<CanonicalEvent>);
+
+    for (const std::string& difference : testing::checkGolden(CANONICAL_GOLDEN_TABLE, cells))
+    {
+        ADD_FAILURE() << difference;
+    }
+}
+
+TEST_F(CanonicalConformanceTest, GoldenTablesRoundTrip)
+{
+    const std::vector<Cell> cells = Runner(pool_, prototype_).run();
+    std::stringstream table;
+    testing::writeConformance(table, cells);
+    EXPECT_EQ(testing::readConformance<Canonical>(table), cells);
+}
+
+TEST_F(CanonicalConformanceTest, ReportsEveryDifference)
+{
+    std::vector<Cell> golden = Runner(pool_, prototype_).run();
+    const std::vector<Cell> actual = golden;
+    golden[0].to = CanonicalState::eS12;
+    golden[1].trace += "exit_S0 \t";
+    golden.pop_back();
+    golden.push_back({CanonicalState::eS0, CanonicalEvent::A, CanonicalState::eS0, 0, ""});
+
+    const std::vector<std::string> differences = testing::compareConformance(golden, actual);
+    ASSERT_EQ(differences.size(), 4u);
+    EXPECT_EQ(differences[0].rfind("eS11 + A: expected eS12", 0), 0u) << differences[0];
+    EXPECT_NE(differences[1].find("exit_S0 \\t\", got"), std::string::npos) << differences[1];
+    EXPECT_NE(differences[2].find("eS211 + Z: not in the golden table"), std::string::npos) << differences[2];
+    EXPECT_EQ(differences[3], "eS0 + A: in the golden table, but was not run");
+}
+
+TEST_F(CanonicalConformanceTest, MalformedTablesAreRejected)
+{
+    std::stringstream table{"# comment\n\neS11\tA\teS11\n"};
+    EXPECT_THROW(testing::readConformance<Canonical>(table), std::runtime_error);
+    std::stringstream unknown{"eS11\tNotAnEvent\teS11\t0\t\n"};
+    EXPECT_THROW(testing::readConformance<Canonical>(unknown), std::runtime_error);
+}
+
+}  // namespace tests
+}  // namespace canonical
+}  // namespace examples
+}  // namespace eta_hsm
@@ -2,6 +2,11 @@
 
 #include <gtest/gtest.h>
 
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
 namespace eta_hsm {
 namespace examples {
 namespace canonical {
@@ -16,6 +21,109 @@ protected:
 
 TEST_F(CanonicalTest, InitialConditionsTest) { EXPECT_EQ(canonical_hsm_.identify(), CanonicalState::eS11); }
 
+/// One event from a known leaf, with the actions it should log (including one during()) and where it should end up
+struct Scenario {
+    CanonicalState from;
+    CanonicalEvent event;
+    const char* log;
+    CanonicalState to;
+};
+
+const std::vector<Scenario> kScenarios = {
+    {CanonicalState::eS11, CanonicalEvent::A, "exit_S11 exit_S1 enter_S1 init_S1 enter_S11 during_S11 ",
+     CanonicalState::eS11},
+    {CanonicalState::eS11, CanonicalEvent::E,
+     "exit_S11 exit_S1 exit_S0 enter_S0 enter_S2 enter_S21 enter_S211 during_S211 ", CanonicalState::eS211},
+    {CanonicalState::eS211, CanonicalEvent::E,
+     "exit_S211 exit_S21 exit_S2 exit_S0 enter_S0 enter_S2 enter_S21 enter_S211 during_S211 ", CanonicalState::eS211},
+    {CanonicalState::eS211, CanonicalEvent::A, "during_S211 ", CanonicalState::eS211},
+    {CanonicalState::eS211, CanonicalEvent::H, "exit_S211 exit_S21 enter_S21 init_S21 enter_S211 during_S211 ",
+     CanonicalState::eS211},
+    {CanonicalState::eS211, CanonicalEvent::G,
+     "exit_S211 exit_S21 exit_S2 exit_S0 enter_S0 init_S0 enter_S1 init_S1 enter_S11 during_S11 ",
+     CanonicalState::eS11},
+};
+
+/// Run `scenario` on a new machine, capturing on the calling thread, and return what was captured
+std::string run(const Scenario& scenario)
+{
+    Canonical hsm;
+    if (scenario.from == CanonicalState::eS211)
+    {
+        hsm.directlySetStateForTestingOnly<S211>();
+    }
+    utils::TestLog::instance().startCapture();
+    hsm.dispatch(scenario.event);
+    hsm.during();
+    utils::TestLog::instance().stopCapture();
+    EXPECT_EQ(hsm.identify(), scenario.to);
+    return utils::TestLog::instance().getCaptured();
+}
+
+class CanonicalCaptureTest : public ::testing::Test {
+protected:
+    void SetUp() override
+    {
+        if (!utils::TestLog::kCompiledIn)
+        {
+            GTEST_SKIP() << "TestLog statements are compiled out";
+        }
+        utils::TestLog::instance().disable();
+    }
+    void TearDown() override { utils::TestLog::instance().enable(); }
+};
+
+TEST_F(CanonicalCaptureTest, EachScenarioLogsItsActions)
+{
+    for (const Scenario& scenario : kScenarios)
+    {
+        EXPECT_EQ(run(scenario), scenario.log);
+    }
+}
+
+TEST_F(CanonicalCaptureTest, ThreadsCaptureIndependently)
+{
+    constexpr int kThreads = 8;
+    constexpr int kRounds = 200;
+    utils::TestLog::instance().clearAll();
+    std::vector<int> mismatches(kThreads, 0);
+    std::atomic<int> started{0};
+    std::vector<std::thread> threads;
+    for (int thread = 0; thread < kThreads; ++thread)
+    {
+        threads.emplace_back([&mismatches, &started, thread]() {
+            // Every thread holds on to a shard of its own before any of them finishes
+            utils::TestLog::instance().startCapture();
+            ++started;
+            while (started < kThreads)
+            {
+                std::this_thread::yield();
+            }
+            for (int round = 0; round < kRounds; ++round)
+            {
+                const Scenario& scenario = kScenarios[static_cast<size_t>(round + thread) % kScenarios.size()];
+                mismatches[static_cast<size_t>(thread)] += run(scenario) != scenario.log;
+            }
+        });
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+    for (int thread = 0; thread < kThreads; ++thread)
+    {
+        EXPECT_EQ(mismatches[static_cast<size_t>(thread)], 0) << "thread " << thread;
+    }
+
+    // Each finished thread's last capture is still there in the merged view
+    size_t captures = 0;
+    utils::TestLog::instance().forEachCapture([&captures](std::string_view capture) {
+        captures += !capture.empty();
+        EXPECT_NE(capture.find("during_S"), std::string_view::npos);
+    });
+    EXPECT_EQ(captures, static_cast<size_t>(kThreads));
+}
+
 }  // namespace tests
 }  // namespace canonical
 }  // namespace examples
@@ -1,24 +1,20 @@
 // CDPlayer.hpp
 
 #include <chrono>
+#include <cstdint>
 
 #include "../../Hsm.hpp"
+#include "../../StateTable.hpp"
 #include "../../utils/TestLog.hpp"
+#include "wise_enum/wise_enum.h"
 
 namespace eta_hsm {
 namespace examples {
 namespace cd_player {
 
-enum class CdEvent { ePlay, eOpenClose, eStop, eCdDetected, ePause, eEndPause };
+WISE_ENUM_CLASS((CdEvent, int32_t), ePlay, eOpenClose, eStop, eCdDetected, ePause, eEndPause)
 
-enum class CdState {
-    eTop,
-    eStopped,
-    eOpen,
-    eEmpty,
-    ePlaying,
-    ePaused,
-};
+WISE_ENUM_CLASS((CdState, int32_t), eTop, eStopped, eOpen, eEmpty, ePlaying, ePaused)
 
 using PlayerTraits =
     eta_hsm::StateMachineTraits<CdEvent, CdState, std::chrono::steady_clock, DefaultActions::eEntryExitOnly>;
@@ -34,15 +30,15 @@ public:
 
     // Dummy action functions
     // I don't like these being public, but they have to be callable from state objects
-    void start_playback() { utils::TestLog::instance() << "(action) start_playback" << std::endl; }
-    void open_drawer() { utils::TestLog::instance() << "(action) open_drawer" << std::endl; }
-    void close_drawer() { utils::TestLog::instance() << "(action) close_drawer" << std::endl; }
-    void store_cd_info() { utils::TestLog::instance() << "(action) store_cd_info" << std::endl; }
-    void stop_playback() { utils::TestLog::instance() << "(action) stop_playback()" << std::endl; }
-    void pause_playback() { utils::TestLog::instance() << "(action) pause_playback" << std::endl; }
-    void resume_playback() { utils::TestLog::instance() << "(action) resume_playback" << std::endl; }
-    void stop_and_open() { utils::TestLog::instance() << "(action) stop_and_open" << std::endl; }
-    void stopped_again() { utils::TestLog::instance() << "(action) stopped_again" << std::endl; }
+    void start_playback() { ETA_HSM_TEST_LOG("(action) start_playback" << std::endl); }
+    void open_drawer() { ETA_HSM_TEST_LOG("(action) open_drawer" << std::endl); }
+    void close_drawer() { ETA_HSM_TEST_LOG("(action) close_drawer" << std::endl); }
+    void store_cd_info() { ETA_HSM_TEST_LOG("(action) store_cd_info" << std::endl); }
+    void stop_playback() { ETA_HSM_TEST_LOG("(action) stop_playback()" << std::endl); }
+    void pause_playback() { ETA_HSM_TEST_LOG("(action) pause_playback" << std::endl); }
+    void resume_playback() { ETA_HSM_TEST_LOG("(action) resume_playback" << std::endl); }
+    void stop_and_open() { ETA_HSM_TEST_LOG("(action) stop_and_open" << std::endl); }
+    void stopped_again() { ETA_HSM_TEST_LOG("(action) stopped_again" << std::endl); }
 
     template <CdState state>
     void entry()
@@ -67,6 +63,15 @@ using Empty = eta_hsm::LeafState<CdTraits<CdState::eEmpty>, Top>;
 using Playing = eta_hsm::LeafState<CdTraits<CdState::ePlaying>, Top>;
 using Paused = eta_hsm::LeafState<CdTraits<CdState::ePaused>, Top>;
 
+ETA_HSM_REGISTER_STATE(Player, Top, CdState);
+ETA_HSM_REGISTER_STATE(Player, Stopped, CdState);
+ETA_HSM_REGISTER_STATE(Player, Open, CdState);
+ETA_HSM_REGISTER_STATE(Player, Empty, CdState);
+ETA_HSM_REGISTER_STATE(Player, Playing, CdState);
+ETA_HSM_REGISTER_STATE(Player, Paused, CdState);
+
+using CdStateTable = StateTable<Player, wise_enum::size<CdState>>;
+
 }  // namespace cd_player
 }  // namespace examples
 }  // namespace eta_hsm
@@ -176,7 +176,7 @@ inline void examples::cd_player::Top::init(examples::cd_player::Player& player)
     // This declares which substate we default into
     Init<examples::cd_player::Stopped> i(player);
     // QUESTION: How often does this get run?
-    utils::TestLog::instance() << "(init) TopState" << std::endl;
+    ETA_HSM_TEST_LOG("(init) TopState" << std::endl);
 }
 
 }  // namespace eta_hsm
\ No newline at end of file
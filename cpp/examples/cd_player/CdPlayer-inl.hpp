@@ -13,74 +13,74 @@ namespace cd_player {
 template <>
 inline void Player::entry<CdState::eTop>()
 {
-    utils::TestLog::instance() << "(enter) TopState" << std::endl;
+    ETA_HSM_TEST_LOG("(enter) TopState" << std::endl);
 }
 
 template <>
 inline void Player::entry<CdState::eStopped>()
 {
-    utils::TestLog::instance() << "(enter) Stopped" << std::endl;
+    ETA_HSM_TEST_LOG("(enter) Stopped" << std::endl);
 }
 
 template <>
 inline void Player::entry<CdState::eOpen>()
 {
-    utils::TestLog::instance() << "(enter) Open" << std::endl;
+    ETA_HSM_TEST_LOG("(enter) Open" << std::endl);
 }
 
 template <>
 inline void Player::entry<CdState::eEmpty>()
 {
-    utils::TestLog::instance() << "(enter) Empty" << std::endl;
+    ETA_HSM_TEST_LOG("(enter) Empty" << std::endl);
 }
 
 template <>
 inline void Player::entry<CdState::ePlaying>()
 {
-    utils::TestLog::instance() << "(enter) Playing" << std::endl;
+    ETA_HSM_TEST_LOG("(enter) Playing" << std::endl);
 }
 
 template <>
 inline void Player::entry<CdState::ePaused>()
 {
-    utils::TestLog::instance() << "(enter) Entry" << std::endl;
+    ETA_HSM_TEST_LOG("(enter) Entry" << std::endl);
 }
 
 // exit actions
 template <>
 inline void Player::exit<CdState::eTop>()
 {
-    utils::TestLog::instance() << "(exit) TopState" << std::endl;
+    ETA_HSM_TEST_LOG("(exit) TopState" << std::endl);
 }
 
 template <>
 inline void Player::exit<CdState::eStopped>()
 {
-    utils::TestLog::instance() << "(exit) Stopped" << std::endl;
+    ETA_HSM_TEST_LOG("(exit) Stopped" << std::endl);
 }
 
 template <>
 inline void Player::exit<CdState::eOpen>()
 {
-    utils::TestLog::instance() << "(exit) Open" << std::endl;
+    ETA_HSM_TEST_LOG("(exit) Open" << std::endl);
 }
 
 template <>
 inline void Player::exit<CdState::eEmpty>()
 {
-    utils::TestLog::instance() << "(exit) Empty" << std::endl;
+    ETA_HSM_TEST_LOG("(exit) Empty" << std::endl);
 }
 
 template <>
 inline void Player::exit<CdState::ePlaying>()
 {
-    utils::TestLog::instance() << "(exit) Playing" << std::endl;
+    ETA_HSM_TEST_LOG("(exit) Playing" << std::endl);
 }
 
 template <>
 inline void Player::exit<CdState::ePaused>()
 {
-    utils::TestLog::instance() << "(exit) Entry" << std::endl;
+    ETA_HSM_TEST_LOG("(exit) Entry" << std::endl);
 }
 
 }  // namespace cd_player
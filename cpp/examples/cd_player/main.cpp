@@ -42,19 +42,7 @@ int main()
     TestLog::instance() << "Inject stop event" << std::endl;
     player.dispatch(CdEvent::eStop);
 
-    TestLog::instance().disable();
-
-    auto start_time = std::chrono::high_resolution_clock::now();
-    auto N = 1E6;
-    for (auto idx = 0; idx < N; idx++)
-    {
-        player.dispatch(CdEvent::ePlay);
-        player.dispatch(CdEvent::eStop);
-    }
-    auto stop_time = std::chrono::high_resolution_clock::now();
-    auto duration = std::chrono::duration_cast<std::chrono::microseconds>(stop_time - start_time);
-    TestLog::instance().enable();
-    TestLog::instance() << N << " play/stop cycles in " << duration.count() << " microseconds" << std::endl;
+    // for timing, see BM_CdPlayerPlayStop in benchmarks/dispatch_benchmark.cpp
 
     return 0;
 }  // main()
@@ -29,21 +29,21 @@ template <typename Current>
 inline void examples::controller::Awake::handleEvent(examples::controller::ExampleControl& stateMachine,
                                                      const Current& currentState, Event event) const
 {
-    utils::TestLog::instance() << "Awake::handleEvent()" << std::endl;
+    ETA_HSM_TEST_LOG("Awake::handleEvent()" << std::endl);
     switch (event)
     {
         case examples::controller::ExampleEvent::eDrinkBeer:
         {
             // We can cause state transitions based upon events, but we can
             // also take non-transitioning actions as well.
-            utils::TestLog::instance() << "Awake and drinking beer!" << std::endl;
+            ETA_HSM_TEST_LOG("Awake and drinking beer!" << std::endl);
             stateMachine.increaseBac(0.025);
             return;
         }
         case examples::controller::ExampleEvent::eDrinkWiskey:
         {
             // This is the strong stuff, so we take a different action
-            utils::TestLog::instance() << "Awake and drinking whiskey!" << std::endl;
+            ETA_HSM_TEST_LOG("Awake and drinking whiskey!" << std::endl);
             stateMachine.increaseBac(0.05);
             return;
         }
@@ -52,14 +52,14 @@ inline void examples::controller::Awake::handleEvent(examples::controller::Examp
            // StateMachine
             //       is only ever dispatched with a single utils.
             // In other words, utils prioritization happens long before we get here.
-            utils::TestLog::instance() << "Party over..." << std::endl;
+            ETA_HSM_TEST_LOG("Party over..." << std::endl);
             Transition<Current, ThisState, examples::controller::Unconcious> t(stateMachine);
             return;
         }
         case examples::controller::ExampleEvent::eStartWatch:
         {
             // We can now also set timers to fire events at specified points in the future
-            utils::TestLog::instance() << "setting timer to look at watch in 2 units of time" << std::endl;
+            ETA_HSM_TEST_LOG("setting timer to look at watch in 2 units of time" << std::endl);
             stateMachine.eventScheduler().addTimer(examples::controller::ExampleEvent::eLookAtWatch, kState,
                                                    std::chrono::milliseconds(2000));
             return;
@@ -75,14 +75,14 @@ template <typename Current>
 inline void examples::controller::Sober::handleEvent(examples::controller::ExampleControl& stateMachine,
                                                      const Current& currentState, Event event) const
 {
-    utils::TestLog::instance() << "Sober::handleEvent()" << std::endl;
+    ETA_HSM_TEST_LOG("Sober::handleEvent()" << std::endl);
     switch (event)
     {
         // By choosing to handle an event in the substate, we can override the behavior
         // declared in the superstate (Awake)
         case examples::controller::ExampleEvent::eDrinkBeer:
         {
-            utils::TestLog::instance() << "Sober and drinking beer!" << std::endl;
+            ETA_HSM_TEST_LOG("Sober and drinking beer!" << std::endl);
             stateMachine.increaseBac(0.025);
             if (stateMachine.getBac() >= 0.08)
             {
@@ -92,7 +92,7 @@ inline void examples::controller::Sober::handleEvent(examples::controller::Examp
         }
         case examples::controller::ExampleEvent::eDrinkWiskey:
         {
-            utils::TestLog::instance() << "Sober and drinking whiskey!" << std::endl;
+            ETA_HSM_TEST_LOG("Sober and drinking whiskey!" << std::endl);
             stateMachine.increaseBac(0.05);
             if (stateMachine.getBac() >= 0.08)
             {
@@ -102,7 +102,7 @@ inline void examples::controller::Sober::handleEvent(examples::controller::Examp
         }
         case examples::controller::ExampleEvent::eLookAtWatch:
         {
-            utils::TestLog::instance() << "Sober and looking at watch" << std::endl;
+            ETA_HSM_TEST_LOG("Sober and looking at watch" << std::endl);
             Transition<Current, ThisState, examples::controller::Bored> t(stateMachine);
             return;
         }
@@ -117,15 +117,15 @@ template <typename Current>
 inline void examples::controller::Drunk::handleEvent(examples::controller::ExampleControl& stateMachine,
                                                      const Current& currentState, Event event) const
 {
-    utils::TestLog::instance() << "Drunk::handleEvent()" << std::endl;
+    ETA_HSM_TEST_LOG("Drunk::handleEvent()" << std::endl);
     switch (event)
     {
         // By choosing to handle an event in the substate, we can override the behavior
         // declared in the superstate (Awake)
         case examples::controller::ExampleEvent::eLookAtWatch:
         {
-            utils::TestLog::instance() << "Drunk and looking at watch" << std::endl;
-            utils::TestLog::instance() << "Keep partying..." << std::endl;
+            ETA_HSM_TEST_LOG("Drunk and looking at watch" << std::endl);
+            ETA_HSM_TEST_LOG("Keep partying..." << std::endl);
             return;
         }
         default:
@@ -147,7 +147,7 @@ inline void examples::controller::Awake::init(examples::controller::ExampleContr
 {
     // This declares which substate we default into
     Init<examples::controller::Sober> i(stateMachine);
-    utils::TestLog::instance() << "init_Awake" << std::endl;
+    ETA_HSM_TEST_LOG("init_Awake" << std::endl);
 }
 
 template <>
@@ -155,7 +155,7 @@ inline void examples::controller::Top::init(examples::controller::ExampleControl
 {
     // This declares which substate we default into
     Init<examples::controller::Awake> i(stateMachine);
-    utils::TestLog::instance() << "init_Top" << std::endl;
+    ETA_HSM_TEST_LOG("init_Top" << std::endl);
 }
 
 // Entry, Exit, and During actions can now be given a more useful default behavior by passing an
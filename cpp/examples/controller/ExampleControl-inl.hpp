@@ -11,12 +11,13 @@ template <>
 inline void ExampleControl::stateUpdate<ExampleState::eSober>()
 {
     // Can use mpInput-> here to access inputs
-    utils::TestLog::instance() << "stateUpdate<eSober> " << std::endl;
+    ETA_HSM_TEST_LOG("stateUpdate<eSober> " << std::endl);
 
     // Possibly check for fault-like situations
     if (getBac() > 0.35)
-    {  // We can queue events directly from within the state machine if we want to
-        addEvent(ExampleEvent::ePassOut);
+    {  // We can raise events directly from within the state machine if we want to.  Unlike addEvent(), which
+       // would only be seen on the next update, raised events are handled as soon as this during action returns.
+        raise(ExampleEvent::ePassOut);
     }
     // Do something reasonable
     increaseBac(-0.01);  // metabolize alcohol
@@ -26,12 +27,12 @@ template <>
 inline void ExampleControl::stateUpdate<ExampleState::eDrunk>()
 {
     // Can use mpInput-> here to access inputs
-    utils::TestLog::instance() << "stateUpdate<eDrunk> " << std::endl;
+    ETA_HSM_TEST_LOG("stateUpdate<eDrunk> " << std::endl);
 
     // Possibly check for fault-like situations
     if (getBac() > 0.35)
     {
-        addEvent(ExampleEvent::ePassOut);
+        raise(ExampleEvent::ePassOut);
     }
     // Do something unreasonable
     increaseBac(-0.01);  // metabolize alcohol
@@ -40,14 +41,14 @@ inline void ExampleControl::stateUpdate<ExampleState::eDrunk>()
 template <>
 inline void ExampleControl::stateUpdate<ExampleState::eUnconcious>()
 {
-    utils::TestLog::instance() << "stateUpdate<eDead> " << std::endl;
+    ETA_HSM_TEST_LOG("stateUpdate<eDead> " << std::endl);
     // do nothing...
 }
 
 template <>
 inline void ExampleControl::stateUpdate<ExampleState::eBored>()
 {
-    utils::TestLog::instance() << "stateUpdate<eBored> " << std::endl;
+    ETA_HSM_TEST_LOG("stateUpdate<eBored> " << std::endl);
     // do nothing...
 }
 
@@ -56,7 +57,7 @@ inline void ExampleControl::entry<ExampleState::eAwake>()
 {
     // Yes, we can also now test awake-ness by querying state, but I'm keeping this around as an example
     // of how to manipulate controller-continuous-state with state-specialized entry/exit functions.
-    utils::TestLog::instance() << "enter_Awake " << std::endl;
+    ETA_HSM_TEST_LOG("enter_Awake " << std::endl);
     mAccumultedEntryExit += static_cast<int>(ExampleState::eAwake);
     mAwake = true;
 }
@@ -64,7 +65,7 @@ inline void ExampleControl::entry<ExampleState::eAwake>()
 template <>
 inline void ExampleControl::exit<ExampleState::eAwake>()
 {
-    utils::TestLog::instance() << "exit_Awake " << std::endl;
+    ETA_HSM_TEST_LOG("exit_Awake " << std::endl);
     mAccumultedEntryExit -= static_cast<int>(ExampleState::eAwake);
     mAwake = false;
 }
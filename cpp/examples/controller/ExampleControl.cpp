@@ -30,18 +30,12 @@ void ExampleControl::update(const examples::controller::Input& input)
     // so that I can pass in fake clock times.
     // mEventScheduler.checkTimers(std::chrono::system_clock::now(), mEventBucket);
 
-    // Select which event to dispatch state machine with.
+    // Select which events to dispatch state machine with.
     // Specific logic of how events are categorized, prioritized, flushed, etc... is up to the
-    // particular StateMachine.  This is intended just to show an example of what could be done.
-    // In any case, a single utils needs to be selected and "set" before calling dispatch,
-    // although there is nothing stopping you from dispatching the state machine multiple times
-    // in a single controller "update" if the time budget allows.
-    if (!mEventBucket.empty())
-    {
-        Event evt = mEventBucket.getEvent();
-        // TestLog::instance() << "Dispatching hsm with " << wise_enum::to_string(evt) << std::endl;
-        dispatch(evt);
-    }
+    // particular StateMachine (here, the bucket hands them out by priority).  Rather than dispatching
+    // a single event per update, which lets a backlog build up under bursts, dispatch as many as the
+    // update's budget allows and leave the rest for the next update.
+    drain(mEventBucket, kUpdateBudget);
 
     // Kick off the during action of the current state, which will call the appropriate stateUpdate()
     during();
@@ -54,7 +48,7 @@ void ExampleControl::increaseBac(Real amt)
     {
         mBac = 0.0;
     }
-    utils::TestLog::instance() << "BAC = " << mBac << std::endl;
+    ETA_HSM_TEST_LOG("BAC = " << mBac << std::endl);
 }
 
 }  // namespace controller
@@ -5,6 +5,7 @@
 #include <queue>
 
 #include "../../AutoLoggedStateMachine.hpp"
+#include "../../StateTable.hpp"
 #include "../../utils/TestLog.hpp"
 #include "../../utils/Timer.hpp"
 #include "wise_enum/wise_enum.h"
@@ -34,6 +35,7 @@ struct ExampleControlTraits {
     using StateEnum = ExampleState;
     static constexpr DefaultActions kDefaultActions = eta_hsm::DefaultActions::eControlUpdate;
     static constexpr bool kClearTimersOnExit = true;
+    static constexpr size_t kInternalQueueCapacity = 4;  // see StateMachine::raise
 };
 
 /// With eta-hsm, the top-level controller can BE the state machine
@@ -56,6 +58,11 @@ public:
     /// Get a reference to the EventScheduler interface for scheduling events
     EventScheduler& eventScheduler() { return mEventScheduler; }
 
+    /// Most events update() may dispatch per call.  Only a count, so that what an update does never depends on how
+    /// fast the machine running it is (and tests and fuzzers behave the same everywhere); a real controller would
+    /// add a maxTime on its steady clock.
+    static constexpr DrainBudget<std::chrono::steady_clock> kUpdateBudget{8};
+
     /// generic top-level update
     void update(const controller::Input& input);
 
@@ -66,14 +73,14 @@ public:
     template <ExampleState state>
     void entry()  // If called by hsm within "update", input is available as mInput
     {
-        utils::TestLog::instance() << "enter State " << wise_enum::to_string(state) << std::endl;
+        ETA_HSM_TEST_LOG("enter State " << wise_enum::to_string(state) << std::endl);
         mAccumultedEntryExit += static_cast<int>(state);
     }
 
     template <ExampleState state>
     void exit()  // If called by hsm within "update", input is available as mInput
     {
-        utils::TestLog::instance() << "exit State " << wise_enum::to_string(state) << std::endl;
+        ETA_HSM_TEST_LOG("exit State " << wise_enum::to_string(state) << std::endl);
         mAccumultedEntryExit -= static_cast<int>(state);
     }
 
@@ -123,6 +130,15 @@ using Drunk = eta_hsm::LeafState<ExampleTraits<ExampleState::eDrunk>, Awake>;
 using Bored = eta_hsm::LeafState<ExampleTraits<ExampleState::eBored>, Awake>;
 using Unconcious = eta_hsm::LeafState<ExampleTraits<ExampleState::eUnconcious>, Top>;
 
+ETA_HSM_REGISTER_STATE(ExampleControl, Top, ExampleState);
+ETA_HSM_REGISTER_STATE(ExampleControl, Awake, ExampleState);
+ETA_HSM_REGISTER_STATE(ExampleControl, Sober, ExampleState);
+ETA_HSM_REGISTER_STATE(ExampleControl, Drunk, ExampleState);
+ETA_HSM_REGISTER_STATE(ExampleControl, Bored, ExampleState);
+ETA_HSM_REGISTER_STATE(ExampleControl, Unconcious, ExampleState);
+
+using ExampleStateTable = StateTable<ExampleControl, wise_enum::size<ExampleState>>;
+
 }  // namespace controller
 }  // namespace examples
 }  // namespace eta_hsm
@@ -25,6 +25,44 @@ TEST_F(ExampleControlTest, TransitionLoggingTest)
     EXPECT_EQ(example_control_hsm_.identify(), ExampleState::eDrunk);
 }
 
+TEST_F(ExampleControlTest, PassOutWithinSameUpdateTest)
+{
+    for (int idx = 0; idx < 8; ++idx)
+    {
+        example_control_hsm_.dispatch(ExampleEvent::eDrinkWiskey);
+    }
+    EXPECT_EQ(example_control_hsm_.identify(), ExampleState::eDrunk);
+
+    // The during action notices the BAC and raises ePassOut, which is handled before update() returns rather than
+    // waiting in the event bucket for the next update
+    example_control_hsm_.update(Input{});
+    EXPECT_EQ(example_control_hsm_.identify(), ExampleState::eUnconcious);
+}
+
+TEST_F(ExampleControlTest, RaisedEventIsLoggedAsTheCauseTest)
+{
+    for (int idx = 0; idx < 8; ++idx)
+    {
+        example_control_hsm_.dispatch(ExampleEvent::eDrinkWiskey);
+    }
+    utils::TestLog::instance().startCapture();
+    example_control_hsm_.update(Input{});
+    utils::TestLog::instance().stopCapture();
+    EXPECT_EQ(example_control_hsm_.identify(), ExampleState::eUnconcious);
+    EXPECT_NE(utils::TestLog::instance().getCaptured().find("from eDrunk to eUnconcious due to ePassOut"),
+              std::string::npos);
+}
+
+TEST_F(ExampleControlTest, UpdateDrainsBurstTest)
+{
+    // A burst of events no longer takes one update per event to work through
+    example_control_hsm_.addEvent(ExampleEvent::eDrinkWiskey);
+    example_control_hsm_.addEvent(ExampleEvent::eDrinkWiskey);
+    example_control_hsm_.addEvent(ExampleEvent::eDrinkWiskey);
+    example_control_hsm_.update(Input{});
+    EXPECT_EQ(example_control_hsm_.identify(), ExampleState::eDrunk);
+}
+
 }  // namespace tests
 }  // namespace controller
 }  // namespace examples
@@ -0,0 +1,364 @@
+// eta/hsm/fuzz/Explorer.hpp
+
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <ostream>
+#include <random>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "../HsmTestRunner.hpp"
+#include "../utils/ConcurrentHashSet.hpp"
+#include "../utils/ForkJoinPool.hpp"
+#include "FuzzHarness.hpp"
+
+namespace eta_hsm {
+namespace fuzz {
+
+/// What set off a transition seen by the Explorer
+enum class Cause { eEvent, eStep, eTimers };
+
+/// A transition (from one leaf to another, or back to the same one) that the Explorer saw taken
+template <typename Machine>
+struct ExploredTransition {
+    typename Machine::StateEnum from;
+    Cause cause;
+    typename Machine::Event event;  // only meaningful if cause == Cause::eEvent
+    typename Machine::StateEnum to;
+};
+
+/// What an Explorer found
+template <typename Machine>
+struct ExplorationReport {
+    using StateEnum = typename Machine::StateEnum;
+    using Event = typename Machine::Event;
+    using Transition = ExploredTransition<Machine>;
+
+    size_t walks{0};
+    uint64_t steps{0};
+    size_t configurations{0};  // distinct (leaf, armed timers) pairs reached
+    bool overflowed{false};    // the visited set filled up, so some of the above may be missing
+
+    std::vector<StateEnum> unreachedStates{};  // registered states that were never active
+    std::vector<Event> unhandledEvents{};      // events that never changed the leaf or the armed timers
+    std::vector<Transition> taken{};
+
+    /// The transitions among `possible` (e.g. from a ConformanceRunner, which tries every event in every leaf) that
+    /// were never taken, i.e. those that start from configurations the machine never actually gets into
+    std::vector<testing::ConformanceCell<Machine>> untaken(
+        const std::vector<testing::ConformanceCell<Machine>>& possible) const
+    {
+        std::vector<testing::ConformanceCell<Machine>> untaken;
+        for (const auto& cell : possible)
+        {
+            bool found = cell.transitions == 0;  // not a transition at all
+            for (size_t idx = 0; idx < taken.size() && !found; ++idx)
+            {
+                found = taken[idx].cause == Cause::eEvent && taken[idx].from == cell.from &&
+                        taken[idx].event == cell.event && taken[idx].to == cell.to;
+            }
+            if (!found)
+            {
+                untaken.push_back(cell);
+            }
+        }
+        return untaken;
+    }
+
+    void print(std::ostream& os) const
+    {
+        using testing::detail::enumToString;
+        os << walks << " walks, " << steps << " steps, " << configurations << " (leaf, armed timers) configurations"
+           << (overflowed ? " (visited set overflowed, results are incomplete)" : "") << '\n';
+        os << "states never reached:";
+        for (const StateEnum state : unreachedStates)
+        {
+            os << ' ' << enumToString(state);
+        }
+        os << "\nevents never handled:";
+        for (const Event event : unhandledEvents)
+        {
+            os << ' ' << enumToString(event);
+        }
+        os << "\ntransitions taken:\n";
+        for (const Transition& transition : taken)
+        {
+            os << "    " << enumToString(transition.from) << " + "
+               << (transition.cause == Cause::eEvent  ? enumToString(transition.event)
+                   : transition.cause == Cause::eStep ? std::string{"(step)"}
+                                                      : std::string{"(timers)"})
+               << " -> " << enumToString(transition.to) << '\n';
+        }
+    }
+};
+
+/// Explores the configurations a machine can reach, (leaf, armed timers) pairs, with many independent random walks
+/// run in parallel on a ForkJoinPool.  Each walk starts from a freshly constructed machine and takes random steps of
+/// the same kinds as FuzzHarness (events, clock advances and steps), described by the same Adapter.  Armed timers are
+/// only told apart if the Adapter has forEachTimerGroup(), and then by their groups.
+///
+/// Everything a walk sees (configurations, handled events and transitions) goes into one ConcurrentHashSet shared by
+/// every walk.  To keep walks from hammering the shared set with what they have already seen, each one first checks a
+/// small direct-mapped cache of its own.
+template <typename Adapter>
+class Explorer {
+public:
+    using Machine = typename Adapter::Machine;
+    using StateEnum = typename Machine::StateEnum;
+    using Event = typename Machine::Event;
+    using Table = typename Adapter::Table;
+    using TimePoint = std::chrono::time_point<typename Adapter::Clock>;
+    using Report = ExplorationReport<Machine>;
+
+    static_assert(wise_enum::is_wise_enum_v<Event>, "Explorer finds the events of a machine through wise_enum");
+
+    /// `capacity` bounds the number of distinct configurations, handled events and transitions that can be recorded
+    explicit Explorer(utils::ForkJoinPool& pool, size_t capacity = 1 << 16) : mPool{pool}, mVisited{capacity} {}
+
+    /// Run `walks` random walks of `steps` steps each (reproducibly, given `seed`) and report on everything seen so
+    /// far, including by earlier calls
+    Report explore(size_t walks, size_t steps, uint64_t seed = 1)
+    {
+        mPool.run(walks, [&](size_t walk) { this->walk(seed * 0x9e3779b97f4a7c15ULL + walk, steps); });
+        mWalks += walks;
+        mSteps += walks * steps;
+        return report();
+    }
+
+protected:
+private:
+    static constexpr uint64_t kConfiguration = uint64_t{1} << 62;
+    static constexpr uint64_t kHandled = uint64_t{2} << 62;
+    static constexpr uint64_t kTransition = uint64_t{3} << 62;
+    static constexpr uint64_t kKindMask = uint64_t{3} << 62;
+    static constexpr uint64_t kStepCause = 0xffff;
+    static constexpr uint64_t kTimersCause = 0xfffe;
+
+    /// Forwards keys to the shared set, unless this walk has recently done so
+    class Recorder {
+    public:
+        explicit Recorder(utils::ConcurrentHashSet& shared) : mShared{shared} {}
+
+        void record(uint64_t key)
+        {
+            uint64_t& cached = mCache[(key ^ (key >> 17) ^ (key >> 35)) % kCacheSlots];
+            if (cached != key)
+            {
+                cached = key;
+                mShared.insert(key);
+            }
+        }
+
+    private:
+        static constexpr size_t kCacheSlots = 1021;
+        utils::ConcurrentHashSet& mShared;
+        uint64_t mCache[kCacheSlots]{};
+    };
+
+    static uint64_t toBits(StateEnum state) { return static_cast<uint64_t>(state) & 0xffff; }
+
+    /// An order-independent hash of the groups of the armed timers
+    static uint32_t timerSignature(Machine& machine, TimePoint now)
+    {
+        uint64_t signature = 0;
+        if constexpr (detail::HasTimerGroups<Adapter>::value)
+        {
+            Adapter::forEachTimerGroup(machine, now, [&signature](auto group) {
+                uint64_t bits = static_cast<uint64_t>(group) + 1;
+                bits *= 0x9e3779b97f4a7c15ULL;
+                signature += bits ^ (bits >> 29);
+            });
+        }
+        return static_cast<uint32_t>(signature ^ (signature >> 32));
+    }
+
+    void walk(uint64_t seed, size_t steps)
+    {
+        std::mt19937_64 rng{seed};
+        Recorder recorder{mVisited};
+        Machine machine;
+        TimePoint now{};
+        StateEnum leaf = machine.identify();
+        uint32_t timers = timerSignature(machine, now);
+        recorder.record(kConfiguration | toBits(leaf) << 32 | timers);
+
+        for (size_t step = 0; step < steps; ++step)
+        {
+            const uint64_t before = machine.transitions();
+            const uint64_t roll = rng();
+            uint64_t cause;
+            // Mostly events, with enough clock advances and steps mixed in for timers to fire
+            if (roll % 8 < 6)
+            {
+                // Events are keyed by their position in wise_enum::range, as their values need not be contiguous
+                cause = (roll >> 8) % wise_enum::size<Event>;
+                machine.dispatch(wise_enum::range<Event>[cause].value);
+            }
+            else if (roll % 8 == 6)
+            {
+                now += Adapter::kTick * static_cast<int>(((roll >> 8) & 0x3f) + 1);
+                Adapter::fireTimers(machine, now);
+                cause = kTimersCause;
+            }
+            else
+            {
+                Adapter::step(machine);
+                cause = kStepCause;
+            }
+
+            const StateEnum next = machine.identify();
+            const uint32_t nextTimers = timerSignature(machine, now);
+            if (machine.transitions() != before)
+            {
+                recorder.record(kTransition | toBits(leaf) << 32 | cause << 16 | toBits(next));
+            }
+            if (cause < kTimersCause && (machine.transitions() != before || nextTimers != timers))
+            {
+                recorder.record(kHandled | cause);
+            }
+            leaf = next;
+            timers = nextTimers;
+            recorder.record(kConfiguration | toBits(leaf) << 32 | timers);
+        }
+    }
+
+    Report report() const
+    {
+        Report report;
+        report.walks = mWalks;
+        report.steps = mSteps;
+        report.overflowed = mVisited.overflowed();
+
+        std::vector<bool> leafReached(Table::size(), false);
+        std::vector<bool> eventHandled(wise_enum::size<Event>, false);
+        mVisited.forEach([&](uint64_t key) {
+            switch (key & kKindMask)
+            {
+                case kConfiguration:
+                    ++report.configurations;
+                    leafReached[(key >> 32) & 0xffff] = true;
+                    break;
+                case kHandled:
+                    eventHandled[key & 0xffff] = true;
+                    break;
+                default:
+                {
+                    const uint64_t cause = (key >> 16) & 0xffff;
+                    report.taken.push_back({static_cast<StateEnum>((key >> 32) & 0xffff),
+                                            cause == kStepCause     ? Cause::eStep
+                                            : cause == kTimersCause ? Cause::eTimers
+                                                                    : Cause::eEvent,
+                                            wise_enum::range<Event>[cause < kTimersCause ? cause : 0].value,
+                                            static_cast<StateEnum>(key & 0xffff)});
+                }
+            }
+        });
+
+        for (size_t idx = 0; idx < Table::size(); ++idx)
+        {
+            const auto state = static_cast<StateEnum>(idx);
+            if (!Table::isDeclared(state))
+            {
+                continue;
+            }
+            bool reached = false;
+            for (size_t leafIdx = 0; leafIdx < Table::size() && !reached; ++leafIdx)
+            {
+                reached = leafReached[leafIdx] && Table::leaf(static_cast<StateEnum>(leafIdx))->isSubstateOf(state);
+            }
+            if (!reached)
+            {
+                report.unreachedStates.push_back(state);
+            }
+        }
+        for (size_t idx = 0; idx < eventHandled.size(); ++idx)
+        {
+            if (!eventHandled[idx])
+            {
+                report.unhandledEvents.push_back(wise_enum::range<Event>[idx].value);
+            }
+        }
+        std::sort(report.taken.begin(), report.taken.end(), [](const auto& lhs, const auto& rhs) {
+            return std::tie(lhs.from, lhs.cause, lhs.event, lhs.to) < std::tie(rhs.from, rhs.cause, rhs.event, rhs.to);
+        });
+        return report;
+    }
+
+    utils::ForkJoinPool& mPool;
+    utils::ConcurrentHashSet mVisited;
+    size_t mWalks{0};
+    uint64_t mSteps{0};
+};
+
+/// For ExplorerMain.cpp (see ETA_HSM_EXPLORER_TARGET):  explore the machine described by Adapter and print what was
+/// found, followed by the transitions a ConformanceRunner finds possible that were never taken.
+///
+///     <explorer> [-walks=N] [-steps=S] [-seed=X] [-capacity=C]
+template <typename Adapter>
+int exploreMain(int argc, char** argv)
+{
+    using Machine = typename Adapter::Machine;
+    size_t walks = 1000;
+    size_t steps = 200;
+    uint64_t seed = 1;
+    size_t capacity = 1 << 16;
+    for (int idx = 1; idx < argc; ++idx)
+    {
+        const std::string arg{argv[idx]};
+        if (arg.rfind("-walks=", 0) == 0)
+        {
+            walks = std::stoul(arg.substr(7));
+        }
+        else if (arg.rfind("-steps=", 0) == 0)
+        {
+            steps = std::stoul(arg.substr(7));
+        }
+        else if (arg.rfind("-seed=", 0) == 0)
+        {
+            seed = std::stoull(arg.substr(6));
+        }
+        else if (arg.rfind("-capacity=", 0) == 0)
+        {
+            capacity = std::stoul(arg.substr(10));
+        }
+        else
+        {
+            std::cerr << "ignoring unsupported argument " << arg << std::endl;
+        }
+    }
+
+    // Quiet before the machines are constructed, as constructing one runs its entry actions
+    utils::TestLog::instance().disable();
+    utils::ForkJoinPool pool;
+    Explorer<Adapter> explorer{pool, capacity};
+    const auto report = explorer.explore(walks, steps, seed);
+    report.print(std::cout);
+
+    const Machine prototype{};
+    testing::ConformanceRunner<Machine, typename Adapter::Table> runner{pool, prototype};
+    std::cout << "possible transitions never taken:\n";
+    for (const auto& cell : report.untaken(runner.run()))
+    {
+        std::cout << "    " << testing::detail::enumToString(cell.from) << " + "
+                  << testing::detail::enumToString(cell.event) << " -> " << testing::detail::enumToString(cell.to)
+                  << '\n';
+    }
+    return report.overflowed ? 1 : 0;
+}
+
+}  // namespace fuzz
+}  // namespace eta_hsm
+
+/// Define the entry point of ExplorerMain.cpp for the machine described by `adapter` (see FuzzHarness), so that the
+/// same file can be built both as a fuzzer and as an explorer.  Use once per executable.
+#define ETA_HSM_EXPLORER_TARGET(adapter)                                                 \
+    int etaHsmExplore(int argc, char** argv)                                             \
+    {                                                                                    \
+        return ::eta_hsm::fuzz::exploreMain<adapter>(argc, argv);                        \
+    }
@@ -0,0 +1,12 @@
+// ExplorerMain.cpp
+//
+// The main() of the explorers, which share their adapters with the fuzzers (see Explorer.hpp):
+//
+//     <explorer> [-walks=N] [-steps=S] [-seed=X] [-capacity=C]
+//
+// Prints the states never reached, the events never handled and the transitions taken and never taken.  Exits with 1
+// if the visited set overflowed (raise -capacity), and 0 otherwise.
+
+int etaHsmExplore(int argc, char** argv);
+
+int main(int argc, char** argv) { return etaHsmExplore(argc, argv); }
@@ -0,0 +1,184 @@
+// eta/hsm/fuzz/FuzzHarness.hpp
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <type_traits>
+
+#include "../Hsm.hpp"
+#include "../StateTable.hpp"
+#include "../utils/TestLog.hpp"
+#include "wise_enum/wise_enum.h"
+
+namespace eta_hsm {
+namespace fuzz {
+
+namespace detail {
+
+template <typename Adapter, typename = void>
+struct HasEntryExitBalance : std::false_type {};
+template <typename Adapter>
+struct HasEntryExitBalance<Adapter, std::void_t<decltype(Adapter::entryExitBalance(
+                                        std::declval<typename Adapter::Machine&>()))>> : std::true_type {};
+
+struct IgnoreTimerGroup {
+    template <typename Group>
+    void operator()(Group) const
+    {}
+};
+
+template <typename Adapter, typename = void>
+struct HasTimerGroups : std::false_type {};
+template <typename Adapter>
+struct HasTimerGroups<Adapter, std::void_t<decltype(Adapter::forEachTimerGroup(
+                                   std::declval<typename Adapter::Machine&>(),
+                                   std::declval<std::chrono::time_point<typename Adapter::Clock>>(),
+                                   IgnoreTimerGroup{}))>> : std::true_type {};
+
+}  // namespace detail
+
+/// Turns a fuzzer's byte stream into events, clock advances and during() calls for a StateMachine, checking after
+/// every step that the machine is still sane.  Each byte is one step:
+///
+///     0b0xxxxxxx  dispatch event number xxxxxxx (modulo the number of events)
+///     0b10xxxxxx  advance the clock by xxxxxx + 1 ticks and fire whatever timers have expired
+///     0b11xxxxxx  step the machine (during(), or whatever else the adapter does once per cycle)
+///
+/// What a machine needs is described by an Adapter:
+///
+///     struct Adapter {
+///         using Machine = ...;   // events must be a wise_enum
+///         using Table = ...;     // the machine's StateTable, to tell leaves apart
+///         using Clock = ...;     // the clock of the machine's timers (any clock, it is never read)
+///         static constexpr typename Clock::duration kTick = ...;
+///         static void fireTimers(Machine&, std::chrono::time_point<Clock> now);
+///         static void step(Machine&);
+///
+///         // Optional:  the group of every armed timer, checked against the active states when the machine clears
+///         // timers on exit (kClearTimersOnExit)
+///         template <typename Visit>
+///         static void forEachTimerGroup(Machine&, std::chrono::time_point<Clock> now, Visit&& visit);
+///
+///         // Optional:  a count that every entry into state s raises by int(s) and every exit lowers by int(s), which
+///         // must therefore always equal the sum over the active states
+///         static int entryExitBalance(Machine&);
+///     };
+///
+/// One harness (and one machine) lives for the whole fuzzing run.  Every input starts by copy-assigning a pristine
+/// machine over the working one, which reuses whatever the working one's containers have already allocated, and
+/// TestLog output is turned off, so the per-input cost is the steps themselves.  A failed check prints what went
+/// wrong and aborts, which the fuzzer reports as a crash along with the input that caused it.
+template <typename Adapter>
+class FuzzHarness {
+public:
+    using Machine = typename Adapter::Machine;
+    using Event = typename Machine::Event;
+    using StateEnum = typename Machine::StateEnum;
+    using Table = typename Adapter::Table;
+    using TimePoint = std::chrono::time_point<typename Adapter::Clock>;
+
+    static_assert(wise_enum::is_wise_enum_v<Event>, "FuzzHarness finds the events of a machine through wise_enum");
+
+    /// For LLVMFuzzerTestOneInput (see ETA_HSM_FUZZ_TARGET)
+    static int testOneInput(const uint8_t* data, size_t size)
+    {
+        // Quiet before the machines are constructed, as constructing one runs its entry actions
+        static const bool sQuiet = (utils::TestLog::instance().disable(), true);
+        static FuzzHarness sHarness;
+        (void)sQuiet;
+        sHarness.run(data, size);
+        return 0;
+    }
+
+    /// Run one input on the working machine, from the pristine state
+    void run(const uint8_t* data, size_t size)
+    {
+        mMachine = mPristine;
+        mNow = TimePoint{};
+        check();
+        for (size_t idx = 0; idx < size; ++idx)
+        {
+            const uint8_t byte = data[idx];
+            if ((byte & 0x80) == 0)
+            {
+                mMachine.dispatch(wise_enum::range<Event>[byte % wise_enum::size<Event>].value);
+            }
+            else if ((byte & 0x40) == 0)
+            {
+                mNow += Adapter::kTick * ((byte & 0x3f) + 1);
+                Adapter::fireTimers(mMachine, mNow);
+            }
+            else
+            {
+                Adapter::step(mMachine);
+            }
+            check();
+        }
+    }
+
+    const Machine& machine() const { return mMachine; }
+
+protected:
+private:
+    FuzzHarness() = default;
+
+    void check()
+    {
+        const StateEnum state = mMachine.identify();
+        if (!Table::isLeaf(state))
+        {
+            fail("the current state is not a leaf");
+        }
+
+        if constexpr (Machine::kClearTimersOnExit && detail::HasTimerGroups<Adapter>::value)
+        {
+            Adapter::forEachTimerGroup(mMachine, mNow, [this](StateEnum group) {
+                if (!mMachine.isInSubstateOf(group))
+                {
+                    fail("a timer outlived the state it belongs to");
+                }
+            });
+        }
+
+        if constexpr (detail::HasEntryExitBalance<Adapter>::value)
+        {
+            int active = 0;
+            for (size_t idx = 0; idx < Table::size(); ++idx)
+            {
+                const auto candidate = static_cast<StateEnum>(idx);
+                if (Table::isDeclared(candidate) && mMachine.isInSubstateOf(candidate))
+                {
+                    active += static_cast<int>(idx);
+                }
+            }
+            if (Adapter::entryExitBalance(mMachine) != active)
+            {
+                fail("entries and exits do not balance");
+            }
+        }
+    }
+
+    [[noreturn]] void fail(const char* what) const
+    {
+        std::fprintf(stderr, "FuzzHarness: %s (in state %d)\n", what, static_cast<int>(mMachine.identify()));
+        std::abort();
+    }
+
+    const Machine mPristine{};
+    Machine mMachine{};
+    TimePoint mNow{};
+};
+
+}  // namespace fuzz
+}  // namespace eta_hsm
+
+/// Define LLVMFuzzerTestOneInput for the machine described by `adapter` (see FuzzHarness).  Use once per executable.
+#define ETA_HSM_FUZZ_TARGET(adapter)                                                     \
+    extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size)              \
+    {                                                                                    \
+        return ::eta_hsm::fuzz::FuzzHarness<adapter>::testOneInput(data, size);          \
+    }
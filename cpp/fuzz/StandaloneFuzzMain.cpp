@@ -0,0 +1,105 @@
+// StandaloneFuzzMain.cpp
+//
+// Stands in for libFuzzer's main() where libFuzzer is not available (e.g. with gcc), so that the harnesses still
+// build, can replay crash reproducers and corpora, and can be smoke tested with random inputs:
+//
+//     <fuzzer> [-runs=N] [-seed=S] [-max_len=L] [file or directory ...]
+//
+// Files (and the files in directories) are run once each; with none, N random inputs of up to L bytes are run.
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <random>
+#include <string>
+#include <vector>
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size);
+
+namespace {
+
+size_t runFile(const std::filesystem::path& path)
+{
+    std::ifstream input{path, std::ios::binary};
+    const std::vector<uint8_t> bytes{std::istreambuf_iterator<char>(input), std::istreambuf_iterator<char>()};
+    LLVMFuzzerTestOneInput(bytes.data(), bytes.size());
+    return 1;
+}
+
+}  // namespace
+
+int main(int argc, char** argv)
+{
+    size_t runs = 10000;
+    uint32_t seed = 1;
+    size_t maxLength = 256;
+    std::vector<std::filesystem::path> paths;
+    for (int idx = 1; idx < argc; ++idx)
+    {
+        const std::string arg{argv[idx]};
+        if (arg.rfind("-runs=", 0) == 0)
+        {
+            runs = std::stoul(arg.substr(6));
+        }
+        else if (arg.rfind("-seed=", 0) == 0)
+        {
+            seed = static_cast<uint32_t>(std::stoul(arg.substr(6)));
+        }
+        else if (arg.rfind("-max_len=", 0) == 0)
+        {
+            maxLength = std::stoul(arg.substr(9));
+        }
+        else if (arg.rfind('-', 0) == 0)
+        {
+            std::cerr << "ignoring unsupported option " << arg << std::endl;
+        }
+        else
+        {
+            paths.emplace_back(arg);
+        }
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    size_t executed = 0;
+    if (!paths.empty())
+    {
+        for (const auto& path : paths)
+        {
+            if (std::filesystem::is_directory(path))
+            {
+                for (const auto& entry : std::filesystem::directory_iterator(path))
+                {
+                    executed += entry.is_regular_file() ? runFile(entry.path()) : 0;
+                }
+            }
+            else
+            {
+                executed += runFile(path);
+            }
+        }
+    }
+    else
+    {
+        std::mt19937 rng{seed};
+        std::uniform_int_distribution<size_t> length(0, maxLength);
+        std::uniform_int_distribution<int> byte(0, 255);
+        std::vector<uint8_t> input(maxLength);
+        for (; executed < runs; ++executed)
+        {
+            const size_t size = length(rng);
+            for (size_t idx = 0; idx < size; ++idx)
+            {
+                input[idx] = static_cast<uint8_t>(byte(rng));
+            }
+            LLVMFuzzerTestOneInput(input.data(), size);
+        }
+    }
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    std::cerr << "ran " << executed << " inputs in " << elapsed.count() << " s ("
+              << static_cast<double>(executed) / elapsed.count() << " exec/s)" << std::endl;
+    return 0;
+}
@@ -0,0 +1,25 @@
+// canonical_fuzzer.cpp
+
+#include "../examples/canonical/Canonical.hpp"
+#include "Explorer.hpp"
+#include "FuzzHarness.hpp"
+
+namespace eta_hsm {
+namespace fuzz {
+
+/// The canonical example has no timers, and the clock only has to exist
+struct CanonicalAdapter {
+    using Machine = examples::canonical::Canonical;
+    using Table = examples::canonical::CanonicalStateTable;
+    using Clock = std::chrono::steady_clock;
+    static constexpr Clock::duration kTick = std::chrono::milliseconds(1);
+
+    static void fireTimers(Machine&, std::chrono::time_point<Clock>) {}
+    static void step(Machine& machine) { machine.during(); }
+};
+
+}  // namespace fuzz
+}  // namespace eta_hsm
+
+ETA_HSM_FUZZ_TARGET(eta_hsm::fuzz::CanonicalAdapter)
+ETA_HSM_EXPLORER_TARGET(eta_hsm::fuzz::CanonicalAdapter)
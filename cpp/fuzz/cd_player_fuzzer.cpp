@@ -0,0 +1,25 @@
+// cd_player_fuzzer.cpp
+
+#include "../examples/cd_player/CDPlayer.hpp"
+#include "Explorer.hpp"
+#include "FuzzHarness.hpp"
+
+namespace eta_hsm {
+namespace fuzz {
+
+/// The CD player has no timers and nothing to do between events, so everything interesting is in the event order
+struct CdPlayerAdapter {
+    using Machine = examples::cd_player::Player;
+    using Table = examples::cd_player::CdStateTable;
+    using Clock = std::chrono::steady_clock;
+    static constexpr Clock::duration kTick = std::chrono::milliseconds(1);
+
+    static void fireTimers(Machine&, std::chrono::time_point<Clock>) {}
+    static void step(Machine& machine) { machine.during(); }
+};
+
+}  // namespace fuzz
+}  // namespace eta_hsm
+
+ETA_HSM_FUZZ_TARGET(eta_hsm::fuzz::CdPlayerAdapter)
+ETA_HSM_EXPLORER_TARGET(eta_hsm::fuzz::CdPlayerAdapter)
@@ -0,0 +1,48 @@
+// controller_fuzzer.cpp
+
+#include "../examples/controller/ExampleControl.hpp"
+#include "Explorer.hpp"
+#include "FuzzHarness.hpp"
+
+namespace eta_hsm {
+namespace fuzz {
+
+/// The controller queues events (including fired timers) in its bucket, and drains them in update()
+struct ControllerAdapter {
+    using Machine = examples::controller::ExampleControl;
+    using Table = examples::controller::ExampleStateTable;
+    using Clock = Machine::Clock;
+    static constexpr Clock::duration kTick = std::chrono::milliseconds(100);
+
+    /// More than the controller ever arms at once
+    static constexpr size_t kMaxTimers = 16;
+
+    static void fireTimers(Machine& machine, std::chrono::time_point<Clock> now)
+    {
+        machine.eventScheduler().checkTimers(now, machine.eventBucket());
+    }
+
+    static void step(Machine& machine)
+    {
+        static const examples::controller::Input kInput{};
+        machine.update(kInput);
+    }
+
+    template <typename Visit>
+    static void forEachTimerGroup(Machine& machine, std::chrono::time_point<Clock> now, Visit&& visit)
+    {
+        const auto snap = machine.eventScheduler().snapshot<kMaxTimers>(now);
+        for (uint32_t idx = 0; idx < snap.count; ++idx)
+        {
+            visit(snap.timers[idx].groupId);
+        }
+    }
+
+    static int entryExitBalance(Machine& machine) { return machine.accumulatedEntryExit(); }
+};
+
+}  // namespace fuzz
+}  // namespace eta_hsm
+
+ETA_HSM_FUZZ_TARGET(eta_hsm::fuzz::ControllerAdapter)
+ETA_HSM_EXPLORER_TARGET(eta_hsm::fuzz::ControllerAdapter)
@@ -2,80 +2,55 @@
 
 #pragma once
 
-#include "../Hsm.hpp"
-//#include "eta/once/once.hpp"
-
-#include <functional>
-#include <map>
 #include <type_traits>
 
-namespace eta {
-namespace hsm {
-
-template <class T>
-struct isLeaf {
-    template <typename C>
-    static constexpr decltype(std::declval<C>().instanceForTestingOnly(), bool()) test(int)
-    {
-        return true;
-    }
-
-    template <typename C>
-    static constexpr bool test(...)
-    {
-        return false;
-    }
+#include "../Hsm.hpp"
+#include "../StateTable.hpp"
 
-    static constexpr bool value = test<T>(int());
-};
+/// Bound (exclusive) on the StateEnum values of the machines declared with these macros; it sizes their StateTable
+#ifndef ETA_HSM_MAX_STATES
+#define ETA_HSM_MAX_STATES 64
+#endif
 
+// The testing helpers are templates (defaulted to the controller) so that the StateTable behind them is only built
+// where they are used, by which point every state has been declared and registered.
 #define ETA_HSM_DECLARE_TOP_STATE_IMPL(controller, name, state_enum)                                 \
     template <state_enum kState>                                                                     \
-    using controller##StateMachineTraits = hsm::StateTraits<controller, state_enum, kState>;         \
+    using controller##StateMachineTraits = ::eta_hsm::StateTraits<controller, state_enum, kState>;   \
                                                                                                      \
     template <state_enum state, typename parent>                                                     \
-    using CompState = hsm::CompState<controller##StateMachineTraits<state>, parent>;                 \
+    using CompState = ::eta_hsm::CompState<controller##StateMachineTraits<state>, parent>;           \
                                                                                                      \
     template <state_enum state, typename parent>                                                     \
-    using LeafState = hsm::LeafState<controller##StateMachineTraits<state>, parent>;                 \
+    using LeafState = ::eta_hsm::LeafState<controller##StateMachineTraits<state>, parent>;           \
                                                                                                      \
-    using name = eta::hsm::TopState<controller##StateMachineTraits<state_enum::e##name>>;            \
+    using name = ::eta_hsm::TopState<controller##StateMachineTraits<state_enum::e##name>>;           \
                                                                                                      \
-    namespace testing {                                                                              \
+    using controller##StateTable = ::eta_hsm::StateTable<controller, ETA_HSM_MAX_STATES>;            \
                                                                                                      \
-    using controller##StateAttributes = eta::hsm::testing::StateAttributes<controller>;              \
+    namespace testing {                                                                              \
                                                                                                      \
-    template <typename State>                                                                        \
-    auto setState(controller&) -> std::enable_if_t<!eta::hsm::isLeaf<State>::value>                  \
-    {}                                                                                               \
+    /* Put the machine directly into leaf `state`, bypassing entry and exit; false if not a leaf */  \
+    template <typename Controller = controller>                                                      \
+    bool setState(Controller& sm, state_enum state)                                                  \
+    {                                                                                                \
+        return ::eta_hsm::StateTable<Controller, ETA_HSM_MAX_STATES>::setState(sm, state);           \
+    }                                                                                                \
                                                                                                      \
-    template <typename State>                                                                        \
-    auto setState(controller& sm) -> std::enable_if_t<eta::hsm::isLeaf<State>::value>                \
+    template <typename Controller = controller>                                                      \
+    constexpr bool isLeaf(state_enum state)                                                          \
     {                                                                                                \
-        sm.directlySetStateForTestingOnly<State>();                                                  \
+        return ::eta_hsm::StateTable<Controller, ETA_HSM_MAX_STATES>::isLeaf(state);                 \
     }                                                                                                \
                                                                                                      \
-    static auto stateTestAttributes##controller = std::map<state_enum, controller##StateAttributes>{ \
-        {state_enum::eNone, {false, [](controller&) {}}},                                            \
-        {state_enum::e##name, {eta::hsm::isLeaf<name>::value, setState<name>}}};                     \
+    } /* namespace testing */                                                                        \
                                                                                                      \
-    } /* namespace testing */
-
-#define HSM_ADD_STATE_TO_TEST_ATTRIBUTES(controller, name, state_enum)                                  \
-    namespace testing {                                                                                 \
-                                                                                                        \
-    ETA_ONCE(stateTestAttributes##controller.insert(std::pair<state_enum, controller##StateAttributes>( \
-        state_enum::e##name, {eta::hsm::isLeaf<name>::value, setState<name>})));                        \
-                                                                                                        \
-    } /* namespace testing */
+    ETA_HSM_REGISTER_STATE(controller, name, state_enum)
 
 #define ETA_HSM_DECLARE_COMP_STATE_IMPL(controller, name, parent, state_enum) \
     using name = CompState<state_enum::e##name, parent>;                      \
-    HSM_ADD_STATE_TO_TEST_ATTRIBUTES(controller, name, state_enum);
+    ETA_HSM_REGISTER_STATE(controller, name, state_enum)
 
 #define ETA_HSM_DECLARE_LEAF_STATE_IMPL(controller, name, parent, state_enum) \
     using name = LeafState<state_enum::e##name, parent>;                      \
-    HSM_ADD_STATE_TO_TEST_ATTRIBUTES(controller, name, state_enum);
-
-}  // namespace hsm
-}  // namespace eta
+    ETA_HSM_REGISTER_STATE(controller, name, state_enum)
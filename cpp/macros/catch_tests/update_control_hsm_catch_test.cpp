@@ -28,7 +28,7 @@ const std::vector<Transition> eventResponseTests{
 
 FEATURE("Control State Machine Event Test", "[bus_control_events]")
 {
-    runHsmStateTests(eventResponseTests, stateTestAttributesUpdateControlHsm);
+    runHsmStateTests(eventResponseTests, UpdateControlHsmStateTable{});
 }
 
 }  // namespace testing
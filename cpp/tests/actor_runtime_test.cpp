@@ -0,0 +1,288 @@
+// actor_runtime_test.cpp
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <thread>
+#include <vector>
+
+#include "../ActorRuntime.hpp"
+#include "../utils/Mailbox.hpp"
+#include "../utils/Timer.hpp"
+#include "wise_enum/wise_enum.h"
+
+namespace eta_hsm {
+namespace tests {
+
+WISE_ENUM_CLASS((RelayEvent, int32_t), eToggle, eCount, eForward, eTimeout, eNone)
+
+WISE_ENUM_CLASS((RelayState, int32_t), eNone, eTop, eOff, eOn)
+
+struct RelayTraits {
+    using Clock = std::chrono::steady_clock;
+    using Event = RelayEvent;
+    using StateEnum = RelayState;
+    static constexpr DefaultActions kDefaultActions = DefaultActions::eEntryExitOnly;
+    static constexpr bool kClearTimersOnExit = true;
+};
+
+struct RelayAdapter;
+
+/// Toggles on and off, switching itself off again 20 ms after it is switched on; counts what it is sent, checking
+/// that it is never run on two threads at once, and passes eForward on to the next relay while there are hops left
+class Relay : public StateMachine<Relay, RelayTraits> {
+public:
+    using Input = EmptyType;
+    using Clock = RelayTraits::Clock;
+    using Timers = utils::StaticTimerBank<utils::TimerTraits<Clock, RelayEvent, RelayState>>;
+
+    Relay();
+
+    template <RelayState kState>
+    void entry()
+    {
+        if constexpr (kState == RelayState::eOn)
+        {
+            mTimers.addTimer(RelayEvent::eTimeout, kState, Clock::now() + std::chrono::milliseconds(20));
+        }
+    }
+
+    template <RelayState kState>
+    void exit()
+    {}
+
+    Timers& eventScheduler() { return mTimers; }
+
+    /// What every state does with the events that do not change the state
+    void count(RelayEvent event)
+    {
+        if (mInside.exchange(true))
+        {
+            ++mOverlaps;
+        }
+        if (event == RelayEvent::eCount)
+        {
+            ++mCounted;
+        }
+        if (event == RelayEvent::eForward)
+        {
+            ++mForwarded;
+            if (mHops && mHops->fetch_sub(1) > 0)
+            {
+                mForward();
+            }
+        }
+        mInside.store(false);
+    }
+
+    Timers mTimers{};
+    utils::Mailbox<RelayEvent, 64> mMailbox{};
+    std::atomic<bool> mInside{false};
+    std::atomic<int> mOverlaps{0};
+    uint64_t mCounted{0};
+    uint64_t mForwarded{0};
+    std::atomic<int> mTimeouts{0};
+    std::atomic<int>* mHops{nullptr};
+    std::function<void()> mForward{};
+};
+
+struct RelayAdapter {
+    using Machine = Relay;
+    using Clock = Relay::Clock;
+
+    static auto& mailbox(Machine& machine) { return machine.mMailbox; }
+    static void fireTimers(Machine& machine, std::chrono::time_point<Clock> now)
+    {
+        machine.mTimers.checkTimers(now, machine.mMailbox);
+    }
+    static std::optional<std::chrono::time_point<Clock>> nextTimer(const Machine& machine)
+    {
+        return machine.mTimers.nextExpiration();
+    }
+};
+
+template <RelayState kState>
+using RelayStateTraits = StateTraits<Relay, RelayState, kState>;
+
+using Top = TopState<RelayStateTraits<RelayState::eTop>>;
+using Off = LeafState<RelayStateTraits<RelayState::eOff>, Top>;
+using On = LeafState<RelayStateTraits<RelayState::eOn>, Top>;
+
+}  // namespace tests
+
+template <>
+template <typename Current>
+inline void tests::Top::handleEvent(tests::Relay& stateMachine, const Current&, Event event) const
+{
+    stateMachine.count(event);
+}
+
+template <>
+template <typename Current>
+inline void tests::Off::handleEvent(tests::Relay& stateMachine, const Current& currentState, Event event) const
+{
+    if (event == tests::RelayEvent::eToggle)
+    {
+        Transition<Current, ThisState, tests::On> t(stateMachine);
+        return;
+    }
+    return ParentState::handleEvent(stateMachine, currentState, event);
+}
+
+template <>
+template <typename Current>
+inline void tests::On::handleEvent(tests::Relay& stateMachine, const Current& currentState, Event event) const
+{
+    if (event == tests::RelayEvent::eTimeout)
+    {
+        ++stateMachine.mTimeouts;
+    }
+    if (event == tests::RelayEvent::eToggle || event == tests::RelayEvent::eTimeout)
+    {
+        Transition<Current, ThisState, tests::Off> t(stateMachine);
+        return;
+    }
+    return ParentState::handleEvent(stateMachine, currentState, event);
+}
+
+template <>
+inline void tests::Top::init(tests::Relay& stateMachine)
+{
+    Init<tests::Off> i(stateMachine);
+}
+
+namespace tests {
+
+Relay::Relay() { Transition<Top, Top, Top> t(*this); }
+
+using Runtime = ActorRuntime<RelayAdapter>;
+
+TEST(ActorRuntimeTest, EveryEventIsDispatchedOnceAndOneAtATime)
+{
+    constexpr size_t kRelays = 1000;
+    constexpr size_t kPosters = 3;
+    constexpr size_t kRounds = 40;
+    std::vector<std::unique_ptr<Relay>> relays;
+    Runtime runtime(3, 8);
+    for (size_t idx = 0; idx < kRelays; ++idx)
+    {
+        relays.push_back(std::make_unique<Relay>());
+        runtime.add(*relays.back());
+    }
+    runtime.start();
+
+    // Several threads post to every relay at once, a round at a time so that no mailbox overflows
+    for (size_t round = 0; round < kRounds; ++round)
+    {
+        std::vector<std::thread> posters;
+        for (size_t poster = 0; poster < kPosters; ++poster)
+        {
+            posters.emplace_back([&runtime]() {
+                for (Runtime::ActorId id = 0; id < kRelays; ++id)
+                {
+                    EXPECT_TRUE(runtime.post(id, RelayEvent::eCount));
+                }
+            });
+        }
+        for (auto& poster : posters)
+        {
+            poster.join();
+        }
+        ASSERT_TRUE(runtime.waitIdle(std::chrono::seconds(10)));
+    }
+    runtime.stop();
+
+    uint64_t dispatched = 0;
+    for (const auto& stats : runtime.stats())
+    {
+        dispatched += stats.events;
+    }
+    EXPECT_EQ(dispatched, kRelays * kPosters * kRounds);
+    for (const auto& relay : relays)
+    {
+        EXPECT_EQ(relay->mCounted, kPosters * kRounds);
+        EXPECT_EQ(relay->mOverlaps, 0);
+        EXPECT_EQ(relay->mMailbox.overflows(), 0);
+    }
+}
+
+TEST(ActorRuntimeTest, ExpiredTimersWakeIdleActors)
+{
+    Relay relay;
+    Runtime runtime(2);
+    const Runtime::ActorId id = runtime.add(relay);
+    runtime.start();
+
+    runtime.post(id, RelayEvent::eToggle);
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (relay.mTimeouts == 0 && std::chrono::steady_clock::now() < deadline)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    ASSERT_TRUE(runtime.waitIdle(std::chrono::seconds(10)));
+    runtime.stop();
+    EXPECT_EQ(relay.mTimeouts, 1);
+    EXPECT_EQ(relay.identify(), RelayState::eOff);
+}
+
+TEST(ActorRuntimeTest, ActorsPostToEachOther)
+{
+    constexpr size_t kRelays = 64;
+    constexpr int kHops = 5000;
+    std::atomic<int> hops{kHops};
+    std::vector<std::unique_ptr<Relay>> relays;
+    Runtime runtime(3);
+    for (size_t idx = 0; idx < kRelays; ++idx)
+    {
+        relays.push_back(std::make_unique<Relay>());
+        runtime.add(*relays.back());
+    }
+    for (size_t idx = 0; idx < kRelays; ++idx)
+    {
+        relays[idx]->mHops = &hops;
+        relays[idx]->mForward = [&runtime, next = static_cast<Runtime::ActorId>((idx + 1) % kRelays)]() {
+            runtime.post(next, RelayEvent::eForward);
+        };
+    }
+    runtime.start();
+
+    runtime.post(0, RelayEvent::eForward);
+    ASSERT_TRUE(runtime.waitIdle(std::chrono::seconds(10)));
+    runtime.stop();
+
+    uint64_t forwarded = 0;
+    for (const auto& relay : relays)
+    {
+        forwarded += relay->mForwarded;
+        EXPECT_EQ(relay->mOverlaps, 0);
+    }
+    EXPECT_EQ(forwarded, kHops + 1);
+}
+
+TEST(ActorRuntimeTest, FullMailboxRefusesPosts)
+{
+    Relay relay;
+    Runtime runtime(1);
+    const Runtime::ActorId id = runtime.add(relay);
+
+    // Not started, so nothing drains the mailbox
+    for (size_t idx = 0; idx < relay.mMailbox.capacity(); ++idx)
+    {
+        EXPECT_TRUE(runtime.post(id, RelayEvent::eCount));
+    }
+    EXPECT_FALSE(runtime.post(id, RelayEvent::eCount));
+    EXPECT_EQ(relay.mMailbox.overflows(), 1);
+
+    // Whatever was posted before start() is run once it starts
+    runtime.start();
+    ASSERT_TRUE(runtime.waitIdle(std::chrono::seconds(10)));
+    runtime.stop();
+    EXPECT_EQ(relay.mCounted, relay.mMailbox.capacity());
+}
+
+}  // namespace tests
+}  // namespace eta_hsm
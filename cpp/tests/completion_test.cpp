@@ -0,0 +1,207 @@
+// completion_test.cpp
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "../Hsm.hpp"
+#include "wise_enum/wise_enum.h"
+
+namespace eta_hsm {
+namespace tests {
+
+WISE_ENUM_CLASS((PumpEvent, int32_t), eStart, eStop, eService, eNone)
+
+WISE_ENUM_CLASS((PumpState, int32_t), eTop, eOff, eChecking, ePriming, eRunning, eService, eSelfTest)
+
+struct PumpTraits {
+    using Clock = std::chrono::steady_clock;
+    using Event = PumpEvent;
+    using StateEnum = PumpState;
+    static constexpr DefaultActions kDefaultActions = DefaultActions::eEntryExitOnly;
+    static constexpr bool kClearTimersOnExit = false;
+};
+
+/// A pump that checks whether it is primed every time it is started, and only runs once it is
+class Pump : public StateMachine<Pump, PumpTraits> {
+public:
+    using Input = EmptyType;
+    explicit Pump(bool selfTestPasses = true);
+
+    template <PumpState kState>
+    void entry()
+    {
+        mLog.push_back(std::string("enter ") + std::string(wise_enum::to_string(kState)));
+        if (kState == PumpState::ePriming)
+        {
+            mPrimed = !mPrimingFails;
+        }
+    }
+
+    template <PumpState kState>
+    void exit()
+    {
+        mLog.push_back(std::string("exit ") + std::string(wise_enum::to_string(kState)));
+    }
+
+    bool primed() const { return mPrimed; }
+    bool selfTestPasses() const { return mSelfTestPasses; }
+
+    std::vector<std::string> mLog{};
+    bool mPrimed{false};
+    bool mPrimingFails{false};
+    bool mSelfTestPasses;
+    int mHours{0};
+};
+
+template <PumpState kState>
+using PumpStateTraits = StateTraits<Pump, PumpState, kState>;
+
+using Top = TopState<PumpStateTraits<PumpState::eTop>>;
+using SelfTest = LeafState<PumpStateTraits<PumpState::eSelfTest>, Top>;
+using Off = LeafState<PumpStateTraits<PumpState::eOff>, Top>;
+using Checking = LeafState<PumpStateTraits<PumpState::eChecking>, Top>;
+using Priming = LeafState<PumpStateTraits<PumpState::ePriming>, Top>;
+using Running = LeafState<PumpStateTraits<PumpState::eRunning>, Top>;
+using Service = LeafState<PumpStateTraits<PumpState::eService>, Top>;
+
+bool dueForService(const Pump& pump) { return pump.mHours >= 100; }
+
+}  // namespace tests
+
+// The machine starts out in SelfTest, which completes to Off or (without an Else) stays put
+template <>
+struct Completion<tests::SelfTest> : CompletionBranches<Branch<&tests::Pump::selfTestPasses, tests::Off>> {};
+
+// Checking is never stayed in:  it completes straight away, and completing Priming takes us back to Checking
+template <>
+struct Completion<tests::Checking>
+    : CompletionBranches<Branch<&tests::Pump::primed, tests::Running>, Else<tests::Priming>> {};
+template <>
+struct Completion<tests::Priming> : CompletionBranches<Else<tests::Checking>> {};
+
+template <>
+template <typename Current>
+inline void tests::Off::handleEvent(tests::Pump& stateMachine, const Current& currentState, Event event) const
+{
+    if (event == tests::PumpEvent::eStart)
+    {
+        Transition<Current, ThisState, tests::Checking> t(stateMachine);
+        return;
+    }
+    return ParentState::handleEvent(stateMachine, currentState, event);
+}
+
+template <>
+template <typename Current>
+inline void tests::Running::handleEvent(tests::Pump& stateMachine, const Current& currentState, Event event) const
+{
+    if (event == tests::PumpEvent::eStop)
+    {
+        // Off, unless it is time for a service
+        Choice<Current, ThisState, Branch<&tests::dueForService, tests::Service>, Else<tests::Off>> c(stateMachine);
+        return;
+    }
+    return ParentState::handleEvent(stateMachine, currentState, event);
+}
+
+template <>
+template <typename Current>
+inline void tests::Service::handleEvent(tests::Pump& stateMachine, const Current& currentState, Event event) const
+{
+    if (event == tests::PumpEvent::eService)
+    {
+        stateMachine.mHours = 0;
+        // No Else:  now that the hours are reset no branch holds, so the choice does nothing
+        Choice<Current, ThisState, Branch<&tests::dueForService, tests::Service>> c(stateMachine);
+        EXPECT_FALSE(c.taken());
+        Transition<Current, ThisState, tests::Off> t(stateMachine);
+        return;
+    }
+    return ParentState::handleEvent(stateMachine, currentState, event);
+}
+
+template <>
+inline void tests::Top::init(tests::Pump& stateMachine)
+{
+    Init<tests::SelfTest> i(stateMachine);
+}
+
+namespace tests {
+
+Pump::Pump(bool selfTestPasses) : mSelfTestPasses{selfTestPasses} { Transition<Top, Top, Top> t(*this); }
+
+using Log = std::vector<std::string>;
+
+TEST(CompletionTest, CompletesWhileBeingConstructed)
+{
+    Pump pump;
+    EXPECT_EQ(pump.identify(), PumpState::eOff);
+    EXPECT_EQ(pump.mLog, (Log{"exit eTop", "enter eTop", "enter eSelfTest", "exit eSelfTest", "enter eOff"}));
+
+    // Without a branch whose guard holds, the leaf is simply where we stay
+    Pump failed{false};
+    EXPECT_EQ(failed.identify(), PumpState::eSelfTest);
+}
+
+TEST(CompletionTest, CompletionChainRunsWithinOneDispatch)
+{
+    Pump pump;
+    pump.mLog.clear();
+    pump.dispatch(PumpEvent::eStart);
+    EXPECT_EQ(pump.identify(), PumpState::eRunning);
+    EXPECT_EQ(pump.mLog, (Log{"exit eOff", "enter eChecking", "exit eChecking", "enter ePriming", "exit ePriming",
+                              "enter eChecking", "exit eChecking", "enter eRunning"}));
+
+    // Already primed the second time around
+    pump.dispatch(PumpEvent::eStop);
+    pump.mLog.clear();
+    pump.dispatch(PumpEvent::eStart);
+    EXPECT_EQ(pump.mLog, (Log{"exit eOff", "enter eChecking", "exit eChecking", "enter eRunning"}));
+}
+
+TEST(CompletionTest, ChoiceTakesFirstBranchThatHolds)
+{
+    Pump pump;
+    pump.dispatch(PumpEvent::eStart);
+    pump.dispatch(PumpEvent::eStop);
+    EXPECT_EQ(pump.identify(), PumpState::eOff);
+
+    pump.mHours = 150;
+    pump.dispatch(PumpEvent::eStart);
+    pump.mLog.clear();
+    pump.dispatch(PumpEvent::eStop);
+    EXPECT_EQ(pump.identify(), PumpState::eService);
+    EXPECT_EQ(pump.mLog, (Log{"exit eRunning", "enter eService"}));
+
+    pump.dispatch(PumpEvent::eService);
+    EXPECT_EQ(pump.identify(), PumpState::eOff);
+}
+
+TEST(CompletionTest, CompletionCycleIsCutOff)
+{
+    // Checking and Priming complete into each other for as long as priming fails
+    Pump pump;
+    pump.mPrimingFails = true;
+    pump.dispatch(PumpEvent::eStart);
+    EXPECT_EQ(pump.identify(), PumpState::eChecking);
+    EXPECT_EQ(pump.droppedCompletions(), 1u);
+    EXPECT_EQ(std::count(pump.mLog.begin(), pump.mLog.end(), "enter ePriming"),
+              static_cast<std::ptrdiff_t>(Pump::kMaxCompletionSteps / 2));
+
+    // The machine is left in a consistent state, and the limit applies afresh to the next chain
+    pump.mPrimingFails = false;
+    pump.mLog.clear();
+    {
+        Transition<Checking, Checking, Checking> t(pump);
+    }
+    EXPECT_EQ(pump.identify(), PumpState::eRunning);
+    EXPECT_EQ(pump.droppedCompletions(), 1u);
+}
+
+}  // namespace tests
+}  // namespace eta_hsm
@@ -0,0 +1,315 @@
+// coroutine_test.cpp
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+
+#include "../Coroutine.hpp"
+#include "../utils/AllocationGuard.hpp"
+#include "../utils/EventBucket.hpp"
+#include "../utils/Timer.hpp"
+#include "wise_enum/wise_enum.h"
+
+namespace eta_hsm {
+namespace tests {
+
+WISE_ENUM_CLASS((PumpEvent, int32_t), eStart, eStop, eSettled, ePrimed, eLeak, eAck, eReset, eNone)
+
+WISE_ENUM_CLASS((PumpState, int32_t), eNone, eTop, eIdle, ePriming, eRunning, eFault)
+
+struct PumpTraits {
+    using Clock = std::chrono::steady_clock;
+    using Event = PumpEvent;
+    using StateEnum = PumpState;
+    static constexpr DefaultActions kDefaultActions = DefaultActions::eEntryExitOnly;
+    static constexpr bool kClearTimersOnExit = true;
+    static constexpr size_t kInternalQueueCapacity = 4;
+    static constexpr bool kCoroutineActions = true;
+};
+
+/// Priming opens the valve and gives the pressure 200 ms to build before deciding whether to run; a leak faults the
+/// pump until someone acknowledges it.  Both are sequences of steps in one state, written as coroutine actions.
+class Pump : public StateMachine<Pump, PumpTraits> {
+public:
+    using Input = EmptyType;
+    using Clock = PumpTraits::Clock;
+    using Timers = utils::StaticTimerBank<utils::TimerTraits<Clock, PumpEvent, PumpState>>;
+    using Coroutines = CoroutineScope<Pump, 2>;
+    static constexpr int kMinPressure = 3;
+
+    Pump();
+
+    template <PumpState kState>
+    void entry()
+    {
+        if constexpr (kState == PumpState::ePriming)
+        {
+            mCoroutines.spawn(kState, prime());
+        }
+        if constexpr (kState == PumpState::eFault)
+        {
+            mCoroutines.spawn(kState, awaitAcknowledgement());
+        }
+    }
+
+    template <PumpState kState>
+    void exit()
+    {}
+
+    Timers& eventScheduler() { return mTimers; }
+    Coroutines& coroutines() { return mCoroutines; }
+
+    Action prime();
+    Action awaitAcknowledgement();
+    Action waitForAck();
+    Action countWhenDispatched(PumpEvent event);
+
+    /// Let `elapsed` pass, and dispatch whatever timers fired
+    void advance(std::chrono::milliseconds elapsed)
+    {
+        mNow += elapsed;
+        mTimers.checkTimers(mNow, mBucket);
+        while (!mBucket.empty())
+        {
+            dispatch(mBucket.getEvent());
+        }
+    }
+
+    bool mValveOpen{false};
+    int mPressure{0};
+    int mCounted{0};
+    std::chrono::time_point<Clock> mNow{};
+    Timers mTimers{};
+    utils::StaticEventBucket<PumpEvent, 4> mBucket{};
+    Coroutines mCoroutines{};  // last, so that actions are destroyed before anything they use
+};
+
+template <PumpState kState>
+using PumpStateTraits = StateTraits<Pump, PumpState, kState>;
+
+using Top = TopState<PumpStateTraits<PumpState::eTop>>;
+using Idle = LeafState<PumpStateTraits<PumpState::eIdle>, Top>;
+using Priming = LeafState<PumpStateTraits<PumpState::ePriming>, Top>;
+using Running = LeafState<PumpStateTraits<PumpState::eRunning>, Top>;
+using Fault = LeafState<PumpStateTraits<PumpState::eFault>, Top>;
+
+}  // namespace tests
+
+template <>
+template <typename Current>
+inline void tests::Idle::handleEvent(tests::Pump& stateMachine, const Current& currentState, Event event) const
+{
+    if (event == tests::PumpEvent::eStart)
+    {
+        Transition<Current, ThisState, tests::Priming> t(stateMachine);
+        return;
+    }
+    return ParentState::handleEvent(stateMachine, currentState, event);
+}
+
+template <>
+template <typename Current>
+inline void tests::Priming::handleEvent(tests::Pump& stateMachine, const Current& currentState, Event event) const
+{
+    switch (event)
+    {
+        case tests::PumpEvent::ePrimed:
+        {
+            Transition<Current, ThisState, tests::Running> t(stateMachine);
+            return;
+        }
+        case tests::PumpEvent::eLeak:
+        {
+            Transition<Current, ThisState, tests::Fault> t(stateMachine);
+            return;
+        }
+        case tests::PumpEvent::eStop:
+        {
+            Transition<Current, ThisState, tests::Idle> t(stateMachine);
+            return;
+        }
+        default:
+            break;
+    }
+    return ParentState::handleEvent(stateMachine, currentState, event);
+}
+
+template <>
+template <typename Current>
+inline void tests::Running::handleEvent(tests::Pump& stateMachine, const Current& currentState, Event event) const
+{
+    if (event == tests::PumpEvent::eStop)
+    {
+        Transition<Current, ThisState, tests::Idle> t(stateMachine);
+        return;
+    }
+    return ParentState::handleEvent(stateMachine, currentState, event);
+}
+
+template <>
+template <typename Current>
+inline void tests::Fault::handleEvent(tests::Pump& stateMachine, const Current& currentState, Event event) const
+{
+    if (event == tests::PumpEvent::eReset)
+    {
+        Transition<Current, ThisState, tests::Idle> t(stateMachine);
+        return;
+    }
+    return ParentState::handleEvent(stateMachine, currentState, event);
+}
+
+template <>
+inline void tests::Top::init(tests::Pump& stateMachine)
+{
+    Init<tests::Idle> i(stateMachine);
+}
+
+namespace tests {
+
+Pump::Pump() { Transition<Top, Top, Top> t(*this); }
+
+Action Pump::prime()
+{
+    // The valve is closed again unless priming succeeds, including when the action is cancelled
+    struct CloseUnlessPrimed {
+        Pump& pump;
+        bool primed{false};
+        ~CloseUnlessPrimed()
+        {
+            if (!primed)
+            {
+                pump.mValveOpen = false;
+            }
+        }
+    } valve{*this};
+
+    mValveOpen = true;
+    co_await mCoroutines.timer(mTimers, PumpEvent::eSettled, std::chrono::milliseconds(200));
+    valve.primed = mPressure >= kMinPressure;
+    raise(valve.primed ? PumpEvent::ePrimed : PumpEvent::eLeak);
+}
+
+Action Pump::awaitAcknowledgement()
+{
+    co_await mCoroutines.event(PumpEvent::eAck);
+    raise(PumpEvent::eReset);
+}
+
+Action Pump::waitForAck() { co_await mCoroutines.event(PumpEvent::eAck); }
+
+Action Pump::countWhenDispatched(PumpEvent event)
+{
+    co_await mCoroutines.event(event);
+    ++mCounted;
+}
+
+TEST(CoroutineTest, ActionWaitsForItsTimer)
+{
+    Pump pump;
+    pump.mPressure = 5;
+    pump.dispatch(PumpEvent::eStart);
+    EXPECT_EQ(pump.identify(), PumpState::ePriming);
+    EXPECT_TRUE(pump.mValveOpen);
+    EXPECT_EQ(pump.coroutines().active(), 1);
+
+    pump.advance(std::chrono::milliseconds(150));
+    EXPECT_EQ(pump.identify(), PumpState::ePriming);
+
+    pump.advance(std::chrono::milliseconds(100));
+    EXPECT_EQ(pump.identify(), PumpState::eRunning);
+    EXPECT_TRUE(pump.mValveOpen);
+    EXPECT_EQ(pump.coroutines().active(), 0);
+}
+
+TEST(CoroutineTest, ActionWaitsForAnEvent)
+{
+    Pump pump;
+    pump.dispatch(PumpEvent::eStart);
+    pump.advance(std::chrono::milliseconds(250));
+    EXPECT_EQ(pump.identify(), PumpState::eFault);
+    EXPECT_FALSE(pump.mValveOpen);
+    EXPECT_EQ(pump.coroutines().active(), 1);
+
+    // Taken by the waiting action, which raises the event that resets the pump
+    pump.dispatch(PumpEvent::eAck);
+    EXPECT_EQ(pump.identify(), PumpState::eIdle);
+    EXPECT_EQ(pump.coroutines().active(), 0);
+
+    // With nothing waiting for it, the event goes to the state as usual
+    const uint64_t before = pump.transitions();
+    pump.dispatch(PumpEvent::eAck);
+    EXPECT_EQ(pump.transitions(), before);
+}
+
+TEST(CoroutineTest, RaisedEventsWakeActions)
+{
+    Pump pump;
+    pump.mPressure = 5;
+    pump.dispatch(PumpEvent::eStart);
+    EXPECT_TRUE(pump.coroutines().spawn(PumpState::ePriming, pump.countWhenDispatched(PumpEvent::ePrimed)));
+
+    // prime() raises ePrimed, which the waiting action takes before the state can
+    pump.advance(std::chrono::milliseconds(250));
+    EXPECT_EQ(pump.mCounted, 1);
+    EXPECT_EQ(pump.identify(), PumpState::ePriming);
+    EXPECT_EQ(pump.coroutines().active(), 0);
+}
+
+TEST(CoroutineTest, ExitCancelsActionsAndTheirTimers)
+{
+    Pump pump;
+    pump.mPressure = 5;
+    pump.dispatch(PumpEvent::eStart);
+    pump.dispatch(PumpEvent::eStop);
+    EXPECT_EQ(pump.identify(), PumpState::eIdle);
+    EXPECT_EQ(pump.coroutines().active(), 0);
+    // The action's locals were destroyed with it
+    EXPECT_FALSE(pump.mValveOpen);
+    EXPECT_EQ(pump.mTimers.snapshot(pump.mNow).count, 0);
+
+    pump.advance(std::chrono::milliseconds(250));
+    EXPECT_EQ(pump.identify(), PumpState::eIdle);
+}
+
+TEST(CoroutineTest, FramesComeFromThePool)
+{
+    Pump pump;
+    pump.mPressure = 5;
+    utils::AllocationGuard guard;
+    pump.dispatch(PumpEvent::eStart);
+    pump.advance(std::chrono::milliseconds(250));
+    pump.dispatch(PumpEvent::eStop);
+    EXPECT_EQ(guard.allocations(), 0);
+    EXPECT_EQ(pump.coroutines().allocationFailures(), 0);
+}
+
+TEST(CoroutineTest, FullPoolFailsToStart)
+{
+    Pump pump;
+    EXPECT_TRUE(pump.coroutines().spawn(PumpState::eIdle, pump.waitForAck()));
+    EXPECT_TRUE(pump.coroutines().spawn(PumpState::eIdle, pump.waitForAck()));
+    EXPECT_FALSE(pump.coroutines().spawn(PumpState::eIdle, pump.waitForAck()));
+    EXPECT_EQ(pump.coroutines().allocationFailures(), 1);
+    EXPECT_EQ(pump.coroutines().active(), 2);
+
+    // Leaving Idle cancels both, which makes room for priming
+    pump.dispatch(PumpEvent::eStart);
+    EXPECT_EQ(pump.identify(), PumpState::ePriming);
+    EXPECT_EQ(pump.coroutines().active(), 1);
+}
+
+TEST(CoroutineTest, CopiesStartWithoutActions)
+{
+    Pump pump;
+    pump.dispatch(PumpEvent::eStart);
+    Pump copy{pump};
+    EXPECT_EQ(copy.identify(), PumpState::ePriming);
+    EXPECT_EQ(copy.coroutines().active(), 0);
+    EXPECT_EQ(pump.coroutines().active(), 1);
+
+    pump = copy;
+    EXPECT_EQ(pump.coroutines().active(), 0);
+}
+
+}  // namespace tests
+}  // namespace eta_hsm
@@ -0,0 +1,201 @@
+// defer_test.cpp
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <vector>
+
+#include "../Hsm.hpp"
+#include "../utils/AllocationGuard.hpp"
+
+namespace eta_hsm {
+namespace tests {
+
+enum class DeviceEvent { eBooted, eCalibrated, eRun, eConfigure, eDone, eNone };
+
+enum class DeviceState { eTop, eStarting, eBooting, eCalibrating, eReady, eBusy };
+
+struct DeviceTraits {
+    using Clock = std::chrono::steady_clock;
+    using Event = DeviceEvent;
+    using StateEnum = DeviceState;
+    static constexpr DefaultActions kDefaultActions = DefaultActions::eNothing;
+    static constexpr bool kClearTimersOnExit = false;
+    static constexpr size_t kDeferredQueueCapacity = 4;
+};
+
+/// A device that cannot run or be configured until it has finished starting up, and that cannot be reconfigured
+/// while it is busy
+class Device : public StateMachine<Device, DeviceTraits> {
+public:
+    using Input = EmptyType;
+    Device();
+
+    std::vector<DeviceEvent> mHandled{};
+};
+
+template <DeviceState kState>
+using DeviceStateTraits = StateTraits<Device, DeviceState, kState>;
+
+using Top = TopState<DeviceStateTraits<DeviceState::eTop>>;
+using Starting = CompState<DeviceStateTraits<DeviceState::eStarting>, Top>;
+using Booting = LeafState<DeviceStateTraits<DeviceState::eBooting>, Starting>;
+using Calibrating = LeafState<DeviceStateTraits<DeviceState::eCalibrating>, Starting>;
+using Ready = LeafState<DeviceStateTraits<DeviceState::eReady>, Top>;
+using Busy = LeafState<DeviceStateTraits<DeviceState::eBusy>, Top>;
+
+}  // namespace tests
+
+template <>
+struct Defer<tests::Starting> : DeferEvents<tests::DeviceEvent::eRun, tests::DeviceEvent::eConfigure> {};
+template <>
+struct Defer<tests::Busy> : DeferEvents<tests::DeviceEvent::eConfigure> {};
+
+template <>
+template <typename Current>
+inline void tests::Booting::handleEvent(tests::Device& stateMachine, const Current& currentState, Event event) const
+{
+    if (event == tests::DeviceEvent::eBooted)
+    {
+        Transition<Current, ThisState, tests::Calibrating> t(stateMachine);
+        return;
+    }
+    return ParentState::handleEvent(stateMachine, currentState, event);
+}
+
+template <>
+template <typename Current>
+inline void tests::Calibrating::handleEvent(tests::Device& stateMachine, const Current& currentState,
+                                            Event event) const
+{
+    if (event == tests::DeviceEvent::eCalibrated)
+    {
+        Transition<Current, ThisState, tests::Ready> t(stateMachine);
+        return;
+    }
+    return ParentState::handleEvent(stateMachine, currentState, event);
+}
+
+template <>
+template <typename Current>
+inline void tests::Ready::handleEvent(tests::Device& stateMachine, const Current& currentState, Event event) const
+{
+    switch (event)
+    {
+        case tests::DeviceEvent::eRun:
+        {
+            stateMachine.mHandled.push_back(event);
+            Transition<Current, ThisState, tests::Busy> t(stateMachine);
+            return;
+        }
+        case tests::DeviceEvent::eConfigure:
+            stateMachine.mHandled.push_back(event);
+            return;
+        default:
+            break;
+    }
+    return ParentState::handleEvent(stateMachine, currentState, event);
+}
+
+template <>
+template <typename Current>
+inline void tests::Busy::handleEvent(tests::Device& stateMachine, const Current& currentState, Event event) const
+{
+    if (event == tests::DeviceEvent::eDone)
+    {
+        stateMachine.mHandled.push_back(event);
+        Transition<Current, ThisState, tests::Ready> t(stateMachine);
+        return;
+    }
+    return ParentState::handleEvent(stateMachine, currentState, event);
+}
+
+template <>
+inline void tests::Top::init(tests::Device& stateMachine)
+{
+    Init<tests::Starting> i(stateMachine);
+}
+
+template <>
+inline void tests::Starting::init(tests::Device& stateMachine)
+{
+    Init<tests::Booting> i(stateMachine);
+}
+
+namespace tests {
+
+Device::Device() { Transition<Top, Top, Top> t(*this); }
+
+using Handled = std::vector<DeviceEvent>;
+
+static_assert(DeferEvents<DeviceEvent::eRun, DeviceEvent::eConfigure>::kMask == 0b1100);
+static_assert(DeferEvents<>::kMask == 0);
+
+TEST(DeferTest, LeavesInheritTheirAncestorsDeferrals)
+{
+    EXPECT_TRUE(Booting::instanceForTestingOnly().defers(DeviceEvent::eRun));
+    EXPECT_TRUE(Calibrating::instanceForTestingOnly().defers(DeviceEvent::eConfigure));
+    EXPECT_FALSE(Calibrating::instanceForTestingOnly().defers(DeviceEvent::eCalibrated));
+    EXPECT_FALSE(Ready::instanceForTestingOnly().defers(DeviceEvent::eRun));
+    EXPECT_TRUE(Busy::instanceForTestingOnly().defers(DeviceEvent::eConfigure));
+    EXPECT_FALSE(Busy::instanceForTestingOnly().defers(DeviceEvent::eRun));
+}
+
+TEST(DeferTest, DeferredEventsAreRecalledInOrder)
+{
+    Device device;
+    device.dispatch(DeviceEvent::eRun);
+    device.dispatch(DeviceEvent::eConfigure);
+    EXPECT_EQ(device.deferredEvents(), 2);
+    EXPECT_TRUE(device.mHandled.empty());
+
+    // Still starting, so still deferred
+    device.dispatch(DeviceEvent::eBooted);
+    EXPECT_EQ(device.identify(), DeviceState::eCalibrating);
+    EXPECT_EQ(device.deferredEvents(), 2);
+
+    // Ready handles eRun straight away, which makes the device Busy, which defers eConfigure once more
+    device.dispatch(DeviceEvent::eCalibrated);
+    EXPECT_EQ(device.identify(), DeviceState::eBusy);
+    EXPECT_EQ(device.mHandled, (Handled{DeviceEvent::eRun}));
+    EXPECT_EQ(device.deferredEvents(), 1);
+
+    // Back in Ready, the reconfiguration finally goes through
+    device.dispatch(DeviceEvent::eDone);
+    EXPECT_EQ(device.identify(), DeviceState::eReady);
+    EXPECT_EQ(device.mHandled, (Handled{DeviceEvent::eRun, DeviceEvent::eDone, DeviceEvent::eConfigure}));
+    EXPECT_EQ(device.deferredEvents(), 0);
+}
+
+TEST(DeferTest, RecalledEventsSeeEachOthersTransitions)
+{
+    Device device;
+    device.dispatch(DeviceEvent::eConfigure);
+    device.dispatch(DeviceEvent::eRun);
+    device.dispatch(DeviceEvent::eBooted);
+    device.dispatch(DeviceEvent::eCalibrated);
+
+    // Configured in Ready, then off to Busy
+    EXPECT_EQ(device.identify(), DeviceState::eBusy);
+    EXPECT_EQ(device.mHandled, (Handled{DeviceEvent::eConfigure, DeviceEvent::eRun}));
+    EXPECT_EQ(device.deferredEvents(), 0);
+}
+
+TEST(DeferTest, FullQueueDropsWithoutAllocating)
+{
+    Device device;
+    utils::AllocationGuard guard;
+    for (size_t idx = 0; idx < DeviceTraits::kDeferredQueueCapacity + 1; ++idx)
+    {
+        device.dispatch(DeviceEvent::eConfigure);
+    }
+    EXPECT_EQ(guard.allocations(), 0);
+    EXPECT_EQ(device.deferredEvents(), DeviceTraits::kDeferredQueueCapacity);
+    EXPECT_EQ(device.droppedDeferredEvents(), 1);
+
+    device.clearDeferredEvents();
+    EXPECT_EQ(device.deferredEvents(), 0);
+}
+
+}  // namespace tests
+}  // namespace eta_hsm
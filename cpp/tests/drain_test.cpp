@@ -0,0 +1,168 @@
+// drain_test.cpp
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+
+#include "../Hsm.hpp"
+#include "../utils/EventBucket.hpp"
+#include "../utils/FakeClock.hpp"
+
+namespace eta_hsm {
+namespace tests {
+
+enum class TallyEvent { eCount, eSlow, eStop, eNone };
+
+enum class TallyState { eTop, eCounting, eStopped };
+
+struct TallyTraits {
+    using Clock = utils::FakeClock;
+    using Event = TallyEvent;
+    using StateEnum = TallyState;
+    static constexpr DefaultActions kDefaultActions = DefaultActions::eNothing;
+    static constexpr bool kClearTimersOnExit = false;
+};
+
+/// Counts events, pretending that each one takes some time (on a FakeClock) to handle
+class Tally : public StateMachine<Tally, TallyTraits> {
+public:
+    using Input = EmptyType;
+    Tally();
+
+    utils::FakeClock mClock{};
+    int mCount{0};
+};
+
+template <TallyState kState>
+using TallyStateTraits = StateTraits<Tally, TallyState, kState>;
+
+using Top = TopState<TallyStateTraits<TallyState::eTop>>;
+using Counting = LeafState<TallyStateTraits<TallyState::eCounting>, Top>;
+using Stopped = LeafState<TallyStateTraits<TallyState::eStopped>, Top>;
+
+}  // namespace tests
+
+template <>
+template <typename Current>
+inline void tests::Counting::handleEvent(tests::Tally& stateMachine, const Current& currentState, Event event) const
+{
+    switch (event)
+    {
+        case tests::TallyEvent::eCount:
+            ++stateMachine.mCount;
+            stateMachine.mClock.advance(std::chrono::microseconds(10));
+            return;
+        case tests::TallyEvent::eSlow:
+            ++stateMachine.mCount;
+            stateMachine.mClock.advance(std::chrono::milliseconds(5));
+            return;
+        case tests::TallyEvent::eStop:
+        {
+            Transition<Current, ThisState, tests::Stopped> t(stateMachine);
+            return;
+        }
+        default:
+            break;
+    }
+    return ParentState::handleEvent(stateMachine, currentState, event);
+}
+
+template <>
+inline void tests::Top::init(tests::Tally& stateMachine)
+{
+    Init<tests::Counting> i(stateMachine);
+}
+
+namespace tests {
+
+Tally::Tally() { Transition<Top, Top, Top> t(*this); }
+
+using Budget = DrainBudget<utils::FakeClock>;
+
+TEST(DrainTest, DrainsEverythingWithinAnUnlimitedBudget)
+{
+    Tally tally;
+    utils::OrderedEventBucket<TallyEvent> bucket;
+    for (int idx = 0; idx < 5; ++idx)
+    {
+        bucket.addEvent(TallyEvent::eCount);
+    }
+    bucket.addEvent(TallyEvent::eStop);
+
+    const auto stats = tally.drain(bucket, Budget{}, tally.mClock);
+    EXPECT_EQ(stats.dispatched, 6);
+    EXPECT_EQ(stats.remaining, 0);
+    EXPECT_TRUE(stats.drained());
+    EXPECT_EQ(stats.elapsed, std::chrono::microseconds(50));
+    EXPECT_EQ(tally.mCount, 5);
+    EXPECT_EQ(tally.identify(), TallyState::eStopped);
+}
+
+TEST(DrainTest, StopsAtMaxEvents)
+{
+    Tally tally;
+    utils::StaticEventBucket<TallyEvent, 8> bucket;
+    for (int idx = 0; idx < 8; ++idx)
+    {
+        bucket.addEvent(TallyEvent::eCount);
+    }
+
+    auto stats = tally.drain(bucket, Budget{3}, tally.mClock);
+    EXPECT_EQ(stats.dispatched, 3);
+    EXPECT_EQ(stats.remaining, 5);
+    EXPECT_FALSE(stats.drained());
+
+    // The rest on the next go
+    stats = tally.drain(bucket, Budget{}, tally.mClock);
+    EXPECT_EQ(stats.dispatched, 5);
+    EXPECT_TRUE(stats.drained());
+    EXPECT_EQ(tally.mCount, 8);
+}
+
+TEST(DrainTest, StopsAtDeadline)
+{
+    Tally tally;
+    utils::OrderedEventBucket<TallyEvent> bucket;
+    for (int idx = 0; idx < 10; ++idx)
+    {
+        bucket.addEvent(TallyEvent::eCount);
+    }
+
+    // 10us per event, so the deadline is reached after the third
+    auto stats = tally.drain(bucket, Budget{100, std::chrono::microseconds(25)}, tally.mClock);
+    EXPECT_EQ(stats.dispatched, 3);
+    EXPECT_EQ(stats.remaining, 7);
+    EXPECT_EQ(stats.elapsed, std::chrono::microseconds(30));
+
+    // A slow event runs to completion, but nothing new is started after the deadline
+    utils::OrderedEventBucket<TallyEvent> slow;
+    slow.addEvent(TallyEvent::eSlow);
+    slow.addEvent(TallyEvent::eCount);
+    stats = tally.drain(slow, Budget{100, std::chrono::milliseconds(1)}, tally.mClock);
+    EXPECT_EQ(stats.dispatched, 1);
+    EXPECT_EQ(stats.remaining, 1);
+    EXPECT_EQ(stats.elapsed, std::chrono::milliseconds(5));
+
+    // A zero budget does nothing at all
+    stats = tally.drain(bucket, Budget{100, utils::FakeClock::duration::zero()}, tally.mClock);
+    EXPECT_EQ(stats.dispatched, 0);
+    EXPECT_EQ(stats.remaining, 7);
+}
+
+TEST(DrainTest, HonorsBucketPriority)
+{
+    Tally tally;
+    utils::PrioritizedEventBucket<TallyEvent> bucket;
+    bucket.addEvent(TallyEvent::eCount);
+    bucket.addEvent(TallyEvent::eStop);
+    bucket.addEvent(TallyEvent::eCount);
+
+    // PrioritizedEventBucket hands out the lowest enum value first, so both counts land before the stop
+    const auto stats = tally.drain(bucket, Budget{}, tally.mClock);
+    EXPECT_EQ(stats.dispatched, 3);
+    EXPECT_EQ(tally.mCount, 2);
+    EXPECT_EQ(tally.identify(), TallyState::eStopped);
+}
+
+}  // namespace tests
+}  // namespace eta_hsm
@@ -0,0 +1,261 @@
+// event_sourcing_test.cpp
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "../StateTable.hpp"
+#include "../utils/EventBucket.hpp"
+#include "../utils/EventLog.hpp"
+#include "../utils/FakeClock.hpp"
+#include "../utils/Timer.hpp"
+#include "wise_enum/wise_enum.h"
+
+namespace eta_hsm {
+namespace tests {
+
+WISE_ENUM_CLASS((KettleEvent, int32_t), eSwitchOn, eBoiled, eTimeout, eSwitchOff, eNone)
+
+WISE_ENUM_CLASS((KettleState, int32_t), eNone, eTop, eIdle, eBoiling, eKeepWarm)
+
+struct KettleTraits {
+    using Clock = utils::FakeClock;
+    using Event = KettleEvent;
+    using StateEnum = KettleState;
+    static constexpr DefaultActions kDefaultActions = DefaultActions::eEntryExitOnly;
+    static constexpr bool kClearTimersOnExit = false;
+};
+
+struct KettleSnapshot;
+
+/// Boils for 90s once switched on, then keeps warm for 10 minutes
+class Kettle : public StateMachine<Kettle, KettleTraits> {
+public:
+    using Input = EmptyType;
+    using TimerTraits = utils::TimerTraits<utils::FakeClock, KettleEvent, KettleState>;
+
+    explicit Kettle(const utils::FakeClock& clock);
+
+    template <KettleState kState>
+    void entry()
+    {
+        if (kState == KettleState::eBoiling)
+        {
+            mTimers.addTimer(KettleEvent::eBoiled, kState, mClock.now() + std::chrono::seconds(90));
+        }
+        if (kState == KettleState::eKeepWarm)
+        {
+            mTimers.addTimer(KettleEvent::eTimeout, kState, mClock.now() + std::chrono::minutes(10));
+        }
+    }
+
+    template <KettleState kState>
+    void exit()
+    {
+        mTimers.clearAllTimersInGroup(kState);
+    }
+
+    /// Fire expired timers and dispatch everything that is waiting, logging each event on the way in
+    void update(utils::EventJournal<utils::FakeClock>& journal)
+    {
+        mTimers.checkTimers(mClock.now(), mBucket);
+        while (!mBucket.empty())
+        {
+            journal.dispatch(*this, mBucket.getEvent());
+        }
+    }
+
+    /// The machine together with its timers
+    KettleSnapshot snapshot() const;
+    bool restore(const KettleSnapshot& snapshot);
+
+    utils::TimerBank<TimerTraits>& eventScheduler() { return mTimers; }
+
+    const utils::FakeClock& mClock;
+    utils::TimerBank<TimerTraits> mTimers{};
+    utils::StaticEventBucket<KettleEvent, 4> mBucket{};
+};
+
+struct KettleSnapshot {
+    Kettle::Snapshot machine;
+    utils::TimerSnapshot<Kettle::TimerTraits, 4> timers;
+};
+
+template <KettleState kState>
+using KettleStateTraits = StateTraits<Kettle, KettleState, kState>;
+
+using Top = TopState<KettleStateTraits<KettleState::eTop>>;
+using Idle = LeafState<KettleStateTraits<KettleState::eIdle>, Top>;
+using Boiling = LeafState<KettleStateTraits<KettleState::eBoiling>, Top>;
+using KeepWarm = LeafState<KettleStateTraits<KettleState::eKeepWarm>, Top>;
+
+ETA_HSM_REGISTER_STATE(Kettle, Top, KettleState);
+ETA_HSM_REGISTER_STATE(Kettle, Idle, KettleState);
+ETA_HSM_REGISTER_STATE(Kettle, Boiling, KettleState);
+ETA_HSM_REGISTER_STATE(Kettle, KeepWarm, KettleState);
+
+}  // namespace tests
+
+template <>
+template <typename Current>
+inline void tests::Idle::handleEvent(tests::Kettle& stateMachine, const Current& currentState, Event event) const
+{
+    if (event == tests::KettleEvent::eSwitchOn)
+    {
+        Transition<Current, ThisState, tests::Boiling> t(stateMachine);
+        return;
+    }
+    return ParentState::handleEvent(stateMachine, currentState, event);
+}
+
+template <>
+template <typename Current>
+inline void tests::Boiling::handleEvent(tests::Kettle& stateMachine, const Current& currentState, Event event) const
+{
+    if (event == tests::KettleEvent::eBoiled)
+    {
+        Transition<Current, ThisState, tests::KeepWarm> t(stateMachine);
+        return;
+    }
+    return ParentState::handleEvent(stateMachine, currentState, event);
+}
+
+template <>
+template <typename Current>
+inline void tests::KeepWarm::handleEvent(tests::Kettle& stateMachine, const Current& currentState, Event event) const
+{
+    switch (event)
+    {
+        case tests::KettleEvent::eTimeout:
+        case tests::KettleEvent::eSwitchOff:
+        {
+            Transition<Current, ThisState, tests::Idle> t(stateMachine);
+            return;
+        }
+        case tests::KettleEvent::eSwitchOn:
+        {
+            Transition<Current, ThisState, tests::Boiling> t(stateMachine);
+            return;
+        }
+        default:
+            break;
+    }
+    return ParentState::handleEvent(stateMachine, currentState, event);
+}
+
+template <>
+inline void tests::Top::init(tests::Kettle& stateMachine)
+{
+    Init<tests::Idle> i(stateMachine);
+}
+
+namespace tests {
+
+Kettle::Kettle(const utils::FakeClock& clock) : mClock{clock} { Transition<Top, Top, Top> t(*this); }
+
+KettleSnapshot Kettle::snapshot() const { return {StateMachine::snapshot(), mTimers.snapshot<4>(mClock.now())}; }
+
+bool Kettle::restore(const KettleSnapshot& snapshot)
+{
+    if (!StateMachine::restore<StateTable<Kettle, wise_enum::size<KettleState>>>(snapshot.machine))
+    {
+        return false;
+    }
+    mTimers.restore(snapshot.timers, mClock.now());
+    return true;
+}
+
+TEST(EventSourcingTest, SnapshotPlusTailRebuildsTheFleet)
+{
+    const std::string path = ::testing::TempDir() + "event_sourcing_test.log";
+    std::remove(path.c_str());
+
+    utils::FakeClock clock;
+    utils::EventLog log(path);
+    std::vector<std::unique_ptr<Kettle>> fleet;
+    std::vector<utils::EventJournal<utils::FakeClock>> journals;
+    for (uint32_t id = 0; id < 3; ++id)
+    {
+        fleet.push_back(std::make_unique<Kettle>(clock));
+        journals.emplace_back(log, id, clock);
+    }
+    utils::SnapshotStore<Kettle> snapshots(fleet.size(), 5);
+    auto tick = [&](std::chrono::seconds elapsed) {
+        clock.advance(elapsed);
+        for (size_t id = 0; id < fleet.size(); ++id)
+        {
+            fleet[id]->update(journals[id]);
+        }
+        if (snapshots.due(log))
+        {
+            for (uint32_t id = 0; id < fleet.size(); ++id)
+            {
+                snapshots.take(id, *fleet[id], log, clock);
+            }
+        }
+    };
+
+    fleet[0]->mBucket.addEvent(KettleEvent::eSwitchOn);
+    fleet[1]->mBucket.addEvent(KettleEvent::eSwitchOn);
+    tick(std::chrono::seconds(1));
+    tick(std::chrono::seconds(100));  // both boiled
+    EXPECT_FALSE(snapshots.latest(0).taken);
+
+    // Snapshots are taken part way through, once kettle 2 is switched on
+    fleet[1]->mBucket.addEvent(KettleEvent::eSwitchOff);
+    fleet[2]->mBucket.addEvent(KettleEvent::eSwitchOn);
+    tick(std::chrono::seconds(30));
+    EXPECT_TRUE(snapshots.latest(0).taken);
+    EXPECT_EQ(snapshots.latest(0).sequence, 6u);
+    tick(std::chrono::seconds(100));  // kettle 2 boiled
+    fleet[0]->mBucket.addEvent(KettleEvent::eSwitchOn);
+    tick(std::chrono::seconds(5));
+    log.commit();
+    EXPECT_EQ(log.sequence(), 8u);
+
+    utils::FakeClock replayClock;
+    auto recovered = utils::recover(path, snapshots, replayClock,
+                                    [&replayClock](uint32_t) { return std::make_unique<Kettle>(replayClock); });
+    EXPECT_EQ(replayClock.now(), clock.now());
+    for (size_t id = 0; id < fleet.size(); ++id)
+    {
+        EXPECT_EQ(recovered[id]->identify(), fleet[id]->identify()) << "kettle " << id;
+    }
+
+    // Without snapshots, the whole log is replayed to the same end
+    utils::FakeClock fullReplayClock;
+    auto replayed = utils::recover(path, utils::SnapshotStore<Kettle>(fleet.size(), 5), fullReplayClock,
+                                   [&fullReplayClock](uint32_t) { return std::make_unique<Kettle>(fullReplayClock); });
+    EXPECT_EQ(fullReplayClock.now(), clock.now());
+    for (size_t id = 0; id < fleet.size(); ++id)
+    {
+        EXPECT_EQ(replayed[id]->identify(), fleet[id]->identify()) << "kettle " << id;
+    }
+
+    // The rebuilt timers are armed for the same times as the originals (kettle 0 boils between the first two ticks)
+    const std::string resumedPath = path + ".resumed";
+    std::remove(resumedPath.c_str());
+    utils::EventLog resumedLog(resumedPath);
+    utils::EventJournal<utils::FakeClock> replayJournal(resumedLog, 0, replayClock);
+    for (auto elapsed : {std::chrono::seconds(88), std::chrono::seconds(3), std::chrono::seconds(600)})
+    {
+        tick(elapsed);
+        replayClock.advance(elapsed);
+        for (auto& kettle : recovered)
+        {
+            kettle->update(replayJournal);
+        }
+        for (size_t id = 0; id < fleet.size(); ++id)
+        {
+            EXPECT_EQ(recovered[id]->identify(), fleet[id]->identify()) << "kettle " << id;
+        }
+    }
+}
+
+}  // namespace tests
+}  // namespace eta_hsm
@@ -0,0 +1,258 @@
+// explorer_test.cpp
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <sstream>
+#include <vector>
+
+#include "../StateTable.hpp"
+#include "../fuzz/Explorer.hpp"
+#include "../utils/EventBucket.hpp"
+#include "../utils/ForkJoinPool.hpp"
+#include "../utils/Timer.hpp"
+#include "wise_enum/wise_enum.h"
+
+namespace eta_hsm {
+namespace tests {
+
+WISE_ENUM_CLASS((HatchEvent, int32_t), eOpen, eClose, eLock, eUnlock, eTimeout, eKick, eNone)
+
+WISE_ENUM_CLASS((HatchState, int32_t), eTop, eShut, eClosed, eLocked, eOpen, eJammed)
+
+struct HatchTraits {
+    using Clock = std::chrono::steady_clock;
+    using Event = HatchEvent;
+    using StateEnum = HatchState;
+    static constexpr DefaultActions kDefaultActions = DefaultActions::eEntryExitOnly;
+    static constexpr bool kClearTimersOnExit = false;
+};
+
+/// Closes itself 5s after it is opened.  Nothing ever jams it, and nothing handles a kick.
+class Hatch : public StateMachine<Hatch, HatchTraits> {
+public:
+    using Input = EmptyType;
+    using Clock = HatchTraits::Clock;
+    using TimerTraits = utils::TimerTraits<Clock, HatchEvent, HatchState>;
+
+    Hatch();
+
+    template <HatchState kState>
+    void entry()
+    {
+        if (kState == HatchState::eOpen)
+        {
+            mTimers.addTimer(HatchEvent::eTimeout, kState, mNow + std::chrono::seconds(5));
+        }
+    }
+
+    template <HatchState kState>
+    void exit()
+    {
+        mTimers.clearAllTimersInGroup(kState);
+    }
+
+    std::chrono::time_point<Clock> mNow{};
+    utils::TimerBank<TimerTraits> mTimers{};
+    utils::StaticEventBucket<HatchEvent, 4> mBucket{};
+};
+
+template <HatchState kState>
+using HatchStateTraits = StateTraits<Hatch, HatchState, kState>;
+
+using Top = TopState<HatchStateTraits<HatchState::eTop>>;
+using Shut = CompState<HatchStateTraits<HatchState::eShut>, Top>;
+using Closed = LeafState<HatchStateTraits<HatchState::eClosed>, Shut>;
+using Locked = LeafState<HatchStateTraits<HatchState::eLocked>, Shut>;
+using Open = LeafState<HatchStateTraits<HatchState::eOpen>, Top>;
+using Jammed = LeafState<HatchStateTraits<HatchState::eJammed>, Top>;
+
+ETA_HSM_REGISTER_STATE(Hatch, Top, HatchState);
+ETA_HSM_REGISTER_STATE(Hatch, Shut, HatchState);
+ETA_HSM_REGISTER_STATE(Hatch, Closed, HatchState);
+ETA_HSM_REGISTER_STATE(Hatch, Locked, HatchState);
+ETA_HSM_REGISTER_STATE(Hatch, Open, HatchState);
+ETA_HSM_REGISTER_STATE(Hatch, Jammed, HatchState);
+
+using HatchStateTable = StateTable<Hatch, wise_enum::size<HatchState>>;
+
+}  // namespace tests
+
+template <>
+template <typename Current>
+inline void tests::Closed::handleEvent(tests::Hatch& stateMachine, const Current& currentState, Event event) const
+{
+    switch (event)
+    {
+        case tests::HatchEvent::eOpen:
+        {
+            Transition<Current, ThisState, tests::Open> t(stateMachine);
+            return;
+        }
+        case tests::HatchEvent::eLock:
+        {
+            Transition<Current, ThisState, tests::Locked> t(stateMachine);
+            return;
+        }
+        default:
+            break;
+    }
+    return ParentState::handleEvent(stateMachine, currentState, event);
+}
+
+template <>
+template <typename Current>
+inline void tests::Locked::handleEvent(tests::Hatch& stateMachine, const Current& currentState, Event event) const
+{
+    if (event == tests::HatchEvent::eUnlock)
+    {
+        Transition<Current, ThisState, tests::Closed> t(stateMachine);
+        return;
+    }
+    return ParentState::handleEvent(stateMachine, currentState, event);
+}
+
+template <>
+template <typename Current>
+inline void tests::Open::handleEvent(tests::Hatch& stateMachine, const Current& currentState, Event event) const
+{
+    if (event == tests::HatchEvent::eClose || event == tests::HatchEvent::eTimeout)
+    {
+        Transition<Current, ThisState, tests::Closed> t(stateMachine);
+        return;
+    }
+    return ParentState::handleEvent(stateMachine, currentState, event);
+}
+
+template <>
+template <typename Current>
+inline void tests::Jammed::handleEvent(tests::Hatch& stateMachine, const Current& currentState, Event event) const
+{
+    if (event == tests::HatchEvent::eUnlock)
+    {
+        Transition<Current, ThisState, tests::Closed> t(stateMachine);
+        return;
+    }
+    return ParentState::handleEvent(stateMachine, currentState, event);
+}
+
+template <>
+inline void tests::Shut::init(tests::Hatch& stateMachine)
+{
+    Init<tests::Closed> i(stateMachine);
+}
+
+template <>
+inline void tests::Top::init(tests::Hatch& stateMachine)
+{
+    Init<tests::Shut> i(stateMachine);
+}
+
+namespace tests {
+
+Hatch::Hatch() { Transition<Top, Top, Top> t(*this); }
+
+struct HatchAdapter {
+    using Machine = Hatch;
+    using Table = HatchStateTable;
+    using Clock = Hatch::Clock;
+    static constexpr Clock::duration kTick = std::chrono::seconds(1);
+
+    static void fireTimers(Machine& machine, std::chrono::time_point<Clock> now)
+    {
+        machine.mNow = now;
+        machine.mTimers.checkTimers(now, machine.mBucket);
+        while (!machine.mBucket.empty())
+        {
+            machine.dispatch(machine.mBucket.getEvent());
+        }
+    }
+
+    static void step(Machine&) {}
+
+    template <typename Visit>
+    static void forEachTimerGroup(Machine& machine, std::chrono::time_point<Clock> now, Visit&& visit)
+    {
+        const auto snap = machine.mTimers.snapshot<4>(now);
+        for (uint32_t idx = 0; idx < snap.count; ++idx)
+        {
+            visit(snap.timers[idx].groupId);
+        }
+    }
+};
+
+using HatchExplorer = fuzz::Explorer<HatchAdapter>;
+using Transition = fuzz::ExploredTransition<Hatch>;
+
+TEST(ExplorerTest, ReportsWhatWasNeverReached)
+{
+    utils::ForkJoinPool pool(3);
+    HatchExplorer explorer{pool};
+    const auto report = explorer.explore(200, 100);
+
+    EXPECT_EQ(report.walks, 200);
+    EXPECT_EQ(report.steps, 200 * 100);
+    EXPECT_FALSE(report.overflowed);
+    // Closed and Locked without timers, and Open with its timer
+    EXPECT_EQ(report.configurations, 3);
+    EXPECT_EQ(report.unreachedStates, std::vector<HatchState>{HatchState::eJammed});
+    EXPECT_EQ(report.unhandledEvents, (std::vector<HatchEvent>{HatchEvent::eKick, HatchEvent::eNone}));
+
+    const auto taken = [&report](HatchState from, fuzz::Cause cause, HatchEvent event, HatchState to) {
+        for (const Transition& transition : report.taken)
+        {
+            if (transition.from == from && transition.cause == cause && transition.to == to &&
+                (cause != fuzz::Cause::eEvent || transition.event == event))
+            {
+                return true;
+            }
+        }
+        return false;
+    };
+    EXPECT_TRUE(taken(HatchState::eClosed, fuzz::Cause::eEvent, HatchEvent::eOpen, HatchState::eOpen));
+    EXPECT_TRUE(taken(HatchState::eOpen, fuzz::Cause::eTimers, HatchEvent::eTimeout, HatchState::eClosed));
+    EXPECT_FALSE(taken(HatchState::eJammed, fuzz::Cause::eEvent, HatchEvent::eUnlock, HatchState::eClosed));
+    EXPECT_EQ(report.taken.size(), 6);
+}
+
+TEST(ExplorerTest, FindsPossibleTransitionsThatWereNeverTaken)
+{
+    utils::ForkJoinPool pool(2);
+    HatchExplorer explorer{pool};
+    const auto report = explorer.explore(100, 100);
+
+    const Hatch prototype;
+    testing::ConformanceRunner<Hatch, HatchStateTable> runner{pool, prototype};
+    const auto untaken = report.untaken(runner.run());
+    ASSERT_EQ(untaken.size(), 1);
+    EXPECT_EQ(untaken[0].from, HatchState::eJammed);
+    EXPECT_EQ(untaken[0].event, HatchEvent::eUnlock);
+    EXPECT_EQ(untaken[0].to, HatchState::eClosed);
+
+    std::ostringstream printed;
+    report.print(printed);
+    EXPECT_NE(printed.str().find("states never reached: eJammed\n"), std::string::npos) << printed.str();
+    EXPECT_NE(printed.str().find("events never handled: eKick eNone\n"), std::string::npos) << printed.str();
+    EXPECT_NE(printed.str().find("    eOpen + (timers) -> eClosed\n"), std::string::npos) << printed.str();
+}
+
+TEST(ExplorerTest, IsReproducibleAndAccumulates)
+{
+    utils::ForkJoinPool pool(3);
+    HatchExplorer first{pool};
+    HatchExplorer second{pool};
+    const auto one = first.explore(1, 3, 7);
+    const auto other = second.explore(1, 3, 7);
+    EXPECT_EQ(one.configurations, other.configurations);
+    EXPECT_EQ(one.unreachedStates, other.unreachedStates);
+    EXPECT_EQ(one.taken.size(), other.taken.size());
+
+    // Later calls add to what earlier ones found
+    const auto more = first.explore(50, 50, 8);
+    EXPECT_EQ(more.walks, 51);
+    EXPECT_GE(more.configurations, one.configurations);
+    EXPECT_LE(more.unreachedStates.size(), one.unreachedStates.size());
+}
+
+}  // namespace tests
+}  // namespace eta_hsm
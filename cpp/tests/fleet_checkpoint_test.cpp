@@ -0,0 +1,310 @@
+// fleet_checkpoint_test.cpp
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "../DirtyTrackingStateMachine.hpp"
+#include "../StateTable.hpp"
+#include "../utils/FakeClock.hpp"
+#include "../utils/FleetStore.hpp"
+#include "../utils/Timer.hpp"
+#include "wise_enum/wise_enum.h"
+
+namespace eta_hsm {
+namespace tests {
+
+WISE_ENUM_CLASS((GateEvent, int32_t), eOpen, eClose, eNone)
+
+WISE_ENUM_CLASS((GateState, int32_t), eNone, eTop, eClosed, eOpen)
+
+struct GateTraits {
+    using Clock = utils::FakeClock;
+    using Event = GateEvent;
+    using StateEnum = GateState;
+    static constexpr DefaultActions kDefaultActions = DefaultActions::eEntryExitOnly;
+    static constexpr bool kClearTimersOnExit = false;
+};
+
+struct GateRecord;
+
+/// A gate that closes itself 30s after it is opened, one of a fleet that is checkpointed to a FleetStore
+class Gate : public DirtyTrackingStateMachine<Gate, GateTraits> {
+public:
+    using Input = EmptyType;
+    using EventScheduler = utils::StaticTimerBank<utils::TimerTraits<utils::FakeClock, GateEvent, GateState>>;
+
+    explicit Gate(const utils::FakeClock& clock);
+
+    template <GateState kState>
+    void entry()
+    {
+        ++mEntries;
+        if (kState == GateState::eOpen)
+        {
+            ++mOpens;
+            mTimers.addTimer(GateEvent::eClose, kState, mClock.now() + std::chrono::seconds(30));
+        }
+    }
+
+    template <GateState kState>
+    void exit()
+    {
+        mTimers.clearTimer(kState);
+    }
+
+    void update()
+    {
+        mTimers.checkTimers(mClock.now(), mEventBucket);
+        while (!mEventBucket.empty())
+        {
+            dispatch(mEventBucket.getEvent());
+        }
+    }
+
+    /// The timers mark the gate dirty as they are set, cleared, and fired (see DirtyTrackingStateMachine)
+    EventScheduler& eventScheduler() { return mTimers; }
+
+    void capture(GateRecord& record) const;
+    bool restore(const GateRecord& record, utils::FakeClock::time_point checkpointed);
+
+    const utils::FakeClock& mClock;
+    EventScheduler mTimers{};
+    utils::StaticEventBucket<GateEvent, 2> mEventBucket{};
+    uint32_t mOpens{0};  // a host field that is checkpointed too
+    int mEntries{0};
+};
+
+struct GateRecord {
+    Gate::Snapshot machine;
+    Gate::EventScheduler::Snapshot timers;
+    uint32_t opens;
+};
+
+template <GateState kState>
+using GateStateTraits = StateTraits<Gate, GateState, kState>;
+
+using Top = TopState<GateStateTraits<GateState::eTop>>;
+using Closed = LeafState<GateStateTraits<GateState::eClosed>, Top>;
+using Open = LeafState<GateStateTraits<GateState::eOpen>, Top>;
+
+ETA_HSM_REGISTER_STATE(Gate, Top, GateState);
+ETA_HSM_REGISTER_STATE(Gate, Closed, GateState);
+ETA_HSM_REGISTER_STATE(Gate, Open, GateState);
+
+}  // namespace tests
+
+template <>
+template <typename Current>
+inline void tests::Closed::handleEvent(tests::Gate& stateMachine, const Current& currentState, Event event) const
+{
+    if (event == tests::GateEvent::eOpen)
+    {
+        Transition<Current, ThisState, tests::Open> t(stateMachine);
+        return;
+    }
+    return ParentState::handleEvent(stateMachine, currentState, event);
+}
+
+template <>
+template <typename Current>
+inline void tests::Open::handleEvent(tests::Gate& stateMachine, const Current& currentState, Event event) const
+{
+    if (event == tests::GateEvent::eClose)
+    {
+        Transition<Current, ThisState, tests::Closed> t(stateMachine);
+        return;
+    }
+    return ParentState::handleEvent(stateMachine, currentState, event);
+}
+
+template <>
+inline void tests::Top::init(tests::Gate& stateMachine)
+{
+    Init<tests::Closed> i(stateMachine);
+}
+
+namespace tests {
+
+Gate::Gate(const utils::FakeClock& clock) : mClock{clock} { Transition<Top, Top, Top> t(*this); }
+
+void Gate::capture(GateRecord& record) const { record = {snapshot(), mTimers.snapshot(mClock.now()), mOpens}; }
+
+bool Gate::restore(const GateRecord& record, utils::FakeClock::time_point checkpointed)
+{
+    if (!StateMachine::restore<StateTable<Gate, wise_enum::size<GateState>>>(record.machine))
+    {
+        return false;
+    }
+    mTimers.restore(record.timers, mClock.now(), checkpointed);
+    mOpens = record.opens;
+    return true;
+}
+
+using Fleet = std::vector<std::unique_ptr<Gate>>;
+
+Fleet makeFleet(const utils::FakeClock& clock, size_t size)
+{
+    Fleet fleet;
+    for (size_t id = 0; id < size; ++id)
+    {
+        fleet.push_back(std::make_unique<Gate>(clock));
+    }
+    return fleet;
+}
+
+size_t checkpoint(utils::FleetStore<GateRecord>& store, const Fleet& fleet, const utils::FakeClock& clock)
+{
+    return store.checkpoint([&](size_t id, GateRecord& record) { fleet[id]->capture(record); }, clock.now());
+}
+
+/// Each test has a file of its own, as tests can be run in parallel
+std::string storePath(const char* name)
+{
+    std::string path = ::testing::TempDir() + name;
+    std::remove(path.c_str());
+    return path;
+}
+
+TEST(FleetCheckpointTest, OnlyMachinesThatChangedAreWritten)
+{
+    utils::FakeClock clock;
+    utils::FleetStore<GateRecord> store(storePath("fleet_checkpoint_written.store"), 64);
+    Fleet fleet = makeFleet(clock, store.size());
+    for (size_t id = 0; id < fleet.size(); ++id)
+    {
+        fleet[id]->trackDirty(store.dirtyBits(), id);
+    }
+    EXPECT_EQ(checkpoint(store, fleet, clock), 64);
+
+    fleet[3]->dispatch(GateEvent::eOpen);
+    fleet[40]->dispatch(GateEvent::eClose);  // already closed, nothing changes
+    EXPECT_EQ(checkpoint(store, fleet, clock), 1);
+    EXPECT_EQ(store[3].machine.state, GateState::eOpen);
+    EXPECT_EQ(store[3].opens, 1);
+
+    // The timer closing the gate is a transition too
+    clock.advance(std::chrono::seconds(31));
+    for (auto& gate : fleet)
+    {
+        gate->update();
+    }
+    EXPECT_EQ(checkpoint(store, fleet, clock), 1);
+    EXPECT_EQ(store[3].machine.state, GateState::eClosed);
+    EXPECT_EQ(store[3].timers.count, 0);
+
+    // Timers set and cleared outside of transitions mark the machine too
+    fleet[9]->mTimers.addTimer(GateEvent::eOpen, GateState::eClosed, clock.now() + std::chrono::seconds(5));
+    EXPECT_EQ(checkpoint(store, fleet, clock), 1);
+    EXPECT_EQ(store[9].timers.count, 1);
+    fleet[9]->mTimers.clearTimer(GateState::eClosed);
+    EXPECT_EQ(checkpoint(store, fleet, clock), 1);
+    EXPECT_EQ(store[9].timers.count, 0);
+}
+
+TEST(FleetCheckpointTest, CopiesAreNotTracked)
+{
+    utils::FakeClock clock;
+    utils::FleetStore<GateRecord> store(storePath("fleet_checkpoint_copies.store"), 4);
+    Gate gate{clock};
+    gate.trackDirty(store.dirtyBits(), 2);
+    checkpoint(store, makeFleet(clock, store.size()), clock);
+
+    // A clone (as a Speculator makes) can transition without the live machine becoming dirty
+    Gate clone{gate};
+    EXPECT_FALSE(clone.tracksDirty());
+    clone.dispatch(GateEvent::eOpen);
+    EXPECT_EQ(store.dirtyBits().count(), 0);
+
+    gate.dispatch(GateEvent::eOpen);
+    EXPECT_EQ(store.dirtyBits().count(), 1);
+    gate.untrackDirty();
+    gate.dispatch(GateEvent::eClose);
+    EXPECT_EQ(store.dirtyBits().count(), 1);
+}
+
+TEST(FleetCheckpointTest, RestartRestoresFromTheMappingWithoutReplay)
+{
+    const std::string path = storePath("fleet_checkpoint_restart.store");
+    {
+        utils::FakeClock clock;
+        utils::FleetStore<GateRecord> store(path, 16);
+        Fleet fleet = makeFleet(clock, store.size());
+        for (size_t id = 0; id < fleet.size(); ++id)
+        {
+            fleet[id]->trackDirty(store.dirtyBits(), id);
+        }
+        fleet[5]->dispatch(GateEvent::eOpen);
+        clock.advance(std::chrono::seconds(10));
+        checkpoint(store, fleet, clock);
+    }
+
+    // The restarted process has a clock of its own
+    utils::FakeClock clock;
+    clock.advance(std::chrono::hours(1));
+    utils::FleetStore<GateRecord> store(path, 16);
+    ASSERT_TRUE(store.recovered());
+    Fleet fleet = makeFleet(clock, store.size());
+    for (size_t id = 0; id < fleet.size(); ++id)
+    {
+        fleet[id]->mEntries = 0;
+        ASSERT_TRUE(fleet[id]->restore(store[id], store.checkpointTime<utils::FakeClock>()));
+        fleet[id]->trackDirty(store.dirtyBits(), id);
+    }
+    EXPECT_EQ(fleet[5]->identify(), GateState::eOpen);
+    EXPECT_EQ(fleet[5]->mOpens, 1);
+    EXPECT_EQ(fleet[5]->mEntries, 0);
+    EXPECT_EQ(fleet[6]->identify(), GateState::eClosed);
+
+    // Twenty seconds were left on the auto-close timer
+    clock.advance(std::chrono::seconds(20));
+    fleet[5]->update();
+    EXPECT_EQ(fleet[5]->identify(), GateState::eOpen);
+    clock.advance(std::chrono::nanoseconds(1));
+    fleet[5]->update();
+    EXPECT_EQ(fleet[5]->identify(), GateState::eClosed);
+}
+
+TEST(FleetCheckpointTest, UnchangedTimersAreNotWrittenAgain)
+{
+    const std::string path = storePath("fleet_checkpoint_timers.store");
+    {
+        utils::FakeClock clock;
+        utils::FleetStore<GateRecord> store(path, 16);
+        Fleet fleet = makeFleet(clock, store.size());
+        for (size_t id = 0; id < fleet.size(); ++id)
+        {
+            fleet[id]->trackDirty(store.dirtyBits(), id);
+        }
+        fleet[5]->dispatch(GateEvent::eOpen);
+        checkpoint(store, fleet, clock);
+
+        // Gate 5's timer has run down since, but the record of it is still good, so nothing is written
+        clock.advance(std::chrono::seconds(25));
+        EXPECT_EQ(checkpoint(store, fleet, clock), 0);
+        EXPECT_EQ(store[5].timers.count, 1);
+    }
+
+    utils::FakeClock clock;
+    utils::FleetStore<GateRecord> store(path, 16);
+    ASSERT_TRUE(store.recovered());
+    Gate gate{clock};
+    ASSERT_TRUE(gate.restore(store[5], store.checkpointTime<utils::FakeClock>()));
+    EXPECT_EQ(gate.identify(), GateState::eOpen);
+
+    // Five seconds are left on the auto-close timer (as of the last checkpoint), not the thirty it had when the gate
+    // was captured
+    clock.advance(std::chrono::seconds(5));
+    gate.update();
+    EXPECT_EQ(gate.identify(), GateState::eOpen);
+    clock.advance(std::chrono::nanoseconds(1));
+    gate.update();
+    EXPECT_EQ(gate.identify(), GateState::eClosed);
+}
+
+}  // namespace tests
+}  // namespace eta_hsm
@@ -0,0 +1,252 @@
+// history_test.cpp
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "../Hsm.hpp"
+#include "../utils/FakeClock.hpp"
+#include "../utils/Timer.hpp"
+#include "wise_enum/wise_enum.h"
+
+namespace eta_hsm {
+namespace tests {
+
+WISE_ENUM_CLASS((PlantEvent, int32_t), eStart, eWarm, eFault, eResumeDeep, eResumeShallow, eReset, eNone)
+
+WISE_ENUM_CLASS((PlantState, int32_t), eNone, eTop, eOperating, eIdle, eRunning, eWarmup, eSteady, eFault)
+
+/// A plant that can be interrupted by a fault at any point and resumed where it left off once the fault clears
+struct PlantTraits {
+    using Clock = utils::FakeClock;
+    using Event = PlantEvent;
+    using StateEnum = PlantState;
+    static constexpr DefaultActions kDefaultActions = DefaultActions::eEntryExitOnly;
+    static constexpr bool kClearTimersOnExit = true;
+    static constexpr size_t kHistoryStates = wise_enum::size<PlantState>;
+};
+
+class Plant : public StateMachine<Plant, PlantTraits> {
+public:
+    using Input = EmptyType;
+    using EventScheduler = utils::TimerBank<utils::TimerTraits<utils::FakeClock, PlantEvent, PlantState>>;
+
+    Plant();
+
+    template <PlantState kState>
+    void entry()
+    {
+        mLog.push_back(std::string("enter ") + std::string(wise_enum::to_string(kState)));
+    }
+
+    template <PlantState kState>
+    void exit()
+    {
+        mLog.push_back(std::string("exit ") + std::string(wise_enum::to_string(kState)));
+    }
+
+    EventScheduler& eventScheduler() { return mEventScheduler; }
+    bool overheated() const { return mOverheated; }
+
+    std::vector<std::string> mLog{};
+    bool mOverheated{false};
+    EventScheduler mEventScheduler{};
+};
+
+template <PlantState kState>
+using PlantStateTraits = StateTraits<Plant, PlantState, kState>;
+
+using Top = TopState<PlantStateTraits<PlantState::eTop>>;
+using Operating = CompState<PlantStateTraits<PlantState::eOperating>, Top>;
+using Idle = LeafState<PlantStateTraits<PlantState::eIdle>, Operating>;
+using Running = CompState<PlantStateTraits<PlantState::eRunning>, Operating>;
+using Warmup = LeafState<PlantStateTraits<PlantState::eWarmup>, Running>;
+using Steady = LeafState<PlantStateTraits<PlantState::eSteady>, Running>;
+using Fault = LeafState<PlantStateTraits<PlantState::eFault>, Top>;
+
+}  // namespace tests
+
+template <>
+template <typename Current>
+inline void tests::Operating::handleEvent(tests::Plant& stateMachine, const Current& currentState, Event event) const
+{
+    if (event == tests::PlantEvent::eFault)
+    {
+        Transition<Current, ThisState, tests::Fault> t(stateMachine);
+        return;
+    }
+    return ParentState::handleEvent(stateMachine, currentState, event);
+}
+
+template <>
+template <typename Current>
+inline void tests::Idle::handleEvent(tests::Plant& stateMachine, const Current& currentState, Event event) const
+{
+    if (event == tests::PlantEvent::eStart)
+    {
+        Transition<Current, ThisState, tests::Running> t(stateMachine);
+        return;
+    }
+    return ParentState::handleEvent(stateMachine, currentState, event);
+}
+
+template <>
+template <typename Current>
+inline void tests::Warmup::handleEvent(tests::Plant& stateMachine, const Current& currentState, Event event) const
+{
+    if (event == tests::PlantEvent::eWarm)
+    {
+        Transition<Current, ThisState, tests::Steady> t(stateMachine);
+        return;
+    }
+    return ParentState::handleEvent(stateMachine, currentState, event);
+}
+
+template <>
+template <typename Current>
+inline void tests::Fault::handleEvent(tests::Plant& stateMachine, const Current& currentState, Event event) const
+{
+    switch (event)
+    {
+        case tests::PlantEvent::eResumeDeep:
+        {
+            Transition<Current, ThisState, DeepHistory<tests::Operating>> t(stateMachine);
+            return;
+        }
+        case tests::PlantEvent::eResumeShallow:
+        {
+            Transition<Current, ThisState, ShallowHistory<tests::Operating>> t(stateMachine);
+            return;
+        }
+        case tests::PlantEvent::eReset:
+        {
+            Transition<Current, ThisState, tests::Operating> t(stateMachine);
+            return;
+        }
+        default:
+            break;
+    }
+    return ParentState::handleEvent(stateMachine, currentState, event);
+}
+
+// A plant that overheated while it was down cools off in Idle, however it got back to Steady
+template <>
+struct Completion<tests::Steady> : CompletionBranches<Branch<&tests::Plant::overheated, tests::Idle>> {};
+
+template <>
+inline void tests::Top::init(tests::Plant& stateMachine)
+{
+    Init<tests::Operating> i(stateMachine);
+}
+
+template <>
+inline void tests::Operating::init(tests::Plant& stateMachine)
+{
+    Init<tests::Idle> i(stateMachine);
+}
+
+template <>
+inline void tests::Running::init(tests::Plant& stateMachine)
+{
+    Init<tests::Warmup> i(stateMachine);
+}
+
+namespace tests {
+
+Plant::Plant() { Transition<Top, Top, Top> t(*this); }
+
+using Log = std::vector<std::string>;
+
+TEST(HistoryTest, DeepHistoryResumesLeafWithoutInit)
+{
+    Plant plant;
+    plant.dispatch(PlantEvent::eStart);
+    plant.dispatch(PlantEvent::eWarm);
+    EXPECT_EQ(plant.identify(), PlantState::eSteady);
+
+    plant.dispatch(PlantEvent::eFault);
+    EXPECT_EQ(plant.identify(), PlantState::eFault);
+    EXPECT_EQ(plant.history(PlantState::eOperating), PlantState::eSteady);
+    EXPECT_EQ(plant.history(PlantState::eRunning), PlantState::eSteady);
+
+    plant.mLog.clear();
+    plant.dispatch(PlantEvent::eResumeDeep);
+    EXPECT_EQ(plant.identify(), PlantState::eSteady);
+    // Straight back to the remembered leaf:  no eWarmup entry, which the default init chain would have gone through
+    EXPECT_EQ(plant.mLog, (Log{"exit eFault", "enter eOperating", "enter eRunning", "enter eSteady"}));
+}
+
+TEST(HistoryTest, DeepHistoryTakesCompletionOfRestoredLeaf)
+{
+    Plant plant;
+    plant.dispatch(PlantEvent::eStart);
+    plant.dispatch(PlantEvent::eWarm);
+    plant.dispatch(PlantEvent::eFault);
+
+    plant.mOverheated = true;
+    plant.mLog.clear();
+    plant.dispatch(PlantEvent::eResumeDeep);
+    EXPECT_EQ(plant.identify(), PlantState::eIdle);
+    EXPECT_EQ(plant.mLog, (Log{"exit eFault", "enter eOperating", "enter eRunning", "enter eSteady", "exit eSteady",
+                               "exit eRunning", "enter eIdle"}));
+}
+
+TEST(HistoryTest, ShallowHistoryResumesChildThenDefaultInit)
+{
+    Plant plant;
+    plant.dispatch(PlantEvent::eStart);
+    plant.dispatch(PlantEvent::eWarm);
+    plant.dispatch(PlantEvent::eFault);
+
+    plant.mLog.clear();
+    plant.dispatch(PlantEvent::eResumeShallow);
+    EXPECT_EQ(plant.identify(), PlantState::eWarmup);
+    EXPECT_EQ(plant.mLog, (Log{"exit eFault", "enter eOperating", "enter eRunning", "enter eWarmup"}));
+
+    // Shallow history of a leaf child is just that leaf
+    plant.dispatch(PlantEvent::eFault);
+    plant.clearHistory();
+    EXPECT_EQ(plant.history(PlantState::eOperating), PlantState::eTop);
+    plant.dispatch(PlantEvent::eResumeShallow);
+    EXPECT_EQ(plant.identify(), PlantState::eIdle);
+    plant.dispatch(PlantEvent::eFault);
+    plant.dispatch(PlantEvent::eResumeShallow);
+    EXPECT_EQ(plant.identify(), PlantState::eIdle);
+}
+
+TEST(HistoryTest, NoHistoryFallsBackToDefaultInit)
+{
+    Plant plant;
+    plant.dispatch(PlantEvent::eFault);
+    plant.clearHistory();
+    plant.dispatch(PlantEvent::eResumeDeep);
+    EXPECT_EQ(plant.identify(), PlantState::eIdle);
+
+    // An ordinary transition ignores history altogether
+    plant.dispatch(PlantEvent::eStart);
+    plant.dispatch(PlantEvent::eWarm);
+    plant.dispatch(PlantEvent::eFault);
+    plant.dispatch(PlantEvent::eReset);
+    EXPECT_EQ(plant.identify(), PlantState::eIdle);
+}
+
+TEST(HistoryTest, TimersAreStillClearedOnExit)
+{
+    Plant plant;
+    plant.dispatch(PlantEvent::eStart);
+    plant.eventScheduler().addTimer(PlantEvent::eWarm, PlantState::eRunning, utils::FakeClock::time_point());
+    plant.eventScheduler().addTimer(PlantEvent::eWarm, PlantState::eWarmup, utils::FakeClock::time_point());
+    EXPECT_FALSE(plant.eventScheduler().empty());
+
+    // Leaving Operating clears the timers of every state on the way out, and restoring history does not resurrect them
+    plant.dispatch(PlantEvent::eFault);
+    EXPECT_TRUE(plant.eventScheduler().empty());
+    plant.dispatch(PlantEvent::eResumeDeep);
+    EXPECT_EQ(plant.identify(), PlantState::eWarmup);
+    EXPECT_TRUE(plant.eventScheduler().empty());
+}
+
+}  // namespace tests
+}  // namespace eta_hsm
@@ -0,0 +1,168 @@
+// internal_events_test.cpp
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <vector>
+
+#include "../Hsm.hpp"
+#include "../utils/AllocationGuard.hpp"
+#include "../utils/EventBucket.hpp"
+
+namespace eta_hsm {
+namespace tests {
+
+enum class ChainEvent { eGo, eNext, ePing, eBurst, eExternal, eNone };
+
+enum class ChainState { eTop, eA, eB, eC };
+
+struct ChainTraits {
+    using Clock = std::chrono::steady_clock;
+    using Event = ChainEvent;
+    using StateEnum = ChainState;
+    static constexpr DefaultActions kDefaultActions = DefaultActions::eNothing;
+    static constexpr bool kClearTimersOnExit = false;
+    static constexpr size_t kInternalQueueCapacity = 4;
+    static constexpr size_t kMaxInternalSteps = 16;
+};
+
+/// A -(eGo, raises eNext)-> B -(eNext)-> C, where C raises ePing at itself forever
+class Chain : public StateMachine<Chain, ChainTraits> {
+public:
+    using Input = EmptyType;
+    Chain();
+
+    std::vector<ChainEvent> mHandled{};
+};
+
+template <ChainState kState>
+using ChainStateTraits = StateTraits<Chain, ChainState, kState>;
+
+using Top = TopState<ChainStateTraits<ChainState::eTop>>;
+using A = LeafState<ChainStateTraits<ChainState::eA>, Top>;
+using B = LeafState<ChainStateTraits<ChainState::eB>, Top>;
+using C = LeafState<ChainStateTraits<ChainState::eC>, Top>;
+
+}  // namespace tests
+
+template <>
+template <typename Current>
+inline void tests::Top::handleEvent(tests::Chain& stateMachine, const Current&, Event event) const
+{
+    stateMachine.mHandled.push_back(event);
+    if (event == tests::ChainEvent::eBurst)
+    {
+        // More than the queue can hold at once
+        for (int idx = 0; idx < 6; ++idx)
+        {
+            stateMachine.raise(tests::ChainEvent::eNone);
+        }
+    }
+}
+
+template <>
+template <typename Current>
+inline void tests::A::handleEvent(tests::Chain& stateMachine, const Current& currentState, Event event) const
+{
+    if (event == tests::ChainEvent::eGo)
+    {
+        stateMachine.mHandled.push_back(event);
+        stateMachine.raise(tests::ChainEvent::eNext);
+        Transition<Current, ThisState, tests::B> t(stateMachine);
+        return;
+    }
+    return ParentState::handleEvent(stateMachine, currentState, event);
+}
+
+template <>
+template <typename Current>
+inline void tests::B::handleEvent(tests::Chain& stateMachine, const Current& currentState, Event event) const
+{
+    if (event == tests::ChainEvent::eNext)
+    {
+        stateMachine.mHandled.push_back(event);
+        Transition<Current, ThisState, tests::C> t(stateMachine);
+        return;
+    }
+    return ParentState::handleEvent(stateMachine, currentState, event);
+}
+
+template <>
+template <typename Current>
+inline void tests::C::handleEvent(tests::Chain& stateMachine, const Current& currentState, Event event) const
+{
+    if (event == tests::ChainEvent::ePing)
+    {
+        stateMachine.mHandled.push_back(event);
+        stateMachine.raise(tests::ChainEvent::ePing);
+        return;
+    }
+    return ParentState::handleEvent(stateMachine, currentState, event);
+}
+
+template <>
+inline void tests::Top::init(tests::Chain& stateMachine)
+{
+    Init<tests::A> i(stateMachine);
+}
+
+namespace tests {
+
+Chain::Chain() { Transition<Top, Top, Top> t(*this); }
+
+TEST(InternalEventsTest, RaisedEventsRunToCompletion)
+{
+    Chain chain;
+    chain.dispatch(ChainEvent::eGo);
+    // eNext was raised in A, but is handled by B (after the transition completed) before dispatch returned
+    EXPECT_EQ(chain.identify(), ChainState::eC);
+    EXPECT_EQ(chain.mHandled, (std::vector<ChainEvent>{ChainEvent::eGo, ChainEvent::eNext}));
+    EXPECT_EQ(chain.droppedInternalEvents(), 0);
+}
+
+TEST(InternalEventsTest, InternalEventsPrecedeExternalEvents)
+{
+    Chain chain;
+    utils::OrderedEventBucket<ChainEvent> external;
+    external.addEvent(ChainEvent::eGo);
+    external.addEvent(ChainEvent::eExternal);
+
+    // One external event per step, as an update() loop would do
+    chain.dispatch(external.getEvent());
+    EXPECT_EQ(chain.mHandled.back(), ChainEvent::eNext);
+    chain.dispatch(external.getEvent());
+    EXPECT_EQ(chain.mHandled, (std::vector<ChainEvent>{ChainEvent::eGo, ChainEvent::eNext, ChainEvent::eExternal}));
+}
+
+TEST(InternalEventsTest, StepLimitBreaksLivelock)
+{
+    Chain chain;
+    chain.directlySetStateForTestingOnly<C>();
+
+    // C raises ePing at itself every time it handles one.  The initial (external) ePing is followed by exactly
+    // kMaxInternalSteps internal ones before the last one raised is dropped.
+    chain.dispatch(ChainEvent::ePing);
+    EXPECT_EQ(chain.mHandled.size(), 1 + ChainTraits::kMaxInternalSteps);
+    EXPECT_EQ(chain.droppedInternalEvents(), 1);
+
+    // And the machine carries on as usual afterwards
+    chain.mHandled.clear();
+    chain.dispatch(ChainEvent::eExternal);
+    EXPECT_EQ(chain.mHandled, (std::vector<ChainEvent>{ChainEvent::eExternal}));
+}
+
+TEST(InternalEventsTest, OverflowIsDroppedNotAllocated)
+{
+    Chain chain;
+    chain.mHandled.reserve(16);
+    utils::AllocationGuard guard;
+    chain.dispatch(ChainEvent::eBurst);
+    EXPECT_EQ(guard.allocations(), 0);
+
+    // Six raised into a queue of four, so two dropped, and the other four handled
+    EXPECT_EQ(chain.droppedInternalEvents(), 2);
+    EXPECT_EQ(chain.mHandled.size(), 1 + ChainTraits::kInternalQueueCapacity);
+}
+
+}  // namespace tests
+}  // namespace eta_hsm
@@ -0,0 +1,178 @@
+// payload_dispatch_test.cpp
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstdint>
+
+#include "../Hsm.hpp"
+#include "../utils/AllocationGuard.hpp"
+#include "../utils/EventBucket.hpp"
+#include "../utils/PayloadEvent.hpp"
+
+namespace eta_hsm {
+namespace tests {
+
+enum class ThermostatEvent { eSetpoint, eFault, eClear, eNone };
+
+enum class ThermostatState { eTop, eRegulating, eFaulted };
+
+struct Setpoint {
+    float celsius;
+};
+
+struct FaultCode {
+    uint32_t code;
+};
+
+}  // namespace tests
+
+template <>
+struct utils::PayloadOf<tests::ThermostatEvent::eSetpoint> {
+    using type = tests::Setpoint;
+};
+template <>
+struct utils::PayloadOf<tests::ThermostatEvent::eFault> {
+    using type = tests::FaultCode;
+};
+
+namespace tests {
+
+struct ThermostatTraits {
+    using Clock = std::chrono::steady_clock;
+    using Event = utils::PayloadEvent<ThermostatEvent, 16>;
+    using StateEnum = ThermostatState;
+    static constexpr DefaultActions kDefaultActions = DefaultActions::eNothing;
+    static constexpr bool kClearTimersOnExit = false;
+    static constexpr size_t kInternalQueueCapacity = 2;
+    static constexpr size_t kDeferredQueueCapacity = 2;
+};
+
+/// Setpoints and fault codes arrive with their events rather than through members of the host
+class Thermostat : public StateMachine<Thermostat, ThermostatTraits> {
+public:
+    using Input = EmptyType;
+    Thermostat();
+
+    float mTarget{20.0f};
+    uint32_t mFault{0};
+};
+
+template <ThermostatState kState>
+using ThermostatStateTraits = StateTraits<Thermostat, ThermostatState, kState>;
+
+using Top = TopState<ThermostatStateTraits<ThermostatState::eTop>>;
+using Regulating = LeafState<ThermostatStateTraits<ThermostatState::eRegulating>, Top>;
+using Faulted = LeafState<ThermostatStateTraits<ThermostatState::eFaulted>, Top>;
+
+}  // namespace tests
+
+// While faulted, setpoint changes wait (payload and all) until the fault clears
+template <>
+struct Defer<tests::Faulted> : DeferEvents<tests::ThermostatEvent::eSetpoint> {};
+
+template <>
+template <typename Current>
+inline void tests::Regulating::handleEvent(tests::Thermostat& stateMachine, const Current& currentState,
+                                           Event event) const
+{
+    switch (event)
+    {
+        case tests::ThermostatEvent::eSetpoint:
+        {
+            const float celsius = event.get<tests::ThermostatEvent::eSetpoint>().celsius;
+            if (celsius > 90.0f)
+            {
+                // Out of range setpoints are faults in their own right
+                using Raised = tests::Thermostat::Event;
+                stateMachine.raise(Raised::make<tests::ThermostatEvent::eFault>(tests::FaultCode{42}));
+                return;
+            }
+            stateMachine.mTarget = celsius;
+            return;
+        }
+        case tests::ThermostatEvent::eFault:
+        {
+            stateMachine.mFault = event.get<tests::FaultCode>().code;
+            Transition<Current, ThisState, tests::Faulted> t(stateMachine);
+            return;
+        }
+        default:
+            break;
+    }
+    return ParentState::handleEvent(stateMachine, currentState, event);
+}
+
+template <>
+template <typename Current>
+inline void tests::Faulted::handleEvent(tests::Thermostat& stateMachine, const Current& currentState,
+                                        Event event) const
+{
+    if (event == tests::ThermostatEvent::eClear)
+    {
+        stateMachine.mFault = 0;
+        Transition<Current, ThisState, tests::Regulating> t(stateMachine);
+        return;
+    }
+    return ParentState::handleEvent(stateMachine, currentState, event);
+}
+
+template <>
+inline void tests::Top::init(tests::Thermostat& stateMachine)
+{
+    Init<tests::Regulating> i(stateMachine);
+}
+
+namespace tests {
+
+Thermostat::Thermostat() { Transition<Top, Top, Top> t(*this); }
+
+using ThermostatEventT = ThermostatTraits::Event;
+
+TEST(PayloadDispatchTest, HandlersReadPayloads)
+{
+    Thermostat thermostat;
+    thermostat.dispatch(ThermostatEventT::make<ThermostatEvent::eSetpoint>(Setpoint{22.5f}));
+    EXPECT_EQ(thermostat.mTarget, 22.5f);
+
+    thermostat.dispatch(ThermostatEventT{ThermostatEvent::eFault, FaultCode{7}});
+    EXPECT_EQ(thermostat.identify(), ThermostatState::eFaulted);
+    EXPECT_EQ(thermostat.mFault, 7);
+}
+
+TEST(PayloadDispatchTest, RaisedAndDeferredEventsKeepTheirPayloads)
+{
+    Thermostat thermostat;
+    thermostat.dispatch(ThermostatEventT::make<ThermostatEvent::eSetpoint>(Setpoint{95.0f}));
+    EXPECT_EQ(thermostat.identify(), ThermostatState::eFaulted);
+    EXPECT_EQ(thermostat.mFault, 42);
+
+    thermostat.dispatch(ThermostatEventT::make<ThermostatEvent::eSetpoint>(Setpoint{18.0f}));
+    EXPECT_EQ(thermostat.deferredEvents(), 1);
+    EXPECT_EQ(thermostat.mTarget, 20.0f);
+
+    // Enum-only events still dispatch as they are
+    thermostat.dispatch(ThermostatEvent::eClear);
+    EXPECT_EQ(thermostat.identify(), ThermostatState::eRegulating);
+    EXPECT_EQ(thermostat.mTarget, 18.0f);
+}
+
+TEST(PayloadDispatchTest, BucketToHandlerWithoutAllocating)
+{
+    Thermostat thermostat;
+    utils::StaticEventBucket<ThermostatEventT, 4> bucket;
+    utils::AllocationGuard guard;
+    bucket.addEvent(ThermostatEventT::make<ThermostatEvent::eSetpoint>(Setpoint{19.0f}));
+    bucket.addEvent(ThermostatEventT{ThermostatEvent::eFault, FaultCode{3}});
+    bucket.addEvent(ThermostatEventT::make<ThermostatEvent::eSetpoint>(Setpoint{21.0f}));
+    bucket.addEvent(ThermostatEvent::eClear);
+    const auto stats = thermostat.drain(bucket, DrainBudget<ThermostatTraits::Clock>{});
+    EXPECT_EQ(guard.allocations(), 0);
+
+    EXPECT_EQ(stats.dispatched, 4);
+    EXPECT_EQ(thermostat.identify(), ThermostatState::eRegulating);
+    EXPECT_EQ(thermostat.mTarget, 21.0f);
+}
+
+}  // namespace tests
+}  // namespace eta_hsm
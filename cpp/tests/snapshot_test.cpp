@@ -0,0 +1,291 @@
+// snapshot_test.cpp
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
+#include "../StateTable.hpp"
+#include "../utils/EventBucket.hpp"
+#include "../utils/FakeClock.hpp"
+#include "../utils/TimeTracker.hpp"
+#include "../utils/Timer.hpp"
+#include "wise_enum/wise_enum.h"
+
+namespace eta_hsm {
+namespace tests {
+
+WISE_ENUM_CLASS((OvenEvent, int32_t), eStart, eHot, eDone, eOpenDoor, eCloseDoor, eNone)
+
+WISE_ENUM_CLASS((OvenState, int32_t), eNone, eTop, eIdle, eCooking, eHeating, eBaking, eDoorOpen)
+
+struct OvenTraits {
+    using Clock = utils::FakeClock;
+    using Event = OvenEvent;
+    using StateEnum = OvenState;
+    static constexpr DefaultActions kDefaultActions = DefaultActions::eEntryExitOnly;
+    static constexpr bool kClearTimersOnExit = false;
+    static constexpr size_t kHistoryStates = wise_enum::size<OvenState>;
+    static constexpr size_t kDeferredQueueCapacity = 2;
+};
+
+class Oven;
+
+/// Everything a standby needs to carry on where an oven left off, as one block of plain data
+struct OvenCheckpoint;
+
+/// An oven that bakes for ten minutes once it is hot, and pauses (remembering where it was) while the door is open
+class Oven : public StateMachine<Oven, OvenTraits> {
+public:
+    using Input = EmptyType;
+    using Timers = utils::StaticTimerBank<utils::TimerTraits<utils::FakeClock, OvenEvent, OvenState>>;
+    using Bucket = utils::StaticEventBucket<OvenEvent, 4>;
+    using Tracker = utils::TimeTracker<OvenState, utils::FakeClock>;
+
+    explicit Oven(const utils::FakeClock& clock);
+
+    template <OvenState kState>
+    void entry()
+    {
+        mEntered.push_back(kState);
+        mTracker.enter(kState);
+        if (kState == OvenState::eBaking)
+        {
+            mTimers.addTimer(OvenEvent::eDone, kState, mClock.now() + std::chrono::minutes(10));
+        }
+    }
+
+    template <OvenState kState>
+    void exit()
+    {
+        mTracker.exit(kState);
+    }
+
+    /// Fire expired timers, then handle everything in the bucket
+    void update()
+    {
+        mTimers.checkTimers(mClock.now(), mBucket);
+        while (!mBucket.empty())
+        {
+            dispatch(mBucket.getEvent());
+        }
+    }
+
+    OvenCheckpoint checkpoint() const;
+    bool restore(const OvenCheckpoint& checkpoint);
+
+    const utils::FakeClock& mClock;
+    Timers mTimers{};
+    Bucket mBucket{};
+    Tracker mTracker{mClock};
+    std::vector<OvenState> mEntered{};
+};
+
+struct OvenCheckpoint {
+    Oven::Snapshot machine;
+    Oven::Timers::Snapshot timers;
+    Oven::Bucket::Snapshot bucket;
+    Oven::Tracker::Snapshot tracker;
+};
+
+template <OvenState kState>
+using OvenStateTraits = StateTraits<Oven, OvenState, kState>;
+
+using Top = TopState<OvenStateTraits<OvenState::eTop>>;
+using Idle = LeafState<OvenStateTraits<OvenState::eIdle>, Top>;
+using Cooking = CompState<OvenStateTraits<OvenState::eCooking>, Top>;
+using Heating = LeafState<OvenStateTraits<OvenState::eHeating>, Cooking>;
+using Baking = LeafState<OvenStateTraits<OvenState::eBaking>, Cooking>;
+using DoorOpen = LeafState<OvenStateTraits<OvenState::eDoorOpen>, Top>;
+
+ETA_HSM_REGISTER_STATE(Oven, Top, OvenState);
+ETA_HSM_REGISTER_STATE(Oven, Idle, OvenState);
+ETA_HSM_REGISTER_STATE(Oven, Cooking, OvenState);
+ETA_HSM_REGISTER_STATE(Oven, Heating, OvenState);
+ETA_HSM_REGISTER_STATE(Oven, Baking, OvenState);
+ETA_HSM_REGISTER_STATE(Oven, DoorOpen, OvenState);
+
+}  // namespace tests
+
+// Getting hot while the door is open only counts once it is closed again
+template <>
+struct Defer<tests::DoorOpen> : DeferEvents<tests::OvenEvent::eHot> {};
+
+template <>
+template <typename Current>
+inline void tests::Idle::handleEvent(tests::Oven& stateMachine, const Current& currentState, Event event) const
+{
+    if (event == tests::OvenEvent::eStart)
+    {
+        Transition<Current, ThisState, tests::Cooking> t(stateMachine);
+        return;
+    }
+    return ParentState::handleEvent(stateMachine, currentState, event);
+}
+
+template <>
+template <typename Current>
+inline void tests::Cooking::handleEvent(tests::Oven& stateMachine, const Current& currentState, Event event) const
+{
+    if (event == tests::OvenEvent::eOpenDoor)
+    {
+        Transition<Current, ThisState, tests::DoorOpen> t(stateMachine);
+        return;
+    }
+    return ParentState::handleEvent(stateMachine, currentState, event);
+}
+
+template <>
+template <typename Current>
+inline void tests::Heating::handleEvent(tests::Oven& stateMachine, const Current& currentState, Event event) const
+{
+    if (event == tests::OvenEvent::eHot)
+    {
+        Transition<Current, ThisState, tests::Baking> t(stateMachine);
+        return;
+    }
+    return ParentState::handleEvent(stateMachine, currentState, event);
+}
+
+template <>
+template <typename Current>
+inline void tests::Baking::handleEvent(tests::Oven& stateMachine, const Current& currentState, Event event) const
+{
+    if (event == tests::OvenEvent::eDone)
+    {
+        Transition<Current, ThisState, tests::Idle> t(stateMachine);
+        return;
+    }
+    return ParentState::handleEvent(stateMachine, currentState, event);
+}
+
+template <>
+template <typename Current>
+inline void tests::DoorOpen::handleEvent(tests::Oven& stateMachine, const Current& currentState, Event event) const
+{
+    if (event == tests::OvenEvent::eCloseDoor)
+    {
+        Transition<Current, ThisState, DeepHistory<tests::Cooking>> t(stateMachine);
+        return;
+    }
+    return ParentState::handleEvent(stateMachine, currentState, event);
+}
+
+template <>
+inline void tests::Cooking::init(tests::Oven& stateMachine)
+{
+    Init<tests::Heating> i(stateMachine);
+}
+
+template <>
+inline void tests::Top::init(tests::Oven& stateMachine)
+{
+    Init<tests::Idle> i(stateMachine);
+}
+
+namespace tests {
+
+using OvenStateTable = StateTable<Oven, wise_enum::size<OvenState>>;
+
+Oven::Oven(const utils::FakeClock& clock) : mClock{clock} { Transition<Top, Top, Top> t(*this); }
+
+OvenCheckpoint Oven::checkpoint() const
+{
+    return {snapshot(), mTimers.snapshot(mClock.now()), mBucket.snapshot(), mTracker.snapshot()};
+}
+
+bool Oven::restore(const OvenCheckpoint& checkpoint)
+{
+    if (!StateMachine::restore<OvenStateTable>(checkpoint.machine))
+    {
+        return false;
+    }
+    mTimers.restore(checkpoint.timers, mClock.now());
+    mBucket.restore(checkpoint.bucket);
+    mTracker.restore(checkpoint.tracker);
+    return true;
+}
+
+static_assert(std::is_trivially_copyable_v<OvenCheckpoint>);
+static_assert(std::is_standard_layout_v<OvenCheckpoint>);
+
+TEST(SnapshotTest, StandbyCarriesOnWithoutEntryActions)
+{
+    utils::FakeClock primaryClock;
+    Oven primary(primaryClock);
+    primary.dispatch(OvenEvent::eStart);
+    primary.dispatch(OvenEvent::eHot);
+    primaryClock.advance(std::chrono::minutes(4));
+    const OvenCheckpoint checkpoint = primary.checkpoint();
+
+    // The standby's clock need not agree with the primary's
+    utils::FakeClock standbyClock;
+    standbyClock.advance(std::chrono::hours(3));
+    Oven standby(standbyClock);
+    standby.mEntered.clear();
+    ASSERT_TRUE(standby.restore(checkpoint));
+
+    EXPECT_EQ(standby.identify(), OvenState::eBaking);
+    EXPECT_TRUE(standby.isInSubstateOf(OvenState::eCooking));
+    EXPECT_TRUE(standby.mEntered.empty());
+    EXPECT_EQ(standby.mTracker.timeInState(OvenState::eBaking), std::chrono::minutes(4));
+    EXPECT_EQ(standby.mTracker.timeInState(OvenState::eCooking), std::chrono::minutes(4));
+    EXPECT_EQ(standby.mTracker.timeInState(OvenState::eIdle), std::chrono::minutes(0));
+
+    // The bake timer has the six minutes left that it had on the primary
+    standbyClock.advance(std::chrono::minutes(6));
+    standby.update();
+    EXPECT_EQ(standby.identify(), OvenState::eBaking);
+    standbyClock.advance(std::chrono::nanoseconds(1));
+    standby.update();
+    EXPECT_EQ(standby.identify(), OvenState::eIdle);
+}
+
+TEST(SnapshotTest, HistoryDeferredAndQueuedEventsCarryOver)
+{
+    utils::FakeClock clock;
+    Oven primary(clock);
+    primary.dispatch(OvenEvent::eStart);
+    primary.dispatch(OvenEvent::eOpenDoor);
+    primary.dispatch(OvenEvent::eHot);
+    primary.mBucket.addEvent(OvenEvent::eCloseDoor);
+    EXPECT_EQ(primary.deferredEvents(), 1);
+
+    // Checkpoint a whole fleet with one copy
+    std::vector<OvenCheckpoint> fleet(3, primary.checkpoint());
+    std::vector<OvenCheckpoint> replica(fleet.size());
+    std::memcpy(replica.data(), fleet.data(), fleet.size() * sizeof(OvenCheckpoint));
+
+    Oven standby(clock);
+    ASSERT_TRUE(standby.restore(replica[2]));
+    EXPECT_EQ(standby.identify(), OvenState::eDoorOpen);
+    EXPECT_EQ(standby.history(OvenState::eCooking), OvenState::eHeating);
+    EXPECT_EQ(standby.deferredEvents(), 1);
+
+    // Closing the door resumes Heating, where the deferred eHot finally lands
+    standby.mEntered.clear();
+    standby.update();
+    EXPECT_EQ(standby.identify(), OvenState::eBaking);
+    EXPECT_EQ(standby.mEntered, (std::vector<OvenState>{OvenState::eCooking, OvenState::eHeating, OvenState::eBaking}));
+}
+
+TEST(SnapshotTest, RestoreRefusesStatesThatAreNotLeaves)
+{
+    utils::FakeClock clock;
+    Oven oven(clock);
+    OvenCheckpoint checkpoint = oven.checkpoint();
+
+    checkpoint.machine.state = OvenState::eCooking;
+    EXPECT_FALSE(oven.restore(checkpoint));
+    EXPECT_EQ(oven.identify(), OvenState::eIdle);
+
+    checkpoint.machine.state = OvenState::eBaking;
+    checkpoint.machine.history[static_cast<size_t>(OvenState::eCooking)] = OvenState::eCooking;
+    EXPECT_FALSE(oven.restore(checkpoint));
+    EXPECT_EQ(oven.identify(), OvenState::eIdle);
+}
+
+}  // namespace tests
+}  // namespace eta_hsm
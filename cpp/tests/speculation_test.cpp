@@ -0,0 +1,204 @@
+// speculation_test.cpp
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <vector>
+
+#include "../Speculation.hpp"
+#include "../utils/EventBucket.hpp"
+
+namespace eta_hsm {
+namespace tests {
+
+enum class TurnstileEvent { eCoin, ePush, eForce, eReset, eNone };
+
+enum class TurnstileState { eTop, eLocked, eUnlocked, eAlarm };
+
+struct TurnstileTraits {
+    using Clock = std::chrono::steady_clock;
+    using Event = TurnstileEvent;
+    using StateEnum = TurnstileState;
+    static constexpr DefaultActions kDefaultActions = DefaultActions::eEntryExitOnly;
+    static constexpr bool kClearTimersOnExit = false;
+};
+
+/// A coin-operated turnstile that raises an alarm when forced
+class Turnstile : public StateMachine<Turnstile, TurnstileTraits> {
+public:
+    using Input = EmptyType;
+    explicit Turnstile(utils::OrderedEventBucket<TurnstileEvent>& alarms);
+
+    /// Clones keep their alarms to themselves
+    Turnstile(const Turnstile& other) : StateMachine(other), mCoins{other.mCoins} {}
+
+    template <TurnstileState kState>
+    void entry()
+    {
+        if (kState == TurnstileState::eAlarm && mAlarms)
+        {
+            mAlarms->addEvent(TurnstileEvent::eForce);
+        }
+    }
+
+    template <TurnstileState kState>
+    void exit()
+    {}
+
+    utils::OrderedEventBucket<TurnstileEvent>* mAlarms{nullptr};
+    int mCoins{0};
+};
+
+template <TurnstileState kState>
+using TurnstileStateTraits = StateTraits<Turnstile, TurnstileState, kState>;
+
+using Top = TopState<TurnstileStateTraits<TurnstileState::eTop>>;
+using Locked = LeafState<TurnstileStateTraits<TurnstileState::eLocked>, Top>;
+using Unlocked = LeafState<TurnstileStateTraits<TurnstileState::eUnlocked>, Top>;
+using Alarm = LeafState<TurnstileStateTraits<TurnstileState::eAlarm>, Top>;
+
+}  // namespace tests
+
+template <>
+template <typename Current>
+inline void tests::Locked::handleEvent(tests::Turnstile& stateMachine, const Current& currentState,
+                                       Event event) const
+{
+    switch (event)
+    {
+        case tests::TurnstileEvent::eCoin:
+        {
+            ++stateMachine.mCoins;
+            Transition<Current, ThisState, tests::Unlocked> t(stateMachine);
+            return;
+        }
+        case tests::TurnstileEvent::eForce:
+        {
+            Transition<Current, ThisState, tests::Alarm> t(stateMachine);
+            return;
+        }
+        default:
+            break;
+    }
+    return ParentState::handleEvent(stateMachine, currentState, event);
+}
+
+template <>
+template <typename Current>
+inline void tests::Unlocked::handleEvent(tests::Turnstile& stateMachine, const Current& currentState,
+                                         Event event) const
+{
+    if (event == tests::TurnstileEvent::ePush)
+    {
+        Transition<Current, ThisState, tests::Locked> t(stateMachine);
+        return;
+    }
+    return ParentState::handleEvent(stateMachine, currentState, event);
+}
+
+template <>
+template <typename Current>
+inline void tests::Alarm::handleEvent(tests::Turnstile& stateMachine, const Current& currentState, Event event) const
+{
+    if (event == tests::TurnstileEvent::eReset)
+    {
+        Transition<Current, ThisState, tests::Locked> t(stateMachine);
+        return;
+    }
+    return ParentState::handleEvent(stateMachine, currentState, event);
+}
+
+template <>
+inline void tests::Top::init(tests::Turnstile& stateMachine)
+{
+    Init<tests::Locked> i(stateMachine);
+}
+
+namespace tests {
+
+Turnstile::Turnstile(utils::OrderedEventBucket<TurnstileEvent>& alarms) : mAlarms{&alarms}
+{
+    Transition<Top, Top, Top> t(*this);
+}
+
+using Sequences = std::vector<std::vector<TurnstileEvent>>;
+
+TEST(SpeculationTest, CloneStartsWhereTheOriginalIs)
+{
+    utils::OrderedEventBucket<TurnstileEvent> alarms;
+    Turnstile live(alarms);
+    live.dispatch(TurnstileEvent::eCoin);
+
+    Turnstile clone(live);
+    EXPECT_EQ(clone.identify(), TurnstileState::eUnlocked);
+    EXPECT_EQ(clone.transitions(), live.transitions());
+    clone.dispatch(TurnstileEvent::ePush);
+    EXPECT_EQ(clone.identify(), TurnstileState::eLocked);
+    EXPECT_EQ(live.identify(), TurnstileState::eUnlocked);
+}
+
+TEST(SpeculationTest, OutcomesOfEachSequenceWithoutTouchingTheLiveMachine)
+{
+    utils::OrderedEventBucket<TurnstileEvent> alarms;
+    Turnstile live(alarms);
+    const uint64_t liveTransitions = live.transitions();
+
+    utils::ForkJoinPool pool(2);
+    Speculator<Turnstile> speculator(pool);
+    const Sequences sequences{
+        {},
+        {TurnstileEvent::eCoin},
+        {TurnstileEvent::eCoin, TurnstileEvent::ePush, TurnstileEvent::eCoin},
+        {TurnstileEvent::ePush, TurnstileEvent::eForce},
+        {TurnstileEvent::eForce, TurnstileEvent::eCoin, TurnstileEvent::eReset},
+    };
+    const auto outcomes = speculator.run(live, sequences);
+
+    ASSERT_EQ(outcomes.size(), sequences.size());
+    EXPECT_EQ(outcomes[0].state, TurnstileState::eLocked);
+    EXPECT_EQ(outcomes[0].transitions, 0);
+    EXPECT_EQ(outcomes[1].state, TurnstileState::eUnlocked);
+    EXPECT_EQ(outcomes[2].state, TurnstileState::eUnlocked);
+    EXPECT_EQ(outcomes[2].transitions, 3);
+    EXPECT_EQ(outcomes[3].state, TurnstileState::eAlarm);
+    EXPECT_EQ(outcomes[3].dispatched, 2);
+    EXPECT_EQ(outcomes[4].state, TurnstileState::eLocked);
+    EXPECT_EQ(outcomes[4].transitions, 2);
+
+    // Nothing happened to the live machine, or to anything it is connected to
+    EXPECT_EQ(live.identify(), TurnstileState::eLocked);
+    EXPECT_EQ(live.transitions(), liveTransitions);
+    EXPECT_EQ(live.mCoins, 0);
+    EXPECT_TRUE(alarms.empty());
+}
+
+TEST(SpeculationTest, ParallelRunsMatchSerialOnes)
+{
+    utils::OrderedEventBucket<TurnstileEvent> alarms;
+    Turnstile live(alarms);
+    live.dispatch(TurnstileEvent::eCoin);
+
+    Sequences sequences(200);
+    for (size_t idx = 0; idx < sequences.size(); ++idx)
+    {
+        for (size_t step = 0; step < idx % 13; ++step)
+        {
+            sequences[idx].push_back(static_cast<TurnstileEvent>((idx * 7 + step * 3) % 4));
+        }
+    }
+
+    utils::ForkJoinPool serialPool(0);
+    utils::ForkJoinPool parallelPool(4);
+    std::vector<SpeculativeOutcome<TurnstileState>> serial;
+    std::vector<SpeculativeOutcome<TurnstileState>> parallel;
+    Speculator<Turnstile>(serialPool).run(live, sequences, serial);
+    Speculator<Turnstile>(parallelPool).run(live, sequences, parallel);
+    for (size_t idx = 0; idx < sequences.size(); ++idx)
+    {
+        EXPECT_EQ(parallel[idx].state, serial[idx].state) << idx;
+        EXPECT_EQ(parallel[idx].transitions, serial[idx].transitions) << idx;
+    }
+}
+
+}  // namespace tests
+}  // namespace eta_hsm
@@ -0,0 +1,145 @@
+// state_table_test.cpp
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "../macros/HsmMacros.hpp"
+#include "../utils/AllocationGuard.hpp"
+
+namespace eta_hsm {
+namespace tests {
+
+enum class ValveEvent { eOpen, eClose, eNone };
+
+// Deliberately sparse, to show that values without a state (and values past the end) are not leaves
+enum class ValveStateEnum { eNone, eTop, eClosed, eActive, eOpening, eOpen, eUnused, eCount };
+
+struct ValveTraits {
+    using Clock = std::chrono::steady_clock;
+    using Event = ValveEvent;
+    using StateEnum = ValveStateEnum;
+    static constexpr DefaultActions kDefaultActions = DefaultActions::eEntryExitOnly;
+    static constexpr bool kClearTimersOnExit = false;
+};
+
+class Valve : public StateMachine<Valve, ValveTraits> {
+public:
+    using Input = EmptyType;
+    Valve();
+
+    template <ValveStateEnum kState>
+    void entry()
+    {
+        mEntered.push_back(kState);
+    }
+
+    template <ValveStateEnum kState>
+    void exit()
+    {}
+
+    std::vector<ValveStateEnum> mEntered{};
+};
+
+ETA_HSM_TOP_STATE(Valve, Top);
+ETA_HSM_LEAF_STATE(Valve, Closed, Top);
+ETA_HSM_COMP_STATE(Valve, Active, Top);
+ETA_HSM_LEAF_STATE(Valve, Opening, Active);
+ETA_HSM_LEAF_STATE(Valve, Open, Active);
+
+}  // namespace tests
+
+template <>
+template <typename Current>
+inline void tests::Closed::handleEvent(tests::Valve& stateMachine, const Current& currentState, Event event) const
+{
+    if (event == tests::ValveEvent::eOpen)
+    {
+        Transition<Current, ThisState, tests::Opening> t(stateMachine);
+        return;
+    }
+    return ParentState::handleEvent(stateMachine, currentState, event);
+}
+
+template <>
+template <typename Current>
+inline void tests::Active::handleEvent(tests::Valve& stateMachine, const Current& currentState, Event event) const
+{
+    if (event == tests::ValveEvent::eClose)
+    {
+        Transition<Current, ThisState, tests::Closed> t(stateMachine);
+        return;
+    }
+    return ParentState::handleEvent(stateMachine, currentState, event);
+}
+
+template <>
+inline void tests::Active::init(tests::Valve& stateMachine)
+{
+    Init<tests::Opening> i(stateMachine);
+}
+
+template <>
+inline void tests::Top::init(tests::Valve& stateMachine)
+{
+    Init<tests::Closed> i(stateMachine);
+}
+
+namespace tests {
+
+Valve::Valve() { Transition<Top, Top, Top> t(*this); }
+
+TEST(StateTableTest, FlagsAreKnownAtCompileTime)
+{
+    static_assert(testing::isLeaf(ValveStateEnum::eClosed));
+    static_assert(testing::isLeaf(ValveStateEnum::eOpen));
+    static_assert(!testing::isLeaf(ValveStateEnum::eTop));
+    static_assert(!testing::isLeaf(ValveStateEnum::eActive));
+    static_assert(!testing::isLeaf(ValveStateEnum::eUnused));
+
+    static_assert(ValveStateTable::isDeclared(ValveStateEnum::eActive));
+    static_assert(!ValveStateTable::isDeclared(ValveStateEnum::eNone));
+    EXPECT_EQ(ValveStateTable::leaf(ValveStateEnum::eOpening), Opening::instance());
+    EXPECT_EQ(ValveStateTable::leaf(ValveStateEnum::eActive), nullptr);
+    EXPECT_EQ(ValveStateTable::leaf(ValveStateEnum::eCount), nullptr);
+}
+
+TEST(StateTableTest, SetStateBypassesEntryAndExit)
+{
+    Valve valve;
+    valve.mEntered.clear();
+
+    EXPECT_TRUE(testing::setState(valve, ValveStateEnum::eOpen));
+    EXPECT_EQ(valve.identify(), ValveStateEnum::eOpen);
+    EXPECT_TRUE(valve.mEntered.empty());
+
+    // The machine carries on from there as if it had got there itself
+    valve.dispatch(ValveEvent::eClose);
+    EXPECT_EQ(valve.identify(), ValveStateEnum::eClosed);
+    EXPECT_EQ(valve.mEntered, (std::vector<ValveStateEnum>{ValveStateEnum::eClosed}));
+}
+
+TEST(StateTableTest, CompositeAndUnknownStatesAreRefused)
+{
+    Valve valve;
+    EXPECT_FALSE(testing::setState(valve, ValveStateEnum::eActive));
+    EXPECT_FALSE(testing::setState(valve, ValveStateEnum::eUnused));
+    EXPECT_FALSE(testing::setState(valve, static_cast<ValveStateEnum>(1000)));
+    EXPECT_EQ(valve.identify(), ValveStateEnum::eClosed);
+}
+
+TEST(StateTableTest, SetStateDoesNotAllocate)
+{
+    Valve valve;
+    utils::AllocationGuard guard;
+    for (auto state : {ValveStateEnum::eOpening, ValveStateEnum::eOpen, ValveStateEnum::eClosed})
+    {
+        EXPECT_TRUE(testing::setState(valve, state));
+    }
+    EXPECT_EQ(guard.allocations(), 0);
+}
+
+}  // namespace tests
+}  // namespace eta_hsm
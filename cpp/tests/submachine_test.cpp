@@ -0,0 +1,364 @@
+// submachine_test.cpp
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "../Submachine.hpp"
+#include "../utils/FakeClock.hpp"
+#include "../utils/Timer.hpp"
+#include "wise_enum/wise_enum.h"
+
+namespace eta_hsm {
+namespace tests {
+
+using Log = std::vector<std::string>;
+
+//
+// The child:  a lift door, written as an ordinary machine and reused here as-is
+//
+WISE_ENUM_CLASS((DoorEvent, int32_t), eOpened, eClose, eClosed, eObstruct, eTimeout, eNone)
+
+WISE_ENUM_CLASS((DoorState, int32_t), eNone, eTop, eOpening, eOpen, eClosing, eShut, eJammed)
+
+struct DoorTraits {
+    using Clock = utils::FakeClock;
+    using Event = DoorEvent;
+    using StateEnum = DoorState;
+    static constexpr DefaultActions kDefaultActions = DefaultActions::eEntryExitOnly;
+    static constexpr bool kClearTimersOnExit = true;
+};
+
+class Door : public StateMachine<Door, DoorTraits> {
+public:
+    using Input = EmptyType;
+    using EventScheduler = utils::TimerBank<utils::TimerTraits<utils::FakeClock, DoorEvent, DoorState>>;
+
+    /// Not started here:  the Submachine starts the door whenever the lift starts boarding
+    explicit Door(Log& log) : mLog{log} {}
+
+    template <DoorState kState>
+    void entry()
+    {
+        mLog.push_back(std::string("door enter ") + std::string(wise_enum::to_string(kState)));
+        if (kState == DoorState::eOpen)
+        {
+            // Close automatically if nobody asks to first
+            mEventScheduler.addTimer(DoorEvent::eTimeout, kState, utils::FakeClock::time_point());
+        }
+    }
+
+    template <DoorState kState>
+    void exit()
+    {
+        mLog.push_back(std::string("door exit ") + std::string(wise_enum::to_string(kState)));
+    }
+
+    EventScheduler& eventScheduler() { return mEventScheduler; }
+
+    Log& mLog;
+    EventScheduler mEventScheduler{};
+};
+
+template <DoorState kState>
+using DoorStateTraits = StateTraits<Door, DoorState, kState>;
+
+namespace door {
+using Top = TopState<DoorStateTraits<DoorState::eTop>>;
+using Opening = LeafState<DoorStateTraits<DoorState::eOpening>, Top>;
+using Open = LeafState<DoorStateTraits<DoorState::eOpen>, Top>;
+using Closing = LeafState<DoorStateTraits<DoorState::eClosing>, Top>;
+using Shut = LeafState<DoorStateTraits<DoorState::eShut>, Top>;
+using Jammed = LeafState<DoorStateTraits<DoorState::eJammed>, Top>;
+}  // namespace door
+
+//
+// The parent:  a lift, which lets its door do the work while boarding
+//
+WISE_ENUM_CLASS((LiftEvent, int32_t), eArrive, eDoorOpened, eDoorClose, eDoorClosed, eDoorObstruct, eReset, eNone)
+
+WISE_ENUM_CLASS((LiftState, int32_t), eTop, eParked, eBoarding, eMoving, eFault)
+
+struct LiftTraits {
+    using Clock = utils::FakeClock;
+    using Event = LiftEvent;
+    using StateEnum = LiftState;
+    static constexpr DefaultActions kDefaultActions = DefaultActions::eEntryExitOnly;
+    static constexpr bool kClearTimersOnExit = false;
+};
+
+class Lift : public StateMachine<Lift, LiftTraits> {
+public:
+    using Input = EmptyType;
+    Lift();
+
+    template <LiftState kState>
+    void entry()
+    {
+        mLog.push_back(std::string("enter ") + std::string(wise_enum::to_string(kState)));
+    }
+
+    template <LiftState kState>
+    void exit()
+    {
+        mLog.push_back(std::string("exit ") + std::string(wise_enum::to_string(kState)));
+    }
+
+    Log mLog{};
+    Submachine<Door> mDoor{mLog};
+};
+
+template <LiftState kState>
+using LiftStateTraits = StateTraits<Lift, LiftState, kState>;
+
+using Top = TopState<LiftStateTraits<LiftState::eTop>>;
+using Parked = LeafState<LiftStateTraits<LiftState::eParked>, Top>;
+using Boarding = LeafState<LiftStateTraits<LiftState::eBoarding>, Top>;
+using Moving = LeafState<LiftStateTraits<LiftState::eMoving>, Top>;
+using Fault = LeafState<LiftStateTraits<LiftState::eFault>, Top>;
+
+}  // namespace tests
+
+template <>
+template <typename Current>
+inline void tests::door::Opening::handleEvent(tests::Door& stateMachine, const Current& currentState,
+                                              Event event) const
+{
+    if (event == tests::DoorEvent::eOpened)
+    {
+        Transition<Current, ThisState, tests::door::Open> t(stateMachine);
+        return;
+    }
+    return ParentState::handleEvent(stateMachine, currentState, event);
+}
+
+template <>
+template <typename Current>
+inline void tests::door::Open::handleEvent(tests::Door& stateMachine, const Current& currentState, Event event) const
+{
+    if (event == tests::DoorEvent::eClose || event == tests::DoorEvent::eTimeout)
+    {
+        Transition<Current, ThisState, tests::door::Closing> t(stateMachine);
+        return;
+    }
+    return ParentState::handleEvent(stateMachine, currentState, event);
+}
+
+template <>
+template <typename Current>
+inline void tests::door::Closing::handleEvent(tests::Door& stateMachine, const Current& currentState,
+                                              Event event) const
+{
+    switch (event)
+    {
+        case tests::DoorEvent::eClosed:
+        {
+            Transition<Current, ThisState, tests::door::Shut> t(stateMachine);
+            return;
+        }
+        case tests::DoorEvent::eObstruct:
+        {
+            Transition<Current, ThisState, tests::door::Jammed> t(stateMachine);
+            return;
+        }
+        default:
+            break;
+    }
+    return ParentState::handleEvent(stateMachine, currentState, event);
+}
+
+template <>
+inline void tests::door::Top::init(tests::Door& stateMachine)
+{
+    Init<tests::door::Opening> i(stateMachine);
+}
+
+template <>
+inline void tests::Lift::entry<tests::LiftState::eBoarding>()
+{
+    mLog.push_back("enter eBoarding");
+    mDoor.enter();
+}
+
+template <>
+inline void tests::Lift::exit<tests::LiftState::eBoarding>()
+{
+    mDoor.exit();
+    mLog.push_back("exit eBoarding");
+}
+
+template <>
+template <typename Current>
+inline void tests::Parked::handleEvent(tests::Lift& stateMachine, const Current& currentState, Event event) const
+{
+    if (event == tests::LiftEvent::eArrive)
+    {
+        Transition<Current, ThisState, tests::Boarding> t(stateMachine);
+        return;
+    }
+    return ParentState::handleEvent(stateMachine, currentState, event);
+}
+
+template <>
+template <typename Current>
+inline void tests::Boarding::handleEvent(tests::Lift& stateMachine, const Current& currentState, Event event) const
+{
+    tests::DoorEvent doorEvent = tests::DoorEvent::eNone;
+    switch (event)
+    {
+        case tests::LiftEvent::eDoorOpened:
+            doorEvent = tests::DoorEvent::eOpened;
+            break;
+        case tests::LiftEvent::eDoorClose:
+            doorEvent = tests::DoorEvent::eClose;
+            break;
+        case tests::LiftEvent::eDoorClosed:
+            doorEvent = tests::DoorEvent::eClosed;
+            break;
+        case tests::LiftEvent::eDoorObstruct:
+            doorEvent = tests::DoorEvent::eObstruct;
+            break;
+        case tests::LiftEvent::eReset:
+        {
+            // Abandon boarding, whatever the door is up to
+            Transition<Current, ThisState, tests::Parked> t(stateMachine);
+            return;
+        }
+        default:
+            return ParentState::handleEvent(stateMachine, currentState, event);
+    }
+    Forward<Current, ThisState, OnTerminal<tests::door::Shut, tests::Moving>,
+            OnTerminal<tests::door::Jammed, tests::Fault>>
+        f(stateMachine, stateMachine.mDoor, doorEvent);
+}
+
+template <>
+inline void tests::Boarding::during(tests::Lift& stateMachine, const Input&) const
+{
+    // Catch the door reaching a terminal state by itself (e.g. from one of its timers), not only through Forward
+    stateMachine.mDoor.during();
+    Forward<ThisState, ThisState, OnTerminal<tests::door::Shut, tests::Moving>,
+            OnTerminal<tests::door::Jammed, tests::Fault>>
+        f(stateMachine, stateMachine.mDoor);
+}
+
+template <>
+template <typename Current>
+inline void tests::Moving::handleEvent(tests::Lift& stateMachine, const Current& currentState, Event event) const
+{
+    if (event == tests::LiftEvent::eArrive)
+    {
+        Transition<Current, ThisState, tests::Boarding> t(stateMachine);
+        return;
+    }
+    return ParentState::handleEvent(stateMachine, currentState, event);
+}
+
+template <>
+template <typename Current>
+inline void tests::Fault::handleEvent(tests::Lift& stateMachine, const Current& currentState, Event event) const
+{
+    if (event == tests::LiftEvent::eReset)
+    {
+        Transition<Current, ThisState, tests::Parked> t(stateMachine);
+        return;
+    }
+    return ParentState::handleEvent(stateMachine, currentState, event);
+}
+
+template <>
+inline void tests::Top::init(tests::Lift& stateMachine)
+{
+    Init<tests::Parked> i(stateMachine);
+}
+
+namespace tests {
+
+Lift::Lift() { Transition<Top, Top, Top> t(*this); }
+
+TEST(SubmachineTest, ChildRunsOnlyWhileParentIsInContainingState)
+{
+    Lift lift;
+    EXPECT_FALSE(lift.mDoor.running());
+
+    lift.mLog.clear();
+    lift.dispatch(LiftEvent::eArrive);
+    EXPECT_EQ(lift.identify(), LiftState::eBoarding);
+    EXPECT_TRUE(lift.mDoor.running());
+    EXPECT_EQ(lift.mLog, (Log{"exit eParked", "enter eBoarding", "door enter eTop", "door enter eOpening"}));
+
+    lift.dispatch(LiftEvent::eDoorOpened);
+    EXPECT_EQ(lift.mDoor.machine().identify(), DoorState::eOpen);
+}
+
+TEST(SubmachineTest, TerminalStatesBecomeParentTransitions)
+{
+    Lift lift;
+    lift.dispatch(LiftEvent::eArrive);
+    lift.dispatch(LiftEvent::eDoorOpened);
+    lift.dispatch(LiftEvent::eDoorClose);
+    lift.mLog.clear();
+    lift.dispatch(LiftEvent::eDoorClosed);
+
+    // The door reaches Shut, and within the same dispatch the lift leaves Boarding (stopping the door) for Moving
+    EXPECT_EQ(lift.identify(), LiftState::eMoving);
+    EXPECT_FALSE(lift.mDoor.running());
+    EXPECT_EQ(lift.mLog, (Log{"door exit eClosing", "door enter eShut", "door exit eShut", "door exit eTop",
+                              "exit eBoarding", "enter eMoving"}));
+
+    // Boarding again starts the door over from the beginning
+    lift.dispatch(LiftEvent::eArrive);
+    EXPECT_EQ(lift.mDoor.machine().identify(), DoorState::eOpening);
+
+    lift.dispatch(LiftEvent::eDoorOpened);
+    lift.dispatch(LiftEvent::eDoorClose);
+    lift.dispatch(LiftEvent::eDoorObstruct);
+    EXPECT_EQ(lift.identify(), LiftState::eFault);
+}
+
+TEST(SubmachineTest, TerminalsReachedOutsideForwardAreTakenOnTheParentsDuring)
+{
+    Lift lift;
+    lift.dispatch(LiftEvent::eArrive);
+
+    // Events dispatched straight into the child (as its timers would be) do not go through Forward
+    lift.mDoor.dispatch(DoorEvent::eOpened);
+    lift.mDoor.dispatch(DoorEvent::eClose);
+    lift.mDoor.dispatch(DoorEvent::eClosed);
+    EXPECT_EQ(lift.mDoor.machine().identify(), DoorState::eShut);
+    EXPECT_EQ(lift.identify(), LiftState::eBoarding);
+
+    lift.mLog.clear();
+    lift.during();
+    EXPECT_EQ(lift.identify(), LiftState::eMoving);
+    EXPECT_FALSE(lift.mDoor.running());
+    EXPECT_EQ(lift.mLog, (Log{"door exit eShut", "door exit eTop", "exit eBoarding", "enter eMoving"}));
+
+    // Nothing happens while the child is not in a terminal state
+    lift.dispatch(LiftEvent::eArrive);
+    lift.during();
+    EXPECT_EQ(lift.identify(), LiftState::eBoarding);
+}
+
+TEST(SubmachineTest, ChildTimersLiveAndDieWithTheChild)
+{
+    Lift lift;
+    lift.dispatch(LiftEvent::eArrive);
+    lift.dispatch(LiftEvent::eDoorOpened);
+    Door& door = lift.mDoor.machine();
+    EXPECT_FALSE(door.eventScheduler().empty());
+
+    // Leaving Boarding any which way stops the door, which clears the timers of the states it exits
+    lift.dispatch(LiftEvent::eReset);
+    EXPECT_EQ(lift.identify(), LiftState::eParked);
+    EXPECT_FALSE(lift.mDoor.running());
+    EXPECT_TRUE(door.eventScheduler().empty());
+
+    // The door is held by value, not behind a pointer
+    EXPECT_GE(sizeof(Lift), sizeof(Door));
+}
+
+}  // namespace tests
+}  // namespace eta_hsm
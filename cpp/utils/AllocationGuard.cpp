@@ -0,0 +1,157 @@
+// eta/hsm/AllocationGuard.cpp
+
+#include "AllocationGuard.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+namespace eta_hsm {
+namespace utils {
+namespace {
+
+/// Per-thread bookkeeping.  This must stay trivially constructible and destructible so that touching it from inside
+/// the allocator can never itself allocate (or run before/after the thread's TLS is usable).
+struct ThreadAllocationState {
+    uint64_t allocations;
+    uint64_t bytes;
+    uint32_t forbidding;  // number of guards in scope with Policy::eAbort
+};
+
+thread_local ThreadAllocationState tAllocationState{};
+
+void noteAllocation(size_t size)
+{
+    ThreadAllocationState& state = tAllocationState;
+    ++state.allocations;
+    state.bytes += size;
+    if (state.forbidding > 0)
+    {
+        state.forbidding = 0;  // don't recurse if reporting allocates
+        std::fputs("eta_hsm::utils::AllocationGuard: heap allocation inside a guarded scope\n", stderr);
+        std::abort();
+    }
+}
+
+}  // namespace
+
+AllocationGuard::AllocationGuard(Policy policy) : mPolicy{policy}, mStart{threadTotals()}
+{
+    if (mPolicy == Policy::eAbort)
+    {
+        ++tAllocationState.forbidding;
+    }
+}
+
+AllocationGuard::~AllocationGuard()
+{
+    if (mPolicy == Policy::eAbort && tAllocationState.forbidding > 0)
+    {
+        --tAllocationState.forbidding;
+    }
+}
+
+AllocationStats AllocationGuard::stats() const
+{
+    const AllocationStats now = threadTotals();
+    return {now.allocations - mStart.allocations, now.bytes - mStart.bytes};
+}
+
+AllocationStats AllocationGuard::threadTotals() { return {tAllocationState.allocations, tAllocationState.bytes}; }
+
+}  // namespace utils
+}  // namespace eta_hsm
+
+// *********************** Replacement allocation functions ******************
+// With glibc, malloc/calloc/realloc are interposed as well so that C-style allocations (and anything else that goes
+// straight to malloc) are caught.  operator new then goes to glibc's own entry points so that it is not counted twice.
+
+#if defined(__GLIBC__)
+extern "C" {
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t count, size_t size);
+void* __libc_realloc(void* ptr, size_t size);
+
+void* malloc(size_t size)
+{
+    eta_hsm::utils::noteAllocation(size);
+    return __libc_malloc(size);
+}
+
+void* calloc(size_t count, size_t size)
+{
+    eta_hsm::utils::noteAllocation(count * size);
+    return __libc_calloc(count, size);
+}
+
+void* realloc(void* ptr, size_t size)
+{
+    eta_hsm::utils::noteAllocation(size);
+    return __libc_realloc(ptr, size);
+}
+}
+
+namespace {
+void* rawAllocate(size_t size)
+{
+    eta_hsm::utils::noteAllocation(size);
+    return __libc_malloc(size == 0 ? 1 : size);
+}
+}  // namespace
+#else
+namespace {
+void* rawAllocate(size_t size)
+{
+    eta_hsm::utils::noteAllocation(size);
+    return std::malloc(size == 0 ? 1 : size);
+}
+}  // namespace
+#endif
+
+namespace {
+void* rawAllocateAligned(size_t size, std::align_val_t alignment)
+{
+    const size_t align = static_cast<size_t>(alignment);
+    eta_hsm::utils::noteAllocation(size);
+    // aligned_alloc requires the size to be a multiple of the alignment
+    return std::aligned_alloc(align, ((size == 0 ? 1 : size) + align - 1) / align * align);
+}
+
+void* throwIfNull(void* ptr)
+{
+    if (ptr == nullptr)
+    {
+        throw std::bad_alloc();
+    }
+    return ptr;
+}
+}  // namespace
+
+void* operator new(size_t size) { return throwIfNull(rawAllocate(size)); }
+void* operator new[](size_t size) { return throwIfNull(rawAllocate(size)); }
+void* operator new(size_t size, const std::nothrow_t&) noexcept { return rawAllocate(size); }
+void* operator new[](size_t size, const std::nothrow_t&) noexcept { return rawAllocate(size); }
+void* operator new(size_t size, std::align_val_t alignment) { return throwIfNull(rawAllocateAligned(size, alignment)); }
+void* operator new[](size_t size, std::align_val_t alignment)
+{
+    return throwIfNull(rawAllocateAligned(size, alignment));
+}
+void* operator new(size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+    return rawAllocateAligned(size, alignment);
+}
+void* operator new[](size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+    return rawAllocateAligned(size, alignment);
+}
+
+// The nothrow forms of operator delete forward to these by default.  The sized forms are defined too, as the compiler
+// calls them directly when it knows the size, and a sized form left to the library would not match our allocation.
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+void operator delete[](void* ptr) noexcept { std::free(ptr); }
+void operator delete(void* ptr, std::align_val_t) noexcept { std::free(ptr); }
+void operator delete[](void* ptr, std::align_val_t) noexcept { std::free(ptr); }
+void operator delete(void* ptr, size_t) noexcept { std::free(ptr); }
+void operator delete[](void* ptr, size_t) noexcept { std::free(ptr); }
+void operator delete(void* ptr, size_t, std::align_val_t) noexcept { std::free(ptr); }
+void operator delete[](void* ptr, size_t, std::align_val_t) noexcept { std::free(ptr); }
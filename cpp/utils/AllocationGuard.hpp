@@ -0,0 +1,74 @@
+// eta/hsm/AllocationGuard.hpp
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace eta_hsm {
+namespace utils {
+
+/// Number of heap allocations (and bytes requested) made by one thread
+struct AllocationStats {
+    uint64_t allocations{0};
+    uint64_t bytes{0};
+};
+
+/// Real-time code is expected not to touch the heap once it has started up, and AllocationGuard is how we check that.
+/// Linking against the eta_hsm_allocation_guard library replaces the global operator new (and, with glibc, malloc,
+/// calloc and realloc) with versions that count allocations per thread.  An AllocationGuard then measures how many
+/// allocations the current thread made while it was in scope:
+///
+///     AllocationGuard guard;
+///     stateMachine.dispatch(evt);
+///     EXPECT_EQ(guard.allocations(), 0);
+///
+/// With Policy::eAbort, the first allocation made in scope prints a message and aborts instead, which is useful for
+/// catching allocations on a real-time thread in debug builds rather than only in unit tests.
+///
+/// Only the current thread is observed, so allocations made concurrently by other threads (e.g. a test framework or
+/// a logger) never show up as false positives.  Guards nest, and each one reports only what happened in its own scope.
+///
+/// Note: the replacement allocator lives in its own library (rather than in eta_hsm_utils) so that nothing else that
+/// links the utilities has its global allocator replaced behind its back.
+class AllocationGuard {
+public:
+    enum class Policy {
+        eCount,  // just count allocations, see allocations() and bytes()
+        eAbort,  // abort the process on the first allocation in scope
+    };
+
+    explicit AllocationGuard(Policy policy = Policy::eCount);
+    ~AllocationGuard();
+
+    AllocationGuard(const AllocationGuard&) = delete;
+    AllocationGuard& operator=(const AllocationGuard&) = delete;
+
+    /// Number of allocations made by this thread since the guard was created
+    uint64_t allocations() const { return stats().allocations; }
+
+    /// Total number of bytes requested by those allocations
+    uint64_t bytes() const { return stats().bytes; }
+
+    AllocationStats stats() const;
+
+    /// Running totals for the calling thread since it started
+    static AllocationStats threadTotals();
+
+protected:
+private:
+    const Policy mPolicy;
+    const AllocationStats mStart;
+};
+
+/// Convenience wrapper that runs `fn` and returns the allocations it made on the calling thread
+template <typename Fn>
+AllocationStats countAllocations(Fn&& fn)
+{
+    AllocationGuard guard;
+    fn();
+    return guard.stats();
+}
+
+}  // namespace utils
+}  // namespace eta_hsm
@@ -0,0 +1,110 @@
+// eta/hsm/ConcurrentHashSet.hpp
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace eta_hsm {
+namespace utils {
+
+/// A fixed-capacity set of non-zero 64-bit keys that any number of threads can insert into at once without locks:
+/// open addressing with linear probing, where claiming an empty slot is a single compare-and-swap.  Keys can never be
+/// removed, and the set never grows; once it is full, insert() returns false and overflowed() becomes true.
+class ConcurrentHashSet {
+public:
+    /// Room for at least `capacity` keys (rounded up to a power of two, with headroom to keep probe sequences short)
+    explicit ConcurrentHashSet(size_t capacity)
+        : mMask{slotCount(capacity) - 1}, mSlots{new std::atomic<uint64_t>[mMask + 1]()}
+    {}
+
+    ConcurrentHashSet(const ConcurrentHashSet&) = delete;
+    ConcurrentHashSet& operator=(const ConcurrentHashSet&) = delete;
+
+    /// Add `key` (which must not be zero).  Returns true if it was not already in the set.
+    bool insert(uint64_t key)
+    {
+        for (size_t probe = 0, idx = mix(key) & mMask; probe <= mMask; ++probe, idx = (idx + 1) & mMask)
+        {
+            uint64_t seen = mSlots[idx].load(std::memory_order_relaxed);
+            if (seen == 0 && mSlots[idx].compare_exchange_strong(seen, key, std::memory_order_relaxed))
+            {
+                mSize.fetch_add(1, std::memory_order_relaxed);
+                return true;
+            }
+            if (seen == key)
+            {
+                return false;
+            }
+        }
+        mOverflowed.store(true, std::memory_order_relaxed);
+        return false;
+    }
+
+    bool contains(uint64_t key) const
+    {
+        for (size_t probe = 0, idx = mix(key) & mMask; probe <= mMask; ++probe, idx = (idx + 1) & mMask)
+        {
+            const uint64_t seen = mSlots[idx].load(std::memory_order_relaxed);
+            if (seen == key)
+            {
+                return true;
+            }
+            if (seen == 0)
+            {
+                return false;
+            }
+        }
+        return false;
+    }
+
+    size_t size() const { return mSize.load(std::memory_order_relaxed); }
+
+    /// Did an insert() fail because the set was full?
+    bool overflowed() const { return mOverflowed.load(std::memory_order_relaxed); }
+
+    /// Visit every key, in no particular order.  Only sees all of them once the inserting threads are done.
+    template <typename Visitor>
+    void forEach(Visitor&& visit) const
+    {
+        for (size_t idx = 0; idx <= mMask; ++idx)
+        {
+            if (const uint64_t key = mSlots[idx].load(std::memory_order_relaxed))
+            {
+                visit(key);
+            }
+        }
+    }
+
+protected:
+private:
+    static size_t slotCount(size_t capacity)
+    {
+        size_t slots = 16;
+        while (slots < 2 * capacity)
+        {
+            slots *= 2;
+        }
+        return slots;
+    }
+
+    /// Keys are often small packed integers, so spread them out before picking a slot (splitmix64 finalizer)
+    static uint64_t mix(uint64_t key)
+    {
+        key ^= key >> 30;
+        key *= 0xbf58476d1ce4e5b9ULL;
+        key ^= key >> 27;
+        key *= 0x94d049bb133111ebULL;
+        return key ^ (key >> 31);
+    }
+
+    size_t mMask;
+    std::unique_ptr<std::atomic<uint64_t>[]> mSlots;
+    std::atomic<size_t> mSize{0};
+    std::atomic<bool> mOverflowed{false};
+};
+
+}  // namespace utils
+}  // namespace eta_hsm
@@ -2,10 +2,15 @@
 
 #pragma once
 
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
 #include <deque>
 #include <functional>
 #include <queue>
 #include <type_traits>
+#include <utility>
 #include <vector>
 
 namespace eta_hsm {
@@ -29,7 +34,7 @@ template <typename Event>
 class OrderedEventBucket : public EventBucket<Event> {
 public:
     /// Implement the addEvent interface declared in EventBucket
-    void addEvent(Event evt) override { mStorage.push_back(evt); }
+    void addEvent(Event evt) override { mStorage.push_back(std::move(evt)); }
 
     /// Empty the bucket
     void clear() { mStorage.clear(); }
@@ -45,7 +50,7 @@ public:
     {
         if (!empty())
         {
-            Event evt = mStorage.front();  // make a local copy
+            Event evt = std::move(mStorage.front());  // move out (events may carry a payload)
             mStorage.pop_front();
             return evt;
         }
@@ -129,5 +134,179 @@ private:
     std::priority_queue<Event, std::vector<Event>, std::greater<Event>> mStorage{};
 };
 
+/// The queued events of a StaticEventBucket, oldest first, as plain data (see StaticEventBucket::snapshot).  It is
+/// the same size however full the bucket is, so arrays of them can be copied around wholesale.
+template <typename Event, size_t kCapacity>
+struct EventBucketSnapshot {
+    std::array<Event, kCapacity> events{};
+    uint32_t size{0};
+};
+
+/// A fixed-capacity version of OrderedEventBucket that stores events in a ring buffer inside the bucket itself, so
+/// that adding and removing events never touches the heap (OrderedEventBucket's std::deque allocates and frees blocks
+/// as events flow through it).  When the bucket is full, new events are dropped and counted in overflows() rather
+/// than growing the storage, so size kCapacity for the worst-case burst between two drains.
+template <typename Event, size_t kCapacity>
+class StaticEventBucket : public EventBucket<Event> {
+public:
+    static_assert(kCapacity > 0, "StaticEventBucket needs room for at least one event");
+
+    /// Implement the addEvent interface declared in EventBucket
+    void addEvent(Event evt) override
+    {
+        if (mSize == kCapacity)
+        {
+            ++mOverflows;
+            return;
+        }
+        mStorage[(mHead + mSize) % kCapacity] = std::move(evt);
+        ++mSize;
+    }
+
+    /// Empty the bucket
+    void clear()
+    {
+        while (!empty())
+        {
+            pop_front();
+        }
+        mHead = 0;
+    }
+
+    /// Is the bucket empty?
+    bool empty() const { return mSize == 0; }
+
+    /// How many events are in the bucket?
+    size_t size() const { return mSize; }
+
+    /// How many events can the bucket hold?
+    static constexpr size_t capacity() { return kCapacity; }
+
+    /// How many events have been dropped because the bucket was full?
+    uint64_t overflows() const { return mOverflows; }
+
+    /// Simplified accessor that removes an event from the bucket and returns it
+    Event getEvent()
+    {
+        if (!empty())
+        {
+            Event evt = std::move(mStorage[mHead]);
+            pop_front();
+            return evt;
+        }
+        else
+        {
+            return Event::eNone;  // assuming there is an eNone element
+        }
+    }
+
+    /// Direct access to the oldest event (the bucket must not be empty)
+    const Event& front() const { return mStorage[mHead]; }
+
+    using Snapshot = EventBucketSnapshot<Event, kCapacity>;
+
+    /// Copy out the queued events, e.g. to checkpoint a machine for failover.  Only plain (enum-like) events can be
+    /// copied this way:  events carrying payloads own resources that a byte copy cannot carry over.
+    Snapshot snapshot() const
+    {
+        static_assert(std::is_trivially_copyable_v<Event>, "only trivially copyable events can be snapshot");
+        Snapshot snap{};
+        for (size_t i = 0; i < mSize; ++i)
+        {
+            snap.events[i] = mStorage[(mHead + i) % kCapacity];
+        }
+        snap.size = static_cast<uint32_t>(mSize);
+        return snap;
+    }
+
+    /// Replace the contents of the bucket with the events in `snap` (the overflow count is left alone)
+    void restore(const Snapshot& snap)
+    {
+        clear();
+        for (size_t i = 0; i < snap.size && i < kCapacity; ++i)
+        {
+            addEvent(snap.events[i]);
+        }
+    }
+
+    /// Remove the oldest event (the bucket must not be empty)
+    void pop_front()
+    {
+        // Release whatever the event holds (e.g. a PayloadEvent's payload) now rather than when the slot is reused
+        if constexpr (!std::is_trivially_destructible_v<Event>)
+        {
+            mStorage[mHead] = Event{};
+        }
+        mHead = (mHead + 1) % kCapacity;
+        --mSize;
+    }
+
+protected:
+private:
+    std::array<Event, kCapacity> mStorage{};
+    size_t mHead{0};
+    size_t mSize{0};
+    uint64_t mOverflows{0};
+};
+
+/// An event along with the time at which it was placed into a bucket
+template <typename Event, typename Clock>
+struct TimestampedEvent {
+    Event event;
+    std::chrono::time_point<Clock> enqueued;
+};
+
+/// A variation on StaticEventBucket that also remembers when each event was added, so that the time an event spends
+/// waiting in the bucket before being dispatched can be measured (see LatencyRecorder).  Like StaticEventBucket, it
+/// holds up to kCapacity events in a fixed ring, so recording never allocates, and drops (and counts) events added
+/// while it is full.
+/// Like TimeTracker, this holds a reference to the clock instead of interacting with any clock type directly.
+template <typename Event, typename Clock, size_t kCapacity>
+class TimestampedEventBucket : public EventBucket<Event> {
+public:
+    TimestampedEventBucket(const Clock& clock) : mClock{clock} {}
+
+    /// Implement the addEvent interface declared in EventBucket
+    void addEvent(Event evt) override { mStorage.addEvent({std::move(evt), mClock.now()}); }
+
+    /// Empty the bucket
+    void clear() { mStorage.clear(); }
+
+    /// Is the bucket empty?
+    bool empty() const { return mStorage.empty(); }
+
+    /// How many events are in the bucket?
+    size_t size() const { return mStorage.size(); }
+
+    /// How many events can the bucket hold?
+    static constexpr size_t capacity() { return kCapacity; }
+
+    /// How many events have been dropped because the bucket was full?
+    uint64_t overflows() const { return mStorage.overflows(); }
+
+    /// Simplified accessor that removes an event from the bucket and returns it
+    Event getEvent() { return getTimestampedEvent().event; }
+
+    /// Remove an event from the bucket and return it along with the time that it was added
+    TimestampedEvent<Event, Clock> getTimestampedEvent()
+    {
+        if (!empty())
+        {
+            TimestampedEvent<Event, Clock> stamped = mStorage.front();  // make a local copy
+            mStorage.pop_front();
+            return stamped;
+        }
+        else
+        {
+            return {Event::eNone, {}};  // assuming there is an eNone element
+        }
+    }
+
+protected:
+private:
+    const Clock& mClock;
+    StaticEventBucket<TimestampedEvent<Event, Clock>, kCapacity> mStorage{};
+};
+
 }  // namespace utils
 }  // namespace eta_hsm
@@ -0,0 +1,275 @@
+// eta/hsm/EventBus.hpp
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+
+#include "EventBucket.hpp"
+
+namespace eta_hsm {
+namespace utils {
+
+/// Broadcasts events to any number of machines without copying them to each one:  a publisher adds an event once, to
+/// a ring shared by every subscriber, and each Subscriber is a cursor into that ring that reads the events it has
+/// subscribed to when its machine asks for them.  Publishing costs the same however many subscribers there are.
+///
+///     EventBus<ChildEvent, 256> bus;                       // owned by the supervisor, which publishes into it
+///     EventBus<ChildEvent, 256>::Subscriber inbox{bus};    // one per child, which drains it like any other bucket
+///     inbox.subscribe(ChildEvent::eShutdown);
+///     ...
+///     bus.publish(ChildEvent::eShutdown);                  // every subscribed inbox sees it
+///     child.drain(inbox, budget);
+///
+/// The ring never waits for slow subscribers:  one that falls more than kCapacity events behind loses the oldest and
+/// counts them in lost().  Every subscriber's lag (how far behind the publisher it is) can be read from any thread, so
+/// whoever supervises the machines can see which ones are not keeping up (see forEachSubscriber()).
+///
+/// Events are published by one thread at a time.  Each subscriber is read by one thread at a time, which may be the
+/// publisher's (a local subscriber, typically polled every tick) or any other (a cross-thread subscriber, which can ask
+/// to be told when there is something for it, see Subscriber::setNotify()).  Events must be trivially copyable (e.g.
+/// plain enums, not PayloadEvents), only events numbered below 64 can be subscribed to, and subscribers must be
+/// created and destroyed while nothing is being published.
+template <typename Event, size_t kCapacity>
+class EventBus : public EventBucket<Event> {
+public:
+    static_assert(kCapacity > 0 && (kCapacity & (kCapacity - 1)) == 0, "EventBus capacity must be a power of two");
+    static_assert(std::is_trivially_copyable_v<Event>, "subscribers read events out of the ring as it is overwritten");
+
+    using Notify = void (*)(void* context);
+
+    class Subscriber;
+
+    EventBus() = default;
+    EventBus(const EventBus&) = delete;
+    EventBus& operator=(const EventBus&) = delete;
+
+    /// Implement the addEvent interface declared in EventBucket, so a bus can stand in for a bucket
+    void addEvent(Event evt) override { publish(evt); }
+
+    /// Add `evt` to the ring, for every subscriber to read, and notify the subscribers that asked to be notified of it
+    void publish(Event evt)
+    {
+        // A seqlock per slot:  odd while the event is being written, 2 * (position + 1) once it is there
+        const uint64_t position = mPublished.load(std::memory_order_relaxed);
+        Slot& slot = mSlots[position & (kCapacity - 1)];
+        slot.sequence.store(2 * position + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        slot.event.store(evt, std::memory_order_relaxed);
+        slot.sequence.store(2 * position + 2, std::memory_order_release);
+        mPublished.store(position + 1, std::memory_order_release);
+
+        for (const Subscriber* subscriber : mNotified)
+        {
+            if (subscriber->wants(evt))
+            {
+                subscriber->mNotify(subscriber->mNotifyContext);
+            }
+        }
+    }
+
+    /// How many events have been published, ever
+    uint64_t published() const { return mPublished.load(std::memory_order_acquire); }
+
+    /// How many events the ring holds, and so how far behind a subscriber can fall before it loses events
+    static constexpr size_t capacity() { return kCapacity; }
+
+    /// Visit every subscriber (as a const Subscriber&), e.g. to report their lag()
+    template <typename Visitor>
+    void forEachSubscriber(Visitor&& visit) const
+    {
+        for (const Subscriber* subscriber : mSubscribers)
+        {
+            visit(*subscriber);
+        }
+    }
+
+protected:
+private:
+    struct Slot {
+        std::atomic<uint64_t> sequence{0};
+        std::atomic<Event> event{};
+    };
+
+    static void remove(std::vector<const Subscriber*>& subscribers, const Subscriber* subscriber)
+    {
+        subscribers.erase(std::remove(subscribers.begin(), subscribers.end(), subscriber), subscribers.end());
+    }
+
+    /// The publisher has a cache line of its own, apart from the slots subscribers poll
+    alignas(64) std::atomic<uint64_t> mPublished{0};
+    alignas(64) std::array<Slot, kCapacity> mSlots{};
+    std::vector<const Subscriber*> mSubscribers{};
+    std::vector<const Subscriber*> mNotified{};
+};
+
+/// One machine's view of an EventBus:  the events published since it was created, of the types it has subscribed to,
+/// in the order they were published.  It is drained like any other bucket (empty(), size() and getEvent()), and reads
+/// each event out of the bus as it is taken, so it holds nothing but its cursor.
+template <typename Event, size_t kCapacity>
+class EventBus<Event, kCapacity>::Subscriber {
+public:
+    /// Subscribed to nothing yet, and starting from the next event published
+    explicit Subscriber(EventBus& bus) : mBus{bus}, mCursor{bus.published()} { mBus.mSubscribers.push_back(this); }
+
+    Subscriber(const Subscriber&) = delete;
+    Subscriber& operator=(const Subscriber&) = delete;
+
+    ~Subscriber()
+    {
+        remove(mBus.mSubscribers, this);
+        remove(mBus.mNotified, this);
+    }
+
+    /// Take events of type `evt` from now on.  Returns false, subscribing to nothing, if `evt` is numbered 64 or above.
+    bool subscribe(Event evt)
+    {
+        const uint64_t mask = bit(evt);
+        mMask.fetch_or(mask, std::memory_order_relaxed);
+        return mask != 0;
+    }
+
+    /// Skip events of type `evt` from now on (including any already published but not yet taken)
+    void unsubscribe(Event evt) { mMask.fetch_and(~bit(evt), std::memory_order_relaxed); }
+
+    /// Take every event that can be subscribed to
+    void subscribeAll() { mMask.store(~uint64_t{0}, std::memory_order_relaxed); }
+
+    /// Is there an event to take?  (Skips any that are not subscribed to.)
+    bool empty() { return !peek(); }
+
+    /// How many subscribed events are waiting to be taken (leaving out any overwritten before they could be counted).
+    /// Looks at every event this subscriber is behind by.
+    size_t size()
+    {
+        if (!peek())
+        {
+            return 0;
+        }
+        const uint64_t published = mBus.mPublished.load(std::memory_order_acquire);
+        size_t count = 0;
+        Event evt{};
+        for (uint64_t position = mCursor.load(std::memory_order_relaxed); position < published; ++position)
+        {
+            count += read(position, evt) && wants(evt) ? 1 : 0;
+        }
+        return count;
+    }
+
+    /// Simplified accessor that takes the next subscribed event, or returns eNone if there is none
+    Event getEvent()
+    {
+        if (!peek())
+        {
+            return Event::eNone;  // assuming there is an eNone element
+        }
+        mCursor.store(mCursor.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        return mNext;
+    }
+
+    /// How many events (of any type) have been published that this subscriber has not yet taken or skipped.  Can be
+    /// read from any thread.
+    uint64_t lag() const
+    {
+        const uint64_t published = mBus.mPublished.load(std::memory_order_acquire);
+        return published - std::min(published, mCursor.load(std::memory_order_relaxed));
+    }
+
+    /// How many events were overwritten before this subscriber got to them.  Can be read from any thread.
+    uint64_t lost() const { return mLost.load(std::memory_order_relaxed); }
+
+    /// Call `notify(context)` after every subscribed event that is published (from the publisher's thread), e.g. to
+    /// wake the thread that reads this subscriber.  Set it while nothing is being published.
+    void setNotify(Notify notify, void* context)
+    {
+        mNotify = notify;
+        mNotifyContext = context;
+        remove(mBus.mNotified, this);
+        if (mNotify)
+        {
+            mBus.mNotified.push_back(this);
+        }
+    }
+
+protected:
+private:
+    friend class EventBus;
+
+    /// The bit for `evt` in the subscription mask, or none for events that are numbered too high to have one
+    static uint64_t bit(Event evt)
+    {
+        const auto index = static_cast<uint64_t>(evt);
+        return index < 64 ? uint64_t{1} << index : 0;
+    }
+
+    bool wants(Event evt) const { return (mMask.load(std::memory_order_relaxed) & bit(evt)) != 0; }
+
+    /// Move the cursor past events that are not subscribed to or that have been overwritten, up to the next one to
+    /// take, which is copied into mNext.  Returns false if there is none.
+    bool peek()
+    {
+        uint64_t cursor = mCursor.load(std::memory_order_relaxed);
+        uint64_t lost = 0;
+        bool found = false;
+        while (true)
+        {
+            const uint64_t published = mBus.mPublished.load(std::memory_order_acquire);
+            if (cursor >= published)
+            {
+                break;
+            }
+            if (published - cursor > kCapacity)
+            {
+                lost += published - kCapacity - cursor;
+                cursor = published - kCapacity;
+            }
+            Event evt{};
+            if (!read(cursor, evt))
+            {
+                ++lost;
+                ++cursor;
+                continue;
+            }
+            if (wants(evt))
+            {
+                mNext = evt;
+                found = true;
+                break;
+            }
+            ++cursor;
+        }
+        mCursor.store(cursor, std::memory_order_relaxed);
+        if (lost > 0)
+        {
+            mLost.fetch_add(lost, std::memory_order_relaxed);
+        }
+        return found;
+    }
+
+    /// Copy the event published at `position` into `evt`.  Returns false if it has been (or is being) overwritten by
+    /// an event a lap later.
+    bool read(uint64_t position, Event& evt) const
+    {
+        const Slot& slot = mBus.mSlots[position & (kCapacity - 1)];
+        const uint64_t before = slot.sequence.load(std::memory_order_acquire);
+        evt = slot.event.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return before == 2 * position + 2 && slot.sequence.load(std::memory_order_relaxed) == before;
+    }
+
+    EventBus& mBus;
+    std::atomic<uint64_t> mCursor;
+    std::atomic<uint64_t> mMask{0};
+    std::atomic<uint64_t> mLost{0};
+    Event mNext{};
+    Notify mNotify{nullptr};
+    void* mNotifyContext{nullptr};
+};
+
+}  // namespace utils
+}  // namespace eta_hsm
@@ -0,0 +1,193 @@
+// eta/hsm/EventLog.cpp
+
+#include "EventLog.hpp"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <system_error>
+
+namespace eta_hsm {
+namespace utils {
+
+namespace {
+
+[[noreturn]] void throwErrno(const std::string& what)
+{
+    throw std::system_error(errno, std::generic_category(), what);
+}
+
+uint64_t completeRecords(int fd)
+{
+    struct stat info{};
+    if (::fstat(fd, &info) != 0)
+    {
+        throwErrno("fstat");
+    }
+    return static_cast<uint64_t>(info.st_size) / sizeof(EventLogRecord);
+}
+
+}  // namespace
+
+EventLog::EventLog(const std::string& path, std::chrono::milliseconds commitPeriod)
+    : mCommitPeriod{commitPeriod},
+      mRecordStorage{std::make_unique<std::array<EventLogRecord, kCapacity>>()},
+      mRecords{*mRecordStorage}
+{
+    mFd = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+    if (mFd < 0)
+    {
+        throwErrno("open " + path);
+    }
+    // Drop any torn record at the end, and carry on appending after the complete ones
+    mBase = completeRecords(mFd);
+    if (::ftruncate(mFd, static_cast<off_t>(mBase * sizeof(EventLogRecord))) != 0 ||
+        ::lseek(mFd, 0, SEEK_END) < 0)
+    {
+        const int error = errno;
+        ::close(mFd);
+        errno = error;
+        throwErrno("open " + path);
+    }
+    mCommitted.store(mBase, std::memory_order_release);
+    mWriter = std::thread([this]() { run(); });
+}
+
+EventLog::~EventLog()
+{
+    {
+        std::lock_guard<std::mutex> lock(mWakeMutex);
+        mStopping = true;
+    }
+    mWake.notify_one();
+    mWriter.join();
+    ::close(mFd);
+}
+
+void EventLog::commit()
+{
+    const uint64_t target = sequence();
+    std::unique_lock<std::mutex> lock(mWakeMutex);
+    if (target > mCommitRequested)
+    {
+        mCommitRequested = target;
+    }
+    mWake.notify_one();
+    mCommittedWake.wait(lock, [&]() { return committed() >= target || error() != 0; });
+    if (committed() < target)
+    {
+        throwIfFailed();
+    }
+}
+
+void EventLog::throwIfFailed() const
+{
+    if (error() != 0)
+    {
+        throw std::system_error(error(), std::generic_category(), "event log writer");
+    }
+}
+
+void EventLog::run()
+{
+    std::unique_lock<std::mutex> lock(mWakeMutex);
+    while (!mStopping)
+    {
+        mWake.wait_for(lock, mCommitPeriod, [&]() { return mStopping || mCommitRequested > committed(); });
+        lock.unlock();
+        writeAvailable();
+        lock.lock();
+        mCommittedWake.notify_all();
+    }
+    lock.unlock();
+    writeAvailable();
+}
+
+bool EventLog::writeAvailable()
+{
+    if (error() != 0)
+    {
+        return false;
+    }
+    const uint64_t tail = mTail.load(std::memory_order_relaxed);
+    const uint64_t head = mHead.load(std::memory_order_acquire);
+    if (head == tail)
+    {
+        return false;
+    }
+
+    // The records in the ring are at most two contiguous runs, which go out in a single write
+    const size_t first = tail & (kCapacity - 1);
+    const size_t count = head - tail;
+    const size_t firstCount = count < kCapacity - first ? count : kCapacity - first;
+    iovec runs[2] = {{&mRecords[first], firstCount * sizeof(EventLogRecord)},
+                     {&mRecords[0], (count - firstCount) * sizeof(EventLogRecord)}};
+    int runCount = count > firstCount ? 2 : 1;
+    iovec* next = runs;
+    while (runCount > 0)
+    {
+        const ssize_t written = ::writev(mFd, next, runCount);
+        if (written < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            mError.store(errno, std::memory_order_release);
+            return false;
+        }
+        // Short writes are rare, but possible
+        size_t remaining = static_cast<size_t>(written);
+        while (runCount > 0 && remaining >= next->iov_len)
+        {
+            remaining -= next->iov_len;
+            ++next;
+            --runCount;
+        }
+        if (runCount > 0)
+        {
+            next->iov_base = static_cast<char*>(next->iov_base) + remaining;
+            next->iov_len -= remaining;
+        }
+    }
+    if (::fdatasync(mFd) != 0)
+    {
+        mError.store(errno, std::memory_order_release);
+        return false;
+    }
+
+    mTail.store(head, std::memory_order_release);
+    mCommitted.store(mBase + head, std::memory_order_release);
+    return true;
+}
+
+EventLogReader::EventLogReader(const std::string& path)
+{
+    mFd = ::open(path.c_str(), O_RDONLY);
+    if (mFd < 0)
+    {
+        throwErrno("open " + path);
+    }
+}
+
+EventLogReader::~EventLogReader() { ::close(mFd); }
+
+uint64_t EventLogReader::size() const { return completeRecords(mFd); }
+
+size_t EventLogReader::read(uint64_t from, EventLogRecord* records, size_t max) const
+{
+    const ssize_t bytes = ::pread(mFd, records, max * sizeof(EventLogRecord),
+                                  static_cast<off_t>(from * sizeof(EventLogRecord)));
+    if (bytes < 0)
+    {
+        throwErrno("read event log");
+    }
+    // A record still being written (or torn by a crash) is not handed out
+    return static_cast<size_t>(bytes) / sizeof(EventLogRecord);
+}
+
+}  // namespace utils
+}  // namespace eta_hsm
@@ -0,0 +1,320 @@
+// eta/hsm/EventLog.hpp
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "EventBucket.hpp"
+#include "FakeClock.hpp"
+
+namespace eta_hsm {
+namespace utils {
+
+/// One dispatched event, as it is stored in an EventLog file.  Records are written back to back with no framing, so
+/// the n-th record of a log (its sequence number) is at byte offset n * sizeof(EventLogRecord).
+struct EventLogRecord {
+    uint64_t timestampNs;  // the machine's clock when the event was dispatched
+    uint32_t machineId;
+    uint32_t event;  // the event enum's value
+};
+static_assert(sizeof(EventLogRecord) == 16, "EventLogRecord is a wire format");
+
+/// An append-only log of the events dispatched to a fleet of machines, for rebuilding the machines after a crash:
+/// restore the latest snapshot of each machine (see StateMachine::snapshot) and replay the events logged after it
+/// (see EventLogReader).
+///
+/// append() only copies the record into a ring; a background writer commits whatever has accumulated as one write
+/// followed by one fdatasync (group commit), every commitPeriod or whenever commit() asks for it.  Records are
+/// appended by a single thread (the control thread).  If the writer falls so far behind that the ring fills up,
+/// append() waits for room rather than dropping records (see stalls()).
+class EventLog {
+public:
+    static constexpr size_t kCapacity = 1 << 16;
+
+    /// Open (or create) the log at `path`, continuing after any records already in it.  A record left half-written by
+    /// a crash is discarded.  Failures to open the file are reported by throwing std::system_error.
+    explicit EventLog(const std::string& path, std::chrono::milliseconds commitPeriod = std::chrono::milliseconds(5));
+
+    /// Commits everything appended so far and stops the writer
+    ~EventLog();
+
+    EventLog(const EventLog&) = delete;
+    EventLog& operator=(const EventLog&) = delete;
+
+    /// Append a record, returning its sequence number
+    uint64_t append(uint32_t machineId, uint64_t timestampNs, uint32_t event)
+    {
+        const uint64_t head = mHead.load(std::memory_order_relaxed);
+        while (head - mTail.load(std::memory_order_acquire) >= kCapacity)
+        {
+            throwIfFailed();
+            mStalls.fetch_add(1, std::memory_order_relaxed);
+            mWake.notify_one();
+            std::this_thread::yield();
+        }
+        mRecords[head & (kCapacity - 1)] = {timestampNs, machineId, event};
+        mHead.store(head + 1, std::memory_order_release);
+        return mBase + head;
+    }
+
+    /// Sequence number of the next record to be appended (i.e. the number of records in the log, committed or not).
+    /// A snapshot taken between two appends covers exactly the records before this number.
+    uint64_t sequence() const { return mBase + mHead.load(std::memory_order_relaxed); }
+
+    /// Number of records known to be on disk
+    uint64_t committed() const { return mCommitted.load(std::memory_order_acquire); }
+
+    /// Block until every record appended so far is on disk.  If the writer failed to write or sync the file, this
+    /// (and any append() that then has to wait for room) throws std::system_error.
+    void commit();
+
+    /// The errno of the writer's first failure, 0 if none
+    int error() const { return mError.load(std::memory_order_acquire); }
+
+    /// Number of times append() had to wait for the writer
+    uint64_t stalls() const { return mStalls.load(std::memory_order_relaxed); }
+
+protected:
+private:
+    void run();
+    bool writeAvailable();
+    void throwIfFailed() const;
+
+    int mFd{-1};
+    uint64_t mBase{0};  // records that were already in the file when it was opened
+    const std::chrono::milliseconds mCommitPeriod;
+
+    std::unique_ptr<std::array<EventLogRecord, kCapacity>> mRecordStorage;
+    std::array<EventLogRecord, kCapacity>& mRecords;
+    std::atomic<uint64_t> mHead{0};
+    std::atomic<uint64_t> mTail{0};
+    std::atomic<uint64_t> mCommitted{0};
+    std::atomic<uint64_t> mStalls{0};
+    std::atomic<int> mError{0};
+
+    std::mutex mWakeMutex{};
+    std::condition_variable mWake{};
+    std::condition_variable mCommittedWake{};
+    uint64_t mCommitRequested{0};
+    bool mStopping{false};
+    std::thread mWriter{};
+};
+
+/// Reads back an EventLog file (which may still be being appended to), a chunk of records at a time
+class EventLogReader {
+public:
+    explicit EventLogReader(const std::string& path);
+    ~EventLogReader();
+
+    EventLogReader(const EventLogReader&) = delete;
+    EventLogReader& operator=(const EventLogReader&) = delete;
+
+    /// Number of complete records in the file
+    uint64_t size() const;
+
+    /// Hand every record from sequence number `from` to the end of the file to `visit(sequence, record)`, in order.
+    /// Returns the number of records visited.
+    template <typename Visitor>
+    uint64_t replay(uint64_t from, Visitor&& visit) const
+    {
+        std::array<EventLogRecord, kChunk> chunk;
+        uint64_t sequence = from;
+        for (size_t count = read(sequence, chunk.data(), kChunk); count > 0;
+             count = read(sequence, chunk.data(), kChunk))
+        {
+            for (size_t idx = 0; idx < count; ++idx)
+            {
+                visit(sequence + idx, chunk[idx]);
+            }
+            sequence += count;
+        }
+        return sequence - from;
+    }
+
+protected:
+private:
+    static constexpr size_t kChunk = 4096;
+
+    /// Read up to `max` records starting at sequence number `from`, returning how many were read
+    size_t read(uint64_t from, EventLogRecord* records, size_t max) const;
+
+    int mFd{-1};
+};
+
+/// Front end for logging the events of a single machine.  Route dispatch() through it (including the events that the
+/// machine's timers fire) and every event is logged with the machine's id and the time on its clock.
+///
+/// To replay a machine, restore its snapshot and then, for each of its records logged after the snapshot, set a
+/// FakeClock to the record's timestamp, let the machine's timers catch up to it (the events they fire are in the log
+/// already, so they are not dispatched again), and dispatch the record's event.  Entry actions then arm their timers
+/// at exactly the times they originally did.  recover() does all of this for a whole fleet.
+template <typename Clock>
+class EventJournal {
+public:
+    EventJournal(EventLog& log, uint32_t machineId, const Clock& clock)
+        : mLog{log}, mMachineId{machineId}, mClock{clock}
+    {}
+
+    template <typename SM>
+    void dispatch(SM& stateMachine, typename SM::Event evt)
+    {
+        static_assert(std::is_enum_v<typename SM::Event>, "only enum events can be logged");
+        const auto timestamp = std::chrono::duration_cast<std::chrono::nanoseconds>(mClock.now().time_since_epoch());
+        mLog.append(mMachineId, static_cast<uint64_t>(timestamp.count()), static_cast<uint32_t>(evt));
+        stateMachine.dispatch(evt);
+    }
+
+    uint32_t machineId() const { return mMachineId; }
+
+protected:
+private:
+    EventLog& mLog;
+    const uint32_t mMachineId;
+    const Clock& mClock;
+};
+
+/// The latest snapshot of each machine of a fleet, each one tagged with the log's sequence number and the machine's
+/// clock at the time it was taken, so that recover() knows where to pick up.
+///
+/// What is stored is whatever SM::snapshot() returns, and recover() hands it back to SM::restore() (returning whether
+/// it took).  A host that keeps more than its StateMachine (e.g. its timers) hides StateMachine::snapshot()/restore()
+/// with versions that add the rest.  The policy is a new round of snapshots every `period` records of the log (see
+/// due()); machines that have never been snapshotted are replayed from the start of the log.
+template <typename SM>
+class SnapshotStore {
+public:
+    using MachineSnapshot = std::decay_t<decltype(std::declval<const SM&>().snapshot())>;
+
+    struct Entry {
+        MachineSnapshot machine{};
+        uint64_t sequence{0};     // the first record of the log that the snapshot does not cover
+        uint64_t timestampNs{0};  // the machine's clock when the snapshot was taken
+        bool taken{false};
+    };
+
+    SnapshotStore(size_t machines, uint64_t period) : mEntries(machines), mPeriod{period} {}
+
+    /// Has the log grown by `period` records since snapshots were last taken?
+    bool due(const EventLog& log) const { return log.sequence() - mLastSequence >= mPeriod; }
+
+    /// Snapshot machine `id` as of the log's current sequence number, i.e. between two appends
+    template <typename Clock>
+    void take(uint32_t id, const SM& machine, const EventLog& log, const Clock& clock)
+    {
+        const auto timestamp = std::chrono::duration_cast<std::chrono::nanoseconds>(clock.now().time_since_epoch());
+        mEntries[id] = {machine.snapshot(), log.sequence(), static_cast<uint64_t>(timestamp.count()), true};
+        mLastSequence = log.sequence();
+    }
+
+    const Entry& latest(uint32_t id) const { return mEntries[id]; }
+
+    /// Number of machines in the fleet
+    size_t size() const { return mEntries.size(); }
+
+protected:
+private:
+    std::vector<Entry> mEntries;
+    const uint64_t mPeriod;
+    uint64_t mLastSequence{0};
+};
+
+namespace detail {
+
+/// Machines with an eventScheduler() (their timer bank) have their timers caught up as they are replayed
+template <typename SM, typename = void>
+struct ReplaysTimers : std::false_type {};
+template <typename SM>
+struct ReplaysTimers<SM, std::void_t<decltype(std::declval<SM&>().eventScheduler())>> : std::true_type {};
+
+/// Where replayed timers fire into:  their events are in the log already
+template <typename Event>
+class DiscardingEventBucket : public EventBucket<Event> {
+public:
+    void addEvent(Event) override {}
+};
+
+}  // namespace detail
+
+/// Rebuild a fleet after a crash from the snapshots in `store` and the tail of the log at `path`.  `make(id)` creates
+/// machine `id` (as a std::unique_ptr to it) running on `clock`.  Each machine that has a snapshot is restored from it
+/// once the replay reaches the snapshot's sequence number, with the clock set to when it was taken; after that, each of
+/// the machine's records is replayed as EventJournal describes:  the clock is set to the record's timestamp, the
+/// machine's timers (if it has an eventScheduler()) catch up to it without dispatching what they fire, and the
+/// record's event is dispatched.
+///
+/// A snapshot that its machine fails to restore is reported by throwing std::runtime_error.
+template <typename SM, typename MakeMachine>
+std::vector<std::unique_ptr<SM>> recover(const std::string& path, const SnapshotStore<SM>& store, FakeClock& clock,
+                                         MakeMachine&& make)
+{
+    std::vector<std::unique_ptr<SM>> fleet;
+    std::vector<uint32_t> snapshotted;
+    uint64_t from = std::numeric_limits<uint64_t>::max();
+    for (uint32_t id = 0; id < store.size(); ++id)
+    {
+        fleet.push_back(make(id));
+        if (store.latest(id).taken)
+        {
+            snapshotted.push_back(id);
+        }
+        from = std::min(from, store.latest(id).sequence);
+    }
+    std::sort(snapshotted.begin(), snapshotted.end(),
+              [&store](uint32_t lhs, uint32_t rhs) { return store.latest(lhs).sequence < store.latest(rhs).sequence; });
+
+    auto advanceTo = [&clock](uint64_t timestampNs) {
+        const FakeClock::time_point time{std::chrono::nanoseconds(timestampNs)};
+        if (time > clock.now())
+        {
+            clock.advance(time - clock.now());
+        }
+    };
+    size_t restored = 0;
+    auto restoreUpTo = [&](uint64_t sequence) {
+        for (; restored < snapshotted.size() && store.latest(snapshotted[restored]).sequence <= sequence; ++restored)
+        {
+            const uint32_t id = snapshotted[restored];
+            advanceTo(store.latest(id).timestampNs);
+            if (!fleet[id]->restore(store.latest(id).machine))
+            {
+                throw std::runtime_error("snapshot of machine " + std::to_string(id) + " does not restore");
+            }
+        }
+    };
+
+    detail::DiscardingEventBucket<typename SM::Event> alreadyLogged;
+    EventLogReader(path).replay(from, [&](uint64_t sequence, const EventLogRecord& record) {
+        restoreUpTo(sequence);
+        if (sequence < store.latest(record.machineId).sequence)
+        {
+            return;
+        }
+        SM& machine = *fleet[record.machineId];
+        advanceTo(record.timestampNs);
+        if constexpr (detail::ReplaysTimers<SM>::value)
+        {
+            machine.eventScheduler().checkTimers(clock.now(), alreadyLogged);
+        }
+        machine.dispatch(static_cast<typename SM::Event>(record.event));
+    });
+    restoreUpTo(std::numeric_limits<uint64_t>::max());
+    return fleet;
+}
+
+}  // namespace utils
+}  // namespace eta_hsm
@@ -0,0 +1,213 @@
+// eta/hsm/FleetStore.hpp
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <type_traits>
+
+#include "MappedFile.hpp"
+
+namespace eta_hsm {
+namespace utils {
+
+/// One bit per machine, set when the machine changes and cleared when it has been checkpointed.  Bits can be set from
+/// any thread (e.g. by machines stepped in parallel), while consume() must only be called from one thread at a time.
+class DirtyBitmap {
+public:
+    explicit DirtyBitmap(size_t bits) : mBits{bits}, mWords{new std::atomic<uint64_t>[wordCount(bits)]()} {}
+
+    size_t size() const { return mBits; }
+
+    void mark(size_t idx) { mWords[idx / 64].fetch_or(bit(idx), std::memory_order_relaxed); }
+
+    bool test(size_t idx) const { return (mWords[idx / 64].load(std::memory_order_relaxed) & bit(idx)) != 0; }
+
+    /// How many bits are set?
+    size_t count() const
+    {
+        size_t total = 0;
+        for (size_t word = 0; word < wordCount(mBits); ++word)
+        {
+            total += static_cast<size_t>(__builtin_popcountll(mWords[word].load(std::memory_order_relaxed)));
+        }
+        return total;
+    }
+
+    /// Clear every set bit, handing its index to `consume` (in increasing order).  Clean words are skipped 64 bits at
+    /// a time, so this costs little more than a scan of the bitmap when few bits are set.
+    template <typename Consumer>
+    size_t consume(Consumer&& consumer)
+    {
+        size_t consumed = 0;
+        for (size_t word = 0; word < wordCount(mBits); ++word)
+        {
+            if (mWords[word].load(std::memory_order_relaxed) == 0)
+            {
+                continue;
+            }
+            uint64_t bits = mWords[word].exchange(0, std::memory_order_acquire);
+            while (bits != 0)
+            {
+                consumer(word * 64 + static_cast<size_t>(__builtin_ctzll(bits)));
+                bits &= bits - 1;
+                ++consumed;
+            }
+        }
+        return consumed;
+    }
+
+protected:
+private:
+    static constexpr size_t wordCount(size_t bits) { return (bits + 63) / 64; }
+    static constexpr uint64_t bit(size_t idx) { return uint64_t{1} << (idx % 64); }
+
+    size_t mBits;
+    std::unique_ptr<std::atomic<uint64_t>[]> mWords;
+};
+
+/// What is at the start of a FleetStore file, so that a restarted process can tell whether the records it finds there
+/// are ones it can use
+struct FleetStoreHeader {
+    static constexpr uint64_t kMagic = 0x6574612d666c6565;  // "eta-flee"
+    static constexpr uint32_t kVersion = 2;
+
+    uint64_t magic;
+    uint32_t version;
+    uint32_t recordSize;
+    uint64_t recordCount;
+    uint64_t checkpoints;  // checkpoints completed since the file was created
+    int64_t clockNs;       // the machines' clock (since its epoch) as of the latest checkpoint that was given one
+};
+
+/// A persistent store of one fixed-size Record per machine in a fleet, kept in a memory-mapped file.
+///
+/// Record is whatever plain data a machine needs to carry on after a restart, typically the machine's own snapshot
+/// and those of its timers, buckets and time tracker, plus any POD fields of the host (see StateMachine::snapshot).
+/// Machines mark themselves dirty as they change (see DirtyTrackingStateMachine), and checkpoint() only captures the
+/// records of the dirty machines and only syncs the pages those records are on.
+///
+/// After a restart, the records are read straight out of the mapping:  opening the store is a single mmap, and each
+/// machine is restored from its record without replaying any events.
+template <typename Record>
+class FleetStore {
+public:
+    static_assert(std::is_trivially_copyable_v<Record>, "FleetStore records must be plain data");
+
+    /// Open (or create) the store at `path` for `machines` machines.  An existing file is reused as long as it was
+    /// written for the same number and size of records; otherwise it starts over with zeroed records.
+    FleetStore(const std::string& path, size_t machines)
+        : mFile{path, kRecordsOffset + machines * sizeof(Record)},
+          mHeader{reinterpret_cast<FleetStoreHeader*>(mFile.data())},
+          mRecords{reinterpret_cast<Record*>(mFile.data() + kRecordsOffset)},
+          mDirty{machines}
+    {
+        mRecovered = mFile.existed() && mHeader->magic == FleetStoreHeader::kMagic &&
+                     mHeader->version == FleetStoreHeader::kVersion && mHeader->recordSize == sizeof(Record) &&
+                     mHeader->recordCount == machines;
+        if (!mRecovered)
+        {
+            std::memset(mFile.data(), 0, mFile.size());
+            *mHeader = {FleetStoreHeader::kMagic, FleetStoreHeader::kVersion, sizeof(Record), machines, 0, 0};
+            mFile.sync();
+        }
+    }
+
+    FleetStore(const FleetStore&) = delete;
+    FleetStore& operator=(const FleetStore&) = delete;
+
+    size_t size() const { return mDirty.size(); }
+
+    /// Were the records left behind by an earlier process (as opposed to freshly zeroed)?
+    bool recovered() const { return mRecovered; }
+
+    /// How many checkpoints have completed over the life of the file?
+    uint64_t checkpoints() const { return mHeader->checkpoints; }
+
+    /// The machines' clock as of the latest checkpoint (see checkpoint(capture, now))
+    template <typename Clock>
+    std::chrono::time_point<Clock> checkpointTime() const
+    {
+        return std::chrono::time_point<Clock>(
+            std::chrono::duration_cast<typename Clock::duration>(std::chrono::nanoseconds(mHeader->clockNs)));
+    }
+
+    /// The last checkpointed record of machine `id`
+    const Record& operator[](size_t id) const { return mRecords[id]; }
+
+    DirtyBitmap& dirtyBits() { return mDirty; }
+    void markDirty(size_t id) { mDirty.mark(id); }
+
+    /// Capture the record of every dirty machine, by calling `capture(id, record)` with the record in the mapping to
+    /// overwrite, then sync the pages holding those records (runs of neighbouring pages are synced together).
+    /// Returns the number of records written.
+    template <typename Capture>
+    size_t checkpoint(Capture&& capture)
+    {
+        const size_t written = captureDirty(capture);
+        if (written > 0)
+        {
+            ++mHeader->checkpoints;
+            mFile.sync(0, sizeof(FleetStoreHeader));
+        }
+        return written;
+    }
+
+    /// Checkpoint as above, and record `now` on the machines' clock as the time the whole store is as of.
+    ///
+    /// For fleets with timers:  timer snapshots hold absolute expirations (see TimerSnapshot), so the record of a
+    /// machine whose timers have not changed stays valid and is not written again, and on restore each timer gets the
+    /// time it had left as of checkpointTime().  Restored machines are re-armed against a new clock, so they must
+    /// all be captured again at the first checkpoint after a restart (DirtyTrackingStateMachine::trackDirty() marks
+    /// them dirty).
+    template <typename Capture, typename Clock, typename Duration>
+    size_t checkpoint(Capture&& capture, std::chrono::time_point<Clock, Duration> now)
+    {
+        const size_t written = captureDirty(capture);
+        ++mHeader->checkpoints;
+        mHeader->clockNs = std::chrono::duration_cast<std::chrono::nanoseconds>(now.time_since_epoch()).count();
+        mFile.sync(0, sizeof(FleetStoreHeader));
+        return written;
+    }
+
+protected:
+private:
+    /// Records start on the cache line after the header (the mapping itself is page aligned)
+    static constexpr size_t kRecordsOffset = 64;
+    static_assert(sizeof(FleetStoreHeader) <= kRecordsOffset && alignof(Record) <= kRecordsOffset);
+
+    template <typename Capture>
+    size_t captureDirty(Capture& capture)
+    {
+        const size_t page = MappedFile::pageSize();
+        size_t runBegin = 0;
+        size_t runEnd = 0;
+        const size_t written = mDirty.consume([&](size_t id) {
+            capture(id, mRecords[id]);
+            const size_t begin = kRecordsOffset + id * sizeof(Record);
+            const size_t end = begin + sizeof(Record);
+            if (runEnd == 0 || begin / page > (runEnd - 1) / page + 1)
+            {
+                mFile.sync(runBegin, runEnd - runBegin);
+                runBegin = begin;
+            }
+            runEnd = end;
+        });
+        mFile.sync(runBegin, runEnd - runBegin);
+        return written;
+    }
+
+    MappedFile mFile;
+    FleetStoreHeader* mHeader;
+    Record* mRecords;
+    DirtyBitmap mDirty;
+    bool mRecovered{false};
+};
+
+}  // namespace utils
+}  // namespace eta_hsm
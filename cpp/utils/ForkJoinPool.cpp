@@ -0,0 +1,128 @@
+// eta/hsm/ForkJoinPool.cpp
+
+#include "ForkJoinPool.hpp"
+
+#include <utility>
+
+namespace eta_hsm {
+namespace utils {
+namespace {
+
+/// The pool whose task this thread is running, if any (its workers, and a caller of run() while it helps out)
+thread_local const ForkJoinPool* tRunningIn = nullptr;
+
+}  // namespace
+
+ForkJoinPool::ForkJoinPool(size_t workers)
+{
+    mWorkers.reserve(workers);
+    for (size_t idx = 0; idx < workers; ++idx)
+    {
+        mWorkers.emplace_back([this]() { work(); });
+    }
+}
+
+ForkJoinPool::~ForkJoinPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mStopping = true;
+    }
+    mWake.notify_all();
+    for (auto& worker : mWorkers)
+    {
+        worker.join();
+    }
+}
+
+void ForkJoinPool::runErased(size_t count, Trampoline trampoline, void* task)
+{
+    if (count == 0)
+    {
+        return;
+    }
+    if (tRunningIn == this)
+    {
+        // A task of this pool running a batch of its own:  the workers are busy with the outer batch (and the run
+        // mutex is held by whoever started it), so the inner batch runs right here
+        for (size_t idx = 0; idx < count; ++idx)
+        {
+            trampoline(task, idx);
+        }
+        return;
+    }
+    std::lock_guard<std::mutex> runLock(mRunMutex);
+    if (mWorkers.empty() || count == 1)
+    {
+        const ForkJoinPool* const outer = std::exchange(tRunningIn, this);
+        for (size_t idx = 0; idx < count; ++idx)
+        {
+            trampoline(task, idx);
+        }
+        tRunningIn = outer;
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mTrampoline = trampoline;
+        mTask = task;
+        mCount = count;
+        mNext.store(0, std::memory_order_relaxed);
+        mBusyWorkers = mWorkers.size();
+        ++mGeneration;
+    }
+    mWake.notify_all();
+
+    // The caller helps out rather than sitting idle
+    const ForkJoinPool* const outer = std::exchange(tRunningIn, this);
+    drain();
+    tRunningIn = outer;
+
+    std::unique_lock<std::mutex> lock(mMutex);
+    mDone.wait(lock, [this]() { return mBusyWorkers == 0; });
+    mTrampoline = nullptr;
+    mTask = nullptr;
+}
+
+void ForkJoinPool::work()
+{
+    tRunningIn = this;
+    uint64_t seenGeneration = 0;
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(mMutex);
+            mWake.wait(lock, [this, seenGeneration]() { return mStopping || mGeneration != seenGeneration; });
+            if (mStopping)
+            {
+                return;
+            }
+            seenGeneration = mGeneration;
+        }
+
+        drain();
+
+        bool last = false;
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            last = (--mBusyWorkers == 0);
+        }
+        if (last)
+        {
+            mDone.notify_one();
+        }
+    }
+}
+
+void ForkJoinPool::drain()
+{
+    for (size_t idx = mNext.fetch_add(1, std::memory_order_relaxed); idx < mCount;
+         idx = mNext.fetch_add(1, std::memory_order_relaxed))
+    {
+        mTrampoline(mTask, idx);
+    }
+}
+
+}  // namespace utils
+}  // namespace eta_hsm
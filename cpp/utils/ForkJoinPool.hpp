@@ -0,0 +1,82 @@
+// eta/hsm/ForkJoinPool.hpp
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace eta_hsm {
+namespace utils {
+
+/// A small fixed-size pool of worker threads for fork/join style parallelism:  run(count, task) calls task(idx) for
+/// every idx in [0, count) spread across the workers AND the calling thread, and returns once all of them are done.
+///
+/// The task is passed by reference (never copied into a std::function), so run() does not allocate and can be used
+/// on the dispatch path of a real-time machine once the pool has been constructed.  Only one run() may be in flight
+/// at a time; concurrent callers are serialized, and a task that calls run() on its own pool runs that inner batch on
+/// its own thread.
+class ForkJoinPool {
+public:
+    /// Create a pool with `workers` threads in addition to the thread(s) calling run().  With zero workers, run()
+    /// simply executes every task on the calling thread.  By default, one thread per core including the caller's
+    /// (hardware_concurrency() may be 0 if the number of cores is unknown).
+    explicit ForkJoinPool(size_t workers = std::max(std::thread::hardware_concurrency(), 1u) - 1);
+
+    ~ForkJoinPool();
+
+    ForkJoinPool(const ForkJoinPool&) = delete;
+    ForkJoinPool& operator=(const ForkJoinPool&) = delete;
+
+    /// Call task(idx) for idx in [0, count) and wait for all of them to finish
+    template <typename Task>
+    void run(size_t count, Task&& task)
+    {
+        using TaskType = std::remove_reference_t<Task>;
+        runErased(count, &invoke<TaskType>, const_cast<void*>(static_cast<const void*>(&task)));
+    }
+
+    size_t workers() const { return mWorkers.size(); }
+
+protected:
+private:
+    using Trampoline = void (*)(void*, size_t);
+
+    template <typename Task>
+    static void invoke(void* task, size_t idx)
+    {
+        (*static_cast<Task*>(task))(idx);
+    }
+
+    void runErased(size_t count, Trampoline trampoline, void* task);
+    void work();
+    void drain();
+
+    std::vector<std::thread> mWorkers{};
+
+    /// Serializes calls to run()
+    std::mutex mRunMutex{};
+
+    /// Hand-off of a batch to the workers
+    std::mutex mMutex{};
+    std::condition_variable mWake{};
+    std::condition_variable mDone{};
+    uint64_t mGeneration{0};
+    size_t mBusyWorkers{0};
+    bool mStopping{false};
+
+    /// The batch currently being run
+    Trampoline mTrampoline{nullptr};
+    void* mTask{nullptr};
+    size_t mCount{0};
+    std::atomic<size_t> mNext{0};
+};
+
+}  // namespace utils
+}  // namespace eta_hsm
@@ -0,0 +1,205 @@
+// eta/hsm/LatencyHistogram.hpp
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+namespace eta_hsm {
+namespace utils {
+
+/// A high-dynamic-range (log-linear) histogram of latencies in the spirit of HdrHistogram.
+///
+/// Values below 2^kSubBucketBits are counted exactly.  Above that, every power-of-two range is split into
+/// 2^(kSubBucketBits-1) equally sized buckets, so the relative error of any reported value is bounded by
+/// 2^-(kSubBucketBits-1) (about 3% with the default of 6 bits) no matter how large the value is.  Values at or above
+/// 2^kMaxValueBits are clamped into the last bucket (and counted as saturated).
+///
+/// All storage is a fixed-size array of counters, so recording never allocates.  Every counter is an atomic that is
+/// only ever incremented with relaxed ordering, so any number of threads may record into (or merge into) the same
+/// histogram without taking a lock.  Readers see a consistent-enough view for reporting, not a snapshot.
+template <unsigned kSubBucketBits = 6, unsigned kMaxValueBits = 40>
+class LatencyHistogram {
+public:
+    static_assert(kSubBucketBits >= 2 && kSubBucketBits < kMaxValueBits && kMaxValueBits <= 63,
+                  "Unreasonable LatencyHistogram resolution");
+
+    static constexpr uint64_t kSubBucketCount = uint64_t{1} << kSubBucketBits;
+    static constexpr uint64_t kSubBucketHalfCount = kSubBucketCount / 2;
+    static constexpr uint64_t kMaxTrackableValue = (uint64_t{1} << kMaxValueBits) - 1;
+    static constexpr size_t kBucketCount = (kMaxValueBits - kSubBucketBits + 2) * kSubBucketHalfCount;
+
+    LatencyHistogram() = default;
+
+    // Atomic counters are neither copyable nor movable.  Use merge() to combine histograms.
+    LatencyHistogram(const LatencyHistogram&) = delete;
+    LatencyHistogram& operator=(const LatencyHistogram&) = delete;
+
+    /// Record a single (non-negative) value, nominally in nanoseconds
+    void recordValue(uint64_t value)
+    {
+        if (value > kMaxTrackableValue)
+        {
+            value = kMaxTrackableValue;
+            mSaturated.fetch_add(1, std::memory_order_relaxed);
+        }
+        mCounts[bucketIndex(value)].fetch_add(1, std::memory_order_relaxed);
+        mTotalCount.fetch_add(1, std::memory_order_relaxed);
+        mTotalValue.fetch_add(value, std::memory_order_relaxed);
+
+        uint64_t previousMax = mMax.load(std::memory_order_relaxed);
+        while (value > previousMax && !mMax.compare_exchange_weak(previousMax, value, std::memory_order_relaxed))
+        {}
+    }
+
+    /// Record a duration with nanosecond resolution.  Negative durations (e.g. from a misbehaving clock) count as 0.
+    template <typename Rep, typename Period>
+    void record(std::chrono::duration<Rep, Period> duration)
+    {
+        const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count();
+        recordValue(ns > 0 ? static_cast<uint64_t>(ns) : 0);
+    }
+
+    /// Accumulate the counts of another histogram into this one.  The other histogram may still be recording.
+    void merge(const LatencyHistogram& other)
+    {
+        for (size_t idx = 0; idx < kBucketCount; ++idx)
+        {
+            const uint64_t count = other.mCounts[idx].load(std::memory_order_relaxed);
+            if (count != 0)
+            {
+                mCounts[idx].fetch_add(count, std::memory_order_relaxed);
+            }
+        }
+        mTotalCount.fetch_add(other.totalCount(), std::memory_order_relaxed);
+        mTotalValue.fetch_add(other.mTotalValue.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        mSaturated.fetch_add(other.saturatedCount(), std::memory_order_relaxed);
+
+        const uint64_t otherMax = other.max();
+        uint64_t previousMax = mMax.load(std::memory_order_relaxed);
+        while (otherMax > previousMax && !mMax.compare_exchange_weak(previousMax, otherMax, std::memory_order_relaxed))
+        {}
+    }
+
+    /// Forget everything that has been recorded so far
+    void reset()
+    {
+        for (auto& count : mCounts)
+        {
+            count.store(0, std::memory_order_relaxed);
+        }
+        mTotalCount.store(0, std::memory_order_relaxed);
+        mTotalValue.store(0, std::memory_order_relaxed);
+        mSaturated.store(0, std::memory_order_relaxed);
+        mMax.store(0, std::memory_order_relaxed);
+    }
+
+    uint64_t totalCount() const { return mTotalCount.load(std::memory_order_relaxed); }
+    uint64_t saturatedCount() const { return mSaturated.load(std::memory_order_relaxed); }
+    uint64_t max() const { return mMax.load(std::memory_order_relaxed); }
+
+    double mean() const
+    {
+        const uint64_t count = totalCount();
+        return count == 0 ? 0.0 : static_cast<double>(mTotalValue.load(std::memory_order_relaxed)) / count;
+    }
+
+    /// Number of recorded values that landed in the same bucket as `value`
+    uint64_t countAtValue(uint64_t value) const
+    {
+        return mCounts[bucketIndex(value > kMaxTrackableValue ? kMaxTrackableValue : value)].load(
+            std::memory_order_relaxed);
+    }
+
+    /// Smallest value v such that at least `percentile` percent of the recorded values are <= v (to within the
+    /// resolution of the histogram).  Reported values are the upper bound of their bucket, clamped to max().
+    uint64_t valueAtPercentile(double percentile) const
+    {
+        const uint64_t count = totalCount();
+        if (count == 0)
+        {
+            return 0;
+        }
+        if (percentile > 100.0)
+        {
+            percentile = 100.0;
+        }
+        uint64_t threshold = static_cast<uint64_t>(percentile / 100.0 * static_cast<double>(count) + 0.5);
+        if (threshold == 0)
+        {
+            threshold = 1;
+        }
+
+        uint64_t accumulated = 0;
+        for (size_t idx = 0; idx < kBucketCount; ++idx)
+        {
+            accumulated += mCounts[idx].load(std::memory_order_relaxed);
+            if (accumulated >= threshold)
+            {
+                const uint64_t upper = highestEquivalentValue(idx);
+                return upper < max() ? upper : max();
+            }
+        }
+        return max();
+    }
+
+    /// Map a value onto its bucket
+    static constexpr size_t bucketIndex(uint64_t value)
+    {
+        if (value < kSubBucketCount)
+        {
+            return static_cast<size_t>(value);
+        }
+        const unsigned shift = mostSignificantBit(value) - (kSubBucketBits - 1);
+        return static_cast<size_t>(shift * kSubBucketHalfCount + (value >> shift));
+    }
+
+    /// Inverse of bucketIndex():  the smallest and largest values that map onto a particular bucket
+    static constexpr uint64_t lowestEquivalentValue(size_t index)
+    {
+        if (index < kSubBucketCount)
+        {
+            return index;
+        }
+        const uint64_t shift = index / kSubBucketHalfCount - 1;
+        const uint64_t subBucket = index - shift * kSubBucketHalfCount;
+        return subBucket << shift;
+    }
+    static constexpr uint64_t highestEquivalentValue(size_t index)
+    {
+        if (index < kSubBucketCount)
+        {
+            return index;
+        }
+        const uint64_t shift = index / kSubBucketHalfCount - 1;
+        return lowestEquivalentValue(index) + (uint64_t{1} << shift) - 1;
+    }
+
+protected:
+private:
+    static constexpr unsigned mostSignificantBit(uint64_t value)
+    {
+#if defined(__GNUC__) || defined(__clang__)
+        return 63 - static_cast<unsigned>(__builtin_clzll(value));
+#else
+        unsigned msb = 0;
+        while (value >>= 1)
+        {
+            ++msb;
+        }
+        return msb;
+#endif
+    }
+
+    std::array<std::atomic<uint64_t>, kBucketCount> mCounts{};
+    std::atomic<uint64_t> mTotalCount{0};
+    std::atomic<uint64_t> mTotalValue{0};
+    std::atomic<uint64_t> mSaturated{0};
+    std::atomic<uint64_t> mMax{0};
+};
+
+}  // namespace utils
+}  // namespace eta_hsm
@@ -0,0 +1,116 @@
+// eta/hsm/LatencyRecorder.hpp
+
+#pragma once
+
+#include <array>
+#include <cassert>
+#include <chrono>
+#include <cstddef>
+
+#include "EventBucket.hpp"
+#include "LatencyHistogram.hpp"
+
+namespace eta_hsm {
+namespace utils {
+
+/// Instrumentation surface for attributing tail latency of a state machine.  It records three families of histograms:
+///   - dispatch():  latency of StateMachine::dispatch, regardless of state
+///   - during():    latency of StateMachine::during, attributed to the leaf state that was active when it started
+///   - dispatchNext():  delay between an event being added to a TimestampedEventBucket and being dispatched
+///                      (in addition to the dispatch latency itself)
+///
+/// The recorder wraps calls into the state machine rather than living inside it, so it can be bolted onto any
+/// existing StateMachine (including AutoLoggedStateMachine) without changing its type.  Recording is lock-free and
+/// allocation-free (see LatencyHistogram), and recorders can be merged to aggregate across machines and threads.
+///
+/// The per-state histograms are sized from the machine's StateTable (one per StateEnum value below its size()), so
+/// state enums need not be contiguous or start at zero, as long as the table covers them.
+///
+/// Like TimeTracker, time is read from a clock instance held by reference so that tests can drive it with FakeClock.
+template <typename StateTable, typename Clock, typename Histogram = LatencyHistogram<>>
+class LatencyRecorder {
+public:
+    using StateEnum = typename StateTable::StateEnum;
+
+    LatencyRecorder(const Clock& clock) : mClock{clock} {}
+
+    /// Dispatch an event and record how long it took
+    template <typename SM>
+    void dispatch(SM& stateMachine, typename SM::Event evt)
+    {
+        const auto start = mClock.now();
+        stateMachine.dispatch(evt);
+        mDispatch.record(mClock.now() - start);
+    }
+
+    /// Kick off the during action of the current state and record how long it took against that state
+    template <typename SM, typename... Input>
+    void during(SM& stateMachine, const Input&... input)
+    {
+        // Note: during() is allowed to transition, so capture the state that we started in up front
+        const StateEnum state = stateMachine.identify();
+        const auto start = mClock.now();
+        stateMachine.during(input...);
+        mDuring[index(state)].record(mClock.now() - start);
+    }
+
+    /// Remove the oldest event from the bucket (if there is one) and dispatch it, recording both how long it
+    /// spent waiting in the bucket and how long it took to dispatch.  Returns false if the bucket was empty.
+    template <typename SM, typename BucketClock, size_t kCapacity>
+    bool dispatchNext(SM& stateMachine, TimestampedEventBucket<typename SM::Event, BucketClock, kCapacity>& bucket)
+    {
+        if (bucket.empty())
+        {
+            return false;
+        }
+        const auto stamped = bucket.getTimestampedEvent();
+        mQueueDelay.record(mClock.now() - stamped.enqueued);
+        dispatch(stateMachine, stamped.event);
+        return true;
+    }
+
+    /// Accumulate everything recorded by another recorder (e.g. for another machine or thread) into this one
+    void merge(const LatencyRecorder& other)
+    {
+        mDispatch.merge(other.mDispatch);
+        mQueueDelay.merge(other.mQueueDelay);
+        for (size_t idx = 0; idx < mDuring.size(); ++idx)
+        {
+            mDuring[idx].merge(other.mDuring[idx]);
+        }
+    }
+
+    void reset()
+    {
+        mDispatch.reset();
+        mQueueDelay.reset();
+        for (auto& histogram : mDuring)
+        {
+            histogram.reset();
+        }
+    }
+
+    const Histogram& dispatchLatency() const { return mDispatch; }
+    const Histogram& queueDelay() const { return mQueueDelay; }
+    const Histogram& duringLatency(StateEnum state) const { return mDuring[index(state)]; }
+
+protected:
+private:
+    static size_t index(StateEnum state)
+    {
+        const auto idx = static_cast<size_t>(state);
+        assert(idx < StateTable::size() && "state is not covered by the StateTable");
+        return idx;
+    }
+
+    const Clock& mClock;
+
+    Histogram mDispatch{};
+    Histogram mQueueDelay{};
+
+    /// One histogram per state, although only leaf states will ever be populated
+    std::array<Histogram, StateTable::size()> mDuring{};
+};
+
+}  // namespace utils
+}  // namespace eta_hsm
@@ -0,0 +1,144 @@
+// eta/hsm/Mailbox.hpp
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+
+#include "EventBucket.hpp"
+
+namespace eta_hsm {
+namespace utils {
+
+/// A fixed-capacity EventBucket that any number of threads can add events to at once, while one thread (the one
+/// running the machine that owns it) takes them out.  Like StaticEventBucket, events are stored in a ring inside the
+/// mailbox, so it never allocates, and events added while it is full are dropped and counted in overflows().
+///
+/// Each slot carries a sequence number that says whose turn it is (a producer's, to fill it, or the consumer's, to
+/// empty it), so producers only contend on claiming a position and never wait for one another.  Whoever runs the
+/// owner can ask to be told about every event that arrives (see setNotify()), which is how ActorRuntime knows which
+/// machines have work to do.
+template <typename Event, size_t kCapacity>
+class Mailbox : public EventBucket<Event> {
+public:
+    static_assert(kCapacity > 0 && (kCapacity & (kCapacity - 1)) == 0, "Mailbox capacity must be a power of two");
+
+    using Notify = void (*)(void* context);
+
+    Mailbox()
+    {
+        for (size_t idx = 0; idx < kCapacity; ++idx)
+        {
+            mSlots[idx].sequence.store(idx, std::memory_order_relaxed);
+        }
+    }
+
+    Mailbox(const Mailbox&) = delete;
+    Mailbox& operator=(const Mailbox&) = delete;
+
+    /// Implement the addEvent interface declared in EventBucket (from any thread)
+    void addEvent(Event evt) override { tryAddEvent(std::move(evt)); }
+
+    /// As addEvent(), but returns false if the event was dropped because the mailbox was full
+    bool tryAddEvent(Event evt)
+    {
+        size_t position = mTail.load(std::memory_order_relaxed);
+        Slot* slot;
+        while (true)
+        {
+            slot = &mSlots[position & (kCapacity - 1)];
+            const size_t sequence = slot->sequence.load(std::memory_order_acquire);
+            const auto lead = static_cast<std::ptrdiff_t>(sequence - position);
+            if (lead == 0)
+            {
+                if (mTail.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                {
+                    break;
+                }
+            }
+            else if (lead < 0)
+            {
+                // The slot still holds an event from a lap ago:  full
+                mOverflows.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+            else
+            {
+                position = mTail.load(std::memory_order_relaxed);
+            }
+        }
+        slot->event = std::move(evt);
+        slot->sequence.store(position + 1, std::memory_order_release);
+        if (mNotify)
+        {
+            mNotify(mNotifyContext);
+        }
+        return true;
+    }
+
+    /// Is the mailbox empty?  (Only the consumer gets a definite answer.)
+    bool empty() const
+    {
+        const size_t head = mHead.load(std::memory_order_relaxed);
+        return mSlots[head & (kCapacity - 1)].sequence.load(std::memory_order_acquire) != head + 1;
+    }
+
+    /// How many events are in the mailbox, including any that are still being added
+    size_t size() const { return mTail.load(std::memory_order_relaxed) - mHead.load(std::memory_order_relaxed); }
+
+    /// How many events can the mailbox hold?
+    static constexpr size_t capacity() { return kCapacity; }
+
+    /// How many events have been dropped because the mailbox was full?
+    uint64_t overflows() const { return mOverflows.load(std::memory_order_relaxed); }
+
+    /// Simplified accessor that removes an event from the mailbox and returns it (consumer only)
+    Event getEvent()
+    {
+        const size_t head = mHead.load(std::memory_order_relaxed);
+        Slot& slot = mSlots[head & (kCapacity - 1)];
+        if (slot.sequence.load(std::memory_order_acquire) != head + 1)
+        {
+            return Event::eNone;  // assuming there is an eNone element
+        }
+        Event evt = std::move(slot.event);
+        // Release whatever the event holds (e.g. a PayloadEvent's payload) now rather than when the slot is reused
+        if constexpr (!std::is_trivially_destructible_v<Event>)
+        {
+            slot.event = Event{};
+        }
+        slot.sequence.store(head + kCapacity, std::memory_order_release);
+        mHead.store(head + 1, std::memory_order_relaxed);
+        return evt;
+    }
+
+    /// Call `notify(context)` after every event that is added (from the thread that added it).  Set it before any
+    /// producer starts.
+    void setNotify(Notify notify, void* context)
+    {
+        mNotify = notify;
+        mNotifyContext = context;
+    }
+
+protected:
+private:
+    struct Slot {
+        std::atomic<size_t> sequence{0};
+        Event event{};
+    };
+
+    /// Producers and the consumer each get a cache line of their own
+    alignas(64) std::atomic<size_t> mTail{0};
+    alignas(64) std::atomic<size_t> mHead{0};
+    alignas(64) std::array<Slot, kCapacity> mSlots{};
+    std::atomic<uint64_t> mOverflows{0};
+    Notify mNotify{nullptr};
+    void* mNotifyContext{nullptr};
+};
+
+}  // namespace utils
+}  // namespace eta_hsm
@@ -0,0 +1,82 @@
+// eta/hsm/MappedFile.cpp
+
+#include "MappedFile.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <system_error>
+
+namespace eta_hsm {
+namespace utils {
+
+namespace {
+
+[[noreturn]] void throwErrno(const std::string& what)
+{
+    throw std::system_error(errno, std::generic_category(), what);
+}
+
+}  // namespace
+
+MappedFile::MappedFile(const std::string& path, size_t bytes) : mSize{bytes}
+{
+    mFd = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+    if (mFd < 0)
+    {
+        throwErrno("open " + path);
+    }
+    struct stat info{};
+    if (::fstat(mFd, &info) != 0 || (static_cast<size_t>(info.st_size) != bytes && ::ftruncate(mFd, bytes) != 0))
+    {
+        const int error = errno;
+        ::close(mFd);
+        errno = error;
+        throwErrno("resize " + path);
+    }
+    mExisted = static_cast<size_t>(info.st_size) == bytes;
+
+    void* data = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, mFd, 0);
+    if (data == MAP_FAILED)
+    {
+        const int error = errno;
+        ::close(mFd);
+        errno = error;
+        throwErrno("mmap " + path);
+    }
+    mData = static_cast<std::byte*>(data);
+}
+
+MappedFile::~MappedFile()
+{
+    ::munmap(mData, mSize);
+    ::close(mFd);
+}
+
+void MappedFile::sync(size_t offset, size_t length)
+{
+    if (length == 0 || offset >= mSize)
+    {
+        return;
+    }
+    // msync wants a page-aligned start
+    const size_t page = pageSize();
+    const size_t begin = offset - offset % page;
+    const size_t end = offset + length < mSize ? offset + length : mSize;
+    if (::msync(mData + begin, end - begin, MS_SYNC) != 0)
+    {
+        throwErrno("msync");
+    }
+}
+
+size_t MappedFile::pageSize()
+{
+    static const size_t kPageSize = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+    return kPageSize;
+}
+
+}  // namespace utils
+}  // namespace eta_hsm
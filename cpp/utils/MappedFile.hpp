@@ -0,0 +1,48 @@
+// eta/hsm/MappedFile.hpp
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+namespace eta_hsm {
+namespace utils {
+
+/// A file mapped read/write (and shared) into memory.  Stores into the mapping reach the file through the page cache,
+/// so they survive the process crashing as soon as they are made; sync() is only needed to make them survive the
+/// whole host going down.  Failures to open or map the file are reported by throwing std::system_error.
+class MappedFile {
+public:
+    /// Map `path`, creating it if it does not exist.  The file is resized to exactly `bytes` (new space reads as zero).
+    MappedFile(const std::string& path, size_t bytes);
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    std::byte* data() { return mData; }
+    const std::byte* data() const { return mData; }
+    size_t size() const { return mSize; }
+
+    /// Did the file already exist, at exactly the size asked for?
+    bool existed() const { return mExisted; }
+
+    /// Write the pages covering [offset, offset + length) back to the file, and wait for them to get there
+    void sync(size_t offset, size_t length);
+
+    /// Write the whole mapping back to the file
+    void sync() { sync(0, mSize); }
+
+    /// Granularity of sync()
+    static size_t pageSize();
+
+protected:
+private:
+    int mFd{-1};
+    std::byte* mData{nullptr};
+    size_t mSize{0};
+    bool mExisted{false};
+};
+
+}  // namespace utils
+}  // namespace eta_hsm
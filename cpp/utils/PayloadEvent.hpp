@@ -0,0 +1,208 @@
+// eta/hsm/PayloadEvent.hpp
+
+#pragma once
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace eta_hsm {
+namespace utils {
+
+/// The type of payload carried by an event (void for none).  Specialize it to key payload types by event, e.g.
+///
+///     template <>
+///     struct eta_hsm::utils::PayloadOf<ThermostatEvent::eSetpoint> { using type = Setpoint; };
+///
+/// which lets handlers ask for `event.get<ThermostatEvent::eSetpoint>()` instead of naming the type.
+template <auto kEvent>
+struct PayloadOf {
+    using type = void;
+};
+
+/// An event enum together with an optional payload of any (nothrow movable) type of up to kCapacity bytes, which is
+/// stored inside the event itself rather than on the heap.  PayloadEvent is move-only:  it is moved into and out of
+/// event buckets (use StaticEventBucket to keep the whole path allocation-free), and handed to handleEvent by const
+/// reference, so the payload itself is never copied.
+///
+/// To use it, declare `using Event = utils::PayloadEvent<MyEvent>;` in the StateMachineTraits.  Handlers keep their
+/// usual signature and can still compare and switch on the event as if it were the enum:
+///
+///     if (event == MyEvent::eSetpoint)
+///     {
+///         stateMachine.setTarget(event.get<MyEvent::eSetpoint>().celsius);
+///
+/// Like the event buckets, PayloadEvent assumes that the enum has an eNone element, which is what a default
+/// constructed event holds.  A moved-from event keeps its id but no longer has a payload.
+template <typename EventEnum, size_t kCapacity = 32>
+class PayloadEvent {
+public:
+    static_assert(std::is_enum_v<EventEnum>, "PayloadEvent is keyed by an event enum");
+
+    using Enum = EventEnum;
+    static constexpr EventEnum eNone = EventEnum::eNone;  // so that buckets can return Event::eNone when empty
+
+    PayloadEvent() = default;
+
+    /// An event without a payload (implicit, so that plain enum values can be dispatched and added to buckets)
+    PayloadEvent(EventEnum id) : mId{id} {}
+
+    /// An event with a payload
+    template <typename T, typename = std::enable_if_t<!std::is_same_v<std::decay_t<T>, PayloadEvent>>>
+    PayloadEvent(EventEnum id, T&& payload) : mId{id}
+    {
+        emplace<std::decay_t<T>>(std::forward<T>(payload));
+    }
+
+    /// An event whose payload is constructed in place as the type declared for it with PayloadOf
+    template <EventEnum kEvent, typename... Args>
+    static PayloadEvent make(Args&&... args)
+    {
+        using T = typename PayloadOf<kEvent>::type;
+        PayloadEvent evt{kEvent};
+        if constexpr (!std::is_void_v<T>)
+        {
+            evt.template emplace<T>(std::forward<Args>(args)...);
+        }
+        return evt;
+    }
+
+    PayloadEvent(PayloadEvent&& other) noexcept : mId{other.mId} { takePayload(other); }
+
+    PayloadEvent& operator=(PayloadEvent&& other) noexcept
+    {
+        if (this != &other)
+        {
+            reset();
+            mId = other.mId;
+            takePayload(other);
+        }
+        return *this;
+    }
+
+    PayloadEvent(const PayloadEvent&) = delete;
+    PayloadEvent& operator=(const PayloadEvent&) = delete;
+
+    ~PayloadEvent() { reset(); }
+
+    EventEnum id() const { return mId; }
+    operator EventEnum() const { return mId; }
+
+    bool hasPayload() const { return mOps != nullptr; }
+
+    /// Does the payload have type T?
+    template <typename T>
+    bool holds() const
+    {
+        return mOps == &kOps<T>;
+    }
+
+    /// The payload, which must have type T
+    template <typename T>
+    const T& get() const
+    {
+        return *std::launder(reinterpret_cast<const T*>(mStorage));
+    }
+    template <typename T>
+    T& get()
+    {
+        return *std::launder(reinterpret_cast<T*>(mStorage));
+    }
+
+    /// The payload, which must have the type declared for kEvent with PayloadOf
+    template <EventEnum kEvent>
+    const auto& get() const
+    {
+        return get<typename PayloadOf<kEvent>::type>();
+    }
+    template <EventEnum kEvent>
+    auto& get()
+    {
+        return get<typename PayloadOf<kEvent>::type>();
+    }
+
+    /// The payload if it has type T, nullptr otherwise
+    template <typename T>
+    const T* getIf() const
+    {
+        return holds<T>() ? &get<T>() : nullptr;
+    }
+    template <typename T>
+    T* getIf()
+    {
+        return holds<T>() ? &get<T>() : nullptr;
+    }
+
+    /// Replace the payload with a T constructed from args
+    template <typename T, typename... Args>
+    T& emplace(Args&&... args)
+    {
+        static_assert(sizeof(T) <= kCapacity, "Payload does not fit in the PayloadEvent, increase kCapacity");
+        static_assert(alignof(T) <= alignof(std::max_align_t), "Over-aligned payloads are not supported");
+        static_assert(std::is_nothrow_move_constructible_v<T>, "Payloads must be nothrow move constructible");
+        reset();
+        T* payload = ::new (static_cast<void*>(mStorage)) T(std::forward<Args>(args)...);
+        mOps = &kOps<T>;
+        return *payload;
+    }
+
+    /// Destroy the payload (if any), keeping the event id
+    void reset()
+    {
+        if (mOps)
+        {
+            mOps->destroy(mStorage);
+            mOps = nullptr;
+        }
+    }
+
+    friend bool operator==(const PayloadEvent& evt, EventEnum id) { return evt.mId == id; }
+    friend bool operator==(EventEnum id, const PayloadEvent& evt) { return evt.mId == id; }
+    friend bool operator!=(const PayloadEvent& evt, EventEnum id) { return evt.mId != id; }
+    friend bool operator!=(EventEnum id, const PayloadEvent& evt) { return evt.mId != id; }
+
+protected:
+private:
+    /// What it takes to move and destroy a payload whose type has been erased.  The address of the table for a type
+    /// doubles as the identity of that type.
+    struct Ops {
+        void (*move)(void* destination, void* source) noexcept;
+        void (*destroy)(void* payload) noexcept;
+    };
+
+    template <typename T>
+    static void movePayload(void* destination, void* source) noexcept
+    {
+        T* from = std::launder(static_cast<T*>(source));
+        ::new (destination) T(std::move(*from));
+        from->~T();
+    }
+
+    template <typename T>
+    static void destroyPayload(void* payload) noexcept
+    {
+        std::launder(static_cast<T*>(payload))->~T();
+    }
+
+    template <typename T>
+    static constexpr Ops kOps{&movePayload<T>, &destroyPayload<T>};
+
+    /// Move the payload out of other, leaving other with its id but without a payload
+    void takePayload(PayloadEvent& other) noexcept
+    {
+        if (other.mOps)
+        {
+            other.mOps->move(mStorage, other.mStorage);
+            mOps = other.mOps;
+            other.mOps = nullptr;
+        }
+    }
+
+    alignas(std::max_align_t) unsigned char mStorage[kCapacity]{};
+    const Ops* mOps{nullptr};
+    EventEnum mId{EventEnum::eNone};
+};
+
+}  // namespace utils
+}  // namespace eta_hsm
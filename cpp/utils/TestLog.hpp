@@ -1,80 +1,174 @@
 // TestLog.hpp
 #pragma once
 
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <cstddef>
+#include <cstring>
 #include <iostream>
-#include <sstream>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+/// Defining ETA_HSM_DISABLE_TEST_LOG (see the ETA_HSM_TEST_LOG option in CMakeLists.txt) compiles out every log
+/// statement written with ETA_HSM_TEST_LOG, arguments and all.
+#ifdef ETA_HSM_DISABLE_TEST_LOG
+#define ETA_HSM_TEST_LOG_COMPILED_IN false
+#else
+#define ETA_HSM_TEST_LOG_COMPILED_IN true
+#endif
+
+/// Bytes of capture buffer per thread (more than this is dropped, see TestLog::dropped())
+#ifndef ETA_HSM_TEST_LOG_SHARD_BYTES
+#define ETA_HSM_TEST_LOG_SHARD_BYTES (64 * 1024)
+#endif
+
+/// Bytes of output line per thread (a longer line is written out in pieces of this size)
+#ifndef ETA_HSM_TEST_LOG_LINE_BYTES
+#define ETA_HSM_TEST_LOG_LINE_BYTES 512
+#endif
+
+/// Log `stream` (anything that may follow `TestLog::instance() <<`), e.g. ETA_HSM_TEST_LOG("enter_S1 " << std::endl).
+/// The statement is still type checked when the log is compiled out, but generates no code.
+#define ETA_HSM_TEST_LOG(stream)                                         \
+    do                                                                   \
+    {                                                                    \
+        if constexpr (::eta_hsm::utils::TestLog::kCompiledIn)            \
+        {                                                                \
+            ::eta_hsm::utils::TestLog::instance() << stream;             \
+        }                                                                \
+    } while (false)
 
 namespace eta_hsm {
 namespace utils {
 
 /// Crude surrogate for std::cout so that I can enable/disable print statements
 /// from a single place for performance testing of state machine eval code.
-
+///
+/// Captures are per thread:  each thread that calls startCapture() gets a shard with a preallocated buffer of its own,
+/// so machines run on different threads (e.g. tests run in parallel) capture without sharing anything and without
+/// allocating.  Shards are kept in a lock-free list, which is what the merged view (forEachCapture(), getMerged())
+/// walks.  A shard outlives its thread so that its capture can still be checked after the thread has been joined; it
+/// is then handed to the next thread that needs one.
+///
+/// Output to std::cout (while enabled) is per thread too:  each thread builds up its current line on its own and
+/// writes it to std::cout in one piece once it ends (or is flushed), so that lines logged by threads running at the
+/// same time do not interleave.  Manipulators apply to the thread's own output only.
 class TestLog {
 public:
+    static constexpr bool kCompiledIn = ETA_HSM_TEST_LOG_COMPILED_IN;
+    static constexpr size_t kShardCapacity = ETA_HSM_TEST_LOG_SHARD_BYTES;
+    static constexpr size_t kLineCapacity = ETA_HSM_TEST_LOG_LINE_BYTES;
+
     template <typename T>
     TestLog &operator<<(const T &x)
     {
-        if (mEnabled)
+        ThreadState &local = threadState();
+        if (mEnabled.load(std::memory_order_relaxed))
         {
-            std::cout << x;
+            local.print(x);
         }
-        if (mCapturing)
+        if (local.capturing)
         {
-            mCaptureSS << x;
+            local.capture(x);
         }
         return *this;
     }
 
     TestLog &operator<<(std::ostream &(*f)(std::ostream &))
     {
-        if (mEnabled)
+        if (mEnabled.load(std::memory_order_relaxed))
         {
-            f(std::cout);
+            f(threadState().lineStream);
         }
         return *this;
     }
 
     TestLog &operator<<(std::ostream &(*f)(std::ios &))
     {
-        if (mEnabled)
+        if (mEnabled.load(std::memory_order_relaxed))
         {
-            f(std::cout);
+            f(threadState().lineStream);
         }
         return *this;
     }
 
     TestLog &operator<<(std::ostream &(*f)(std::ios_base &))
     {
-        if (mEnabled)
+        if (mEnabled.load(std::memory_order_relaxed))
         {
-            f(std::cout);
+            f(threadState().lineStream);
         }
         return *this;
     }
 
-    void enable()
+    /// Output to std::cout is enabled to begin with.  Disabling it does not stop captures.
+    void enable() { mEnabled = true; }
+
+    void disable() { mEnabled = false; }
+
+    /// Start capturing what this thread logs, discarding whatever it captured before
+    void startCapture()
     {
-        std::cout << "*** Enabling TestLog Output ***" << std::endl;
-        mEnabled = true;
+        ThreadState &local = threadState();
+        if (!local.shard)
+        {
+            local.attach(acquireShard());
+        }
+        local.shard->clear();
+        local.capturing = true;
     }
 
-    void disable()
+    void stopCapture() { threadState().capturing = false; }
+
+    /// What this thread captured since it last called startCapture()
+    std::string getCaptured() { return std::string{captured()}; }
+
+    /// As getCaptured(), without a copy.  Only valid until this thread next calls startCapture().
+    std::string_view captured()
     {
-        std::cout << "*** Disabling TestLog Output ***" << std::endl;
-        mEnabled = false;
+        const Shard *shard = threadState().shard;
+        return shard ? shard->view() : std::string_view{};
     }
 
-    void startCapture()
+    /// How many bytes this thread failed to capture because its shard was full
+    size_t dropped()
     {
-        mCaptureSS.clear();
-        mCaptureSS.str(std::string());
-        mCapturing = true;
+        const Shard *shard = threadState().shard;
+        return shard ? shard->mDropped.load(std::memory_order_relaxed) : 0;
     }
 
-    void stopCapture() { mCapturing = false; }
+    /// Visit the capture of every shard (of running and finished threads alike), most recently created shard first.
+    /// Takes no locks:  a shard that is being written to is seen up to its last completed append.  Captures restarted
+    /// (or cleared) while they are being visited may be seen half overwritten, so check them after the threads that
+    /// made them are done.
+    template <typename Visitor>
+    void forEachCapture(Visitor &&visit) const
+    {
+        for (const Shard *shard = mShards.load(std::memory_order_acquire); shard; shard = shard->mNext)
+        {
+            visit(shard->view());
+        }
+    }
 
-    std::string getCaptured() { return mCaptureSS.str(); }
+    /// Every capture, one after the other (see forEachCapture)
+    std::string getMerged() const
+    {
+        std::string merged;
+        forEachCapture([&merged](std::string_view capture) { merged.append(capture); });
+        return merged;
+    }
+
+    /// Empty every shard, e.g. before a test that checks the merged view.  Must not race with threads that capture.
+    void clearAll()
+    {
+        for (Shard *shard = mShards.load(std::memory_order_acquire); shard; shard = shard->mNext)
+        {
+            shard->clear();
+        }
+    }
 
     static TestLog &instance()
     {
@@ -85,12 +179,203 @@ public:
 private:
     TestLog() { mEnabled = true; }
 
-    bool mEnabled;
+    /// One thread's capture buffer.  It is also the streambuf for values that have to be formatted by an ostream.
+    struct Shard : std::streambuf {
+        void clear()
+        {
+            mLength.store(0, std::memory_order_release);
+            mDropped.store(0, std::memory_order_relaxed);
+        }
+
+        std::string_view view() const { return {mBuffer.get(), mLength.load(std::memory_order_acquire)}; }
+
+        /// Only called by the owning thread
+        void append(const char *data, size_t len)
+        {
+            const size_t length = mLength.load(std::memory_order_relaxed);
+            const size_t kept = std::min(len, kShardCapacity - length);
+            std::memcpy(mBuffer.get() + length, data, kept);
+            mLength.store(length + kept, std::memory_order_release);
+            if (kept < len)
+            {
+                mDropped.fetch_add(len - kept, std::memory_order_relaxed);
+            }
+        }
+
+        std::streamsize xsputn(const char *data, std::streamsize len) override
+        {
+            append(data, static_cast<size_t>(len));
+            return len;
+        }
+
+        int_type overflow(int_type ch) override
+        {
+            if (!traits_type::eq_int_type(ch, traits_type::eof()))
+            {
+                const char c = traits_type::to_char_type(ch);
+                append(&c, 1);
+            }
+            return traits_type::not_eof(ch);
+        }
+
+        std::unique_ptr<char[]> mBuffer{new char[kShardCapacity]};
+        std::atomic<size_t> mLength{0};
+        std::atomic<size_t> mDropped{0};
+        std::atomic<bool> mInUse{true};
+        Shard *mNext{nullptr};
+    };
+
+    /// One thread's output line, written to std::cout in one piece once it ends, is flushed, or fills up
+    struct Line : std::streambuf {
+        void append(const char *data, size_t len)
+        {
+            while (len > 0)
+            {
+                const void *newline = std::memchr(data, '\n', len);
+                const size_t upTo = newline ? static_cast<size_t>(static_cast<const char *>(newline) - data) + 1 : len;
+                const size_t kept = std::min(upTo, kLineCapacity - mLength);
+                std::memcpy(mBuffer + mLength, data, kept);
+                mLength += kept;
+                data += kept;
+                len -= kept;
+                if (mLength == kLineCapacity || (newline && kept == upTo))
+                {
+                    write();
+                }
+            }
+        }
+
+        void write()
+        {
+            if (mLength > 0)
+            {
+                std::cout.write(mBuffer, static_cast<std::streamsize>(mLength));
+                mLength = 0;
+            }
+        }
+
+        std::streamsize xsputn(const char *data, std::streamsize len) override
+        {
+            append(data, static_cast<size_t>(len));
+            return len;
+        }
+
+        int_type overflow(int_type ch) override
+        {
+            if (!traits_type::eq_int_type(ch, traits_type::eof()))
+            {
+                const char c = traits_type::to_char_type(ch);
+                append(&c, 1);
+            }
+            return traits_type::not_eof(ch);
+        }
+
+        int sync() override
+        {
+            write();
+            std::cout.flush();
+            return 0;
+        }
+
+        char mBuffer[kLineCapacity];
+        size_t mLength{0};
+    };
+
+    /// What each thread keeps to itself:  its output line, its shard (once it has captured something) and whether it
+    /// is capturing
+    struct ThreadState {
+        ~ThreadState()
+        {
+            line.write();
+            if (shard)
+            {
+                shard->mInUse.store(false, std::memory_order_release);
+            }
+        }
+
+        void attach(Shard *newShard)
+        {
+            shard = newShard;
+            stream.rdbuf(shard);
+        }
+
+        /// Strings are copied straight into the line; anything else is formatted by the line's own ostream
+        template <typename T>
+        void print(const T &x)
+        {
+            if constexpr (std::is_convertible_v<const T &, std::string_view>)
+            {
+                const std::string_view text{x};
+                line.append(text.data(), text.size());
+            }
+            else
+            {
+                lineStream << x;
+            }
+        }
+
+        /// Strings and integers are copied straight into the shard; anything else goes through an ostream that
+        /// writes into the shard, so that it reads exactly as it would on std::cout.
+        template <typename T>
+        void capture(const T &x)
+        {
+            if constexpr (std::is_convertible_v<const T &, std::string_view>)
+            {
+                const std::string_view text{x};
+                shard->append(text.data(), text.size());
+            }
+            else if constexpr (std::is_integral_v<T> && !std::is_same_v<T, bool> && !std::is_same_v<T, char> &&
+                               !std::is_same_v<T, signed char> && !std::is_same_v<T, unsigned char>)
+            {
+                char digits[24];
+                const auto result = std::to_chars(digits, digits + sizeof(digits), x);
+                shard->append(digits, static_cast<size_t>(result.ptr - digits));
+            }
+            else
+            {
+                stream << x;
+            }
+        }
+
+        Line line{};
+        std::ostream lineStream{&line};
+        Shard *shard{nullptr};
+        bool capturing{false};
+        std::ostream stream{nullptr};
+    };
+
+    static ThreadState &threadState()
+    {
+        thread_local ThreadState sState;
+        return sState;
+    }
+
+    /// Reuse the shard of a thread that has finished, or add a new one to the list
+    Shard *acquireShard()
+    {
+        for (Shard *shard = mShards.load(std::memory_order_acquire); shard; shard = shard->mNext)
+        {
+            bool inUse = false;
+            if (shard->mInUse.compare_exchange_strong(inUse, true, std::memory_order_acquire))
+            {
+                return shard;
+            }
+        }
+        // Never freed:  the list only grows to the largest number of threads that have captured at once
+        Shard *shard = new Shard;
+        shard->mNext = mShards.load(std::memory_order_relaxed);
+        while (!mShards.compare_exchange_weak(shard->mNext, shard, std::memory_order_release,
+                                              std::memory_order_relaxed))
+        {
+        }
+        return shard;
+    }
+
+    std::atomic<bool> mEnabled;
 
-    // Capture log traffic to an internal strinstream for retrieval later.
-    bool mCapturing;
-    std::stringstream mCaptureSS;
+    // Capture log traffic to per-thread shards for retrieval later.
+    std::atomic<Shard *> mShards{nullptr};
 };
 
 }  // namespace utils
-}  // namespace eta_hsm
\ No newline at end of file
+}  // namespace eta_hsm
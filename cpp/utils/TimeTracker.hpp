@@ -3,6 +3,7 @@
 #pragma once
 #include <array>
 #include <chrono>
+#include <cstddef>
 
 #include "wise_enum/wise_enum.h"
 
@@ -40,6 +41,35 @@ public:
         return mClock.now() - mEntryTimes.at(static_cast<Underlying>(state));
     }
 
+    /// How long we had been in each state, as plain data (see snapshot() and restore())
+    struct Snapshot {
+        std::array<Duration, wise_enum::size<StateEnum>> elapsed{};
+        std::array<bool, wise_enum::size<StateEnum>> inState{};
+    };
+
+    /// Record how long we have been in each state we are in.  Elapsed times (rather than entry times) carry over to
+    /// a tracker with a different clock, e.g. on a standby that takes over from a failed primary.
+    Snapshot snapshot() const
+    {
+        Snapshot snap{};
+        for (size_t i = 0; i < snap.elapsed.size(); ++i)
+        {
+            snap.inState[i] = mInState[i];
+            snap.elapsed[i] = mInState[i] ? mClock.now() - mEntryTimes[i] : Duration::zero();
+        }
+        return snap;
+    }
+
+    /// Carry on as if each state in `snap` had been entered the recorded time ago (without calling enter())
+    void restore(const Snapshot& snap)
+    {
+        for (size_t i = 0; i < snap.elapsed.size(); ++i)
+        {
+            mInState[i] = snap.inState[i];
+            mEntryTimes[i] = mClock.now() - snap.elapsed[i];
+        }
+    }
+
 protected:
 private:
     const LocalClock& mClock;
@@ -1,7 +1,11 @@
 // eta/hsm/Timer.hpp
 #pragma once
 
+#include <array>
 #include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
 #include <set>
 
 #include "EventBucket.hpp"
@@ -49,6 +53,13 @@ public:
     Event event() const { return mEvent; }
     GroupEnum groupId() const { return mGroupId; }
     UniqueEnum uniqueId() const { return mUniqueId; }
+    std::chrono::time_point<Clock> expiration() const { return mExpiration; }
+
+    /// How long until the timer expires, as of `now` (zero if it already has)
+    typename Clock::duration remaining(const std::chrono::time_point<Clock>& now) const
+    {
+        return mExpiration > now ? mExpiration - now : Clock::duration::zero();
+    }
 
     /// Check whether or not this particular timer has expired
     bool expired(const std::chrono::time_point<Clock>& now) const
@@ -87,6 +98,67 @@ private:
     bool mArmed;
 };
 
+/// An armed timer as plain data
+template <typename Traits_>
+struct TimerRecord {
+    typename Traits_::Event event;
+    typename Traits_::GroupEnum groupId;
+    typename Traits_::UniqueEnum uniqueId;
+    typename Traits_::Clock::duration expiration;  // since the clock's epoch
+
+    /// How long the timer had left as of `asOf` (zero if it had already expired)
+    typename Traits_::Clock::duration remaining(std::chrono::time_point<typename Traits_::Clock> asOf) const
+    {
+        const std::chrono::time_point<typename Traits_::Clock> expires(expiration);
+        return expires > asOf ? expires - asOf : Traits_::Clock::duration::zero();
+    }
+};
+
+/// Up to kMaxTimers armed timers of a TimerBank or StaticTimerBank (see their snapshot() and restore()).
+///
+/// Expirations are kept as they were, along with the time the snapshot was taken, rather than as the time each timer
+/// had left:  a snapshot of timers that have not changed since stays valid, and only the time it is taken to be as of
+/// needs updating.  Restoring re-arms each timer with the time it had left as of then, so it can be against a
+/// different clock (e.g. on a standby that takes over from a failed primary).
+template <typename Traits_, size_t kMaxTimers>
+struct TimerSnapshot {
+    std::array<TimerRecord<Traits_>, kMaxTimers> timers{};
+    uint32_t count{0};
+    bool truncated{false};  // there were more than kMaxTimers armed timers, and the ones that expire last were lost
+    typename Traits_::Clock::duration capturedAt{};  // since the clock's epoch
+};
+
+/// Who a timer bank tells when its armed timers change (set, cleared, or fired), e.g. so that a machine can mark
+/// itself dirty for the next checkpoint (see DirtyTrackingStateMachine).  The hook is not copied along with the
+/// bank:  a copy tells no one, and an assignment leaves the hook as it was.
+class TimerChangeHook {
+public:
+    using Notify = void (*)(void* context);
+
+    TimerChangeHook() = default;
+    TimerChangeHook(const TimerChangeHook&) {}
+    TimerChangeHook& operator=(const TimerChangeHook&) { return *this; }
+
+    void set(Notify notify, void* context)
+    {
+        mNotify = notify;
+        mContext = context;
+    }
+
+    void operator()() const
+    {
+        if (mNotify)
+        {
+            mNotify(mContext);
+        }
+    }
+
+protected:
+private:
+    Notify mNotify{nullptr};
+    void* mContext{nullptr};
+};
+
 /// The controller (which is an eta-hsm::StateMachine) will have to hold potentially several timers running
 /// simultaneously, and I was unsure which STL container (if any) would end up working best for indexing by state and
 /// utils, much less one that would be appropriate for the RPU from a memory allocation standpoint. Hence, I'm going to
@@ -112,6 +184,16 @@ public:
 
     bool empty() { return mTimers.empty(); }
 
+    /// When the next timer expires (e.g. to know when to check again), or nothing if no timer is armed
+    std::optional<std::chrono::time_point<Clock>> nextExpiration() const
+    {
+        if (mTimers.empty())
+        {
+            return std::nullopt;
+        }
+        return mTimers.begin()->expiration();
+    }
+
     /// create (set) timer to expire at a specified time_point in the future
     void addTimer(Event event, GroupEnum groupId, std::chrono::time_point<Clock> expiration,
                   UniqueEnum uniqueId = UniqueEnum::eNone)
@@ -120,16 +202,14 @@ public:
         clearTimer(event, groupId, uniqueId);
         // multiset will take care of sorting by expiration
         mTimers.emplace(Timer<Traits_>(event, groupId, expiration, uniqueId));
+        mOnChange();
     }
 
     /// create (set) timer to expire a specified duration from now
     void addTimer(Event event, GroupEnum groupId, std::chrono::milliseconds duration_ms,
                   UniqueEnum uniqueId = UniqueEnum::eNone)
     {
-        // TODO: Question: Do we want to allow exact duplicates?
-        clearTimer(event, groupId, uniqueId);
-        // multiset will take care of sorting by expiration
-        mTimers.emplace(Timer<Traits_>(event, groupId, mLastTimeValue + duration_ms, uniqueId));
+        addTimer(event, groupId, mLastTimeValue + duration_ms, uniqueId);
     }
 
     /// clear (remove) a specific timer
@@ -141,6 +221,7 @@ public:
             if (it->event() == event && it->groupId() == groupId && it->uniqueId() == uniqueId)
             {
                 it = mTimers.erase(it);
+                mOnChange();
                 // keep searching since there might be multiples
             }
             else
@@ -161,6 +242,7 @@ public:
             if (it->groupId() == groupId)
             {
                 it = mTimers.erase(it);
+                mOnChange();
                 // keep searching since there might be multiples
             }
             else
@@ -205,6 +287,7 @@ public:
             // Note: we only have to check the first timer since they are already sorted by expiration
             Event firedEvent = mTimers.begin()->event();
             mTimers.erase(mTimers.begin());
+            mOnChange();
             return firedEvent;
         }
         else
@@ -213,11 +296,56 @@ public:
         }
     }
 
+    /// Copy out up to kMaxTimers armed timers (soonest first), as of `now`
+    template <size_t kMaxTimers>
+    TimerSnapshot<Traits_, kMaxTimers> snapshot(std::chrono::time_point<Clock> now) const
+    {
+        TimerSnapshot<Traits_, kMaxTimers> snap{};
+        snap.capturedAt = now.time_since_epoch();
+        for (const auto& timer : mTimers)
+        {
+            if (snap.count == kMaxTimers)
+            {
+                snap.truncated = true;
+                break;
+            }
+            snap.timers[snap.count++] = {timer.event(), timer.groupId(), timer.uniqueId(),
+                                         timer.expiration().time_since_epoch()};
+        }
+        return snap;
+    }
+
+    /// Replace all timers with the ones in `snap`, each set to expire the time it had left as of `asOf` (by default,
+    /// when the snapshot was taken) after `now`
+    template <size_t kMaxTimers>
+    void restore(const TimerSnapshot<Traits_, kMaxTimers>& snap, std::chrono::time_point<Clock> now)
+    {
+        restore(snap, now, std::chrono::time_point<Clock>(snap.capturedAt));
+    }
+    template <size_t kMaxTimers>
+    void restore(const TimerSnapshot<Traits_, kMaxTimers>& snap, std::chrono::time_point<Clock> now,
+                 std::chrono::time_point<Clock> asOf)
+    {
+        mTimers.clear();
+        mLastTimeValue = now;
+        for (size_t i = 0; i < snap.count && i < kMaxTimers; ++i)
+        {
+            const auto& record = snap.timers[i];
+            mTimers.emplace(
+                Timer<Traits_>(record.event, record.groupId, now + record.remaining(asOf), record.uniqueId));
+        }
+        mOnChange();
+    }
+
+    /// Call `notify(context)` whenever the armed timers change (see TimerChangeHook)
+    void onChange(TimerChangeHook::Notify notify, void* context) { mOnChange.set(notify, context); }
+
 protected:
 private:
     std::multiset<Timer<Traits_>> mTimers{};
     /// Keep the "latest" timer value around for future use
     std::chrono::time_point<Clock> mLastTimeValue{};
+    TimerChangeHook mOnChange{};
 };
 
 /// A StaticTimerBank provides a subset of the functionality of TimerBank but does so without dynamically
@@ -257,6 +385,7 @@ public:
         //            mEventEmitter->emit(StaticTimerBankOverwriteActiveTimer{.groupId=groupId});
         //        }
         mTimers.at(static_cast<size_t>(groupId)).reset(event, groupId, expiration);
+        mOnChange();
     }
 
     /// set timer to expire a specified duration from now
@@ -266,7 +395,29 @@ public:
     }
 
     /// clear a specific timer
-    void clearTimer(GroupEnum groupId) { mTimers.at(static_cast<size_t>(groupId)).disarm(); }
+    void clearTimer(GroupEnum groupId)
+    {
+        Timer<Traits_>& timer = mTimers.at(static_cast<size_t>(groupId));
+        if (timer.armed())
+        {
+            timer.disarm();
+            mOnChange();
+        }
+    }
+
+    /// When the next timer expires (e.g. to know when to check again), or nothing if no timer is armed
+    std::optional<std::chrono::time_point<Clock>> nextExpiration() const
+    {
+        std::optional<std::chrono::time_point<Clock>> next;
+        for (const auto& timer : mTimers)
+        {
+            if (timer.armed() && (!next || timer.expiration() < *next))
+            {
+                next = timer.expiration();
+            }
+        }
+        return next;
+    }
 
     /// Since StaticTimerBank only allows one timer per group, clearing all timers in the
     /// group is the same thing as clearing **the** timer for the group in the function above.
@@ -287,16 +438,61 @@ public:
             {
                 eventBucket.addEvent(timer.event());
                 timer.disarm();
+                mOnChange();
             }
         }
     }
 
+    using Snapshot = TimerSnapshot<Traits_, wise_enum::size<GroupEnum>>;
+
+    /// Copy out the armed timers, as of `now`.  There is at most one timer per group, so a snapshot always has room
+    /// for all of them.
+    Snapshot snapshot(std::chrono::time_point<Clock> now) const
+    {
+        Snapshot snap{};
+        snap.capturedAt = now.time_since_epoch();
+        for (const auto& timer : mTimers)
+        {
+            if (timer.armed())
+            {
+                snap.timers[snap.count++] = {timer.event(), timer.groupId(), timer.uniqueId(),
+                                             timer.expiration().time_since_epoch()};
+            }
+        }
+        return snap;
+    }
+
+    /// Replace all timers with the ones in `snap`, each set to expire the time it had left as of `asOf` (by default,
+    /// when the snapshot was taken) after `now`
+    void restore(const Snapshot& snap, std::chrono::time_point<Clock> now)
+    {
+        restore(snap, now, std::chrono::time_point<Clock>(snap.capturedAt));
+    }
+    void restore(const Snapshot& snap, std::chrono::time_point<Clock> now, std::chrono::time_point<Clock> asOf)
+    {
+        for (auto& timer : mTimers)
+        {
+            timer.disarm();
+        }
+        mLastTimeValue = now;
+        for (size_t i = 0; i < snap.count && i < snap.timers.size(); ++i)
+        {
+            const auto& record = snap.timers[i];
+            addTimer(record.event, record.groupId, now + record.remaining(asOf));
+        }
+        mOnChange();
+    }
+
+    /// Call `notify(context)` whenever the armed timers change (see TimerChangeHook)
+    void onChange(TimerChangeHook::Notify notify, void* context) { mOnChange.set(notify, context); }
+
 protected:
 private:
     // Using a static array with one timer allowed per state
     std::array<Timer<Traits_>, wise_enum::size<GroupEnum>> mTimers{};
     /// Keep the "latest" timer value around for future use
     std::chrono::time_point<Clock> mLastTimeValue{};
+    TimerChangeHook mOnChange{};
 };
 
 }  // namespace utils
@@ -0,0 +1,179 @@
+// eta/hsm/TraceRecorder.cpp
+
+#include "TraceRecorder.hpp"
+
+#include <initializer_list>
+
+namespace eta_hsm {
+namespace utils {
+
+namespace {
+
+/// Every recorder gets a unique id so that stale thread-local ring caches can never be mistaken for current ones
+std::atomic<uint64_t> sNextRecorderId{1};
+
+/// The Chrome "tid" of one of a machine's tracks, which keeps the two tracks of each machine next to each other
+uint64_t tid(uint32_t machineId, TraceRecord::Track track)
+{
+    return 2 * uint64_t{machineId} + static_cast<uint64_t>(track);
+}
+
+void writeEscaped(std::ostream& output, std::string_view text)
+{
+    for (char c : text)
+    {
+        if (c == '"' || c == '\\')
+        {
+            output << '\\';
+        }
+        output << c;
+    }
+}
+
+}  // namespace
+
+TraceRecorder::TraceRecorder(std::ostream& output, std::chrono::milliseconds flushPeriod)
+    : mOutput{output}, mFlushPeriod{flushPeriod}, mId{sNextRecorderId.fetch_add(1)}
+{
+    mOutput << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+    mWriter = std::thread([this]() { run(); });
+}
+
+TraceRecorder::~TraceRecorder()
+{
+    {
+        std::lock_guard<std::mutex> lock(mWakeMutex);
+        mStopping = true;
+    }
+    mWake.notify_one();
+    mWriter.join();
+
+    std::lock_guard<std::mutex> lock(mWriteMutex);
+    writeAvailable();
+    mOutput << "\n]}\n";
+    mOutput.flush();
+}
+
+void TraceRecorder::nameMachine(uint32_t machineId, std::string name)
+{
+    std::lock_guard<std::mutex> lock(mWriteMutex);
+    for (const auto track : {TraceRecord::Track::eActivity, TraceRecord::Track::eStates})
+    {
+        separate();
+        mOutput << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << tid(machineId, track)
+                << ",\"args\":{\"name\":\"";
+        writeEscaped(mOutput, name);
+        mOutput << (track == TraceRecord::Track::eStates ? " states\"}}" : "\"}}");
+    }
+}
+
+void TraceRecorder::flush()
+{
+    std::lock_guard<std::mutex> lock(mWriteMutex);
+    writeAvailable();
+    mOutput.flush();
+}
+
+uint64_t TraceRecorder::dropped() const
+{
+    std::lock_guard<std::mutex> lock(mRingsMutex);
+    uint64_t total = 0;
+    for (const auto& entry : mRings)
+    {
+        total += entry.second->dropped();
+    }
+    return total;
+}
+
+TraceRing& TraceRecorder::ringForThisThread()
+{
+    // Cache the most recently used ring so that the common case (one recorder per process) never takes the lock
+    thread_local uint64_t tCachedRecorderId{0};
+    thread_local TraceRing* tCachedRing{nullptr};
+    if (tCachedRecorderId == mId)
+    {
+        return *tCachedRing;
+    }
+
+    std::lock_guard<std::mutex> lock(mRingsMutex);
+    const auto threadId = std::this_thread::get_id();
+    TraceRing* ring = nullptr;
+    for (auto& entry : mRings)
+    {
+        if (entry.first == threadId)
+        {
+            ring = entry.second.get();
+            break;
+        }
+    }
+    if (!ring)
+    {
+        mRings.emplace_back(threadId, std::make_unique<TraceRing>());
+        ring = mRings.back().second.get();
+    }
+    tCachedRecorderId = mId;
+    tCachedRing = ring;
+    return *ring;
+}
+
+void TraceRecorder::run()
+{
+    std::unique_lock<std::mutex> wakeLock(mWakeMutex);
+    while (!mStopping)
+    {
+        mWake.wait_for(wakeLock, mFlushPeriod, [this]() { return mStopping; });
+        wakeLock.unlock();
+        {
+            std::lock_guard<std::mutex> lock(mWriteMutex);
+            writeAvailable();
+        }
+        wakeLock.lock();
+    }
+}
+
+void TraceRecorder::writeAvailable()
+{
+    std::lock_guard<std::mutex> lock(mRingsMutex);
+    for (auto& entry : mRings)
+    {
+        entry.second->drain([this](const TraceRecord& record) { write(record); });
+    }
+}
+
+void TraceRecorder::separate()
+{
+    if (!mFirstRecord)
+    {
+        mOutput << ',';
+    }
+    mFirstRecord = false;
+    mOutput << '\n';
+}
+
+void TraceRecorder::write(const TraceRecord& record)
+{
+    separate();
+    mOutput << "{\"name\":\"";
+    writeEscaped(mOutput, record.name);
+    mOutput << "\",\"cat\":\"";
+    writeEscaped(mOutput, record.category);
+    mOutput << "\",\"ph\":\"" << static_cast<char>(record.phase) << "\",\"ts\":" << record.timestampNs / 1000 << '.';
+    const uint64_t fraction = record.timestampNs % 1000;
+    mOutput << static_cast<char>('0' + fraction / 100) << static_cast<char>('0' + fraction / 10 % 10)
+            << static_cast<char>('0' + fraction % 10);
+    mOutput << ",\"pid\":1,\"tid\":" << tid(record.machineId, record.track);
+    if (record.phase == TraceRecord::Phase::eInstant)
+    {
+        mOutput << ",\"s\":\"t\"";
+    }
+    if (!record.detail.empty())
+    {
+        mOutput << ",\"args\":{\"event\":\"";
+        writeEscaped(mOutput, record.detail);
+        mOutput << "\"}";
+    }
+    mOutput << '}';
+}
+
+}  // namespace utils
+}  // namespace eta_hsm
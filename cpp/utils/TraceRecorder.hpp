@@ -0,0 +1,258 @@
+// eta/hsm/TraceRecorder.hpp
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "EventBucket.hpp"
+#include "wise_enum/wise_enum.h"
+
+namespace eta_hsm {
+namespace utils {
+
+/// A single entry in a trace.  Names must refer to storage that outlives the TraceRecorder (string literals and the
+/// names produced by wise_enum::to_string both qualify), so that recording a trace entry never copies a string.
+struct TraceRecord {
+    enum class Phase : char {
+        eBegin = 'B',
+        eEnd = 'E',
+        eInstant = 'i',
+    };
+
+    /// Which of its machine's two tracks an entry goes on
+    enum class Track : uint8_t {
+        eActivity,  // dispatch and during spans, and instant events
+        eStates,    // state residency spans, which open and close in the middle of activity spans
+    };
+
+    Phase phase;
+    uint32_t machineId;
+    uint64_t timestampNs;
+    std::string_view category;
+    std::string_view name;
+    std::string_view detail;  // optional, e.g. the event that was dispatched
+    Track track{Track::eActivity};
+};
+
+/// Fixed-capacity single-producer/single-consumer ring of TraceRecords.  The producer is the thread that owns the
+/// ring and the consumer is the TraceRecorder's background writer.  If the writer falls behind, new records are
+/// dropped (and counted) rather than blocking or allocating on the producing thread.
+class TraceRing {
+public:
+    static constexpr size_t kCapacity = 1 << 14;
+
+    bool push(const TraceRecord& record)
+    {
+        const size_t head = mHead.load(std::memory_order_relaxed);
+        if (head - mTail.load(std::memory_order_acquire) >= kCapacity)
+        {
+            mDropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        mRecords[head & (kCapacity - 1)] = record;
+        mHead.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    /// Hand every record currently in the ring to `consume` (in order) and release their slots
+    template <typename Consumer>
+    size_t drain(Consumer&& consume)
+    {
+        const size_t tail = mTail.load(std::memory_order_relaxed);
+        const size_t head = mHead.load(std::memory_order_acquire);
+        for (size_t idx = tail; idx != head; ++idx)
+        {
+            consume(mRecords[idx & (kCapacity - 1)]);
+        }
+        mTail.store(head, std::memory_order_release);
+        return head - tail;
+    }
+
+    uint64_t dropped() const { return mDropped.load(std::memory_order_relaxed); }
+
+protected:
+private:
+    std::array<TraceRecord, kCapacity> mRecords{};
+    std::atomic<size_t> mHead{0};
+    std::atomic<size_t> mTail{0};
+    std::atomic<uint64_t> mDropped{0};
+};
+
+/// Collects TraceRecords from any number of threads and writes them in the background as Chrome Trace Event Format
+/// JSON, which can be loaded by chrome://tracing or https://ui.perfetto.dev.
+///
+/// Each machine is given a pair of tracks (Chrome "tid"s 2 * machineId and 2 * machineId + 1), one for what it is
+/// doing and one for the states it is in.  Spans on a track must nest, and a transition closes residency spans in the
+/// middle of a dispatch span, so the two kinds of span cannot share one.  On their own track, nested state residency
+/// spans line up by hierarchy level, and thousands of machines can be viewed on a single timeline.  Every recording
+/// thread is lazily given its own TraceRing, so the only synchronization on the recording path is the ring itself.
+class TraceRecorder {
+public:
+    /// Begin writing a trace to `output`, which must outlive the recorder.
+    explicit TraceRecorder(std::ostream& output, std::chrono::milliseconds flushPeriod = std::chrono::milliseconds(50));
+
+    /// Stops the background writer, writes everything that is still buffered, and closes the JSON document
+    ~TraceRecorder();
+
+    TraceRecorder(const TraceRecorder&) = delete;
+    TraceRecorder& operator=(const TraceRecorder&) = delete;
+
+    /// Record an entry from the calling thread.  Lock-free and allocation-free except for the very first record
+    /// from a new thread, which registers that thread's ring.
+    void record(const TraceRecord& record) { ringForThisThread().push(record); }
+
+    /// Give a machine's tracks a human-readable name in the viewer.  Intended to be called during setup.
+    void nameMachine(uint32_t machineId, std::string name);
+
+    /// Block until everything recorded so far (by any thread) has been written to the output
+    void flush();
+
+    /// Total number of records that were dropped because a ring was full
+    uint64_t dropped() const;
+
+    /// Nanoseconds since the recorder was created, suitable for TraceRecord::timestampNs
+    uint64_t now() const
+    {
+        return static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - mEpoch).count());
+    }
+
+protected:
+private:
+    TraceRing& ringForThisThread();
+    void run();
+    void writeAvailable();
+    void write(const TraceRecord& record);
+    void separate();
+
+    std::ostream& mOutput;
+    const std::chrono::milliseconds mFlushPeriod;
+    const std::chrono::steady_clock::time_point mEpoch{std::chrono::steady_clock::now()};
+    const uint64_t mId;
+
+    /// Rings are only ever added (under mRingsMutex) and are never removed before the recorder is destroyed
+    mutable std::mutex mRingsMutex{};
+    std::vector<std::pair<std::thread::id, std::unique_ptr<TraceRing>>> mRings{};
+
+    /// Only the writer (or flush/destructor, under mWriteMutex) touches the output
+    std::mutex mWriteMutex{};
+    bool mFirstRecord{true};
+
+    std::mutex mWakeMutex{};
+    std::condition_variable mWake{};
+    bool mStopping{false};
+    std::thread mWriter{};
+};
+
+/// Front end for tracing a single state machine.  Declare `kTraceStates = true` in the machine's StateMachineTraits and
+/// give the machine a `stateTracer()` that returns its StateTracer, and the machine calls enter()/exit() itself as it
+/// enters and exits composite and leaf states, for one span per state residency at every level of the hierarchy.
+/// Route dispatch()/during() through it to get spans for those as well.
+template <typename StateEnum>
+class StateTracer {
+public:
+    StateTracer(TraceRecorder& recorder, uint32_t machineId) : mRecorder{recorder}, mMachineId{machineId} {}
+
+    void enter(StateEnum state)
+    {
+        emit(TraceRecord::Phase::eBegin, kStateCategory, wise_enum::to_string(state), {}, TraceRecord::Track::eStates);
+    }
+    void exit(StateEnum state)
+    {
+        emit(TraceRecord::Phase::eEnd, kStateCategory, wise_enum::to_string(state), {}, TraceRecord::Track::eStates);
+    }
+
+    /// Dispatch an event within a "dispatch" span
+    template <typename SM>
+    void dispatch(SM& stateMachine, typename SM::Event evt)
+    {
+        emit(TraceRecord::Phase::eBegin, kDispatchCategory, "dispatch", eventName(evt));
+        stateMachine.dispatch(evt);
+        emit(TraceRecord::Phase::eEnd, kDispatchCategory, "dispatch");
+    }
+
+    /// Kick off the during action of the current state within a "during" span
+    template <typename SM, typename... Input>
+    void during(SM& stateMachine, const Input&... input)
+    {
+        emit(TraceRecord::Phase::eBegin, kDuringCategory, "during");
+        stateMachine.during(input...);
+        emit(TraceRecord::Phase::eEnd, kDuringCategory, "during");
+    }
+
+    /// Record an instant event, e.g. a timer firing
+    template <typename Event>
+    void instant(std::string_view category, Event evt)
+    {
+        emit(TraceRecord::Phase::eInstant, category, eventName(evt));
+    }
+
+    uint32_t machineId() const { return mMachineId; }
+
+    static constexpr std::string_view kStateCategory{"state"};
+    static constexpr std::string_view kDispatchCategory{"dispatch"};
+    static constexpr std::string_view kDuringCategory{"during"};
+    static constexpr std::string_view kTimerCategory{"timer"};
+
+protected:
+private:
+    void emit(TraceRecord::Phase phase, std::string_view category, std::string_view name, std::string_view detail = {},
+              TraceRecord::Track track = TraceRecord::Track::eActivity)
+    {
+        mRecorder.record({phase, mMachineId, mRecorder.now(), category, name, detail, track});
+    }
+
+    template <typename Event>
+    static std::string_view eventName(Event evt)
+    {
+        if constexpr (wise_enum::is_wise_enum_v<Event>)
+        {
+            return wise_enum::to_string(evt);
+        }
+        else
+        {
+            return "event";
+        }
+    }
+
+    TraceRecorder& mRecorder;
+    const uint32_t mMachineId;
+};
+
+/// EventBucket adapter that records an instant event for every event passed through it before forwarding it on.
+/// Hand this to TimerBank::checkTimers (or StaticTimerBank::checkTimers) to see timer firings on the trace.
+template <typename Event, typename StateEnum>
+class TracingEventBucket : public EventBucket<Event> {
+public:
+    TracingEventBucket(EventBucket<Event>& bucket, StateTracer<StateEnum>& tracer,
+                       std::string_view category = StateTracer<StateEnum>::kTimerCategory)
+        : mBucket{bucket}, mTracer{tracer}, mCategory{category}
+    {}
+
+    void addEvent(Event evt) override
+    {
+        mTracer.instant(mCategory, evt);
+        mBucket.addEvent(evt);
+    }
+
+protected:
+private:
+    EventBucket<Event>& mBucket;
+    StateTracer<StateEnum>& mTracer;
+    std::string_view mCategory;
+};
+
+}  // namespace utils
+}  // namespace eta_hsm
@@ -0,0 +1,385 @@
+// allocation_guard_test.cpp
+
+#include "../AllocationGuard.hpp"
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../../AutoLoggedStateMachine.hpp"
+#include "../../Hsm.hpp"
+#include "../EventBucket.hpp"
+#include "../FakeClock.hpp"
+#include "../TestLog.hpp"
+#include "../Timer.hpp"
+
+namespace eta_hsm {
+namespace utils {
+namespace tests {
+
+WISE_ENUM_CLASS((Event, int32_t), eTick, eToggle, eNone)
+
+WISE_ENUM_CLASS((State, int32_t), eNone, eTop, eOn, eOff)
+
+/// Smallest useful machine with entry/exit/during actions, none of which allocate
+template <typename Base>
+class Blinker : public Base {
+public:
+    template <typename... Args>
+    Blinker(Args&&... args);
+
+    template <State kState>
+    void entry()
+    {
+        ++mEntries;
+    }
+    template <State kState>
+    void exit()
+    {
+        ++mExits;
+    }
+    template <State kState>
+    void stateUpdate()
+    {
+        ++mUpdates;
+    }
+
+    int mEntries{0};
+    int mExits{0};
+    int mUpdates{0};
+};
+
+using BlinkerTraits = StateMachineTraits<Event, State, FakeClock, DefaultActions::eControlUpdate>;
+
+struct PlainBlinker : Blinker<StateMachine<PlainBlinker, BlinkerTraits>> {
+    using Input = EmptyType;
+    PlainBlinker();
+};
+
+struct LoggedBlinker : Blinker<AutoLoggedStateMachine<LoggedBlinker, BlinkerTraits, TestLog>> {
+    using Input = EmptyType;
+    LoggedBlinker();
+};
+
+template <typename Host>
+using Top = TopState<StateTraits<Host, State, State::eTop>>;
+template <typename Host>
+using On = LeafState<StateTraits<Host, State, State::eOn>, Top<Host>>;
+template <typename Host>
+using Off = LeafState<StateTraits<Host, State, State::eOff>, Top<Host>>;
+
+}  // namespace tests
+}  // namespace utils
+
+template <>
+template <typename Current>
+inline void utils::tests::On<utils::tests::PlainBlinker>::handleEvent(utils::tests::PlainBlinker& stateMachine,
+                                                                      const Current&, Event event) const
+{
+    if (event == utils::tests::Event::eToggle)
+    {
+        Transition<Current, ThisState, utils::tests::Off<utils::tests::PlainBlinker>> t(stateMachine);
+    }
+}
+
+template <>
+template <typename Current>
+inline void utils::tests::Off<utils::tests::PlainBlinker>::handleEvent(utils::tests::PlainBlinker& stateMachine,
+                                                                       const Current&, Event event) const
+{
+    if (event == utils::tests::Event::eToggle)
+    {
+        Transition<Current, ThisState, utils::tests::On<utils::tests::PlainBlinker>> t(stateMachine);
+    }
+}
+
+template <>
+template <typename Current>
+inline void utils::tests::On<utils::tests::LoggedBlinker>::handleEvent(utils::tests::LoggedBlinker& stateMachine,
+                                                                       const Current&, Event event) const
+{
+    if (event == utils::tests::Event::eToggle)
+    {
+        Transition<Current, ThisState, utils::tests::Off<utils::tests::LoggedBlinker>> t(stateMachine);
+    }
+}
+
+template <>
+template <typename Current>
+inline void utils::tests::Off<utils::tests::LoggedBlinker>::handleEvent(utils::tests::LoggedBlinker& stateMachine,
+                                                                        const Current&, Event event) const
+{
+    if (event == utils::tests::Event::eToggle)
+    {
+        Transition<Current, ThisState, utils::tests::On<utils::tests::LoggedBlinker>> t(stateMachine);
+    }
+}
+
+template <>
+inline void utils::tests::Top<utils::tests::PlainBlinker>::init(utils::tests::PlainBlinker& stateMachine)
+{
+    Init<utils::tests::Off<utils::tests::PlainBlinker>> i(stateMachine);
+}
+
+template <>
+inline void utils::tests::Top<utils::tests::LoggedBlinker>::init(utils::tests::LoggedBlinker& stateMachine)
+{
+    Init<utils::tests::Off<utils::tests::LoggedBlinker>> i(stateMachine);
+}
+
+namespace utils {
+namespace tests {
+
+template <typename Base>
+template <typename... Args>
+Blinker<Base>::Blinker(Args&&... args) : Base(std::forward<Args>(args)...)
+{}
+
+PlainBlinker::PlainBlinker() { Transition<Top<PlainBlinker>, Top<PlainBlinker>, Top<PlainBlinker>> t(*this); }
+
+LoggedBlinker::LoggedBlinker() : Blinker("blinker", &TestLog::instance())
+{
+    Transition<Top<LoggedBlinker>, Top<LoggedBlinker>, Top<LoggedBlinker>> t(*this);
+}
+
+TEST(AllocationGuardTest, CountsOnlyThisThreadAndScope)
+{
+    AllocationGuard outer;
+    auto first = std::make_unique<int>(1);
+    EXPECT_EQ(outer.allocations(), 1);
+    EXPECT_GE(outer.bytes(), sizeof(int));
+
+    {
+        AllocationGuard inner;
+        std::vector<int> values(100);
+        EXPECT_EQ(inner.allocations(), 1);
+        EXPECT_EQ(inner.bytes(), 100 * sizeof(int));
+    }
+    EXPECT_EQ(outer.allocations(), 2);
+
+    // C-style allocations are caught too (where the platform allows interposing malloc)
+#if defined(__GLIBC__)
+    void* raw = std::malloc(16);
+    std::free(raw);
+    EXPECT_EQ(outer.allocations(), 3);
+#endif
+
+    // Other threads never show up
+    AllocationStats fromOtherThread{};
+    std::thread([&fromOtherThread]() {
+        fromOtherThread = countAllocations([]() { std::string big(1000, 'x'); });
+    }).join();
+    EXPECT_EQ(fromOtherThread.allocations, 1);
+    const uint64_t beforeIdle = outer.allocations();
+    std::thread([]() { std::vector<int> unrelated(1000); }).join();
+    // std::thread itself allocates its state on this thread, but the vector belongs to the other thread
+    EXPECT_LE(outer.allocations() - beforeIdle, 1);
+}
+
+TEST(AllocationGuardTest, AbortPolicyDiesOnAllocation)
+{
+    EXPECT_DEATH(
+        {
+            AllocationGuard guard(AllocationGuard::Policy::eAbort);
+            auto leaked = std::make_unique<std::string>(100, 'x');
+        },
+        "heap allocation inside a guarded scope");
+
+    // No allocation, no problem
+    PlainBlinker blinker;
+    AllocationGuard guard(AllocationGuard::Policy::eAbort);
+    blinker.dispatch(Event::eToggle);
+    EXPECT_EQ(guard.allocations(), 0);
+}
+
+TEST(AllocationGuardTest, DispatchAndDuringAreHeapFree)
+{
+    PlainBlinker blinker;
+    const AllocationStats stats = countAllocations([&blinker]() {
+        for (int idx = 0; idx < 1000; ++idx)
+        {
+            blinker.dispatch(idx % 3 == 0 ? Event::eToggle : Event::eTick);
+            blinker.during();
+        }
+    });
+    EXPECT_EQ(stats.allocations, 0);
+    EXPECT_EQ(blinker.mUpdates, 1000);
+    EXPECT_GT(blinker.mEntries, 300);
+}
+
+TEST(AllocationGuardTest, AutoLoggedDispatchIsHeapFreeWhileCapturing)
+{
+    LoggedBlinker blinker;
+    TestLog::instance().disable();
+    TestLog::instance().startCapture();
+    const AllocationStats capturing = countAllocations([&blinker]() {
+        for (int idx = 0; idx < 100; ++idx)
+        {
+            blinker.dispatch(Event::eToggle);
+        }
+    });
+    TestLog::instance().stopCapture();
+    TestLog::instance().enable();
+
+    // The transition log goes into this thread's preallocated TestLog shard
+    EXPECT_EQ(capturing.allocations, 0);
+    EXPECT_NE(TestLog::instance().captured().find("transitioning from"), std::string_view::npos);
+}
+
+// *********************** Certification matrix ******************
+// Every combination of event bucket and timer bank is driven through a steady-state cycle of
+// addTimer -> checkTimers -> addEvent -> getEvent -> dispatch -> during, after one warm-up cycle so that containers that
+// only grow (e.g. the vector behind PrioritizedEventBucket) have reached their working size.  Anything that allocates
+// per event or per timer shows up as a non-zero count.
+
+using TimerTraitsForTest = TimerTraits<FakeClock, Event, State>;
+
+struct OrderedBucket {
+    using Type = OrderedEventBucket<Event>;
+    static constexpr const char* kName = "OrderedEventBucket";
+    static Type make(const FakeClock&) { return {}; }
+};
+struct PrioritizedBucket {
+    using Type = PrioritizedEventBucket<Event>;
+    static constexpr const char* kName = "PrioritizedEventBucket";
+    static Type make(const FakeClock&) { return {}; }
+};
+struct TimestampedBucket {
+    using Type = TimestampedEventBucket<Event, FakeClock, 16>;
+    static constexpr const char* kName = "TimestampedEventBucket";
+    static Type make(const FakeClock& clock) { return Type(clock); }
+};
+struct StaticBucket {
+    using Type = StaticEventBucket<Event, 16>;
+    static constexpr const char* kName = "StaticEventBucket";
+    static Type make(const FakeClock&) { return {}; }
+};
+
+struct DynamicTimers {
+    using Type = TimerBank<TimerTraitsForTest>;
+    static constexpr const char* kName = "TimerBank";
+};
+struct StaticTimers {
+    using Type = StaticTimerBank<TimerTraitsForTest>;
+    static constexpr const char* kName = "StaticTimerBank";
+};
+
+template <typename Bucket_, typename Timers_, bool kHeapFree_>
+struct Configuration {
+    using Bucket = Bucket_;
+    using Timers = Timers_;
+    static constexpr bool kHeapFree = kHeapFree_;
+};
+
+/// Run `cycles` steady-state cycles and return the allocations made by each operation separately
+template <typename Config>
+struct CycleAllocations {
+    AllocationStats addTimer{};
+    AllocationStats checkTimers{};
+    AllocationStats getEvent{};
+    AllocationStats dispatch{};
+
+    uint64_t total() const
+    {
+        return addTimer.allocations + checkTimers.allocations + getEvent.allocations + dispatch.allocations;
+    }
+
+    static CycleAllocations run(int cycles)
+    {
+        FakeClock clock;
+        auto bucket = Config::Bucket::make(clock);
+        typename Config::Timers::Type timers;
+        PlainBlinker blinker;
+        CycleAllocations result;
+
+        auto accumulate = [](AllocationStats& into, const AllocationStats& from) {
+            into.allocations += from.allocations;
+            into.bytes += from.bytes;
+        };
+
+        for (int cycle = -1; cycle < cycles; ++cycle)
+        {
+            const bool measuring = cycle >= 0;  // the first cycle is warm-up
+            CycleAllocations step;
+            step.addTimer = countAllocations([&]() {
+                timers.addTimer(Event::eToggle, State::eOn, clock.now() + std::chrono::milliseconds(1));
+                timers.addTimer(Event::eTick, State::eOff, clock.now() + std::chrono::milliseconds(2));
+            });
+            clock.advance(std::chrono::milliseconds(5));
+            step.checkTimers = countAllocations([&]() { timers.checkTimers(clock.now(), bucket); });
+            step.getEvent = countAllocations([&]() {
+                while (!bucket.empty())
+                {
+                    const Event evt = bucket.getEvent();
+                    const AllocationStats dispatched = countAllocations([&]() {
+                        blinker.dispatch(evt);
+                        blinker.during();
+                    });
+                    accumulate(step.dispatch, dispatched);
+                }
+            });
+            // getEvent's count includes dispatch's, so take it back out
+            step.getEvent.allocations -= step.dispatch.allocations;
+            step.getEvent.bytes -= step.dispatch.bytes;
+            if (measuring)
+            {
+                accumulate(result.addTimer, step.addTimer);
+                accumulate(result.checkTimers, step.checkTimers);
+                accumulate(result.getEvent, step.getEvent);
+                accumulate(result.dispatch, step.dispatch);
+            }
+        }
+        return result;
+    }
+};
+
+template <typename Config>
+class AllocationMatrixTest : public ::testing::Test {};
+
+// Certified heap-free:
+//   - StaticEventBucket, TimestampedEventBucket or PrioritizedEventBucket (once its vector has grown), with
+//     StaticTimerBank
+// Not heap-free:
+//   - OrderedEventBucket, whose std::deque allocates blocks as events flow through
+//   - TimerBank, whose std::multiset allocates a node for every addTimer
+using Configurations = ::testing::Types<Configuration<StaticBucket, StaticTimers, true>,
+                                        Configuration<PrioritizedBucket, StaticTimers, true>,
+                                        Configuration<OrderedBucket, StaticTimers, false>,
+                                        Configuration<TimestampedBucket, StaticTimers, true>,
+                                        Configuration<StaticBucket, DynamicTimers, false>,
+                                        Configuration<PrioritizedBucket, DynamicTimers, false>,
+                                        Configuration<OrderedBucket, DynamicTimers, false>,
+                                        Configuration<TimestampedBucket, DynamicTimers, false>>;
+
+TYPED_TEST_SUITE(AllocationMatrixTest, Configurations);
+
+TYPED_TEST(AllocationMatrixTest, SteadyStateCycle)
+{
+    constexpr int kCycles = 500;
+    const auto allocations = CycleAllocations<TypeParam>::run(kCycles);
+    this->RecordProperty("bucket", TypeParam::Bucket::kName);
+    this->RecordProperty("timers", TypeParam::Timers::kName);
+    this->RecordProperty("allocations", std::to_string(allocations.total()));
+
+    // dispatch and during never allocate, whatever is feeding them events
+    EXPECT_EQ(allocations.dispatch.allocations, 0);
+
+    if (TypeParam::kHeapFree)
+    {
+        EXPECT_EQ(allocations.total(), 0) << TypeParam::Bucket::kName << " + " << TypeParam::Timers::kName;
+    }
+    else
+    {
+        EXPECT_GT(allocations.total(), 0) << TypeParam::Bucket::kName << " + " << TypeParam::Timers::kName
+                                          << " is now heap-free; update the certification matrix";
+    }
+}
+
+}  // namespace tests
+}  // namespace utils
+}  // namespace eta_hsm
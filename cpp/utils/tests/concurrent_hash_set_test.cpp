@@ -0,0 +1,86 @@
+// concurrent_hash_set_test.cpp
+
+#include "../ConcurrentHashSet.hpp"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <cstdint>
+#include <set>
+#include <thread>
+#include <vector>
+
+namespace eta_hsm {
+namespace utils {
+namespace tests {
+
+TEST(ConcurrentHashSetTest, InsertsEachKeyOnce)
+{
+    ConcurrentHashSet set(100);
+    EXPECT_TRUE(set.insert(42));
+    EXPECT_FALSE(set.insert(42));
+    EXPECT_TRUE(set.insert(uint64_t{1} << 63));
+    EXPECT_TRUE(set.contains(42));
+    EXPECT_FALSE(set.contains(43));
+    EXPECT_EQ(set.size(), 2);
+
+    std::set<uint64_t> seen;
+    set.forEach([&seen](uint64_t key) { seen.insert(key); });
+    EXPECT_EQ(seen, (std::set<uint64_t>{42, uint64_t{1} << 63}));
+    EXPECT_FALSE(set.overflowed());
+}
+
+TEST(ConcurrentHashSetTest, ReportsOverflow)
+{
+    // Rounded up to 16 slots
+    ConcurrentHashSet set(1);
+    for (uint64_t key = 1; key <= 16; ++key)
+    {
+        EXPECT_TRUE(set.insert(key));
+    }
+    EXPECT_FALSE(set.overflowed());
+    EXPECT_FALSE(set.insert(17));
+    EXPECT_TRUE(set.overflowed());
+    EXPECT_FALSE(set.insert(16));
+    EXPECT_EQ(set.size(), 16);
+}
+
+TEST(ConcurrentHashSetTest, OverlappingInsertsFromManyThreadsAgree)
+{
+    constexpr uint64_t kKeys = 20000;
+    constexpr size_t kThreads = 4;
+    ConcurrentHashSet set(kKeys);
+    std::atomic<uint64_t> newKeys{0};
+
+    // Every thread inserts every key, in a different order, so that all of them race for every slot
+    std::vector<std::thread> threads;
+    for (size_t thread = 0; thread < kThreads; ++thread)
+    {
+        threads.emplace_back([&, thread] {
+            for (uint64_t idx = 0; idx < kKeys; ++idx)
+            {
+                const uint64_t key = (idx * (2 * thread + 1)) % kKeys + 1;
+                if (set.insert(key))
+                {
+                    newKeys.fetch_add(1, std::memory_order_relaxed);
+                }
+            }
+        });
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+
+    EXPECT_EQ(newKeys.load(), kKeys);
+    EXPECT_EQ(set.size(), kKeys);
+    EXPECT_FALSE(set.overflowed());
+    for (uint64_t key = 1; key <= kKeys; ++key)
+    {
+        EXPECT_TRUE(set.contains(key));
+    }
+}
+
+}  // namespace tests
+}  // namespace utils
+}  // namespace eta_hsm
@@ -74,6 +74,62 @@ TEST(EventBucketTest, PrioritizedEventBucketTest)
     EXPECT_TRUE(prioritizedBucket.empty());
 }
 
+TEST(EventBucketTest, StaticEventBucketTest)
+{
+    StaticEventBucket<TestEnum, 3> staticBucket;
+    EventBucket<TestEnum>& bucket = staticBucket;
+    EXPECT_EQ(staticBucket.getEvent(), TestEnum::eNone);
+
+    // Wrap around the end of the ring a few times
+    for (int round = 0; round < 4; ++round)
+    {
+        bucket.addEvent(TestEnum::eOne);
+        bucket.addEvent(TestEnum::eTwo);
+        EXPECT_EQ(staticBucket.size(), 2);
+        EXPECT_EQ(staticBucket.getEvent(), TestEnum::eOne);
+        EXPECT_EQ(staticBucket.getEvent(), TestEnum::eTwo);
+        EXPECT_TRUE(staticBucket.empty());
+    }
+
+    // Events beyond capacity are dropped (and counted) rather than overwriting older ones
+    bucket.addEvent(TestEnum::eOne);
+    bucket.addEvent(TestEnum::eTwo);
+    bucket.addEvent(TestEnum::eThree);
+    bucket.addEvent(TestEnum::eMax);
+    EXPECT_EQ(staticBucket.size(), 3);
+    EXPECT_EQ(staticBucket.overflows(), 1);
+    EXPECT_EQ(staticBucket.front(), TestEnum::eOne);
+
+    staticBucket.clear();
+    EXPECT_TRUE(staticBucket.empty());
+    EXPECT_EQ(staticBucket.overflows(), 1);
+}
+
+TEST(EventBucketTest, StaticEventBucketSnapshotKeepsOrder)
+{
+    StaticEventBucket<TestEnum, 3> bucket;
+    bucket.addEvent(TestEnum::eOne);
+    bucket.addEvent(TestEnum::eOne);
+    bucket.getEvent();
+    bucket.getEvent();
+    // Now the queued events wrap around the end of the ring
+    bucket.addEvent(TestEnum::eTwo);
+    bucket.addEvent(TestEnum::eThree);
+    bucket.addEvent(TestEnum::eMax);
+
+    const auto snap = bucket.snapshot();
+    EXPECT_EQ(snap.size, 3);
+    EXPECT_EQ(snap.events[0], TestEnum::eTwo);
+
+    StaticEventBucket<TestEnum, 3> copy;
+    copy.addEvent(TestEnum::eOne);
+    copy.restore(snap);
+    EXPECT_EQ(copy.size(), 3);
+    EXPECT_EQ(copy.getEvent(), TestEnum::eTwo);
+    EXPECT_EQ(copy.getEvent(), TestEnum::eThree);
+    EXPECT_EQ(copy.getEvent(), TestEnum::eMax);
+}
+
 }  // namespace tests
 }  // namespace utils
 }  // namespace eta_hsm
@@ -0,0 +1,172 @@
+// event_bus_test.cpp
+
+#include "../EventBus.hpp"
+
+#include <gtest/gtest.h>
+
+#include <thread>
+
+namespace eta_hsm {
+namespace utils {
+namespace tests {
+
+enum class Event { eNone, eOne, eTwo, eThree };
+
+/// Events numbered 1 to 63, to tell a long sequence of them apart
+enum class Numbered : int { eNone };
+
+TEST(EventBusTest, EachSubscriberTakesTheTypesItSubscribedTo)
+{
+    EventBus<Event, 8> bus;
+    EventBus<Event, 8>::Subscriber ones{bus};
+    EventBus<Event, 8>::Subscriber all{bus};
+    ones.subscribe(Event::eOne);
+    all.subscribeAll();
+    EXPECT_TRUE(ones.empty());
+    EXPECT_EQ(ones.getEvent(), Event::eNone);
+
+    bus.publish(Event::eOne);
+    bus.addEvent(Event::eTwo);
+    bus.publish(Event::eOne);
+    EXPECT_EQ(bus.published(), 3);
+    EXPECT_EQ(ones.size(), 2);
+    EXPECT_EQ(all.size(), 3);
+
+    EXPECT_EQ(ones.getEvent(), Event::eOne);
+    EXPECT_EQ(ones.getEvent(), Event::eOne);
+    EXPECT_TRUE(ones.empty());
+    EXPECT_EQ(ones.lag(), 0);
+
+    EXPECT_EQ(all.lag(), 3);
+    EXPECT_EQ(all.getEvent(), Event::eOne);
+    all.unsubscribe(Event::eTwo);
+    EXPECT_EQ(all.getEvent(), Event::eOne);
+    EXPECT_TRUE(all.empty());
+}
+
+TEST(EventBusTest, SubscribersStartFromTheNextEvent)
+{
+    EventBus<Event, 8> bus;
+    bus.publish(Event::eOne);
+    EventBus<Event, 8>::Subscriber late{bus};
+    late.subscribeAll();
+    EXPECT_TRUE(late.empty());
+    bus.publish(Event::eTwo);
+    EXPECT_EQ(late.getEvent(), Event::eTwo);
+}
+
+TEST(EventBusTest, SlowSubscribersLoseTheOldestEvents)
+{
+    EventBus<Numbered, 4> bus;
+    EventBus<Numbered, 4>::Subscriber slow{bus};
+    slow.subscribeAll();
+    for (int value = 1; value <= 6; ++value)
+    {
+        bus.publish(static_cast<Numbered>(value));
+    }
+    EXPECT_EQ(slow.lag(), 6);
+    EXPECT_EQ(slow.lost(), 0);
+
+    for (int value = 3; value <= 6; ++value)
+    {
+        EXPECT_EQ(slow.getEvent(), static_cast<Numbered>(value));
+    }
+    EXPECT_EQ(slow.lost(), 2);
+    EXPECT_EQ(slow.lag(), 0);
+}
+
+TEST(EventBusTest, EventsNumberedTooHighCannotBeSubscribedTo)
+{
+    EventBus<Numbered, 8> bus;
+    EventBus<Numbered, 8>::Subscriber subscriber{bus};
+    EXPECT_FALSE(subscriber.subscribe(static_cast<Numbered>(64)));
+    EXPECT_TRUE(subscriber.subscribe(static_cast<Numbered>(63)));
+    subscriber.subscribeAll();
+    bus.publish(static_cast<Numbered>(1000));
+    bus.publish(static_cast<Numbered>(63));
+    EXPECT_EQ(subscriber.size(), 1);
+    EXPECT_EQ(subscriber.getEvent(), static_cast<Numbered>(63));
+    EXPECT_TRUE(subscriber.empty());
+}
+
+TEST(EventBusTest, SizeOnlyCountsEventsStillInTheRing)
+{
+    EventBus<Numbered, 4> bus;
+    EventBus<Numbered, 4>::Subscriber subscriber{bus};
+    subscriber.subscribeAll();
+    for (int value = 1; value <= 7; ++value)
+    {
+        bus.publish(static_cast<Numbered>(value));
+    }
+    EXPECT_EQ(subscriber.size(), 4);
+    EXPECT_EQ(subscriber.lost(), 3);
+}
+
+TEST(EventBusTest, ReportsEverySubscriberAndNotifiesOnlyOfSubscribedEvents)
+{
+    EventBus<Event, 8> bus;
+    EventBus<Event, 8>::Subscriber first{bus};
+    int notified = 0;
+    {
+        EventBus<Event, 8>::Subscriber second{bus};
+        second.subscribe(Event::eTwo);
+        second.setNotify([](void* context) { ++*static_cast<int*>(context); }, &notified);
+        bus.publish(Event::eOne);
+        bus.publish(Event::eTwo);
+        EXPECT_EQ(notified, 1);
+
+        int subscribers = 0;
+        bus.forEachSubscriber([&subscribers](const EventBus<Event, 8>::Subscriber& subscriber) {
+            EXPECT_EQ(subscriber.lag(), 2);
+            ++subscribers;
+        });
+        EXPECT_EQ(subscribers, 2);
+    }
+
+    // Gone subscribers are neither reported nor notified
+    bus.publish(Event::eTwo);
+    EXPECT_EQ(notified, 1);
+    int subscribers = 0;
+    bus.forEachSubscriber([&subscribers](const EventBus<Event, 8>::Subscriber&) { ++subscribers; });
+    EXPECT_EQ(subscribers, 1);
+}
+
+TEST(EventBusTest, CrossThreadSubscribersSeeEveryEventInOrder)
+{
+    constexpr int kEvents = 200000;
+    EventBus<Numbered, 64> bus;
+    EventBus<Numbered, 64>::Subscriber local{bus};
+    EventBus<Numbered, 64>::Subscriber remote{bus};
+    local.subscribeAll();
+    remote.subscribeAll();
+
+    std::thread reader([&remote]() {
+        for (int idx = 0; idx < kEvents;)
+        {
+            if (remote.empty())
+            {
+                std::this_thread::yield();
+                continue;
+            }
+            ASSERT_EQ(remote.getEvent(), static_cast<Numbered>(idx % 63 + 1));
+            ++idx;
+        }
+    });
+    for (int idx = 0; idx < kEvents; ++idx)
+    {
+        // The publisher never waits for subscribers, so this one keeps the remote one from falling a lap behind
+        while (remote.lag() >= bus.capacity())
+        {
+            std::this_thread::yield();
+        }
+        bus.publish(static_cast<Numbered>(idx % 63 + 1));
+        ASSERT_EQ(local.getEvent(), static_cast<Numbered>(idx % 63 + 1));
+    }
+    reader.join();
+    EXPECT_EQ(remote.lost(), 0);
+    EXPECT_EQ(remote.lag(), 0);
+}
+
+}  // namespace tests
+}  // namespace utils
+}  // namespace eta_hsm
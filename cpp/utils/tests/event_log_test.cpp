@@ -0,0 +1,97 @@
+// event_log_test.cpp
+
+#include "../EventLog.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace eta_hsm {
+namespace utils {
+namespace tests {
+
+std::string logPath(const char* name)
+{
+    std::string path = ::testing::TempDir() + name;
+    std::remove(path.c_str());
+    return path;
+}
+
+TEST(EventLogTest, CommittedRecordsReadBackInOrder)
+{
+    const std::string path = logPath("event_log_order.log");
+    EventLog log(path, std::chrono::milliseconds(1000));
+    for (uint32_t idx = 0; idx < 10; ++idx)
+    {
+        EXPECT_EQ(log.append(idx % 3, 1000 + idx, idx), idx);
+    }
+    EXPECT_EQ(log.sequence(), 10);
+    log.commit();
+    EXPECT_EQ(log.committed(), 10);
+
+    EventLogReader reader(path);
+    EXPECT_EQ(reader.size(), 10);
+    std::vector<uint64_t> sequences;
+    const uint64_t replayed = reader.replay(4, [&](uint64_t sequence, const EventLogRecord& record) {
+        sequences.push_back(sequence);
+        EXPECT_EQ(record.event, sequence);
+        EXPECT_EQ(record.machineId, sequence % 3);
+        EXPECT_EQ(record.timestampNs, 1000 + sequence);
+    });
+    EXPECT_EQ(replayed, 6);
+    EXPECT_EQ(sequences, (std::vector<uint64_t>{4, 5, 6, 7, 8, 9}));
+}
+
+TEST(EventLogTest, ReopenedLogContinuesAfterTornRecord)
+{
+    const std::string path = logPath("event_log_reopen.log");
+    {
+        EventLog log(path);
+        log.append(1, 10, 7);
+        log.append(1, 20, 8);
+    }
+    // A crash in the middle of writing a record leaves part of it behind
+    {
+        std::ofstream torn(path, std::ios::binary | std::ios::app);
+        torn.write("partial", 7);
+    }
+    EXPECT_EQ(EventLogReader(path).size(), 2);
+
+    EventLog log(path);
+    EXPECT_EQ(log.sequence(), 2);
+    EXPECT_EQ(log.append(2, 30, 9), 2);
+    log.commit();
+
+    std::vector<uint32_t> events;
+    EventLogReader(path).replay(0, [&](uint64_t, const EventLogRecord& record) { events.push_back(record.event); });
+    EXPECT_EQ(events, (std::vector<uint32_t>{7, 8, 9}));
+}
+
+TEST(EventLogTest, GroupCommitKeepsUpWithBursts)
+{
+    const std::string path = logPath("event_log_burst.log");
+    const uint64_t burst = 3 * EventLog::kCapacity;
+    {
+        EventLog log(path);
+        for (uint64_t idx = 0; idx < burst; ++idx)
+        {
+            log.append(0, idx, static_cast<uint32_t>(idx));
+        }
+        log.commit();
+        EXPECT_EQ(log.committed(), burst);
+        EXPECT_EQ(log.error(), 0);
+    }
+    uint64_t expected = 0;
+    EventLogReader(path).replay(0, [&](uint64_t, const EventLogRecord& record) {
+        EXPECT_EQ(record.timestampNs, expected);
+        ++expected;
+    });
+    EXPECT_EQ(expected, burst);
+}
+
+}  // namespace tests
+}  // namespace utils
+}  // namespace eta_hsm
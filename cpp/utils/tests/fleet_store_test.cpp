@@ -0,0 +1,95 @@
+// fleet_store_test.cpp
+
+#include "../FleetStore.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace eta_hsm {
+namespace utils {
+namespace tests {
+
+struct Record {
+    uint32_t id;
+    uint32_t generation;
+};
+
+std::string storePath(const char* name)
+{
+    std::string path = ::testing::TempDir() + name;
+    std::remove(path.c_str());
+    return path;
+}
+
+TEST(FleetStoreTest, DirtyBitmapConsumesInOrder)
+{
+    DirtyBitmap bits(200);
+    bits.mark(130);
+    bits.mark(3);
+    bits.mark(64);
+    bits.mark(3);
+    EXPECT_EQ(bits.count(), 3);
+    EXPECT_TRUE(bits.test(64));
+    EXPECT_FALSE(bits.test(65));
+
+    std::vector<size_t> consumed;
+    EXPECT_EQ(bits.consume([&](size_t idx) { consumed.push_back(idx); }), 3);
+    EXPECT_EQ(consumed, (std::vector<size_t>{3, 64, 130}));
+    EXPECT_EQ(bits.count(), 0);
+}
+
+TEST(FleetStoreTest, CheckpointWritesOnlyDirtyRecords)
+{
+    FleetStore<Record> store(storePath("fleet_store_dirty.store"), 1000);
+    EXPECT_FALSE(store.recovered());
+    EXPECT_EQ(store[999].generation, 0);
+
+    store.markDirty(7);
+    store.markDirty(512);
+    std::vector<size_t> captured;
+    const size_t written = store.checkpoint([&](size_t id, Record& record) {
+        captured.push_back(id);
+        record = {static_cast<uint32_t>(id), 1};
+    });
+    EXPECT_EQ(written, 2);
+    EXPECT_EQ(captured, (std::vector<size_t>{7, 512}));
+    EXPECT_EQ(store[512].generation, 1);
+    EXPECT_EQ(store.checkpoints(), 1);
+
+    // Nothing dirty, nothing written (and no checkpoint counted)
+    EXPECT_EQ(store.checkpoint([](size_t, Record&) { ADD_FAILURE(); }), 0);
+    EXPECT_EQ(store.checkpoints(), 1);
+}
+
+TEST(FleetStoreTest, RecordsSurviveReopening)
+{
+    const std::string path = storePath("fleet_store_reopen.store");
+    {
+        FleetStore<Record> store(path, 100);
+        for (size_t id = 0; id < store.size(); id += 10)
+        {
+            store.markDirty(id);
+        }
+        store.checkpoint([](size_t id, Record& record) { record = {static_cast<uint32_t>(id), 2}; });
+    }
+
+    FleetStore<Record> reopened(path, 100);
+    EXPECT_TRUE(reopened.recovered());
+    EXPECT_EQ(reopened.checkpoints(), 1);
+    EXPECT_EQ(reopened[90].id, 90);
+    EXPECT_EQ(reopened[90].generation, 2);
+    EXPECT_EQ(reopened[91].generation, 0);
+
+    // A store for a different fleet does not trust what it finds
+    FleetStore<Record> resized(path, 50);
+    EXPECT_FALSE(resized.recovered());
+    EXPECT_EQ(resized[0].generation, 0);
+}
+
+}  // namespace tests
+}  // namespace utils
+}  // namespace eta_hsm
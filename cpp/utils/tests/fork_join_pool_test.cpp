@@ -0,0 +1,89 @@
+// fork_join_pool_test.cpp
+
+#include "../ForkJoinPool.hpp"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <vector>
+
+namespace eta_hsm {
+namespace utils {
+namespace tests {
+
+TEST(ForkJoinPoolTest, RunsEveryTaskExactlyOnce)
+{
+    ForkJoinPool pool(3);
+    EXPECT_EQ(pool.workers(), 3);
+
+    for (size_t count : {0, 1, 2, 7, 1000})
+    {
+        std::vector<std::atomic<int>> hits(count);
+        pool.run(count, [&hits](size_t idx) { hits[idx].fetch_add(1); });
+        for (const auto& hit : hits)
+        {
+            EXPECT_EQ(hit.load(), 1);
+        }
+    }
+}
+
+TEST(ForkJoinPoolTest, SpreadsWorkAcrossThreads)
+{
+    ForkJoinPool pool(2);
+    std::mutex mutex;
+    std::set<std::thread::id> threads;
+    // Every task waits until three of them are running at once, which is only possible if the two workers and the
+    // calling thread all take part
+    std::atomic<int> running{0};
+    pool.run(3, [&](size_t) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            threads.insert(std::this_thread::get_id());
+        }
+        running.fetch_add(1);
+        while (running.load() < 3)
+        {
+            std::this_thread::yield();
+        }
+    });
+    EXPECT_EQ(threads.size(), 3);
+    EXPECT_EQ(threads.count(std::this_thread::get_id()), 1);
+}
+
+TEST(ForkJoinPoolTest, WithoutWorkersRunsOnCaller)
+{
+    ForkJoinPool pool(0);
+    std::vector<std::thread::id> threads;
+    pool.run(4, [&threads](size_t) { threads.push_back(std::this_thread::get_id()); });
+    EXPECT_EQ(threads, std::vector<std::thread::id>(4, std::this_thread::get_id()));
+}
+
+TEST(ForkJoinPoolTest, NestedRunsOnTheSamePoolRunInline)
+{
+    for (size_t workers : {0, 2})
+    {
+        ForkJoinPool pool(workers);
+        std::vector<std::atomic<int>> hits(8 * 8);
+        pool.run(8, [&pool, &hits](size_t outer) {
+            pool.run(8, [&hits, outer](size_t inner) { hits[outer * 8 + inner].fetch_add(1); });
+        });
+        for (const auto& hit : hits)
+        {
+            EXPECT_EQ(hit.load(), 1);
+        }
+    }
+}
+
+TEST(ForkJoinPoolTest, DefaultLeavesACoreForTheCaller)
+{
+    ForkJoinPool pool;
+    EXPECT_EQ(pool.workers(), std::max(std::thread::hardware_concurrency(), 1u) - 1);
+}
+
+}  // namespace tests
+}  // namespace utils
+}  // namespace eta_hsm
@@ -0,0 +1,173 @@
+// latency_recorder_test.cpp
+
+#include "../LatencyRecorder.hpp"
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+#include "../FakeClock.hpp"
+#include "wise_enum/wise_enum.h"
+
+namespace eta_hsm {
+namespace utils {
+namespace tests {
+
+enum class Event { eNone, eSlow, eFast };
+
+WISE_ENUM_CLASS((State, int32_t), eTop, eIdle, eBusy)
+
+/// Minimal stand-in for a StateMachine that takes a known amount of (fake) time to do anything
+struct FakeMachine {
+    using Event = tests::Event;
+
+    void dispatch(Event evt)
+    {
+        clock.advance(evt == Event::eSlow ? std::chrono::microseconds(500) : std::chrono::microseconds(5));
+        state = (state == State::eIdle) ? State::eBusy : State::eIdle;
+    }
+    void during()
+    {
+        clock.advance(state == State::eBusy ? std::chrono::microseconds(50) : std::chrono::microseconds(1));
+    }
+    State identify() const { return state; }
+
+    FakeClock& clock;
+    State state{State::eIdle};
+};
+
+/// Minimal stand-in for the machine's StateTable, which is all LatencyRecorder needs to size its per-state histograms
+struct FakeStateTable {
+    using StateEnum = State;
+    static constexpr size_t size() { return wise_enum::size<State>; }
+};
+
+using Histogram = LatencyHistogram<>;
+
+TEST(LatencyRecorderTest, HistogramBuckets)
+{
+    // Small values are exact, larger values keep a bounded relative error
+    for (uint64_t value : {0ull, 1ull, 17ull, 63ull, 64ull, 1000ull, 123456ull, 987654321ull})
+    {
+        const size_t idx = Histogram::bucketIndex(value);
+        EXPECT_LE(Histogram::lowestEquivalentValue(idx), value);
+        EXPECT_GE(Histogram::highestEquivalentValue(idx), value);
+        EXPECT_LE(Histogram::highestEquivalentValue(idx) - Histogram::lowestEquivalentValue(idx), value / 32);
+    }
+
+    // Buckets are contiguous and cover the whole trackable range
+    for (size_t idx = 1; idx < Histogram::kBucketCount; ++idx)
+    {
+        EXPECT_EQ(Histogram::lowestEquivalentValue(idx), Histogram::highestEquivalentValue(idx - 1) + 1);
+    }
+    EXPECT_EQ(Histogram::bucketIndex(Histogram::kMaxTrackableValue), Histogram::kBucketCount - 1);
+}
+
+TEST(LatencyRecorderTest, HistogramPercentiles)
+{
+    Histogram histogram;
+    EXPECT_EQ(histogram.valueAtPercentile(99.0), 0);
+
+    // 990 fast samples and 10 slow ones
+    for (int idx = 0; idx < 990; ++idx)
+    {
+        histogram.record(std::chrono::microseconds(10));
+    }
+    for (int idx = 0; idx < 10; ++idx)
+    {
+        histogram.record(std::chrono::milliseconds(5));
+    }
+
+    EXPECT_EQ(histogram.totalCount(), 1000);
+    EXPECT_EQ(histogram.max(), 5000000);
+    EXPECT_NEAR(histogram.valueAtPercentile(50.0), 10000, 10000 / 32);
+    EXPECT_NEAR(histogram.valueAtPercentile(99.0), 10000, 10000 / 32);
+    EXPECT_EQ(histogram.valueAtPercentile(99.9), 5000000);
+    EXPECT_EQ(histogram.valueAtPercentile(100.0), 5000000);
+
+    // Values beyond the trackable range are clamped rather than lost
+    histogram.recordValue(Histogram::kMaxTrackableValue + 1);
+    EXPECT_EQ(histogram.saturatedCount(), 1);
+    EXPECT_EQ(histogram.max(), Histogram::kMaxTrackableValue);
+
+    histogram.reset();
+    EXPECT_EQ(histogram.totalCount(), 0);
+    EXPECT_EQ(histogram.max(), 0);
+}
+
+TEST(LatencyRecorderTest, HistogramMergeAcrossThreads)
+{
+    Histogram shared;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t)
+    {
+        threads.emplace_back([&shared, t]() {
+            Histogram local;
+            for (int idx = 0; idx < 10000; ++idx)
+            {
+                local.recordValue(static_cast<uint64_t>(idx * (t + 1)));
+                shared.recordValue(static_cast<uint64_t>(idx));
+            }
+            shared.merge(local);
+        });
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+    EXPECT_EQ(shared.totalCount(), 80000);
+    EXPECT_EQ(shared.max(), 9999 * 4);
+}
+
+TEST(LatencyRecorderTest, RecorderAttributesLatency)
+{
+    FakeClock clock;
+    FakeMachine machine{clock};
+    LatencyRecorder<FakeStateTable, FakeClock> recorder(clock);
+
+    TimestampedEventBucket<Event, FakeClock, 2> bucket(clock);
+    EXPECT_FALSE(recorder.dispatchNext(machine, bucket));
+
+    bucket.addEvent(Event::eSlow);
+    clock.advance(std::chrono::milliseconds(2));
+    bucket.addEvent(Event::eFast);
+    clock.advance(std::chrono::milliseconds(1));
+
+    // eSlow waited 3ms, took 500us, and left us in eBusy
+    EXPECT_TRUE(recorder.dispatchNext(machine, bucket));
+    recorder.during(machine);
+    // eFast waited about 1.5ms, took 5us, and left us in eIdle
+    EXPECT_TRUE(recorder.dispatchNext(machine, bucket));
+    recorder.during(machine);
+    EXPECT_TRUE(bucket.empty());
+
+    // The bucket is a fixed ring:  events that do not fit are dropped and counted rather than allocated for
+    bucket.addEvent(Event::eFast);
+    bucket.addEvent(Event::eFast);
+    bucket.addEvent(Event::eSlow);
+    EXPECT_EQ(bucket.size(), 2);
+    EXPECT_EQ(bucket.overflows(), 1);
+    bucket.clear();
+
+    EXPECT_EQ(recorder.dispatchLatency().totalCount(), 2);
+    EXPECT_EQ(recorder.dispatchLatency().max(), 500000);
+    EXPECT_EQ(recorder.queueDelay().totalCount(), 2);
+    EXPECT_EQ(recorder.queueDelay().max(), 3000000);
+    EXPECT_EQ(recorder.duringLatency(State::eBusy).max(), 50000);
+    EXPECT_EQ(recorder.duringLatency(State::eIdle).max(), 1000);
+    EXPECT_EQ(recorder.duringLatency(State::eTop).totalCount(), 0);
+
+    // Recorders from separate machines can be combined for reporting
+    LatencyRecorder<FakeStateTable, FakeClock> fleet(clock);
+    fleet.merge(recorder);
+    fleet.merge(recorder);
+    EXPECT_EQ(fleet.dispatchLatency().totalCount(), 4);
+    EXPECT_EQ(fleet.duringLatency(State::eBusy).totalCount(), 2);
+}
+
+}  // namespace tests
+}  // namespace utils
+}  // namespace eta_hsm
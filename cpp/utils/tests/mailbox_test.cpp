@@ -0,0 +1,91 @@
+// mailbox_test.cpp
+
+#include "../Mailbox.hpp"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+namespace eta_hsm {
+namespace utils {
+namespace tests {
+
+enum class Event { eNone, eOne, eTwo, eThree };
+
+/// Any int, for events that say who sent them
+enum class Numbered : int { eNone };
+
+TEST(MailboxTest, KeepsOrderAndDropsWhenFull)
+{
+    Mailbox<Event, 2> mailbox;
+    EXPECT_TRUE(mailbox.empty());
+    EXPECT_EQ(mailbox.getEvent(), Event::eNone);
+
+    EXPECT_TRUE(mailbox.tryAddEvent(Event::eOne));
+    mailbox.addEvent(Event::eTwo);
+    EXPECT_FALSE(mailbox.tryAddEvent(Event::eThree));
+    EXPECT_EQ(mailbox.size(), 2);
+    EXPECT_EQ(mailbox.overflows(), 1);
+
+    EXPECT_EQ(mailbox.getEvent(), Event::eOne);
+    EXPECT_TRUE(mailbox.tryAddEvent(Event::eThree));
+    EXPECT_EQ(mailbox.getEvent(), Event::eTwo);
+    EXPECT_EQ(mailbox.getEvent(), Event::eThree);
+    EXPECT_TRUE(mailbox.empty());
+}
+
+TEST(MailboxTest, NotifiesOnEveryEvent)
+{
+    Mailbox<Event, 4> mailbox;
+    int notified = 0;
+    mailbox.setNotify([](void* context) { ++*static_cast<int*>(context); }, &notified);
+    mailbox.addEvent(Event::eOne);
+    mailbox.addEvent(Event::eTwo);
+    EXPECT_EQ(notified, 2);
+}
+
+TEST(MailboxTest, ManyProducersOneConsumer)
+{
+    constexpr int kProducers = 4;
+    constexpr int kPerProducer = 20000;
+    Mailbox<Numbered, 64> mailbox;
+    std::vector<std::thread> producers;
+    for (int producer = 0; producer < kProducers; ++producer)
+    {
+        producers.emplace_back([&mailbox, producer]() {
+            for (int idx = 0; idx < kPerProducer; ++idx)
+            {
+                // Values are one more than (producer, idx) packed, so that none of them is 0 (eNone)
+                while (!mailbox.tryAddEvent(static_cast<Numbered>(producer * kPerProducer + idx + 1)))
+                {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+
+    // Each producer's events arrive in the order it added them
+    std::vector<int> next(kProducers, 0);
+    for (int received = 0; received < kProducers * kPerProducer;)
+    {
+        if (mailbox.empty())
+        {
+            std::this_thread::yield();
+            continue;
+        }
+        const int value = static_cast<int>(mailbox.getEvent()) - 1;
+        ASSERT_EQ(value % kPerProducer, next[value / kPerProducer]++);
+        ++received;
+    }
+    for (auto& producer : producers)
+    {
+        producer.join();
+    }
+    EXPECT_TRUE(mailbox.empty());
+}
+
+}  // namespace tests
+}  // namespace utils
+}  // namespace eta_hsm
@@ -0,0 +1,110 @@
+// payload_event_test.cpp
+
+#include "../PayloadEvent.hpp"
+
+#include <gtest/gtest.h>
+
+#include <string>
+
+#include "../EventBucket.hpp"
+
+namespace eta_hsm {
+namespace utils {
+namespace tests {
+
+enum class Command { eMove, eRename, eStop, eNone };
+
+struct Move {
+    double x;
+    double y;
+};
+
+/// Counts the ways it gets passed around
+struct Tracked {
+    Tracked() = default;
+    Tracked(const Tracked& other) : copies{other.copies + 1}, moves{other.moves} {}
+    Tracked(Tracked&& other) noexcept : copies{other.copies}, moves{other.moves + 1} {}
+    int copies{0};
+    int moves{0};
+};
+
+}  // namespace tests
+
+template <>
+struct PayloadOf<tests::Command::eMove> {
+    using type = tests::Move;
+};
+
+namespace tests {
+
+using CommandEvent = PayloadEvent<Command>;
+
+TEST(PayloadEventTest, BehavesLikeTheEnum)
+{
+    const CommandEvent stop{Command::eStop};
+    EXPECT_EQ(stop.id(), Command::eStop);
+    EXPECT_TRUE(stop == Command::eStop);
+    EXPECT_TRUE(Command::eMove != stop);
+    EXPECT_FALSE(stop.hasPayload());
+    EXPECT_EQ(CommandEvent{}.id(), Command::eNone);
+
+    switch (stop)
+    {
+        case Command::eStop:
+            SUCCEED();
+            break;
+        default:
+            FAIL();
+    }
+}
+
+TEST(PayloadEventTest, HoldsTypedPayload)
+{
+    auto move = CommandEvent::make<Command::eMove>(Move{1.0, 2.0});
+    EXPECT_TRUE(move.holds<Move>());
+    EXPECT_FALSE(move.holds<std::string>());
+    EXPECT_EQ(move.get<Command::eMove>().y, 2.0);
+    EXPECT_EQ(move.getIf<std::string>(), nullptr);
+
+    // Non-trivial payloads are fine too, as long as they fit
+    CommandEvent rename{Command::eRename, std::string("pump")};
+    ASSERT_NE(rename.getIf<std::string>(), nullptr);
+    EXPECT_EQ(rename.get<std::string>(), "pump");
+    rename.emplace<Move>(Move{3.0, 4.0});
+    EXPECT_EQ(rename.get<Move>().x, 3.0);
+}
+
+TEST(PayloadEventTest, MovesThroughBucketsWithoutCopying)
+{
+    StaticEventBucket<CommandEvent, 4> bucket;
+    bucket.addEvent(CommandEvent{Command::eMove, Tracked{}});
+    bucket.addEvent(Command::eStop);
+    EXPECT_EQ(bucket.size(), 2);
+
+    const CommandEvent first = bucket.getEvent();
+    ASSERT_TRUE(first.holds<Tracked>());
+    EXPECT_EQ(first.get<Tracked>().copies, 0);
+    EXPECT_GT(first.get<Tracked>().moves, 0);
+    EXPECT_EQ(bucket.getEvent().id(), Command::eStop);
+    EXPECT_EQ(bucket.getEvent().id(), Command::eNone);
+
+    OrderedEventBucket<CommandEvent> ordered;
+    ordered.addEvent(CommandEvent{Command::eMove, Tracked{}});
+    EXPECT_EQ(ordered.getEvent().get<Tracked>().copies, 0);
+}
+
+TEST(PayloadEventTest, MovedFromEventKeepsIdButNotPayload)
+{
+    CommandEvent rename{Command::eRename, std::string("a name long enough to defeat the small string optimization")};
+    CommandEvent other{std::move(rename)};
+    EXPECT_EQ(rename.id(), Command::eRename);
+    EXPECT_FALSE(rename.hasPayload());
+    EXPECT_EQ(other.get<std::string>().size(), 58);
+
+    other = CommandEvent{Command::eStop};
+    EXPECT_FALSE(other.hasPayload());
+}
+
+}  // namespace tests
+}  // namespace utils
+}  // namespace eta_hsm
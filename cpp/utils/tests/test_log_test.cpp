@@ -0,0 +1,145 @@
+// test_log_test.cpp
+
+#include "../TestLog.hpp"
+
+#include <gtest/gtest.h>
+
+#include <iomanip>
+#include <iostream>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <thread>
+
+namespace eta_hsm {
+namespace utils {
+namespace tests {
+
+enum class Color { eRed, eGreen };
+
+std::ostream& operator<<(std::ostream& os, Color color) { return os << (color == Color::eRed ? "red" : "green"); }
+
+class TestLogTest : public ::testing::Test {
+protected:
+    void SetUp() override { TestLog::instance().disable(); }
+    void TearDown() override
+    {
+        TestLog::instance().stopCapture();
+        TestLog::instance().enable();
+    }
+};
+
+TEST_F(TestLogTest, CapturesWhatStdCoutWouldShow)
+{
+    const std::string name{"valve"};
+    TestLog::instance().startCapture();
+    TestLog::instance() << name << " opened " << 3 << ' ' << -42L << ' ' << 2.5 << ' ' << true << ' ' << Color::eGreen
+                        << std::endl;
+    TestLog::instance().stopCapture();
+    TestLog::instance() << "not captured";
+
+    // Manipulators only ever went to the output
+    EXPECT_EQ(TestLog::instance().getCaptured(), "valve opened 3 -42 2.5 1 green");
+    EXPECT_EQ(TestLog::instance().dropped(), 0u);
+
+    TestLog::instance().startCapture();
+    EXPECT_EQ(TestLog::instance().getCaptured(), "");
+}
+
+TEST_F(TestLogTest, ThreadsWriteWholeLines)
+{
+    std::ostringstream out;
+    std::streambuf* const cout = std::cout.rdbuf(out.rdbuf());
+    TestLog::instance().enable();
+
+    TestLog::instance() << "main " << 1;
+    std::thread worker([]() {
+        TestLog::instance() << "worker " << std::hex << 255 << std::endl;
+        TestLog::instance() << "unfinished";
+    });
+    worker.join();
+    EXPECT_EQ(out.str(), "worker ff\nunfinished");
+
+    // The worker's hex did not leak into this thread's line
+    TestLog::instance() << ' ' << 255 << "\nnext\n";
+    TestLog::instance().disable();
+    std::cout.rdbuf(cout);
+    EXPECT_EQ(out.str(), "worker ff\nunfinishedmain 1 255\nnext\n");
+}
+
+TEST_F(TestLogTest, MacroLogsOnlyWhenCompiledIn)
+{
+    TestLog::instance().startCapture();
+    ETA_HSM_TEST_LOG("enter_S" << 1 << ' ');
+    TestLog::instance().stopCapture();
+    EXPECT_EQ(TestLog::instance().getCaptured(), TestLog::kCompiledIn ? "enter_S1 " : "");
+}
+
+TEST_F(TestLogTest, DropsWhatDoesNotFitInTheShard)
+{
+    const std::string chunk(1000, 'x');
+    TestLog::instance().startCapture();
+    for (size_t written = 0; written < TestLog::kShardCapacity; written += chunk.size())
+    {
+        TestLog::instance() << chunk;
+    }
+    TestLog::instance() << "!";
+    TestLog::instance().stopCapture();
+
+    EXPECT_EQ(TestLog::instance().captured().size(), TestLog::kShardCapacity);
+    EXPECT_EQ(TestLog::instance().dropped(), chunk.size() - TestLog::kShardCapacity % chunk.size() + 1);
+}
+
+TEST_F(TestLogTest, ThreadsHaveTheirOwnCaptures)
+{
+    TestLog::instance().clearAll();
+    TestLog::instance().startCapture();
+    TestLog::instance() << "main ";
+
+    std::string workerCapture;
+    std::thread worker([&workerCapture]() {
+        TestLog::instance() << "lost ";  // this thread is not capturing
+        TestLog::instance().startCapture();
+        TestLog::instance() << "worker ";
+        TestLog::instance().stopCapture();
+        workerCapture = TestLog::instance().getCaptured();
+    });
+    worker.join();
+    TestLog::instance() << "again";
+    TestLog::instance().stopCapture();
+
+    EXPECT_EQ(workerCapture, "worker ");
+    EXPECT_EQ(TestLog::instance().getCaptured(), "main again");
+
+    // The worker has finished, but what it captured is still in the merged view
+    const std::string merged = TestLog::instance().getMerged();
+    EXPECT_EQ(merged.size(), std::string{"worker main again"}.size());
+    EXPECT_NE(merged.find("worker "), std::string::npos);
+    EXPECT_NE(merged.find("main again"), std::string::npos);
+}
+
+TEST_F(TestLogTest, FinishedThreadsHandTheirShardsOn)
+{
+    auto captureOnce = []() {
+        std::thread worker([]() {
+            TestLog::instance().startCapture();
+            TestLog::instance() << "once";
+        });
+        worker.join();
+    };
+    captureOnce();
+    size_t shards = 0;
+    TestLog::instance().forEachCapture([&shards](std::string_view) { ++shards; });
+
+    for (int round = 0; round < 10; ++round)
+    {
+        captureOnce();
+    }
+    size_t shardsAfter = 0;
+    TestLog::instance().forEachCapture([&shardsAfter](std::string_view) { ++shardsAfter; });
+    EXPECT_EQ(shardsAfter, shards);
+}
+
+}  // namespace tests
+}  // namespace utils
+}  // namespace eta_hsm
@@ -5,6 +5,7 @@
 #include <gtest/gtest.h>
 
 #include <chrono>
+#include <tuple>
 
 #include "../FakeClock.hpp"
 
@@ -248,6 +249,89 @@ TEST(TimerTest, StaticTimerBank)
     EXPECT_TRUE(bucket.empty());
 }
 
+TEST(TimerTest, TimerBankSnapshotRearmsWithRemainingTime)
+{
+    TimerBank<TimerTraits<Clock, Event, State, UniqueId>> bank;
+    bank.addTimer(Event::eOne, State::eRed, epoch + std::chrono::seconds(50));
+    bank.addTimer(Event::eTwo, State::eGreen, epoch + std::chrono::seconds(20), UniqueId::eAlpha);
+    bank.addTimer(Event::eThree, State::eBlue, epoch + std::chrono::seconds(90));
+
+    // Only room for two:  the timer that expires last is the one left out
+    const auto snap = bank.template snapshot<2>(epoch + std::chrono::seconds(10));
+    EXPECT_EQ(snap.count, 2);
+    EXPECT_TRUE(snap.truncated);
+    EXPECT_EQ(snap.timers[0].event, Event::eTwo);
+    EXPECT_EQ(snap.timers[0].uniqueId, UniqueId::eAlpha);
+    EXPECT_EQ(snap.timers[0].remaining(epoch + std::chrono::seconds(10)), std::chrono::seconds(10));
+    EXPECT_EQ(snap.timers[1].remaining(epoch + std::chrono::seconds(10)), std::chrono::seconds(40));
+
+    // Restored against a later "now", the timers keep the time they had left
+    TimerBank<TimerTraits<Clock, Event, State, UniqueId>> standby;
+    const auto now = epoch + std::chrono::seconds(1000);
+    standby.restore(snap, now);
+    EXPECT_EQ(standby.checkForSingleFiredEvent(now + std::chrono::seconds(9)), Event::eNone);
+    EXPECT_EQ(standby.checkForSingleFiredEvent(now + std::chrono::seconds(11)), Event::eTwo);
+    EXPECT_EQ(standby.checkForSingleFiredEvent(now + std::chrono::seconds(41)), Event::eOne);
+    EXPECT_TRUE(standby.empty());
+
+    // Taken to be as of later than it was, the snapshot has that much less time left on each timer
+    standby.restore(snap, now, epoch + std::chrono::seconds(15));
+    EXPECT_EQ(standby.checkForSingleFiredEvent(now + std::chrono::seconds(6)), Event::eTwo);
+    EXPECT_EQ(standby.checkForSingleFiredEvent(now + std::chrono::seconds(36)), Event::eOne);
+}
+
+TEST(TimerTest, ChangesAreReportedToTheHook)
+{
+    int changes = 0;
+    const auto count = [](void* context) { ++*static_cast<int*>(context); };
+    TimerBank<TimerTraits<Clock, Event, State>> bank;
+    StaticTimerBank<TimerTraits<Clock, Event, State>> staticBank;
+    bank.onChange(count, &changes);
+    staticBank.onChange(count, &changes);
+
+    bank.addTimer(Event::eOne, State::eRed, epoch + std::chrono::seconds(50));
+    staticBank.addTimer(Event::eOne, State::eRed, epoch + std::chrono::seconds(50));
+    EXPECT_EQ(changes, 2);
+
+    // Clearing a timer that is not armed changes nothing
+    bank.clearAllTimersInGroup(State::eGreen);
+    staticBank.clearTimer(State::eGreen);
+    EXPECT_EQ(changes, 2);
+
+    OrderedEventBucket<Event> bucket;
+    bank.checkTimers(epoch + std::chrono::seconds(60), bucket);
+    staticBank.checkTimers(epoch + std::chrono::seconds(60), bucket);
+    EXPECT_EQ(changes, 4);
+
+    // Copies do not report to the hook
+    auto copy = bank;
+    copy.addTimer(Event::eTwo, State::eBlue, epoch + std::chrono::seconds(90));
+    EXPECT_EQ(changes, 4);
+}
+
+TEST(TimerTest, NextExpiration)
+{
+    TimerBank<TimerTraits<Clock, Event, State>> bank;
+    StaticTimerBank<TimerTraits<Clock, Event, State>> staticBank;
+    EXPECT_FALSE(bank.nextExpiration());
+    EXPECT_FALSE(staticBank.nextExpiration());
+
+    for (const auto& [event, group, seconds] : {std::make_tuple(Event::eOne, State::eRed, 50),
+                                                std::make_tuple(Event::eTwo, State::eGreen, 20),
+                                                std::make_tuple(Event::eThree, State::eBlue, 90)})
+    {
+        bank.addTimer(event, group, epoch + std::chrono::seconds(seconds));
+        staticBank.addTimer(event, group, epoch + std::chrono::seconds(seconds));
+    }
+    EXPECT_EQ(bank.nextExpiration(), epoch + std::chrono::seconds(20));
+    EXPECT_EQ(staticBank.nextExpiration(), epoch + std::chrono::seconds(20));
+
+    bank.clearAllTimersInGroup(State::eGreen);
+    staticBank.clearAllTimersInGroup(State::eGreen);
+    EXPECT_EQ(bank.nextExpiration(), epoch + std::chrono::seconds(50));
+    EXPECT_EQ(staticBank.nextExpiration(), epoch + std::chrono::seconds(50));
+}
+
 }  // namespace tests
 }  // namespace utils
 }  // namespace eta_hsm
@@ -0,0 +1,181 @@
+// trace_recorder_test.cpp
+
+#include "../TraceRecorder.hpp"
+
+#include <gtest/gtest.h>
+
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../../Hsm.hpp"
+#include "../FakeClock.hpp"
+#include "../Timer.hpp"
+
+namespace eta_hsm {
+namespace utils {
+namespace tests {
+
+WISE_ENUM_CLASS((Event, int32_t), eNone, eGo, eTimeout)
+
+WISE_ENUM_CLASS((State, int32_t), eNone, eTop, eParent, eChild)
+
+struct TracedTraits {
+    using Clock = FakeClock;
+    using Event = tests::Event;
+    using StateEnum = State;
+    static constexpr DefaultActions kDefaultActions = DefaultActions::eNothing;
+    static constexpr bool kClearTimersOnExit = false;
+    static constexpr bool kTraceStates = true;
+};
+
+/// A machine whose residency spans are recorded as it enters and exits states
+class TracedMachine : public StateMachine<TracedMachine, TracedTraits> {
+public:
+    using Input = EmptyType;
+    explicit TracedMachine(StateTracer<State>& tracer);
+
+    StateTracer<State>& stateTracer() { return mTracer; }
+
+private:
+    StateTracer<State>& mTracer;
+};
+
+template <State kState>
+using TracedStateTraits = StateTraits<TracedMachine, State, kState>;
+
+using Top = TopState<TracedStateTraits<State::eTop>>;
+using Parent = CompState<TracedStateTraits<State::eParent>, Top>;
+using Child = LeafState<TracedStateTraits<State::eChild>, Parent>;
+
+}  // namespace tests
+}  // namespace utils
+
+template <>
+inline void utils::tests::Top::init(utils::tests::TracedMachine& stateMachine)
+{
+    Init<utils::tests::Parent> i(stateMachine);
+}
+
+template <>
+inline void utils::tests::Parent::init(utils::tests::TracedMachine& stateMachine)
+{
+    Init<utils::tests::Child> i(stateMachine);
+}
+
+template <>
+template <typename Current>
+inline void utils::tests::Child::handleEvent(utils::tests::TracedMachine& stateMachine, const Current& currentState,
+                                             Event event) const
+{
+    if (event == utils::tests::Event::eGo)
+    {
+        Transition<Current, ThisState, utils::tests::Child> t(stateMachine);
+        return;
+    }
+    return ParentState::handleEvent(stateMachine, currentState, event);
+}
+
+namespace utils {
+namespace tests {
+
+TracedMachine::TracedMachine(StateTracer<State>& tracer) : mTracer{tracer} { Transition<Top, Top, Top> t(*this); }
+
+size_t countOf(const std::string& haystack, const std::string& needle)
+{
+    size_t count = 0;
+    for (size_t pos = haystack.find(needle); pos != std::string::npos; pos = haystack.find(needle, pos + 1))
+    {
+        ++count;
+    }
+    return count;
+}
+
+TEST(TraceRecorderTest, StateDispatchAndTimerSpans)
+{
+    std::stringstream output;
+    {
+        TraceRecorder recorder(output);
+        recorder.nameMachine(7, "Machine \"Seven\"");
+        StateTracer<State> tracer(recorder, 7);
+
+        // Nested residency spans come from entering the initial states (the top state spans the whole track)
+        TracedMachine machine{tracer};
+
+        // Timer firings show up as instant events on the way into the event bucket
+        OrderedEventBucket<Event> bucket;
+        TracingEventBucket<Event, State> tracingBucket(bucket, tracer);
+        TimerBank<TimerTraits<FakeClock, Event, State>> timers;
+        timers.addTimer(Event::eTimeout, State::eChild, FakeClock::time_point() + std::chrono::seconds(1));
+        timers.checkTimers(FakeClock::time_point() + std::chrono::seconds(2), tracingBucket);
+        EXPECT_EQ(bucket.getEvent(), Event::eTimeout);
+
+        tracer.dispatch(machine, Event::eGo);
+        tracer.during(machine);
+        recorder.flush();
+        EXPECT_NE(output.str().find("\"name\":\"eChild\",\"cat\":\"state\",\"ph\":\"B\""), std::string::npos);
+    }
+
+    const std::string json = output.str();
+    EXPECT_EQ(json.rfind("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[", 0), 0);
+    EXPECT_EQ(json.substr(json.size() - 4), "\n]}\n");
+    EXPECT_NE(json.find("\"tid\":14,\"args\":{\"name\":\"Machine \\\"Seven\\\"\"}"), std::string::npos);
+    EXPECT_NE(json.find("\"tid\":15,\"args\":{\"name\":\"Machine \\\"Seven\\\" states\"}"), std::string::npos);
+
+    // Spans nest in the order they were recorded
+    const size_t parent = json.find("\"name\":\"eParent\",\"cat\":\"state\",\"ph\":\"B\"");
+    const size_t child = json.find("\"name\":\"eChild\",\"cat\":\"state\",\"ph\":\"B\"");
+    const size_t timer = json.find("\"name\":\"eTimeout\",\"cat\":\"timer\",\"ph\":\"i\"");
+    const size_t dispatch = json.find("\"name\":\"dispatch\",\"cat\":\"dispatch\",\"ph\":\"B\"");
+    const size_t childExit = json.find("\"name\":\"eChild\",\"cat\":\"state\",\"ph\":\"E\"");
+    EXPECT_LT(parent, child);
+    EXPECT_LT(child, timer);
+    EXPECT_LT(timer, dispatch);
+    EXPECT_LT(dispatch, childExit);
+    EXPECT_NE(json.find("\"args\":{\"event\":\"eGo\"}"), std::string::npos);
+    EXPECT_EQ(countOf(json, "\"name\":\"during\""), 2);
+
+    // The eChild span closes (and reopens) inside the dispatch span, so residency spans are on a track of their own
+    EXPECT_EQ(countOf(json, "\"cat\":\"state\",\"ph\":"), 4);
+    EXPECT_EQ(countOf(json, "\"name\":\"eTop\""), 0);
+    EXPECT_EQ(countOf(json, "\"pid\":1,\"tid\":15}"), 4);
+    EXPECT_EQ(countOf(json, "\"tid\":14"), 6);
+    EXPECT_EQ(countOf(json, "\"tid\":15"), 5);
+}
+
+TEST(TraceRecorderTest, RecordsFromManyThreads)
+{
+    constexpr int kThreads = 4;
+    constexpr int kRecordsPerThread = 2000;
+
+    std::stringstream output;
+    uint64_t dropped = 0;
+    {
+        TraceRecorder recorder(output, std::chrono::milliseconds(1));
+        std::vector<std::thread> threads;
+        for (int t = 0; t < kThreads; ++t)
+        {
+            threads.emplace_back([&recorder, t]() {
+                StateTracer<State> tracer(recorder, static_cast<uint32_t>(t));
+                for (int idx = 0; idx < kRecordsPerThread / 2; ++idx)
+                {
+                    tracer.enter(State::eChild);
+                    tracer.exit(State::eChild);
+                }
+            });
+        }
+        for (auto& thread : threads)
+        {
+            thread.join();
+        }
+        recorder.flush();
+        dropped = recorder.dropped();
+    }
+
+    EXPECT_EQ(countOf(output.str(), "\"ph\":") + dropped, kThreads * kRecordsPerThread);
+}
+
+}  // namespace tests
+}  // namespace utils
+}  // namespace eta_hsm